@@ -20,6 +20,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 */
 
 #include "ResampleAudioReader.h"
+#include "TPolyphaseResampler.h"
 #include <QString>
 #include <cstdio>
 
@@ -53,6 +54,8 @@ ResampleAudioReader::ResampleAudioReader(QString filename, const QString& decode
 	m_resampleDecodeBufferIsMine = false;
 	m_resampleDecodeBuffer = 0;
 	m_convertorType = -1;
+	m_polyphase = 0;
+	m_usePolyphase = false;
 }
 
 
@@ -77,6 +80,8 @@ ResampleAudioReader::~ResampleAudioReader()
 	if (m_resampleDecodeBufferIsMine) {
 		delete m_resampleDecodeBuffer;
 	}
+	
+	delete m_polyphase;
 }
 
 
@@ -102,6 +107,10 @@ void ResampleAudioReader::reset()
 		src_reset(state);
 	}
 	
+	if (m_polyphase) {
+		m_polyphase->reset();
+	}
+	
 	m_srcData.end_of_input = 0;
 	m_overflowUsed = 0;
 	
@@ -147,10 +156,31 @@ void ResampleAudioReader::set_converter_type(int converter_type)
 		}
 	}
 	
+	update_polyphase_resampler();
+	
 	// seek_private will reset the src states!
 	seek_private(pos());
 }
 
+// Uses the built in polyphase resampler instead of libsamplerate when enabled,
+// and the file and output rate have a ratio it supports. The best quality setting
+// is always left to libsamplerate, none of the polyphase filters matches it.
+void ResampleAudioReader::update_polyphase_resampler()
+{
+	bool usePolyphase = m_usePolyphase && m_reader && m_convertorType > SRC_SINC_BEST_QUALITY && m_outputRate != m_rate
+			&& TPolyphaseFilter::is_supported(m_rate, m_outputRate);
+	TPolyphaseFilter::Quality quality = TPolyphaseResampler::quality_for_converter_type(m_convertorType);
+	
+	if (m_polyphase && (!usePolyphase || !m_polyphase->matches(m_rate, m_outputRate, quality))) {
+		delete m_polyphase;
+		m_polyphase = 0;
+	}
+	
+	if (usePolyphase && !m_polyphase) {
+		m_polyphase = new TPolyphaseResampler(m_channels, m_rate, m_outputRate, quality);
+	}
+}
+
 int ResampleAudioReader::get_output_rate()
 {
 	return m_outputRate;
@@ -170,6 +200,8 @@ void ResampleAudioReader::set_output_rate(int rate)
 	m_nframes = file_to_resampled_frame(m_reader->get_nframes());
 	m_length = TimeRef(m_nframes, m_outputRate);
 	
+	update_polyphase_resampler();
+	
 	reset();
 }
 
@@ -259,30 +291,38 @@ nframes_t ResampleAudioReader::read_private(DecodeBuffer* buffer, nframes_t fram
 		framesToConvert = m_nframes - m_readPos;
 	}
 	
-	for (int chan = 0; chan < m_channels; chan++) {
-		// Set up sample rate converter struct for s.r.c. processing
-		m_srcData.data_in = m_resampleDecodeBuffer->destination[chan];
-		m_srcData.input_frames = bufferUsed;
-		m_srcData.data_out = buffer->destination[chan];
-		m_srcData.output_frames = framesToConvert;
-		m_srcData.src_ratio = (double) m_outputRate / m_rate;
-		src_set_ratio(m_srcStates[chan], m_srcData.src_ratio);
-		
-		if (src_process(m_srcStates[chan], &m_srcData)) {
-			PERROR("Resampler: src_process() error!");
-			return 0;
+	nframes_t inputUsed = 0;
+	
+	if (m_polyphase) {
+		framesRead = m_polyphase->process(m_resampleDecodeBuffer->destination, bufferUsed,
+						buffer->destination, framesToConvert, m_srcData.end_of_input, inputUsed);
+	} else {
+		for (int chan = 0; chan < m_channels; chan++) {
+			// Set up sample rate converter struct for s.r.c. processing
+			m_srcData.data_in = m_resampleDecodeBuffer->destination[chan];
+			m_srcData.input_frames = bufferUsed;
+			m_srcData.data_out = buffer->destination[chan];
+			m_srcData.output_frames = framesToConvert;
+			m_srcData.src_ratio = (double) m_outputRate / m_rate;
+			src_set_ratio(m_srcStates[chan], m_srcData.src_ratio);
+			
+			if (src_process(m_srcStates[chan], &m_srcData)) {
+				PERROR("Resampler: src_process() error!");
+				return 0;
+			}
+			framesRead = m_srcData.output_frames_gen;
 		}
-		framesRead = m_srcData.output_frames_gen;
+		inputUsed = m_srcData.input_frames_used;
 	}
 	
-	m_overflowUsed = bufferUsed - m_srcData.input_frames_used;
+	m_overflowUsed = bufferUsed - inputUsed;
 	if (m_overflowUsed < 0) {
 		m_overflowUsed = 0;
 	}
 	if (m_overflowUsed) {
 		// If there was overflow, save it for the next read.
 		for (int chan = 0; chan < m_channels; chan++) {
-			memcpy(m_overflowBuffers[chan], m_resampleDecodeBuffer->destination[chan] + m_srcData.input_frames_used, m_overflowUsed * sizeof(audio_sample_t));
+			memcpy(m_overflowBuffers[chan], m_resampleDecodeBuffer->destination[chan] + inputUsed, m_overflowUsed * sizeof(audio_sample_t));
 		}
 	}
 	
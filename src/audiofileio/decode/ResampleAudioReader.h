@@ -26,6 +26,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QVector>
 #include <samplerate.h>
 
+class TPolyphaseResampler;
 
 class ResampleAudioReader : public AbstractAudioReader
 {
@@ -49,6 +50,7 @@ public:
 	int get_convertor_type() const {return m_convertorType;}
 	void set_output_rate(int rate);
 	void set_converter_type(int converter_type);
+	void set_polyphase_resampling(bool usePolyphase) {m_usePolyphase = usePolyphase;}
 	void set_resample_decode_buffer(DecodeBuffer* buffer);
 	
 protected:
@@ -72,8 +74,11 @@ protected:
 	
 private:
 	void create_overflow_buffers();
+	void update_polyphase_resampler();
 	DecodeBuffer* m_resampleDecodeBuffer;
+	TPolyphaseResampler* m_polyphase;
 	bool m_resampleDecodeBufferIsMine;
+	bool m_usePolyphase;
 };
 
 #endif
@@ -139,6 +139,23 @@ int Gain::undo_action()
 }
 
 
+/**
+ * Merges a following Gain change of the same object into this one, keeping
+ * the original gain of this command and the new gain of \a command.
+ */
+bool Gain::mergeWith(const QUndoCommand* command)
+{
+	const Gain* next = static_cast<const Gain*>(command);
+	
+	if (next->m_gainObject != m_gainObject || !is_merge_interval(next)) {
+		return false;
+	}
+	
+	m_newGain = next->m_newGain;
+	
+	return true;
+}
+
 void Gain::cancel_action()
 {
 	finish_hold();
@@ -47,6 +47,9 @@ public :
         
         int jog();
         
+        int id() const {return GainMergeId;}
+        bool mergeWith(const QUndoCommand* command);
+        
         void set_cursor_shape(int useX, int useY);
 	bool restoreCursorPosition() const {return true;}
 
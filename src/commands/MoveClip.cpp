@@ -183,6 +183,11 @@ MoveClip::~MoveClip()
 	}
 }
 
+qint64 MoveClip::get_memory_usage() const
+{
+	return sizeof(MoveClip) + m_markers.size() * sizeof(MarkerAndOrigin) + m_group.get_size() * sizeof(AudioClip*);
+}
+
 int MoveClip::begin_hold()
 {
 	if ((!m_group.get_size() || m_group.is_locked()) && !m_markers.count()) {
@@ -60,6 +60,9 @@ public :
 
 	void set_cursor_shape(int useX, int useY);
         void set_jog_bypassed(bool bypassed);
+
+protected:
+	qint64 get_memory_usage() const;
 	
 private :
 	enum ActionType {
@@ -111,6 +111,11 @@ int MoveCurveNode::do_action()
         return 1;
 }
 
+qint64 MoveCurveNode::get_memory_usage() const
+{
+	return sizeof(MoveCurveNode) + m_nodeDatas.size() * sizeof(CurveNodeData);
+}
+
 int MoveCurveNode::undo_action()
 {
 	foreach(const CurveNodeData& nodeData, m_nodeDatas) {
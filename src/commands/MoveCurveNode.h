@@ -90,6 +90,7 @@ private :
 	QList<CurveNodeData> m_nodeDatas;
 
 	int check_and_apply_when_and_value_diffs();
+	qint64 get_memory_usage() const;
 
 
 public slots:
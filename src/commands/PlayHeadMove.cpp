@@ -31,6 +31,8 @@
 PlayHeadMove::PlayHeadMove(SheetView* sv)
         : MoveCommand("Play Cursor Move")
         , m_session(sv->get_sheet())
+        , m_sheet(qobject_cast<Sheet*>(sv->get_sheet()))
+        , m_scrubbing(false)
 {
         m_sv = sv;
         m_playhead = m_sv->get_play_cursor();
@@ -41,9 +43,18 @@ PlayHeadMove::PlayHeadMove(SheetView* sv)
 
 int PlayHeadMove::finish_hold()
 {
+        // Scrubbing didn't move the transport, seek once now.
+        if (m_scrubbing) {
+                m_sheet->stop_scrub();
+                m_scrubbing = false;
+                if (m_session->is_transport_rolling()) {
+                        m_playhead->hide();
+                }
+                m_session->set_transport_pos(m_newTransportLocation);
+        }
 	// When SyncDuringDrag is true, don't seek in finish_hold()
 	// since that causes another audio glitch.
-        if (!(m_resync && m_session->is_transport_rolling())) {
+        else if (!(m_resync && m_session->is_transport_rolling())) {
 		// if the sheet is transporting, the seek action will cause 
 		// the playcursor to be moved to the correct location.
 		// Until then hide it, it will be shown again when the seek is finished!
@@ -64,6 +75,11 @@ int PlayHeadMove::begin_hold()
 	m_sv->start_shuttle(true, true);
         m_holdCursorSceneY = cpointer().scene_y();
 
+        // Scrub instead of seeking the Sheet on each movement
+        if (m_sheet) {
+                m_scrubbing = m_sheet->start_scrub(m_newTransportLocation);
+        }
+
         ClipsViewPort* port = m_sv->get_clips_viewport();
 	cpointer().setCursorPos(QPointF(m_playhead->scenePos().x(), cpointer().y()));
         int x = port->mapFromScene(m_playhead->scenePos()).x();
@@ -77,9 +93,15 @@ int PlayHeadMove::begin_hold()
 
 void PlayHeadMove::cancel_action()
 {
+        // The transport location wasn't changed while scrubbing
+        bool scrubbed = m_scrubbing;
+        if (m_scrubbing) {
+                m_sheet->stop_scrub();
+                m_scrubbing = false;
+        }
 	m_sv->start_shuttle(false);
         m_playhead->set_active(m_session->is_transport_rolling());
-	if (!m_resync) {
+	if (!m_resync || scrubbed) {
                 m_playhead->setPos(m_origXPos, 0);
 	}
 }
@@ -109,7 +131,9 @@ int PlayHeadMove::jog()
 
                 m_newTransportLocation = TimeRef(x * m_sv->timeref_scalefactor);
 
-                if (m_resync && m_session->is_transport_rolling()) {
+                if (m_scrubbing) {
+                        m_sheet->set_scrub_location(m_newTransportLocation);
+                } else if (m_resync && m_session->is_transport_rolling()) {
                         m_session->set_transport_pos(m_newTransportLocation);
 		}
 		
@@ -168,7 +192,11 @@ void PlayHeadMove::do_keyboard_move(TimeRef newLocation, bool centerInView)
 
         m_newTransportLocation = newLocation;
 
-        if (m_resync && m_session->is_transport_rolling()) {
+        if (m_scrubbing) {
+                m_sheet->set_scrub_location(m_newTransportLocation);
+        }
+
+        if (m_resync && m_session->is_transport_rolling() && !m_scrubbing) {
                 m_session->set_transport_pos(m_newTransportLocation);
         } else {
                 m_playhead->setPos(newLocation / m_sv->timeref_scalefactor, 0);
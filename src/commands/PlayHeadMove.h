@@ -26,6 +26,7 @@
 #include "defines.h"
 
 class TSession;
+class Sheet;
 class SheetView;
 class PlayHead;
 
@@ -48,8 +49,10 @@ public :
 private :
 	PlayHead*	m_playhead;
         TSession*	m_session;
+        Sheet*		m_sheet;
 	SheetView*	m_sv;
 	bool		m_resync;
+        bool		m_scrubbing;
 	int		m_origXPos;
 	int		m_newXPos;
 	int		m_newYPos;
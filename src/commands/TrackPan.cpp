@@ -99,6 +99,22 @@ int TrackPan::undo_action()
         return 1;
 }
 
+/**
+ * Merges a following pan change of the same Track into this one.
+ */
+bool TrackPan::mergeWith(const QUndoCommand* command)
+{
+	const TrackPan* next = static_cast<const TrackPan*>(command);
+	
+	if (next->m_track != m_track || !is_merge_interval(next)) {
+		return false;
+	}
+	
+	m_newPan = next->m_newPan;
+	
+	return true;
+}
+
 void TrackPan::cancel_action()
 {
 	finish_hold();
@@ -46,6 +46,9 @@ public :
 
         int jog();
 
+        int id() const {return TrackPanMergeId;}
+        bool mergeWith(const QUndoCommand* command);
+
 	void set_cursor_shape(int useX, int useY);
 	bool restoreCursorPosition() const {return true;}
 	
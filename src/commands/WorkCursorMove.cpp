@@ -182,7 +182,6 @@ void WorkCursorMove::toggle_snap_on_off(bool autorepeat)
 
 void WorkCursorMove::browse_to_next_marker()
 {
-	QList<Marker*> markers = m_session->get_timeline()->get_markers();
 	QList<ContextItem*> contexts = cpointer().get_active_context_items();
 	MarkerView* view;
 	foreach(ContextItem* item, contexts) {
@@ -193,21 +192,12 @@ void WorkCursorMove::browse_to_next_marker()
 		}
 	}
 
-	Marker* next = 0;
-	foreach(Marker* marker, markers) {
-		if (marker->get_when() > m_session->get_work_location()) {
-			next = marker;
-			break;
-		}
-	}
+	Marker* next = m_session->get_timeline()->get_next_marker(m_session->get_work_location());
 
 	if (next) {
-		QList<MarkerView*> markerViews = m_sv->get_timeline_viewport()->get_timeline_view()->get_marker_views();
-		foreach(MarkerView* view, markerViews) {
-			if (view->get_marker() == next) {
-				contexts.prepend(view);
-				break;
-			}
+		view = m_sv->get_timeline_viewport()->get_timeline_view()->get_marker_view(next);
+		if (view) {
+			contexts.prepend(view);
 		}
 		do_keyboard_move(next->get_when());
 	}
@@ -217,7 +207,6 @@ void WorkCursorMove::browse_to_next_marker()
 
 void WorkCursorMove::browse_to_previous_marker()
 {
-	QList<Marker*> markers = m_session->get_timeline()->get_markers();
 	QList<ContextItem*> contexts = cpointer().get_active_context_items();
 	MarkerView* view;
 	foreach(ContextItem* item, contexts) {
@@ -228,22 +217,12 @@ void WorkCursorMove::browse_to_previous_marker()
 		}
 	}
 
-	Marker* prev = 0;
-	for (int i=markers.size() - 1; i>= 0; --i) {
-		Marker* marker = markers.at(i);
-		if (marker->get_when() < m_session->get_work_location()) {
-			prev = marker;
-			break;
-		}
-	}
+	Marker* prev = m_session->get_timeline()->get_previous_marker(m_session->get_work_location());
 
 	if (prev) {
-		QList<MarkerView*> markerViews = m_sv->get_timeline_viewport()->get_timeline_view()->get_marker_views();
-		foreach(MarkerView* view, markerViews) {
-			if (view->get_marker() == prev) {
-				contexts.prepend(view);
-				break;
-			}
+		view = m_sv->get_timeline_viewport()->get_timeline_view()->get_marker_view(prev);
+		if (view) {
+			contexts.prepend(view);
 		}
 
 		do_keyboard_move(prev->get_when());
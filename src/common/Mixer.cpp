@@ -23,11 +23,15 @@
 #include "Mixer.h"
 #include "defines.h"
 #include <cmath> // used for fabs
+#include <cstring> // used for memcpy
 
 Mixer::compute_peak_t			Mixer::compute_peak 		= 0;
 Mixer::apply_gain_to_buffer_t		Mixer::apply_gain_to_buffer 	= 0;
 Mixer::mix_buffers_with_gain_t		Mixer::mix_buffers_with_gain 	= 0;
 Mixer::mix_buffers_no_gain_t		Mixer::mix_buffers_no_gain 	= 0;
+Mixer::interleave_buffers_t		Mixer::interleave_buffers	= 0;
+Mixer::apply_gain_ramp_to_buffer_t	Mixer::apply_gain_ramp_to_buffer	= 0;
+Mixer::mix_buffers_with_gain_ramp_t	Mixer::mix_buffers_with_gain_ramp	= 0;
 
 
 
@@ -61,6 +65,111 @@ void default_mix_buffers_no_gain (audio_sample_t* dst, const audio_sample_t* src
 }
 
 
+// The gain of the last frame is endGain, the next buffer continues from there
+void default_apply_gain_ramp_to_buffer (audio_sample_t* buf, nframes_t nframes, float startGain, float endGain)
+{
+        float step = (endGain - startGain) / nframes;
+
+        for (nframes_t i = 0; i < nframes; i++) {
+                buf[i] *= startGain + step * (i + 1);
+        }
+}
+
+void default_mix_buffers_with_gain_ramp (audio_sample_t* dst, const audio_sample_t* src, nframes_t nframes, float startGain, float endGain)
+{
+        float step = (endGain - startGain) / nframes;
+
+        for (nframes_t i = 0; i < nframes; i++) {
+                dst[i] += src[i] * (startGain + step * (i + 1));
+        }
+}
+
+
+void default_interleave_buffers (audio_sample_t* dst, audio_sample_t** src, int channels, nframes_t nframes)
+{
+        if (channels == 1) {
+                memcpy(dst, src[0], nframes * sizeof(audio_sample_t));
+                return;
+        }
+
+        for (int chan = 0; chan < channels; ++chan) {
+                const audio_sample_t* buf = src[chan];
+                audio_sample_t* out = dst + chan;
+                for (nframes_t i = 0; i < nframes; ++i) {
+                        out[i * channels] = buf[i];
+                }
+        }
+}
+
+
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (USE_XMMINTRIN)
+#include <xmmintrin.h>
+
+// Stereo is by far the most common case, interleave 4 frames at once
+// with the SSE unpack instructions, fall back to the default for others.
+void x86_sse_interleave_buffers (audio_sample_t* dst, audio_sample_t** src, int channels, nframes_t nframes)
+{
+        if (channels != 2) {
+                default_interleave_buffers(dst, src, channels, nframes);
+                return;
+        }
+
+        const audio_sample_t* left = src[0];
+        const audio_sample_t* right = src[1];
+        nframes_t i = 0;
+
+        for (; i + 4 <= nframes; i += 4) {
+                __m128 l = _mm_loadu_ps(left + i);
+                __m128 r = _mm_loadu_ps(right + i);
+                _mm_storeu_ps(dst + 2 * i, _mm_unpacklo_ps(l, r));
+                _mm_storeu_ps(dst + 2 * i + 4, _mm_unpackhi_ps(l, r));
+        }
+
+        for (; i < nframes; ++i) {
+                dst[2 * i] = left[i];
+                dst[2 * i + 1] = right[i];
+        }
+}
+
+// Keep the gains of 4 frames in one register, and advance them by 4 steps at once.
+void x86_sse_apply_gain_ramp_to_buffer (audio_sample_t* buf, nframes_t nframes, float startGain, float endGain)
+{
+        float step = (endGain - startGain) / nframes;
+        __m128 gain = _mm_add_ps(_mm_set1_ps(startGain), _mm_mul_ps(_mm_set1_ps(step), _mm_set_ps(4.0f, 3.0f, 2.0f, 1.0f)));
+        __m128 increment = _mm_set1_ps(4.0f * step);
+        nframes_t i = 0;
+
+        for (; i + 4 <= nframes; i += 4) {
+                _mm_storeu_ps(buf + i, _mm_mul_ps(_mm_loadu_ps(buf + i), gain));
+                gain = _mm_add_ps(gain, increment);
+        }
+
+        for (; i < nframes; ++i) {
+                buf[i] *= startGain + step * (i + 1);
+        }
+}
+
+void x86_sse_mix_buffers_with_gain_ramp (audio_sample_t* dst, const audio_sample_t* src, nframes_t nframes, float startGain, float endGain)
+{
+        float step = (endGain - startGain) / nframes;
+        __m128 gain = _mm_add_ps(_mm_set1_ps(startGain), _mm_mul_ps(_mm_set1_ps(step), _mm_set_ps(4.0f, 3.0f, 2.0f, 1.0f)));
+        __m128 increment = _mm_set1_ps(4.0f * step);
+        nframes_t i = 0;
+
+        for (; i + 4 <= nframes; i += 4) {
+                __m128 mixed = _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), gain));
+                _mm_storeu_ps(dst + i, mixed);
+                gain = _mm_add_ps(gain, increment);
+        }
+
+        for (; i < nframes; ++i) {
+                dst[i] += src[i] * (startGain + step * (i + 1));
+        }
+}
+
+#endif
+
+
 #if defined (__APPLE__) && defined (BUILD_VECLIB_OPTIMIZATIONS)
 #include <Accelerate/Accelerate.h>
 
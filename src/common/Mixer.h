@@ -64,6 +64,9 @@ float default_compute_peak			(const audio_sample_t*  buf, nframes_t nsamples, fl
 void  default_apply_gain_to_buffer		(audio_sample_t*  buf, nframes_t nframes, float gain);
 void  default_mix_buffers_with_gain		(audio_sample_t*  dst, const audio_sample_t*  src, nframes_t nframes, float gain);
 void  default_mix_buffers_no_gain		(audio_sample_t*  dst, const audio_sample_t*  src, nframes_t nframes);
+void  default_interleave_buffers		(audio_sample_t*  dst, audio_sample_t** src, int channels, nframes_t nframes);
+void  default_apply_gain_ramp_to_buffer		(audio_sample_t*  buf, nframes_t nframes, float startGain, float endGain);
+void  default_mix_buffers_with_gain_ramp	(audio_sample_t*  dst, const audio_sample_t*  src, nframes_t nframes, float startGain, float endGain);
 
 
 #if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (SSE_OPTIMIZATIONS)
@@ -78,6 +81,14 @@ extern "C"
 }
 #endif
 
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (USE_XMMINTRIN)
+
+void  x86_sse_interleave_buffers		(audio_sample_t*  dst, audio_sample_t** src, int channels, nframes_t nframes);
+void  x86_sse_apply_gain_ramp_to_buffer		(audio_sample_t*  buf, nframes_t nframes, float startGain, float endGain);
+void  x86_sse_mix_buffers_with_gain_ramp	(audio_sample_t*  dst, const audio_sample_t*  src, nframes_t nframes, float startGain, float endGain);
+
+#endif
+
 #if defined (__APPLE__)  && defined (BUILD_VECLIB_OPTIMIZATIONS)
 
 float veclib_compute_peak              (const audio_sample_t* buf, nframes_t nsamples, float current);
@@ -94,11 +105,37 @@ public:
         typedef void  (*apply_gain_to_buffer_t)		(audio_sample_t* , nframes_t, float);
         typedef void  (*mix_buffers_with_gain_t)	(audio_sample_t* , const audio_sample_t* , nframes_t, float);
         typedef void  (*mix_buffers_no_gain_t)		(audio_sample_t* , const audio_sample_t* , nframes_t);
+        typedef void  (*interleave_buffers_t)		(audio_sample_t* , audio_sample_t** , int, nframes_t);
+        typedef void  (*apply_gain_ramp_to_buffer_t)	(audio_sample_t* , nframes_t, float, float);
+        typedef void  (*mix_buffers_with_gain_ramp_t)	(audio_sample_t* , const audio_sample_t* , nframes_t, float, float);
 
         static compute_peak_t		compute_peak;
         static apply_gain_to_buffer_t	apply_gain_to_buffer;
         static mix_buffers_with_gain_t	mix_buffers_with_gain;
         static mix_buffers_no_gain_t	mix_buffers_no_gain;
+        static interleave_buffers_t	interleave_buffers;
+        static apply_gain_ramp_to_buffer_t	apply_gain_ramp_to_buffer;
+        static mix_buffers_with_gain_ramp_t	mix_buffers_with_gain_ramp;
+
+        // Apply or mix with a gain that moves linearly from startGain to endGain
+        // over the buffer, the ramp is only computed if the gain changes.
+        static void apply_gain(audio_sample_t* buf, nframes_t nframes, float startGain, float endGain) {
+                if (startGain == endGain) {
+                        apply_gain_to_buffer(buf, nframes, endGain);
+                } else {
+                        apply_gain_ramp_to_buffer(buf, nframes, startGain, endGain);
+                }
+        }
+
+        static void mix_with_gain(audio_sample_t* dst, const audio_sample_t* src, nframes_t nframes, float startGain, float endGain) {
+                if (startGain != endGain) {
+                        mix_buffers_with_gain_ramp(dst, src, nframes, startGain, endGain);
+                } else if (endGain == 1.0f) {
+                        mix_buffers_no_gain(dst, src, nframes);
+                } else {
+                        mix_buffers_with_gain(dst, src, nframes, endGain);
+                }
+        }
 };
 
 #endif
@@ -0,0 +1,88 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TENGINE_PARAMETER_H
+#define TENGINE_PARAMETER_H
+
+#include <QAtomicInt>
+
+/**
+ * \class TEngineParameter
+ * \brief A gain or pan value set from the GUI thread and ramped to by the audio thread
+ *
+ * The GUI thread only sets the target, which is published atomically, a newer
+ * target replaces one the audio thread didn't pick up yet. At the start of each
+ * process cycle the audio thread calls begin_cycle(), and applies the value as a
+ * linear ramp from get_start() to get_end() over the block. A fader move so costs
+ * one ramp per block, and doesn't produce the zipper noise of a gain jump.
+ *
+ * Threads that render outside the process cycle (render ahead, export workers,
+ * scrubbing) use get_target() as a constant value.
+ */
+
+class TEngineParameter
+{
+public:
+        TEngineParameter(float value=0.0f)
+                : m_target(to_int(value))
+                , m_start(value)
+                , m_end(value)
+        {}
+
+        // GUI thread
+        void set_target(float value) {m_target.fetchAndStoreRelease(to_int(value));}
+        float get_target() const {return to_float(m_target.fetchAndAddAcquire(0));}
+
+        // Jump to the target without a ramp, only when the audio thread doesn't
+        // process the parameter, e.g. when restoring state.
+        void reset() {m_start = m_end = get_target();}
+
+        // Audio thread, once per process cycle
+        void begin_cycle() {
+                m_start = m_end;
+                m_end = get_target();
+        }
+
+        float get_start() const {return m_start;}
+        float get_end() const {return m_end;}
+        bool is_ramping() const {return m_start != m_end;}
+
+private:
+        mutable QAtomicInt      m_target;
+        float                   m_start;
+        float                   m_end;
+
+        static int to_int(float value) {
+                union {float f; int i;} u;
+                u.f = value;
+                return u.i;
+        }
+
+        static float to_float(int value) {
+                union {float f; int i;} u;
+                u.i = value;
+                return u.f;
+        }
+};
+
+#endif
+
+//eof
@@ -0,0 +1,60 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TMultiChannelRingBuffer.h"
+
+#include <cerrno>
+
+#ifdef USE_MLOCK
+#include <sys/mman.h>
+#endif /* USE_MLOCK */
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+/**
+ * Locks \a size bytes of ring buffer storage at \a data, when build with USE_MLOCK.
+ * A failure isn't fatal, the buffer can page out then.
+ */
+void tmcrb_lock_memory(void* data, size_t size)
+{
+#ifdef USE_MLOCK
+        if (mlock(data, size)) {
+                PWARN("TMultiChannelRingBuffer: unable to lock %d bytes of memory (%s)", int(size), strerror(errno));
+        }
+#else
+        Q_UNUSED(data);
+        Q_UNUSED(size);
+#endif /* USE_MLOCK */
+}
+
+void tmcrb_unlock_memory(void* data, size_t size)
+{
+#ifdef USE_MLOCK
+        munlock(data, size);
+#else
+        Q_UNUSED(data);
+        Q_UNUSED(size);
+#endif /* USE_MLOCK */
+}
+
+//eof
@@ -0,0 +1,258 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TMULTI_CHANNEL_RING_BUFFER_H
+#define TMULTI_CHANNEL_RING_BUFFER_H
+
+#include <QAtomicInt>
+#include <cstring>
+
+#include "defines.h"
+
+// Not templated, so they can report a failure with the debugger macros
+void tmcrb_lock_memory(void* data, size_t size);
+void tmcrb_unlock_memory(void* data, size_t size);
+
+/**
+ * \class TMultiChannelRingBuffer
+ * \brief Single producer, single consumer ringbuffer holding N channels in lock step
+ *
+ * All channels share one read and one write index, so reading or writing all channels
+ * touches one pair of indices, and the channels can never get out of sync like separate
+ * RingBufferNPT's per channel can.
+ *
+ * The storage of each channel is rounded up to a power of two, so the free running indices
+ * can be masked instead of using a modulo. Of that storage, exactly the requested size
+ * can be used, so callers relying on the size (like the DiskIO write buffer) are unaffected.
+ *
+ * Each index lives in it's own cache line, so the producer and consumer don't invalidate
+ * each others cache line on each update.
+ * The producer publishes the write index with release semantics after writing the data, the
+ * consumer loads it with acquire semantics before reading, and the other way around for the
+ * read index.
+ *
+ * The data of each channel is stored in one contiguous (planar) block.
+ *
+ * reset() is not thread safe.
+ */
+
+template<class T>
+class TMultiChannelRingBuffer
+{
+public:
+        TMultiChannelRingBuffer(int channels, size_t size);
+        ~TMultiChannelRingBuffer();
+
+        struct rw_vector {
+                T *buf[2];
+                size_t len[2];
+        };
+
+        void reset() {
+                m_writeIndex.value.fetchAndStoreRelease(0);
+                m_readIndex.value.fetchAndStoreRelease(0);
+        }
+
+        // Producer
+        size_t write_space() const {
+                return m_capacity - (uint(m_writeIndex.value) - load_read_index());
+        }
+        size_t write(T* const* src, size_t cnt);
+        void get_write_vectors(rw_vector* vectors);
+        void increment_write_ptr(size_t cnt) {
+                m_writeIndex.value.fetchAndStoreRelease(int(uint(m_writeIndex.value) + cnt));
+        }
+
+        // Consumer
+        size_t read_space() const {
+                return load_write_index() - uint(m_readIndex.value);
+        }
+        size_t read(T* const* dest, size_t cnt);
+        void get_read_vectors(rw_vector* vectors);
+        void increment_read_ptr(size_t cnt) {
+                m_readIndex.value.fetchAndStoreRelease(int(uint(m_readIndex.value) + cnt));
+        }
+
+        int get_channel_count() const {return m_channelCount;}
+        size_t bufsize() const {return m_capacity;}
+        size_t storage_size() const {return m_size * m_channelCount * sizeof(T);}
+
+private:
+        // Keep each index in it's own cache line
+        enum {CACHE_LINE_SIZE = 64};
+        struct PaddedIndex {
+                QAtomicInt value;
+                char pad[CACHE_LINE_SIZE - sizeof(QAtomicInt)];
+        };
+
+        T*              m_data;
+        T**             m_channels;
+        size_t          m_capacity;
+        size_t          m_size;
+        size_t          m_mask;
+        int             m_channelCount;
+
+        char            m_pad[CACHE_LINE_SIZE];
+        PaddedIndex     m_writeIndex;
+        PaddedIndex     m_readIndex;
+
+        uint load_write_index() const {return uint(const_cast<QAtomicInt&>(m_writeIndex.value).fetchAndAddAcquire(0));}
+        uint load_read_index() const {return uint(const_cast<QAtomicInt&>(m_readIndex.value).fetchAndAddAcquire(0));}
+};
+
+
+template<class T>
+TMultiChannelRingBuffer<T>::TMultiChannelRingBuffer(int channels, size_t size)
+        : m_capacity(size)
+        , m_channelCount(channels)
+{
+        m_size = 1;
+        while (m_size < size) {
+                m_size <<= 1;
+        }
+        m_mask = m_size - 1;
+
+        m_data = new T[m_size * m_channelCount];
+        m_channels = new T*[m_channelCount];
+        for (int chan=0; chan<m_channelCount; ++chan) {
+                m_channels[chan] = m_data + chan * m_size;
+        }
+
+        tmcrb_lock_memory(m_data, storage_size());
+
+        reset();
+}
+
+template<class T>
+TMultiChannelRingBuffer<T>::~TMultiChannelRingBuffer()
+{
+        tmcrb_unlock_memory(m_data, storage_size());
+        delete [] m_channels;
+        delete [] m_data;
+}
+
+/**
+ * Writes \a cnt frames from \a src, one pointer for each channel, into all channels.
+ *
+ * @return The number of frames written, which is less then \a cnt when there
+ *	wasn't enough write space.
+ */
+template<class T> size_t
+TMultiChannelRingBuffer<T>::write(T* const* src, size_t cnt)
+{
+        uint w = uint(m_writeIndex.value);
+        size_t toWrite = qMin(cnt, size_t(m_capacity - (w - load_read_index())));
+
+        if (toWrite == 0) {
+                return 0;
+        }
+
+        size_t offset = w & m_mask;
+        size_t n1 = qMin(toWrite, m_size - offset);
+        size_t n2 = toWrite - n1;
+
+        for (int chan=0; chan<m_channelCount; ++chan) {
+                memcpy(m_channels[chan] + offset, src[chan], n1 * sizeof(T));
+                if (n2) {
+                        memcpy(m_channels[chan], src[chan] + n1, n2 * sizeof(T));
+                }
+        }
+
+        m_writeIndex.value.fetchAndStoreRelease(int(w + toWrite));
+
+        return toWrite;
+}
+
+/**
+ * Reads \a cnt frames of all channels into \a dest, one pointer for each channel.
+ *
+ * @return The number of frames read, which is less then \a cnt when there
+ *	wasn't enough data available.
+ */
+template<class T> size_t
+TMultiChannelRingBuffer<T>::read(T* const* dest, size_t cnt)
+{
+        uint r = uint(m_readIndex.value);
+        size_t toRead = qMin(cnt, size_t(load_write_index() - r));
+
+        if (toRead == 0) {
+                return 0;
+        }
+
+        size_t offset = r & m_mask;
+        size_t n1 = qMin(toRead, m_size - offset);
+        size_t n2 = toRead - n1;
+
+        for (int chan=0; chan<m_channelCount; ++chan) {
+                memcpy(dest[chan], m_channels[chan] + offset, n1 * sizeof(T));
+                if (n2) {
+                        memcpy(dest[chan] + n1, m_channels[chan], n2 * sizeof(T));
+                }
+        }
+
+        m_readIndex.value.fetchAndStoreRelease(int(r + toRead));
+
+        return toRead;
+}
+
+/**
+ * Fills \a vectors, one for each channel, with the readable data, which
+ * consists of at most 2 parts. All vectors have the same length.
+ */
+template<class T> void
+TMultiChannelRingBuffer<T>::get_read_vectors(rw_vector* vectors)
+{
+        uint r = uint(m_readIndex.value);
+        size_t available = load_write_index() - r;
+        size_t offset = r & m_mask;
+        size_t n1 = qMin(available, m_size - offset);
+
+        for (int chan=0; chan<m_channelCount; ++chan) {
+                vectors[chan].buf[0] = m_channels[chan] + offset;
+                vectors[chan].len[0] = n1;
+                vectors[chan].buf[1] = m_channels[chan];
+                vectors[chan].len[1] = available - n1;
+        }
+}
+
+/**
+ * Fills \a vectors, one for each channel, with the writable space, which
+ * consists of at most 2 parts. All vectors have the same length.
+ */
+template<class T> void
+TMultiChannelRingBuffer<T>::get_write_vectors(rw_vector* vectors)
+{
+        uint w = uint(m_writeIndex.value);
+        size_t space = m_capacity - (w - load_read_index());
+        size_t offset = w & m_mask;
+        size_t n1 = qMin(space, m_size - offset);
+
+        for (int chan=0; chan<m_channelCount; ++chan) {
+                vectors[chan].buf[0] = m_channels[chan] + offset;
+                vectors[chan].len[0] = n1;
+                vectors[chan].buf[1] = m_channels[chan];
+                vectors[chan].len[1] = space - n1;
+        }
+}
+
+#endif
+
+//eof
@@ -0,0 +1,418 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TPolyphaseResampler.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <cmath>
+#include <cstring>
+
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (USE_XMMINTRIN) && defined (__SSE__)
+#include <xmmintrin.h>
+#define POLYPHASE_SSE
+#endif
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+/**
+ * \class TPolyphaseResampler
+ * \brief Fixed ratio resampler, using precomputed polyphase filter tables
+ *
+ * Converting between two sample rates with a rational ratio L/M (e.g. 160/147 for
+ * 44.1 to 48 kHz) needs only L different sets of filter taps (phases). These are
+ * computed once by TPolyphaseFilter, and shared by all resamplers with the same
+ * ratio and quality, so resampling a frame costs one dot product per channel,
+ * instead of libsamplerate's per sample filter interpolation.
+ *
+ * The filter is a Kaiser windowed sinc, the quality tiers differ in the number
+ * of taps, the cutoff frequency and the Kaiser beta. The cutoff is the -6 dB point,
+ * the transition band is centered on it. Measured for 44.1 to 48 kHz, relative to
+ * the lowest nyquist frequency:
+ *
+ * - Fast:   16 taps, cutoff 85%, -0.1 dB at 65%,   -63 dB stop band from 110%
+ * - Medium: 32 taps, cutoff 91%, -0.1 dB at 79%,   -81 dB stop band from 107%
+ * - High:   64 taps, cutoff 95%, -0.1 dB at 88.5%, -94 dB stop band from 105%
+ * - Best:  128 taps, cutoff 97%, -0.1 dB at 93.5%, -108 dB stop band from 102.5%
+ *
+ * So all tiers let frequencies just above the nyquist frequency alias with 25 to
+ * 30 dB attenuation only. libsamplerate's best converter has a wider pass band, it's
+ * not replaced by the Best tier, see ResampleAudioReader. The benchmark mode
+ * (see TBenchmark) compares the tiers with libsamplerate.
+ *
+ * The filter delay is compensated, output frame n corresponds to input frame n * M / L,
+ * like libsamplerate does.
+ *
+ * Input is copied into a per channel history and always consumed completely.
+ * The dot products use SSE when available.
+ *
+ * Only ratios with up to MAX_PHASES phases and at most MAX_DOWN_FACTOR times
+ * down sampling are supported, see is_supported(). Other ratios are left to libsamplerate.
+ */
+
+static const int MAX_PHASES = 1024;
+static const int MAX_DOWN_FACTOR = 8;
+
+struct QualitySpec {
+        int     taps;
+        double  passband;
+        double  beta;
+};
+
+static const QualitySpec QUALITY_SPECS[] = {
+        {16,  0.85, 6.0},
+        {32,  0.91, 8.0},
+        {64,  0.95, 9.5},
+        {128, 0.97, 11.0}
+};
+
+static QMutex filtersMutex;
+static QHash<qint64, TPolyphaseFilter*> filters;
+
+static int gcd(int a, int b)
+{
+        while (b) {
+                int t = a % b;
+                a = b;
+                b = t;
+        }
+        return a;
+}
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+static double bessel_i0(double x)
+{
+        double sum = 1.0;
+        double term = 1.0;
+        double halfx = x / 2.0;
+
+        for (int k=1; k<50; ++k) {
+                term *= (halfx / k) * (halfx / k);
+                sum += term;
+                if (term < sum * 1e-12) {
+                        break;
+                }
+        }
+
+        return sum;
+}
+
+static inline float dot_product(const float* taps, const float* data, int count)
+{
+#if defined (POLYPHASE_SSE)
+        // taps are 16 byte aligned, and count is a multiple of 4
+        __m128 sum = _mm_setzero_ps();
+        for (int i=0; i<count; i+=4) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(taps + i), _mm_loadu_ps(data + i)));
+        }
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        float result;
+        _mm_store_ss(&result, sum);
+        return result;
+#else
+        float sum = 0.0f;
+        for (int i=0; i<count; ++i) {
+                sum += taps[i] * data[i];
+        }
+        return sum;
+#endif
+}
+
+
+bool TPolyphaseFilter::is_supported(int inputRate, int outputRate)
+{
+        if (inputRate <= 0 || outputRate <= 0) {
+                return false;
+        }
+
+        int divisor = gcd(inputRate, outputRate);
+        int up = outputRate / divisor;
+        int down = inputRate / divisor;
+
+        return up <= MAX_PHASES && down <= MAX_DOWN_FACTOR * up;
+}
+
+/**
+ * Returns the (shared) filter to convert from \a inputRate to \a outputRate, which must
+ * be supported (see is_supported()). Release it with release() when done.
+ */
+TPolyphaseFilter* TPolyphaseFilter::acquire(int inputRate, int outputRate, Quality quality)
+{
+        Q_ASSERT(is_supported(inputRate, outputRate));
+
+        int divisor = gcd(inputRate, outputRate);
+        int up = outputRate / divisor;
+        int down = inputRate / divisor;
+        qint64 key = (qint64(quality) << 40) | (qint64(up) << 20) | qint64(down);
+
+        QMutexLocker locker(&filtersMutex);
+
+        TPolyphaseFilter* filter = filters.value(key);
+        if (!filter) {
+                filter = new TPolyphaseFilter(up, down, quality);
+                filters.insert(key, filter);
+        }
+
+        filter->m_refCount++;
+
+        return filter;
+}
+
+void TPolyphaseFilter::release(TPolyphaseFilter* filter)
+{
+        QMutexLocker locker(&filtersMutex);
+
+        if (--filter->m_refCount > 0) {
+                return;
+        }
+
+        filters.remove(filters.key(filter));
+        delete filter;
+}
+
+TPolyphaseFilter::TPolyphaseFilter(int up, int down, Quality quality)
+        : m_up(up)
+        , m_down(down)
+        , m_refCount(0)
+        , m_quality(quality)
+{
+        const QualitySpec& spec = QUALITY_SPECS[quality];
+        m_taps = spec.taps;
+
+        // The prototype low pass filter runs at up * input rate, it's cutoff is the
+        // lowest of the input and output nyquist frequency, in cycles per sample.
+        int length = m_up * m_taps;
+        double center = (m_taps / 2) * m_up;
+        double cutoff = spec.passband * 0.5 * qMin(1.0, double(m_up) / m_down) / m_up;
+        double i0beta = bessel_i0(spec.beta);
+
+        double* prototype = new double[length];
+        double sum = 0.0;
+
+        for (int j=0; j<length; ++j) {
+                double x = j - center;
+                double sinc = (x == 0.0) ? 1.0 : sin(2.0 * M_PI * cutoff * x) / (2.0 * M_PI * cutoff * x);
+                double w = x / (length / 2.0);
+                double window = bessel_i0(spec.beta * sqrt(qMax(0.0, 1.0 - w * w))) / i0beta;
+                prototype[j] = 2.0 * cutoff * sinc * window;
+                sum += prototype[j];
+        }
+
+        // Each phase has a DC gain of (about) 1
+        double gain = m_up / sum;
+
+        // 16 byte aligned for the SSE loads
+        m_coefficientsBuffer = new float[length + 4];
+        m_coefficients = (float*)(((size_t)m_coefficientsBuffer + 15) & ~(size_t)15);
+
+        // Phase p applies tap p + k * up to input sample top - k, store the taps reversed,
+        // so they line up with the input samples top - taps + 1 ... top
+        for (int p=0; p<m_up; ++p) {
+                for (int k=0; k<m_taps; ++k) {
+                        m_coefficients[p * m_taps + (m_taps - 1 - k)] = float(prototype[p + k * m_up] * gain);
+                }
+        }
+
+        delete [] prototype;
+
+        PMESG("TPolyphaseFilter: created %d/%d filter with %d phases of %d taps", m_up, m_down, m_up, m_taps);
+}
+
+TPolyphaseFilter::~TPolyphaseFilter()
+{
+        delete [] m_coefficientsBuffer;
+}
+
+
+TPolyphaseResampler::TPolyphaseResampler(int channels, int inputRate, int outputRate, TPolyphaseFilter::Quality quality)
+        : m_historyCapacity(0)
+        , m_channels(channels)
+        , m_inputRate(inputRate)
+        , m_outputRate(outputRate)
+{
+        m_filter = TPolyphaseFilter::acquire(inputRate, outputRate, quality);
+        m_delay = m_filter->get_tap_count() / 2;
+
+        m_history = new audio_sample_t*[m_channels];
+        for (int chan=0; chan<m_channels; ++chan) {
+                m_history[chan] = 0;
+        }
+
+        reserve_history(4096);
+        reset();
+}
+
+TPolyphaseResampler::~TPolyphaseResampler()
+{
+        for (int chan=0; chan<m_channels; ++chan) {
+                delete [] m_history[chan];
+        }
+        delete [] m_history;
+
+        TPolyphaseFilter::release(m_filter);
+}
+
+/**
+ * Clears the history, use after a seek.
+ */
+void TPolyphaseResampler::reset()
+{
+        int taps = m_filter->get_tap_count();
+
+        // The history starts with taps - 1 zeros before the first input frame
+        for (int chan=0; chan<m_channels; ++chan) {
+                memset(m_history[chan], 0, (taps - 1) * sizeof(audio_sample_t));
+        }
+
+        m_historyFill = taps - 1;
+        m_historyStart = -(taps - 1);
+        m_inputCount = 0;
+        m_inputPos = 0;
+        m_phase = 0;
+}
+
+bool TPolyphaseResampler::matches(int inputRate, int outputRate, TPolyphaseFilter::Quality quality) const
+{
+        return inputRate == m_inputRate && outputRate == m_outputRate && quality == m_filter->get_quality();
+}
+
+/**
+ * Maps the libsamplerate converter types as used by the resample quality
+ * setting (SRC_SINC_BEST_QUALITY ... SRC_LINEAR) to a quality tier.
+ * SRC_SINC_BEST_QUALITY maps to Best for comparison only, playback keeps
+ * using libsamplerate for it.
+ */
+TPolyphaseFilter::Quality TPolyphaseResampler::quality_for_converter_type(int converterType)
+{
+        switch (converterType) {
+                case 0: return TPolyphaseFilter::Best;
+                case 1: return TPolyphaseFilter::High;
+                case 2: return TPolyphaseFilter::Medium;
+                default: return TPolyphaseFilter::Fast;
+        }
+}
+
+void TPolyphaseResampler::reserve_history(nframes_t frames)
+{
+        if (frames <= m_historyCapacity) {
+                return;
+        }
+
+        for (int chan=0; chan<m_channels; ++chan) {
+                audio_sample_t* history = new audio_sample_t[frames];
+                if (m_history[chan]) {
+                        memcpy(history, m_history[chan], m_historyFill * sizeof(audio_sample_t));
+                        delete [] m_history[chan];
+                }
+                m_history[chan] = history;
+        }
+
+        m_historyCapacity = frames;
+}
+
+/**
+ * Converts \a inputFrames of \a input into at most \a outputFrames of \a output,
+ * one buffer per channel for both.
+ *
+ * @param endOfInput If true, the input is padded with silence to produce
+ *      the last output frames.
+ * @param inputUsed Is set to the number of input frames consumed, which
+ *      is always \a inputFrames.
+ * @return The number of output frames generated.
+ */
+nframes_t TPolyphaseResampler::process(
+        audio_sample_t** input,
+        nframes_t inputFrames,
+        audio_sample_t** output,
+        nframes_t outputFrames,
+        bool endOfInput,
+        nframes_t& inputUsed)
+{
+        int taps = m_filter->get_tap_count();
+        int up = m_filter->get_up_factor();
+        int down = m_filter->get_down_factor();
+
+        if (endOfInput) {
+                reserve_history(m_historyFill + inputFrames + m_delay);
+        } else {
+                reserve_history(m_historyFill + inputFrames);
+        }
+
+        for (int chan=0; chan<m_channels; ++chan) {
+                memcpy(m_history[chan] + m_historyFill, input[chan], inputFrames * sizeof(audio_sample_t));
+        }
+        m_historyFill += inputFrames;
+        m_inputCount += inputFrames;
+        inputUsed = inputFrames;
+
+        qint64 available = m_historyStart + m_historyFill;
+
+        if (endOfInput) {
+                // Silence after the last frame, so the filter's look ahead reaches it
+                for (int chan=0; chan<m_channels; ++chan) {
+                        memset(m_history[chan] + m_historyFill, 0, m_delay * sizeof(audio_sample_t));
+                }
+                available += m_delay;
+        }
+
+        nframes_t generated = 0;
+
+        while (generated < outputFrames) {
+                qint64 top = m_inputPos + m_delay;
+
+                if (top >= available || (endOfInput && m_inputPos >= m_inputCount)) {
+                        break;
+                }
+
+                const float* coefficients = m_filter->get_phase(m_phase);
+                nframes_t offset = nframes_t(top - taps + 1 - m_historyStart);
+
+                for (int chan=0; chan<m_channels; ++chan) {
+                        output[chan][generated] = dot_product(coefficients, m_history[chan] + offset, taps);
+                }
+
+                ++generated;
+
+                m_phase += down;
+                m_inputPos += m_phase / up;
+                m_phase %= up;
+        }
+
+        // Keep the frames the next output frame needs
+        qint64 keepFrom = m_inputPos + m_delay - taps + 1;
+        nframes_t consumed = nframes_t(qBound(qint64(0), keepFrom - m_historyStart, qint64(m_historyFill)));
+
+        if (consumed) {
+                m_historyFill -= consumed;
+                m_historyStart += consumed;
+                for (int chan=0; chan<m_channels; ++chan) {
+                        memmove(m_history[chan], m_history[chan] + consumed, m_historyFill * sizeof(audio_sample_t));
+                }
+        }
+
+        return generated;
+}
+
+//eof
@@ -0,0 +1,100 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TPOLYPHASE_RESAMPLER_H
+#define TPOLYPHASE_RESAMPLER_H
+
+#include "defines.h"
+
+class TPolyphaseFilter
+{
+public:
+        enum Quality {
+                Fast,
+                Medium,
+                High,
+                Best
+        };
+
+        static TPolyphaseFilter* acquire(int inputRate, int outputRate, Quality quality);
+        static void release(TPolyphaseFilter* filter);
+        static bool is_supported(int inputRate, int outputRate);
+
+        int get_up_factor() const {return m_up;}
+        int get_down_factor() const {return m_down;}
+        int get_tap_count() const {return m_taps;}
+        Quality get_quality() const {return m_quality;}
+
+        // The taps of a phase, in the order of the input samples they are applied to
+        const float* get_phase(int phase) const {return m_coefficients + phase * m_taps;}
+
+private:
+        TPolyphaseFilter(int up, int down, Quality quality);
+        ~TPolyphaseFilter();
+
+        float*  m_coefficientsBuffer;
+        float*  m_coefficients;
+        int     m_up;
+        int     m_down;
+        int     m_taps;
+        int     m_refCount;
+        Quality m_quality;
+};
+
+
+class TPolyphaseResampler
+{
+public:
+        TPolyphaseResampler(int channels, int inputRate, int outputRate, TPolyphaseFilter::Quality quality);
+        ~TPolyphaseResampler();
+
+        void reset();
+        nframes_t process(audio_sample_t** input,
+                          nframes_t inputFrames,
+                          audio_sample_t** output,
+                          nframes_t outputFrames,
+                          bool endOfInput,
+                          nframes_t& inputUsed);
+
+        bool matches(int inputRate, int outputRate, TPolyphaseFilter::Quality quality) const;
+
+        static TPolyphaseFilter::Quality quality_for_converter_type(int converterType);
+
+private:
+        TPolyphaseFilter*       m_filter;
+        audio_sample_t**        m_history;
+        nframes_t               m_historyCapacity;
+        nframes_t               m_historyFill;
+        qint64                  m_historyStart;
+        qint64                  m_inputCount;
+        qint64                  m_inputPos;
+        int                     m_phase;
+        int                     m_delay;
+        int                     m_channels;
+        int                     m_inputRate;
+        int                     m_outputRate;
+
+        void reserve_history(nframes_t frames);
+};
+
+#endif
+
+//eof
@@ -0,0 +1,138 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TTIME_INDEX_H
+#define TTIME_INDEX_H
+
+#include <QVector>
+
+/**
+ * \class TTimeIndex
+ * \brief Items ordered by their position in time, for fast lookups by position
+ *
+ * The owner rebuilds the index with clear() and append() in position order
+ * whenever the positions change, which is rare compared to the lookups.
+ *
+ * lower_bound(), upper_bound() and range() are binary searches, O(log n).
+ * segment() keeps a finger, owned by the caller, at the last result. Evaluating
+ * at increasing positions mostly finds the segment at or right after the finger,
+ * which makes sequential access O(1) amortized, while a jump (seek, loop, another
+ * view) falls back to a binary search instead of a walk from the previous position.
+ *
+ * The index is implicitly shared like the Qt containers, a copy is cheap and
+ * stays valid while the owner rebuilds it's own.
+ */
+
+template<class Key, class T>
+class TTimeIndex
+{
+public:
+        struct Entry {
+                Key     key;
+                T       item;
+        };
+
+        void clear() {m_entries.clear();}
+        void reserve(int size) {m_entries.reserve(size);}
+
+        // Entries must be appended in order of their position
+        void append(const Key& key, const T& item) {
+                Entry entry;
+                entry.key = key;
+                entry.item = item;
+                m_entries.append(entry);
+        }
+
+        int size() const {return m_entries.size();}
+        bool isEmpty() const {return m_entries.isEmpty();}
+        const Key& key(int index) const {return m_entries.at(index).key;}
+        const T& at(int index) const {return m_entries.at(index).item;}
+        T& item(int index) {return m_entries[index].item;}
+
+        // Index of the first entry at or after key, size() if there is none
+        int lower_bound(const Key& key) const {
+                int first = 0;
+                int len = m_entries.size();
+                while (len > 0) {
+                        int half = len >> 1;
+                        if (m_entries.at(first + half).key < key) {
+                                first += half + 1;
+                                len -= half + 1;
+                        } else {
+                                len = half;
+                        }
+                }
+                return first;
+        }
+
+        // Index of the first entry after key, size() if there is none
+        int upper_bound(const Key& key) const {
+                int first = 0;
+                int len = m_entries.size();
+                while (len > 0) {
+                        int half = len >> 1;
+                        if (key < m_entries.at(first + half).key) {
+                                len = half;
+                        } else {
+                                first += half + 1;
+                                len -= half + 1;
+                        }
+                }
+                return first;
+        }
+
+        // The entries from start up to and including end are [first, last)
+        void range(const Key& start, const Key& end, int& first, int& last) const {
+                first = lower_bound(start);
+                last = upper_bound(end);
+                if (last < first) {
+                        last = first;
+                }
+        }
+
+        /**
+         * @return The index of the last entry at or before key, -1 if key is
+         *	before the first entry. Start with finger -1.
+         */
+        int segment(const Key& key, int& finger) const {
+                int count = m_entries.size();
+
+                if (finger >= 0 && finger < count && !(key < m_entries.at(finger).key)) {
+                        // Still in the same segment, or in one of the next two
+                        for (int i=0; i<3; ++i) {
+                                if (finger + 1 >= count || key < m_entries.at(finger + 1).key) {
+                                        return finger;
+                                }
+                                ++finger;
+                        }
+                }
+
+                finger = upper_bound(key) - 1;
+                return finger;
+        }
+
+private:
+        QVector<Entry>  m_entries;
+};
+
+#endif
+
+//eof
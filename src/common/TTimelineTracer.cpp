@@ -0,0 +1,255 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TTimelineTracer.h"
+
+#if defined (TIMELINE_TRACER)
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QVector>
+
+#include "TConfig.h"
+#include "Utils.h"
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+/**
+ * \class TTimelineTracer
+ * \brief Records what each thread was doing, and writes it to a trace file when an xrun happens
+ *
+ * Only build when configured with WANT_TIMELINE_TRACER, otherwise the TRACE_THREAD(),
+ * TRACE_SCOPE() and TRACE_XRUN() macros are empty.
+ *
+ * A thread calls TRACE_THREAD() once to get it's own ring of events, the events of threads
+ * that didn't are ignored. TRACE_SCOPE() records the begin and end of the enclosing scope,
+ * which costs a clock read and a few stores, no locks or allocations. The ring of a finished
+ * thread is kept and reused for the next thread that registers.
+ *
+ * When AudioDevice reports an xrun, the writer thread waits Tracer/SnapshotAfter milliseconds,
+ * then copies the events of all threads from Tracer/SnapshotBefore milliseconds before the
+ * xrun, and writes them in the Chrome trace event format (load it in chrome://tracing) to
+ * ~/.traverso/traces, or the directory set with Tracer/Directory.
+ */
+
+TTimelineTracer& ttracer()
+{
+        static TTimelineTracer tracer;
+        return tracer;
+}
+
+
+const uint TTraceRing::CAPACITY;
+
+TTraceRing::TTraceRing(int id)
+        : m_head(0)
+        , m_name("")
+        , m_id(id)
+{
+        m_events = new TTraceEvent[CAPACITY];
+}
+
+TTraceRing::~TTraceRing()
+{
+        delete [] m_events;
+}
+
+/**
+ * Appends the events recorded since \a from to \a events. Events that were
+ * overwritten by the owning thread while copying them are skipped.
+ */
+void TTraceRing::copy_events(trav_time_t from, QList<TTraceEvent>& events)
+{
+        uint end = uint(m_written.fetchAndAddAcquire(0));
+        uint count = qMin(end, CAPACITY);
+        uint begin = end - count;
+
+        QVector<TTraceEvent> copy(count);
+        for (uint i=0; i<count; ++i) {
+                copy[i] = m_events[(begin + i) & (CAPACITY - 1)];
+        }
+
+        // The event after the last published one may be half written as well
+        uint after = uint(m_written.fetchAndAddAcquire(0)) + 1;
+        uint overwritten = (after - begin > CAPACITY) ? after - begin - CAPACITY : 0;
+
+        for (uint i=overwritten; i<count; ++i) {
+                if (copy.at(i).time >= from) {
+                        events.append(copy.at(i));
+                }
+        }
+}
+
+
+void TTraceWriterThread::run()
+{
+        ttracer().run();
+}
+
+
+TTimelineTracer::TTimelineTracer()
+        : m_stop(false)
+{
+        m_before = config().get_property("Tracer", "SnapshotBefore", 3000).toInt();
+        m_after = config().get_property("Tracer", "SnapshotAfter", 1000).toInt();
+        m_directory = config().get_property("Tracer", "Directory", QDir::homePath() + "/.traverso/traces").toString();
+
+        m_writer = new TTraceWriterThread;
+        m_writer->start(QThread::LowPriority);
+}
+
+TTimelineTracer::~TTimelineTracer()
+{
+        m_stop = true;
+        m_writer->wait();
+        delete m_writer;
+
+        // The rings are not deleted, threads which are still
+        // running could write to them until they exit.
+}
+
+/**
+ * Gives the calling thread it's ring of events, nothing is recorded for a thread
+ * before it is registered. Registering a thread that already is, does nothing.
+ *
+ * The ring is allocated the first time, real time threads should register before
+ * they are processing, or accept the one time allocation.
+ */
+void TTimelineTracer::register_thread(const char* name)
+{
+        if (m_threadData.hasLocalData()) {
+                return;
+        }
+
+        QMutexLocker locker(&m_mutex);
+
+        TTraceRing* ring = 0;
+        foreach(TTraceRing* unused, m_rings) {
+                if (unused->m_inUse.testAndSetOrdered(0, 1)) {
+                        ring = unused;
+                        break;
+                }
+        }
+
+        if (!ring) {
+                ring = new TTraceRing(m_rings.size() + 1);
+                ring->m_inUse.fetchAndStoreOrdered(1);
+                m_rings.append(ring);
+        }
+
+        ring->m_name = name;
+        m_threadData.setLocalData(new ThreadData(ring));
+}
+
+/**
+ * Called by AudioDevice from the audio thread, schedules writing a trace file.
+ */
+void TTimelineTracer::xrun()
+{
+        if (TTraceRing* ring = get_ring()) {
+                ring->push("xrun", 'i');
+        }
+
+        m_xrunPending.fetchAndStoreRelease(1);
+}
+
+void TTimelineTracer::run()
+{
+        while (!m_stop) {
+                QThread::msleep(100);
+
+                if (!m_xrunPending.fetchAndStoreOrdered(0)) {
+                        continue;
+                }
+
+                // The xrun happened during the last sleep
+                trav_time_t xrunTime = get_microseconds() - 100000;
+                trav_time_t writeTime = xrunTime + m_after * 1000.0;
+
+                while (!m_stop && get_microseconds() < writeTime) {
+                        QThread::msleep(100);
+                }
+
+                write_trace(xrunTime - m_before * 1000.0);
+        }
+}
+
+void TTimelineTracer::write_trace(trav_time_t from)
+{
+        QList<TTraceRing*> rings;
+        {
+                QMutexLocker locker(&m_mutex);
+                rings = m_rings;
+        }
+
+        QDir dir;
+        if (!dir.mkpath(m_directory)) {
+                PERROR("Tracer: Could not create directory %s", QS_C(m_directory));
+                return;
+        }
+
+        QString fileName = m_directory + "/xrun-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss-zzz") + ".json";
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                PERROR("Tracer: Could not open %s for writing", QS_C(fileName));
+                return;
+        }
+
+        QTextStream stream(&file);
+        stream << "{\"traceEvents\":[\n";
+
+        bool first = true;
+        foreach(TTraceRing* ring, rings) {
+                QList<TTraceEvent> events;
+                ring->copy_events(from, events);
+
+                if (!first) {
+                        stream << ",\n";
+                }
+                first = false;
+
+                stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->get_id()
+                       << ",\"args\":{\"name\":\"" << ring->get_name() << "\"}}";
+
+                foreach(const TTraceEvent& event, events) {
+                        stream << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"" << event.phase
+                               << "\",\"ts\":" << qint64(event.time - from)
+                               << ",\"pid\":1,\"tid\":" << ring->get_id();
+                        if (event.phase == 'i') {
+                                stream << ",\"s\":\"g\"";
+                        }
+                        stream << "}";
+                }
+        }
+
+        stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+        printf("Tracer: xrun trace written to %s\n", QS_C(fileName));
+}
+
+#endif
+
+//eof
@@ -0,0 +1,168 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TTIMELINE_TRACER_H
+#define TTIMELINE_TRACER_H
+
+#if defined (TIMELINE_TRACER)
+
+#include <QThread>
+#include <QThreadStorage>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QList>
+#include <QString>
+
+#include "defines.h"
+
+struct TTraceEvent {
+        trav_time_t     time;
+        const char*     name;
+        char            phase;
+};
+
+
+/**
+ * The events of one thread. Only the owning thread writes, the
+ * tracer copies the events while they are written.
+ */
+class TTraceRing
+{
+public:
+        TTraceRing(int id);
+        ~TTraceRing();
+
+        void push(const char* name, char phase) {
+                TTraceEvent& event = m_events[m_head & (CAPACITY - 1)];
+                event.time = get_microseconds();
+                event.name = name;
+                event.phase = phase;
+                ++m_head;
+                m_written.fetchAndStoreRelease(int(m_head));
+        }
+
+        void copy_events(trav_time_t from, QList<TTraceEvent>& events);
+        void release() {m_inUse.fetchAndStoreRelease(0);}
+
+        int get_id() const {return m_id;}
+        const char* get_name() const {return m_name;}
+
+private:
+        static const uint CAPACITY = 16384;
+
+        TTraceEvent*    m_events;
+        uint            m_head;
+        QAtomicInt      m_written;
+        QAtomicInt      m_inUse;
+        const char*     m_name;
+        int             m_id;
+
+        friend class TTimelineTracer;
+};
+
+
+class TTraceWriterThread : public QThread
+{
+protected:
+        void run();
+};
+
+
+class TTimelineTracer
+{
+public:
+        ~TTimelineTracer();
+
+        void register_thread(const char* name);
+
+        void begin(const char* name) {
+                if (TTraceRing* ring = get_ring()) {
+                        ring->push(name, 'B');
+                }
+        }
+        void end(const char* name) {
+                if (TTraceRing* ring = get_ring()) {
+                        ring->push(name, 'E');
+                }
+        }
+        void xrun();
+
+private:
+        TTimelineTracer();
+        TTimelineTracer(const TTimelineTracer&);
+
+        // Deleted when the thread finishes, which frees it's ring for the next thread
+        struct ThreadData {
+                ThreadData(TTraceRing* r) : ring(r) {}
+                ~ThreadData() {ring->release();}
+                TTraceRing* ring;
+        };
+
+        QThreadStorage<ThreadData*>     m_threadData;
+        QList<TTraceRing*>              m_rings;
+        QMutex                          m_mutex;
+        TTraceWriterThread*             m_writer;
+        QAtomicInt                      m_xrunPending;
+        volatile bool                   m_stop;
+        int                             m_before;
+        int                             m_after;
+        QString                         m_directory;
+
+        TTraceRing* get_ring() {
+                return m_threadData.hasLocalData() ? m_threadData.localData()->ring : 0;
+        }
+
+        void run();
+        void write_trace(trav_time_t from);
+
+        friend class TTraceWriterThread;
+        friend TTimelineTracer& ttracer();
+};
+
+// use this function to access the tracer
+TTimelineTracer& ttracer();
+
+
+class TTraceScope
+{
+public:
+        TTraceScope(const char* name) : m_name(name) {ttracer().begin(m_name);}
+        ~TTraceScope() {ttracer().end(m_name);}
+
+private:
+        const char* m_name;
+};
+
+#define TRACE_THREAD(name) ttracer().register_thread(name)
+#define TRACE_SCOPE(name) TTraceScope traceScope(name)
+#define TRACE_XRUN() ttracer().xrun()
+
+#else
+
+#define TRACE_THREAD(name)
+#define TRACE_SCOPE(name)
+#define TRACE_XRUN()
+
+#endif
+
+#endif
+
+//eof
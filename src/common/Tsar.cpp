@@ -24,6 +24,7 @@ $Id: Tsar.cpp,v 1.4 2008/02/11 10:11:52 r_sijrier Exp $
 
 #include "AudioDevice.h"
 #include "TInputEventDispatcher.h"
+#include "TTimelineTracer.h"
 #include <QMetaMethod>
 #include <QMessageBox>
 #include <QCoreApplication>
@@ -66,6 +67,7 @@ Tsar::Tsar()
 	m_events.append(new RingBufferNPT<TsarEvent>(audioThreadEventsBufferSize));
 
 	m_retryCount = 0;
+	m_postponed = 0;
 	
 #if defined (THREAD_CHECK)
 	m_threadId = QThread::currentThreadId ();
@@ -131,8 +133,19 @@ void Tsar::add_rt_event( TsarEvent& event )
 //
 void Tsar::process_events( )
 {
+        TRACE_SCOPE("Tsar::process_events");
+
 //#define profile
 
+	// A non real time thread is walking data which is modified by our
+	// events, don't wait for it, try again next cycle.
+	if ( ! m_processLock.tryLockForWrite() ) {
+		m_postponed = 1;
+		return;
+	}
+	
+	m_postponed = 0;
+
 	for (int i=0; i<m_events.size(); ++i) {
 		RingBufferNPT<TsarEvent>* newEvents = m_events.at(i);
 		
@@ -163,6 +176,36 @@ void Tsar::process_events( )
 #endif
 		}
 	}
+	
+	m_processLock.unlock();
+}
+
+/**
+ * 	Blocks the processing of events until unblock_event_processing() is called.
+ *
+ *	Threads other then the GUI and audio thread that process Tracks (like the
+ *	Track freeze or render ahead threads) walk the clip, curve node and plugin
+ *	lists which are only modified by Tsar events in the audio thread. Wrap such
+ *	a processing step in block_event_processing() and unblock_event_processing().
+ *
+ *	The audio thread never waits on the lock, it postpones the processing of
+ *	the events to the next cycle. Keep the blocked period short, and give the
+ *	audio thread a chance to process them when event_processing_postponed()
+ *	returns true.
+ *
+ *	Several threads can block the event processing at the same time, like the
+ *	segment render threads of a parallel export.
+ *
+ *	Note: Never call this function from the real time audio thread!
+ */
+void Tsar::block_event_processing()
+{
+	m_processLock.lockForRead();
+}
+
+void Tsar::unblock_event_processing()
+{
+	m_processLock.unlock();
 }
 
 void Tsar::finish_processed_events( )
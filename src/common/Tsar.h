@@ -26,6 +26,7 @@ $Id: Tsar.h,v 1.4 2008/02/11 10:11:52 r_sijrier Exp $
 #include <QObject>
 #include <QBasicTimer>
 #include <QByteArray>
+#include <QReadWriteLock>
 #include "RingBufferNPT.h"
 
 #define THREAD_SAVE_INVOKE(caller, argument, slotSignature)  { \
@@ -83,6 +84,10 @@ public:
 	void process_event_signal(const TsarEvent& event);
 	void process_event_slot_signal(const TsarEvent& event);
 
+	void block_event_processing();
+	void unblock_event_processing();
+	bool event_processing_postponed() const {return m_postponed;}
+
 protected:
         void timerEvent(QTimerEvent *event);
 
@@ -100,8 +105,10 @@ private:
 	QList<RingBufferNPT<TsarEvent>*>	m_events;
 	RingBufferNPT<TsarEvent>*		oldEvents;
         QBasicTimer                             m_timer;
+	QReadWriteLock				m_processLock;
 	int 	m_eventCounter;
 	int 	m_retryCount;
+	volatile size_t	m_postponed;
 
 #if defined (THREAD_CHECK)
 	unsigned long	m_threadId;
@@ -310,6 +310,8 @@ struct AudioDeviceSetup {
                 playback = capture = true;
                 cardDevice = "";
                 ditherShape = "None";
+                lockMemory = false;
+                countPageFaults = false;
         }
 
         QList<BusConfig>        busConfigs;
@@ -322,6 +324,8 @@ struct AudioDeviceSetup {
         bool            playback;
         QString         cardDevice;
         QString         ditherShape;
+        bool            lockMemory;
+        bool            countPageFaults;
 };
 
 #define MouseScrollHorizontalLeft -1
@@ -51,6 +51,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "PluginChain.h"
 #include "GainEnvelope.h"
 #include "TInputEventDispatcher.h"
+#include "TRenderAheadEngine.h"
 
 #include "AbstractAudioReader.h"
 
@@ -265,7 +266,10 @@ void AudioClip::set_sources_active_state()
 		stopSyncDueMove = false;
 	}
 		
-	if ( m_track->is_muted() || m_track->is_muted_by_solo() || is_muted() || stopSyncDueMove) {
+	// A frozen Track streams it's freeze clip instead of us
+	bool replacedByFreeze = m_track->is_frozen() && m_track->get_freeze_clip() != this;
+
+	if ( m_track->is_muted() || m_track->is_muted_by_solo() || is_muted() || stopSyncDueMove || replacedByFreeze) {
                 m_readSource->set_active(false);
 	} else {
 		m_readSource->set_active(true);
@@ -426,6 +430,7 @@ void AudioClip::set_gain(float gain)
 	
 	m_fader->set_gain(gain);
 	emit stateChanged();
+	emit gainChanged();
 }
 
 void AudioClip::set_selected(bool selected)
@@ -436,7 +441,7 @@ void AudioClip::set_selected(bool selected)
 //
 //  Function called in RealTime AudioThread processing path
 //
-int AudioClip::process(nframes_t nframes)
+int AudioClip::process(nframes_t nframes, const TRenderContext* context)
 {
 	Q_ASSERT(m_sheet);
 	
@@ -446,7 +451,9 @@ int AudioClip::process(nframes_t nframes)
 	}
 	
 	if (m_recordingStatus == RECORDING) {
-		process_capture(nframes);
+		if (!context) {
+			process_capture(nframes);
+		}
 		return 0;
 	}
 
@@ -460,17 +467,15 @@ int AudioClip::process(nframes_t nframes)
 	
 	Q_ASSERT(m_readSource);
 	
-	AudioBus* bus = m_sheet->get_clip_render_bus();
-	bus->silence_buffers(nframes);
-	
 	TimeRef mix_pos;
 	int channelcount = get_channel_count();
-	audio_sample_t* mixdown[channelcount];
 	uint framesToProcess = nframes;
+	uint offset = 0;
 
 
 	int outputRate = m_readSource->get_output_rate();
-	TimeRef transportLocation = m_sheet->get_transport_location();
+	// A render context is used when rendering ahead outside the audio thread
+	TimeRef transportLocation = context ? context->location : m_sheet->get_transport_location();
 	TimeRef upperRange = transportLocation + TimeRef(framesToProcess, outputRate);
 	
 	
@@ -479,22 +484,14 @@ int AudioClip::process(nframes_t nframes)
 			// Using to_frame() for both the m_trackStartLocation and transportLocation seems to round 
 			// better then using (m_trackStartLocation - transportLocation).to_frame()
 			// TODO : find out why!
-			uint offset = (m_trackStartLocation).to_frame(outputRate) - transportLocation.to_frame(outputRate);
+			offset = (m_trackStartLocation).to_frame(outputRate) - transportLocation.to_frame(outputRate);
 			mix_pos = m_sourceStartLocation;
 // 			printf("offset %d\n", offset);
 			
-			for (int chan=0; chan<bus->get_channel_count(); ++chan) {
-				audio_sample_t* buf = bus->get_buffer(chan, framesToProcess);
-				mixdown[chan] = buf + offset;
-			}
 			framesToProcess = framesToProcess - offset;
 		} else {
 			mix_pos = (transportLocation - m_trackStartLocation + m_sourceStartLocation);
 // 			printf("else: Setting mix pos to start location %d\n", mix_pos.to_frame(96000));
-			
-			for (int chan=0; chan<bus->get_channel_count(); ++chan) {
-				mixdown[chan] = bus->get_buffer(chan, framesToProcess);
-			}
 		}
 		if (m_trackEndLocation < upperRange) {
 			// Using to_frame() for both the upperRange and m_trackEndLocation seems to round 
@@ -507,17 +504,27 @@ int AudioClip::process(nframes_t nframes)
 		return 0;
 	}
 
-	uint read_frames = 0;
-
-	if (m_sheet->realtime_path()) {
-		read_frames = m_readSource->rb_read(mixdown, mix_pos, framesToProcess);
-	} else {
-		read_frames = m_readSource->file_read(m_sheet->renderDecodeBuffer, mix_pos, framesToProcess);
-		if (read_frames > 0) {
-			for (int chan=0; chan<channelcount; ++chan) {
-				memcpy(mixdown[chan], m_sheet->renderDecodeBuffer->destination[chan], read_frames * sizeof(audio_sample_t));
-			}
+	// The source data is processed where it is, in the ringbuffers or the decode buffer,
+	// each channel consists of at most 2 parts, see TMultiChannelRingBuffer::get_read_vectors().
+	TMultiChannelRingBuffer<audio_sample_t>::rw_vector source[channelcount];
+	int read_frames = 0;
+	bool ringbufferRead = false;
+
+	if (context || !m_sheet->realtime_path()) {
+		ReadSource* readSource = context ? context->sources->get_source(this) : m_readSource;
+		DecodeBuffer* decodeBuffer = context ? context->decodeBuffer : m_sheet->renderDecodeBuffer;
+		if (!readSource) {
+			return 0;
+		}
+		read_frames = readSource->file_read(decodeBuffer, mix_pos, framesToProcess);
+		for (int chan=0; chan<channelcount && read_frames > 0; ++chan) {
+			source[chan].buf[0] = decodeBuffer->destination[chan];
+			source[chan].len[0] = read_frames;
+			source[chan].len[1] = 0;
 		}
+	} else {
+		read_frames = m_readSource->rb_get_read_vector(source, mix_pos, framesToProcess);
+		ringbufferRead = true;
 	}
 	
 	if (read_frames <= 0) {
@@ -525,28 +532,61 @@ int AudioClip::process(nframes_t nframes)
 		return 0;
 	}
 	
-	if (read_frames != framesToProcess) {
+	if (uint(read_frames) != framesToProcess) {
 		printf("read_frames, framesToProcess %d, %d\n", read_frames, framesToProcess);
 	}		
 	
-
+	// Combine the fades and the gain (envelope) into one gain vector, indexed like the
+	// process bus, or a constant gain when there is neither a fade nor gain automation.
+	audio_sample_t* gainVector = context ? context->mixdown : m_sheet->mixdown;
+	audio_sample_t* scratch = context ? context->gainBuffer : m_sheet->gainbuffer;
+	float gain;
+	
+	TimeRef endlocation = mix_pos + TimeRef(nframes_t(read_frames), get_rate());
+	bool varyingGain = m_fader->get_gain_vector(scratch, mix_pos, endlocation, read_frames, gain);
+	if (varyingGain) {
+		memcpy(gainVector + offset, scratch, read_frames * sizeof(audio_sample_t));
+	}
+	
 	apill_foreach(FadeCurve* fade, FadeCurve, m_fades) {
-                fade->process(bus, nframes);
+		if (fade->process_gain(gainVector, scratch, nframes, transportLocation, varyingGain)) {
+			varyingGain = true;
+		}
 	}
 	
-	TimeRef endlocation = mix_pos + TimeRef(read_frames, get_rate());
-	m_fader->process_gain(mixdown, mix_pos, endlocation, read_frames, channelcount);
+        AudioBus* processBus = context ? context->processBus : m_track->get_process_bus();
 	
-        AudioBus* processBus = m_track->get_process_bus();
+	// Mono clips are mixed into both channels of the process bus, stereo clips channel by channel
+	if (channelcount <= 2) {
+		for (int chan=0; chan<2; ++chan) {
+			TMultiChannelRingBuffer<audio_sample_t>::rw_vector& vector = source[channelcount == 1 ? 0 : chan];
+			audio_sample_t* dst = processBus->get_buffer(chan, nframes) + offset;
+			audio_sample_t* gainbuf = gainVector + offset;
+			nframes_t remaining = read_frames;
+			
+			for (int part=0; part<2 && remaining; ++part) {
+				nframes_t count = qMin(nframes_t(vector.len[part]), remaining);
+				audio_sample_t* src = vector.buf[part];
+				
+				if (varyingGain) {
+					for (nframes_t frame = 0; frame < count; ++frame) {
+						dst[frame] += src[frame] * gainbuf[frame] * gain;
+					}
+				} else if (gain == 1.0f) {
+					Mixer::mix_buffers_no_gain(dst, src, count);
+				} else {
+					Mixer::mix_buffers_with_gain(dst, src, count, gain);
+				}
+				
+				dst += count;
+				gainbuf += count;
+				remaining -= count;
+			}
+		}
+	}
 	
-	// NEVER EVER FORGET that the mixing should be done on the WHOLE buffer, not just part of it
-	// so use an unmodified nframes variable!!!!!!!!!!!!!!!!!!!!!!!!!!!1
-	if (channelcount == 1) {
-                Mixer::mix_buffers_no_gain(processBus->get_buffer(0, nframes), bus->get_buffer(0, nframes), nframes);
-                Mixer::mix_buffers_no_gain(processBus->get_buffer(1, nframes), bus->get_buffer(0, nframes), nframes);
-	} else if (channelcount == 2) {
-                Mixer::mix_buffers_no_gain(processBus->get_buffer(0, nframes), bus->get_buffer(0, nframes), nframes);
-                Mixer::mix_buffers_no_gain(processBus->get_buffer(1, nframes), bus->get_buffer(1, nframes), nframes);
+	if (ringbufferRead) {
+		m_readSource->rb_read_done(read_frames);
 	}
 	
 	return 1;
@@ -41,6 +41,7 @@ class Peak;
 class AudioBus;
 class FadeCurve;
 class PluginChain;
+struct TRenderContext;
 
 class AudioClip : public ProcessingData, public Snappable
 {
@@ -60,7 +61,7 @@ public:
 	
 	void set_audio_source(ReadSource* source);
         int init_recording();
-	int process(nframes_t nframes);
+	int process(nframes_t nframes, const TRenderContext* context=0);
 	
 	void set_track_start_location(const TimeRef& location);
 	void set_fade_in(double range);
@@ -157,6 +158,7 @@ signals:
 	void fadeAdded(FadeCurve*);
 	void fadeRemoved(FadeCurve*);
 	void recordingFinished(AudioClip*);
+	void gainChanged();
 
 public slots:
 	void finish_recording();
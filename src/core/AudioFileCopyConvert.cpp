@@ -20,25 +20,50 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 */
 
 #include "AudioFileCopyConvert.h"
-#include <QFile>
-#include <QMutexLocker>
 #include <QFileInfo>
 
 #include "Export.h"
-#include "AbstractAudioReader.h"
-#include "ProjectManager.h"
 #include "ResourcesManager.h"
 #include "ReadSource.h"
-#include "WriteSource.h"
-#include "Peak.h"
+#include "TConversionService.h"
 #include "defines.h"
 
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+/**
+ * \class AudioFileCopyConvert
+ * \brief Copies ReadSources into float wav files in the Project's audiosources dir
+ *
+ * The copying itself is done by the TConversionService, multiple files are
+ * copied concurrently. progress() reports the progress of all queued tasks together.
+ */
+
 AudioFileCopyConvert::AudioFileCopyConvert()
 {
-	m_stopProcessing = false;
-	moveToThread(this);
-	start();
-	connect(this, SIGNAL(dequeueTask()), this, SLOT(dequeue_tasks()), Qt::QueuedConnection);
+	m_group = conversionservice().create_group();
+	
+	connect(&conversionservice(), SIGNAL(jobStarted(int, int, QString)),
+		this, SLOT(job_started(int, int, QString)), Qt::QueuedConnection);
+	connect(&conversionservice(), SIGNAL(jobFinished(int, int, QString, QString)),
+		this, SLOT(job_finished(int, int, QString, QString)), Qt::QueuedConnection);
+	connect(&conversionservice(), SIGNAL(jobCancelled(int, int)),
+		this, SLOT(job_cancelled(int, int)), Qt::QueuedConnection);
+	connect(&conversionservice(), SIGNAL(groupProgress(int, int)),
+		this, SLOT(group_progress(int, int)), Qt::QueuedConnection);
+	connect(&conversionservice(), SIGNAL(groupStopped(int)),
+		this, SLOT(group_stopped(int)), Qt::QueuedConnection);
+}
+
+AudioFileCopyConvert::~AudioFileCopyConvert()
+{
+	disconnect(&conversionservice(), 0, this, 0);
+	
+	// The jobs own their ReadSource, running jobs release
+	// it once they noticed the cancel request.
+	conversionservice().cancel_group(m_group);
+	conversionservice().release_group(m_group);
 }
 
 /**
@@ -60,134 +85,67 @@ void AudioFileCopyConvert::enqueue_task(ReadSource * source,
 {
 	QFileInfo fi(outfilename);
 
+	QList<ReadSource*> sources;
+	sources << source;
+	
+	int job = conversionservice().enqueue_job(m_group, sources, spec, dir, fi.completeBaseName(),
+						  source->get_name(), TConversionService::OwnsSources);
+	if (job == -1) {
+		resources_manager()->remove_source(source);
+		return;
+	}
+
 	CopyTask task;
-	task.readsource = source;
-	task.outFileName = fi.completeBaseName();
-	task.extension = fi.suffix();
 	task.tracknumber = tracknumber;
 	task.trackname = trackname;
-	task.dir = dir;
-	task.spec = spec;
 	
-	m_mutex.lock();
-	m_tasks.enqueue(task);
-	m_mutex.unlock();
-	
-	emit dequeueTask();
+	m_tasks.insert(job, task);
 }
 
-void AudioFileCopyConvert::dequeue_tasks()
+void AudioFileCopyConvert::stop_merging()
 {
-	m_mutex.lock();
-	if (m_tasks.size()) {
-		CopyTask task = m_tasks.dequeue();
-		m_mutex.unlock();
-		process_task(task);
-		return;
-	}
-	m_mutex.unlock();
+	conversionservice().cancel_group(m_group);
 }
 
-void AudioFileCopyConvert::process_task(CopyTask task)
+void AudioFileCopyConvert::job_started(int group, int job, QString description)
 {
-	emit taskStarted(task.readsource->get_name());
-
-	uint buffersize = 16384;
-	DecodeBuffer decodebuffer;
-	
-	task.spec->startLocation = TimeRef();
-	task.spec->endLocation = task.readsource->get_length();
-	task.spec->totalTime = task.spec->endLocation;
-	task.spec->pos = TimeRef();
-	task.spec->isRecording = false;
-	
-	task.spec->exportdir = task.dir;
-	task.spec->writerType = "sndfile";
-	task.spec->extraFormat["filetype"] = "wav";
-	task.spec->data_width = 1;	// 1 means float
-	task.spec->channels = task.readsource->get_channel_count();
-	task.spec->sample_rate = task.readsource->get_rate();
-	task.spec->blocksize = buffersize;
-	task.spec->name = task.outFileName;
-	task.spec->dataF = new audio_sample_t[buffersize * 2];
+	Q_UNUSED(job);
 	
-	WriteSource* writesource = new WriteSource(task.spec);
-	bool failedToPrepareWritesource = false;
-	int oldprogress = 0;
-
-	if (writesource->prepare_export() == -1) {
-		failedToPrepareWritesource = true;
-		goto out;
+	if (group == m_group) {
+		emit taskStarted(description);
 	}
-	// Enable on the fly generation of peak data to speedup conversion 
-	// (no need to re-read all the audio files to generate peaks)
-	writesource->set_process_peaks(true);
-	
-	do {
-		// if the user asked to stop processing, jump out of this 
-		// loop, and cleanup any resources in use.
-		if (m_stopProcessing) {
-			goto out;
-		}
-			
-		nframes_t diff = (task.spec->endLocation - task.spec->pos).to_frame(task.readsource->get_rate());
-		nframes_t this_nframes = std::min(diff, buffersize);
-		nframes_t nframes = this_nframes;
-		
-		memset (task.spec->dataF, 0, sizeof (task.spec->dataF[0]) * nframes * task.spec->channels);
-		
-		task.readsource->file_read(&decodebuffer, task.spec->pos, nframes);
-			
-		for (uint x = 0; x < nframes; ++x) {
-			for (int y = 0; y < task.spec->channels; ++y) {
-				task.spec->dataF[y + x*task.spec->channels] = decodebuffer.destination[y][x];
-			}
-		}
-		
-		// due the fact peak generating does _not_ happen in writesource->process
-		// but in a function used by DiskIO, we have to hack the peak processing 
-		// in here.
-		for (int y = 0; y < task.spec->channels; ++y) {
-			writesource->get_peak()->process(y, decodebuffer.destination[y], nframes);
-		}
-		
-		// Process the data, and write to disk
-		writesource->process(buffersize);
-		
-		task.spec->pos.add_frames(nframes, task.readsource->get_rate());
-		
-		int currentprogress = int(double(task.spec->pos.universal_frame()) / double(task.spec->totalTime.universal_frame()) * 100);
-		if (currentprogress > oldprogress) {
-			oldprogress = currentprogress;
-			emit progress(currentprogress);
-		}
-			
-	} while (task.spec->pos != task.spec->totalTime);
-		
-	
-	out:
-	if (!failedToPrepareWritesource) {
-		writesource->finish_export();
-	}
-	delete writesource;
-	delete [] task.spec->dataF;
-	resources_manager()->remove_source(task.readsource);
+}
+
+void AudioFileCopyConvert::job_finished(int group, int job, QString description, QString filename)
+{
+	Q_UNUSED(description);
 	
-	//  The user asked to stop processing, exit the event loop
-	// and signal we're done.
-	if (m_stopProcessing) {
-		exit(0);
-		wait(1000);
-		m_tasks.clear();
-		emit processingStopped();
+	if (group != m_group || !m_tasks.contains(job)) {
 		return;
 	}
 	
-	emit taskFinished(task.dir + "/" + task.outFileName + ".wav", task.tracknumber, task.trackname);
+	CopyTask task = m_tasks.take(job);
+	
+	emit taskFinished(filename, task.tracknumber, task.trackname);
 }
 
-void AudioFileCopyConvert::stop_merging()
+void AudioFileCopyConvert::job_cancelled(int group, int job)
 {
-	m_stopProcessing = true;
+	if (group == m_group) {
+		m_tasks.remove(job);
+	}
+}
+
+void AudioFileCopyConvert::group_progress(int group, int value)
+{
+	if (group == m_group) {
+		emit progress(value);
+	}
 }
 
+void AudioFileCopyConvert::group_stopped(int group)
+{
+	if (group == m_group) {
+		emit processingStopped();
+	}
+}
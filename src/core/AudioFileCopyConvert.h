@@ -22,48 +22,41 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #ifndef AUDIO_FILE_COPY_CONVERT_H
 #define AUDIO_FILE_COPY_CONVERT_H
 
-#include <QThread>
-#include <QQueue>
-#include <QMutex>
+#include <QObject>
+#include <QHash>
 
 class ReadSource;
 struct ExportSpecification;
 
-class AudioFileCopyConvert : public QThread
+class AudioFileCopyConvert : public QObject
 {
 	Q_OBJECT
 public:
 	AudioFileCopyConvert();
-	void run() {
-		exec();
-	}
+	~AudioFileCopyConvert();
 	
 	void enqueue_task(ReadSource* source, ExportSpecification* spec, const QString& dir, const QString& outfilename, int tracknumber, const QString& trackname);
 	void stop_merging();
+	bool is_processing() const {return !m_tasks.isEmpty();}
 
 		
 private slots:
-	void dequeue_tasks();
+	void job_started(int group, int job, QString description);
+	void job_finished(int group, int job, QString description, QString filename);
+	void job_cancelled(int group, int job);
+	void group_progress(int group, int progress);
+	void group_stopped(int group);
 	
 private:
 	struct CopyTask {
-		QString outFileName;
-		QString dir;
-		QString extension;
 		int tracknumber;
 		QString trackname;
-		ReadSource* readsource;
-		ExportSpecification* spec;
 	};
 	
-	QQueue<CopyTask> m_tasks;
-	QMutex m_mutex;
-	bool m_stopProcessing;
-	
-	void process_task(CopyTask task);
+	QHash<int, CopyTask> m_tasks;
+	int m_group;
 	
 signals:
-	void dequeueTask();
 	void progress(int);
 	void taskStarted(QString);
 	void taskFinished(QString, int, QString);
@@ -20,151 +20,114 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 */
 
 #include "AudioFileMerger.h"
-#include <QFile>
-#include <QMutexLocker>
 
 #include "Export.h"
-#include "AbstractAudioReader.h"
 #include "ReadSource.h"
-#include "WriteSource.h"
-#include "Peak.h"
+#include "TConversionService.h"
 #include "defines.h"
 
-AudioFileMerger::AudioFileMerger()
-{
-	m_stopMerging = false;
-	moveToThread(this);
-	start();
-	connect(this, SIGNAL(dequeueTask()), this, SLOT(dequeue_tasks()), Qt::QueuedConnection);
-}
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
 
-void AudioFileMerger::enqueue_task(ReadSource * source0, ReadSource * source1, const QString& dir, const QString & outfilename)
+/**
+ * \class AudioFileMerger
+ * \brief Merges 2 mono ReadSources into one stereo file
+ *
+ * The merging itself is done by the TConversionService, multiple files
+ * are merged concurrently. progress() reports the progress of all queued
+ * tasks together.
+ */
+
+AudioFileMerger::AudioFileMerger()
 {
-	MergeTask task;
-	task.readsource0 = source0;
-	task.readsource1 = source1;
-	task.outFileName = outfilename;
-	task.dir = dir;
-	
-	m_mutex.lock();
-	m_tasks.enqueue(task);
-	m_mutex.unlock();
+	m_group = conversionservice().create_group();
 	
-	emit dequeueTask();
+	connect(&conversionservice(), SIGNAL(jobStarted(int, int, QString)),
+		this, SLOT(job_started(int, int, QString)), Qt::QueuedConnection);
+	connect(&conversionservice(), SIGNAL(jobFinished(int, int, QString, QString)),
+		this, SLOT(job_finished(int, int, QString, QString)), Qt::QueuedConnection);
+	connect(&conversionservice(), SIGNAL(jobCancelled(int, int)),
+		this, SLOT(job_cancelled(int, int)), Qt::QueuedConnection);
+	connect(&conversionservice(), SIGNAL(groupProgress(int, int)),
+		this, SLOT(group_progress(int, int)), Qt::QueuedConnection);
+	connect(&conversionservice(), SIGNAL(groupStopped(int)),
+		this, SLOT(group_stopped(int)), Qt::QueuedConnection);
 }
 
-void AudioFileMerger::dequeue_tasks()
+AudioFileMerger::~AudioFileMerger()
 {
-	m_mutex.lock();
-	if (m_tasks.size()) {
-		MergeTask task = m_tasks.dequeue();
-		m_mutex.unlock();
-		process_task(task);
-		return;
-	}
-	m_mutex.unlock();
+	disconnect(&conversionservice(), 0, this, 0);
+	
+	// The jobs own their ExportSpecification, running jobs
+	// delete it once they noticed the cancel request.
+	conversionservice().cancel_group(m_group);
+	conversionservice().release_group(m_group);
 }
 
-void AudioFileMerger::process_task(MergeTask task)
+void AudioFileMerger::enqueue_task(ReadSource * source0, ReadSource * source1, const QString& dir, const QString & outfilename)
 {
-	QString name = task.readsource0->get_name();
-	int length = name.length();
-	emit taskStarted(name.left(length-28));
-	uint buffersize = 16384;
-	DecodeBuffer decodebuffer0;
-	DecodeBuffer decodebuffer1;
+	QString name = source0->get_name();
 	
-	ExportSpecification* spec = new ExportSpecification();
-	spec->startLocation = TimeRef();
-	spec->endLocation = task.readsource0->get_length();
-	spec->totalTime = spec->endLocation;
-	spec->pos = TimeRef();
-	spec->isRecording = false;
+	QList<ReadSource*> sources;
+	sources << source0 << source1;
 	
-	spec->exportdir = task.dir;
-	spec->writerType = "sndfile";
-	spec->extraFormat["filetype"] = "wav";
-	spec->data_width = 1;	// 1 means float
-	spec->channels = 2;
-	spec->sample_rate = task.readsource0->get_rate();
-	spec->blocksize = buffersize;
-	spec->name = task.outFileName;
-	spec->dataF = new audio_sample_t[buffersize * 2];
+	ExportSpecification* spec = new ExportSpecification();
 	
-	WriteSource* writesource = new WriteSource(spec);
-	if (writesource->prepare_export() == -1) {
-		delete writesource;
-		delete [] spec->dataF;
+	int job = conversionservice().enqueue_job(m_group, sources, spec, dir, outfilename,
+						  name.left(name.length() - 28), TConversionService::OwnsSpec);
+	if (job == -1) {
 		delete spec;
 		return;
 	}
-	// Enable on the fly generation of peak data to speedup conversion 
-	// (no need to re-read all the audio files to generate peaks)
-	writesource->set_process_peaks(true);
 	
-	int oldprogress = 0;
-	do {
-		// if the user asked to stop processing, jump out of this 
-		// loop, and cleanup any resources in use.
-		if (m_stopMerging) {
-			goto out;
-		}
-			
-		nframes_t diff = (spec->endLocation - spec->pos).to_frame(task.readsource0->get_rate());
-		nframes_t this_nframes = std::min(diff, buffersize);
-		nframes_t nframes = this_nframes;
-		
-		memset (spec->dataF, 0, sizeof (spec->dataF[0]) * nframes * spec->channels);
-		
-		task.readsource0->file_read(&decodebuffer0, spec->pos, nframes);
-		task.readsource1->file_read(&decodebuffer1, spec->pos, nframes);
-			
-		for (uint x = 0; x < nframes; ++x) {
-			spec->dataF[x*spec->channels] = decodebuffer0.destination[0][x];
-			spec->dataF[1+(x*spec->channels)] = decodebuffer1.destination[0][x];
-		}
-		
-		// due the fact peak generating does _not_ happen in writesource->process
-		// but in a function used by DiskIO, we have to hack the peak processing 
-		// in here.
-		writesource->get_peak()->process(0, decodebuffer0.destination[0], nframes);
-		writesource->get_peak()->process(1, decodebuffer1.destination[0], nframes);
-		
-		// Process the data, and write to disk
-		writesource->process(buffersize);
-		
-		spec->pos.add_frames(nframes, task.readsource0->get_rate());
-		
-		int currentprogress = int(double(spec->pos.universal_frame()) / double(spec->totalTime.universal_frame()) * 100);
-		if (currentprogress > oldprogress) {
-			oldprogress = currentprogress;
-			emit progress(currentprogress);
-		}
-			
-	} while (spec->pos != spec->totalTime);
-		
+	m_jobs.insert(job);
+}
+
+void AudioFileMerger::stop_merging()
+{
+	conversionservice().cancel_group(m_group);
+}
+
+void AudioFileMerger::job_started(int group, int job, QString description)
+{
+	Q_UNUSED(job);
 	
-	out:
-	writesource->finish_export();
-	delete writesource;
-	delete [] spec->dataF;
-	delete spec;
+	if (group == m_group) {
+		emit taskStarted(description);
+	}
+}
+
+void AudioFileMerger::job_finished(int group, int job, QString description, QString filename)
+{
+	Q_UNUSED(filename);
 	
-	//  The user asked to stop processing, exit the event loop
-	// and signal we're done.
-	if (m_stopMerging) {
-		exit(0);
-		wait(1000);
-		m_tasks.clear();
-		emit processingStopped();
+	if (group != m_group) {
 		return;
 	}
 	
-	emit taskFinished(name.left(length-28));
+	m_jobs.remove(job);
+	
+	emit taskFinished(description);
 }
 
-void AudioFileMerger::stop_merging()
+void AudioFileMerger::job_cancelled(int group, int job)
 {
-	m_stopMerging = true;
+	if (group == m_group) {
+		m_jobs.remove(job);
+	}
+}
+
+void AudioFileMerger::group_progress(int group, int value)
+{
+	if (group == m_group) {
+		emit progress(value);
+	}
 }
 
+void AudioFileMerger::group_stopped(int group)
+{
+	if (group == m_group) {
+		emit processingStopped();
+	}
+}
@@ -22,44 +22,36 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #ifndef AUDIO_FILE_MERGER_H
 #define AUDIO_FILE_MERGER_H
 
-#include <QThread>
-#include <QQueue>
-#include <QMutex>
+#include <QObject>
+#include <QSet>
 
 class ReadSource;
+struct ExportSpecification;
 
-class AudioFileMerger : public QThread
+class AudioFileMerger : public QObject
 {
 	Q_OBJECT
 public:
 	AudioFileMerger();
-	void run() {
-		exec();
-	}
+	~AudioFileMerger();
 	
 	void enqueue_task(ReadSource* source0, ReadSource* source2, const QString& dir, const QString& outfilename);
 	void stop_merging();
+	bool is_processing() const {return !m_jobs.isEmpty();}
 
 		
 private slots:
-	void dequeue_tasks();
+	void job_started(int group, int job, QString description);
+	void job_finished(int group, int job, QString description, QString filename);
+	void job_cancelled(int group, int job);
+	void group_progress(int group, int progress);
+	void group_stopped(int group);
 	
 private:
-	struct MergeTask {
-		QString outFileName;
-		QString dir;
-		ReadSource* readsource0;
-		ReadSource* readsource1;
-	};
-	
-	QQueue<MergeTask> m_tasks;
-	QMutex m_mutex;
-	bool m_stopMerging;
-	
-	void process_task(MergeTask task);
+	QSet<int> m_jobs;
+	int m_group;
 	
 signals:
-	void dequeueTask();
 	void progress(int);
 	void taskStarted(QString);
 	void taskFinished(QString);
@@ -35,7 +35,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 
 // This constructor is called at file import or recording
 AudioSource::AudioSource(const QString& dir, const QString& name)
-	: m_dir(dir)
+	: m_buffer(0)
+	, m_dir(dir)
 	, m_name(name)
 	, m_shortName(name)
 	, m_wasRecording (false)
@@ -48,7 +49,8 @@ AudioSource::AudioSource(const QString& dir, const QString& name)
 
 // This constructor is called for existing (recorded/imported) audio sources
 AudioSource::AudioSource()
-	: m_dir("")
+	: m_buffer(0)
+	, m_dir("")
 	, m_name("")
 	, m_fileName("")
 	, m_wasRecording(false)
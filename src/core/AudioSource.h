@@ -26,7 +26,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 
 #include <QObject>
 
-#include "RingBufferNPT.h"
+#include "TMultiChannelRingBuffer.h"
 
 
 class QString;
@@ -54,7 +54,7 @@ public :
 	int get_bit_depth() const;
 	
 protected:
-	QList<RingBufferNPT<audio_sample_t>*> 	m_buffers;
+	TMultiChannelRingBuffer<audio_sample_t>* m_buffer;
 	
 	uint		m_bufferSize;
 	uint		m_chunkSize;
@@ -23,6 +23,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 
 #include <QDomElement>
 #include <QDomNode>
+#include <QFile>
+#include <QThread>
 
 #include "Sheet.h"
 #include "AudioClip.h"
@@ -37,11 +39,45 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <limits.h>
 #include "AddRemove.h"
 #include "PCommand.h"
+#include "Curve.h"
+#include "FadeCurve.h"
+#include "Export.h"
+#include "Mixer.h"
+#include "Peak.h"
+#include "Plugin.h"
+#include "ReadSource.h"
+#include "TRenderAheadEngine.h"
+#include "Tsar.h"
+#include "WriteSource.h"
 
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
 #include "Debugger.h"
 
+// Plugins like reverbs and delays keep sounding after the last
+// clip ended, give them some time to fade out in the frozen render
+static const int FREEZE_PLUGIN_TAIL_SECONDS = 4;
+
+// FreezeThread is a private class used by AudioTrack
+// to render the frozen Track outside the GUI thread.
+class FreezeThread : public QThread
+{
+public:
+        FreezeThread(AudioTrack* track)
+                : m_track(track)
+        {
+        }
+
+protected:
+        void run()
+        {
+                m_track->render_freeze();
+        }
+
+private:
+        AudioTrack*     m_track;
+};
+
 
 AudioTrack::AudioTrack(Sheet* sheet, const QString& name, int height )
         : Track(sheet)
@@ -51,7 +87,7 @@ AudioTrack::AudioTrack(Sheet* sheet, const QString& name, int height )
         m_id = create_id();
         m_name = name;
         sheet->set_track_height(m_id, height);
-        m_pan = m_numtakes = 0;
+        m_numtakes = 0;
 	m_showClipVolumeAutomation = false;
 
         m_busInName = "Capture 1-2";
@@ -69,9 +105,35 @@ AudioTrack::AudioTrack( Sheet * sheet, const QDomNode node)
 }
 
 
+// The freeze render and it's peak files
+static void remove_freeze_files(const QString& dir, const QString& name, int channels)
+{
+        QFile::remove(dir + name);
+
+        foreach(const QString& fileName, Peak::get_peak_file_names(dir, name, channels)) {
+                QFile::remove(fileName);
+        }
+}
+
 AudioTrack::~AudioTrack()
 {
         PENTERDES;
+        if (m_freezeThread) {
+                m_freezeSpec->stop = true;
+                m_freezeThread->wait();
+                delete m_freezeThread;
+                m_sheet->finish_offline_render();
+                remove_freeze_files(m_freezeSpec->exportdir, m_freezeSpec->name + ".wav", m_freezeSpec->channels);
+                delete [] m_freezeSpec->dataF;
+                delete m_freezeSpec;
+        }
+        delete_freeze_clip(m_freezeClip);
+        delete_freeze_clip(m_retiredFreezeClip);
+
+        // The Sheet detached them from it's render ahead engine
+        // allready, or deleted the engine when it's being deleted.
+        delete m_renderAheadTrack;
+        qDeleteAll(m_retiredRenderAheadTracks);
 }
 
 void AudioTrack::init()
@@ -82,6 +144,21 @@ void AudioTrack::init()
         m_isArmed = false;
         m_fader->set_gain(1.0);
         m_processBus = m_sheet->get_render_bus();
+
+        m_freezeClip = m_retiredFreezeClip = 0;
+        m_freezeThread = 0;
+        m_freezeSpec = 0;
+        m_freezeRendering = 0;
+        m_freezeInvalidated = false;
+        m_freezeResult = 0;
+
+        m_renderAhead = m_renderAheadTrack = 0;
+        m_pendingRenderAheadChanges = 0;
+        m_renderWatchActive = false;
+
+        connect(this, SIGNAL(freezeClipChanged(AudioClip*)), this, SLOT(freeze_clip_changed(AudioClip*)));
+        connect(this, SIGNAL(renderAheadChanged(TRenderAheadTrack*)), this, SLOT(render_ahead_changed(TRenderAheadTrack*)));
+        connect(this, SIGNAL(routingConfigurationChanged()), this, SLOT(update_render_ahead_state()));
 }
 
 QDomNode AudioTrack::get_state( QDomDocument doc, bool istemplate)
@@ -234,6 +311,9 @@ void AudioTrack::set_armed( bool armed )
 //        }
 
         emit armedChanged(m_isArmed);
+
+        // Armed Tracks are processed in the audio thread
+        update_render_ahead_state();
 }
 
 void AudioTrack::add_input_bus(AudioBus *bus)
@@ -260,7 +340,13 @@ int AudioTrack::process( nframes_t nframes )
 {
         int processResult = 0;
 
-        if ( (m_isMuted || m_mutedBySolo) && ( ! m_isArmed) ) {
+        begin_cycle();
+
+        if (m_renderAhead && m_sheet->realtime_path()) {
+                return process_render_ahead(nframes);
+        }
+
+        if ( (m_isMuted || m_mutedBySolo) && ( ! m_isArmed) && ( ! m_freezeRendering) ) {
                 return 0;
         }
 
@@ -269,8 +355,20 @@ int AudioTrack::process( nframes_t nframes )
         // or buffers located on the heap...
         m_processBus->silence_buffers(nframes);
 
+        // A frozen Track only has to stream it's freeze clip, the clips, fades,
+        // gain automation and plugins are allready rendered into it.
+        if (m_freezeClip && ! m_isArmed) {
+                if (m_freezeClip->process(nframes) <= 0) {
+                        return 0;
+                }
+
+                m_processBus->process_monitoring(m_vumonitors);
+                process_post_sends(nframes);
+
+                return 1;
+        }
+
         int result;
-        float panFactor;
 
         // Read in clip data into process bus.
         apill_foreach(AudioClip* clip, AudioClip, m_clips) {
@@ -290,8 +388,25 @@ int AudioTrack::process( nframes_t nframes )
                 processResult |= result;
         }
 
+        // No clip wrote into the process bus, there is nothing to send, pan
+        // or apply gain to. Only the post fader plugins might still have to
+        // play out their tail.
+        if (m_processBus->is_silent()) {
+                ++m_skippedCycles;
+                processResult |= m_pluginChain->process_post_fader(m_processBus, nframes);
+                if (processResult && ! m_freezeRendering) {
+                        if (!m_isArmed) {
+                                m_processBus->process_monitoring(m_vumonitors);
+                        }
+                        process_post_sends(nframes);
+                }
+                return processResult;
+        }
+
         // Then do the pre-send:
-        process_pre_sends(nframes);
+        if (! m_freezeRendering) {
+                process_pre_sends(nframes);
+        }
 
 
         // Then apply the pre fader plugins;
@@ -299,46 +414,166 @@ int AudioTrack::process( nframes_t nframes )
 
 
         // Obviously fader here, pan, gain, gain automation
-        if ( (m_processBus->get_channel_count() >= 1) && (m_pan > 0) )  {
-                panFactor = 1 - m_pan;
-                Mixer::apply_gain_to_buffer(m_processBus->get_buffer(0, nframes), nframes, panFactor);
-        }
+        process_pan_and_gain(m_processBus, nframes, m_sheet->get_transport_location(), 0, true);
+
+
+        // Post fader plugins now
+        processResult |= m_pluginChain->process_post_fader(m_processBus, nframes);
 
-        if ( (m_processBus->get_channel_count() >= 2) && (m_pan < 0) )  {
-                panFactor = 1 + m_pan;
-                Mixer::apply_gain_to_buffer(m_processBus->get_buffer(1, nframes), nframes, panFactor);
+        // TODO: is there a situation where we still want to call process_post_sends
+        // even if processresult == 0?
+        if (processResult && ! m_freezeRendering) {
+                if (!m_isArmed) {
+                        m_processBus->process_monitoring(m_vumonitors);
+                }
+
+        // And finally do the post sends
+                process_post_sends(nframes);
         }
 
+        return processResult;
+}
+
+void AudioTrack::process_pan_and_gain(AudioBus* bus, nframes_t nframes, const TimeRef& location, audio_sample_t* gainbuffer, bool ramp)
+{
+        process_pan(bus, nframes, ramp);
+
 
         // gain automation curve only understands audio_sample_t** atm
         // so wrap the process buffers into a audio_sample_t**
-        audio_sample_t* mixdown[m_processBus->get_channel_count()];
-        for(int chan=0; chan<m_processBus->get_channel_count(); chan++) {
-                mixdown[chan] = m_processBus->get_buffer(chan, nframes);
+        audio_sample_t* mixdown[bus->get_channel_count()];
+        for(int chan=0; chan<bus->get_channel_count(); chan++) {
+                mixdown[chan] = bus->get_buffer(chan, nframes);
         }
 
-        TimeRef location = m_sheet->get_transport_location();
         TimeRef endlocation = location + TimeRef(nframes, audiodevice().get_sample_rate());
-        m_fader->process_gain(mixdown, location, endlocation, nframes, m_processBus->get_channel_count());
+        m_fader->process_gain(mixdown, location, endlocation, nframes, bus->get_channel_count(), gainbuffer, ramp);
+}
+
+//
+//  Function called in RealTime AudioThread processing path
+//
+int AudioTrack::process_render_ahead(nframes_t nframes)
+{
+        TimeRef location = m_sheet->get_transport_location();
 
+        // Keep reading while muted, else the render thread assumes
+        // we stopped playing and we'd get a drop out when unmuted.
+        if (m_isMuted || m_mutedBySolo) {
+                m_renderAhead->read(0, location, nframes);
+                return 0;
+        }
 
-        // Post fader plugins now
-        processResult |= m_pluginChain->process_post_fader(m_processBus, nframes);
+        m_processBus->silence_buffers(nframes);
 
-        // TODO: is there a situation where we still want to call process_post_sends
-        // even if processresult == 0?
-        if (processResult) {
-                if (!m_isArmed) {
-                        m_processBus->process_monitoring(m_vumonitors);
+        if (m_renderAhead->read(m_processBus, location, nframes) <= 0) {
+                return 0;
+        }
+
+        m_processBus->process_monitoring(m_vumonitors);
+        process_post_sends(nframes);
+
+        return 1;
+}
+
+//
+//  Called by the TRenderAheadEngine and TParallelExport threads, with Tsar event
+//  processing blocked. The clips, plugins and fader render into the buffers of the context.
+//
+int AudioTrack::render_ahead(nframes_t nframes, TRenderContext* context)
+{
+        AudioBus* bus = context->processBus;
+        PluginChain* pluginChain = context->pluginChain ? context->pluginChain : m_pluginChain;
+        int processResult = 0;
+
+        apill_foreach(AudioClip* clip, AudioClip, m_clips) {
+                int result = clip->process(nframes, context);
+
+                if (result <= 0) {
+                        continue;
                 }
 
-        // And finally do the post sends
-                process_post_sends(nframes);
+                processResult |= result;
         }
 
+        if (bus->is_silent()) {
+                return processResult | pluginChain->process_post_fader(bus, nframes);
+        }
+
+        pluginChain->process_pre_fader(bus, nframes);
+
+        process_pan_and_gain(bus, nframes, context->location, context->gainBuffer);
+
+        processResult |= pluginChain->process_post_fader(bus, nframes);
+
         return processResult;
 }
 
+//
+//  Function called in RealTime AudioThread processing path
+//
+void AudioTrack::locate_render_ahead(const TimeRef& location)
+{
+        if (m_renderAhead) {
+                m_renderAhead->request_location(location, true);
+        }
+}
+
+
+/**
+ * Hands this Track over to the Sheet's render ahead engine, or takes it back
+ * into the audio thread, depending on the render ahead configuration and the
+ * state of this Track. Armed and frozen Tracks, and Tracks with pre fader
+ * sends are always processed in the audio thread.
+ */
+void AudioTrack::update_render_ahead_state()
+{
+        TRenderAheadEngine* engine = m_sheet->get_render_ahead_engine();
+
+        bool eligible = engine && engine->is_enabled()
+                        && !m_isArmed && !m_freezeClip && !m_freezeThread
+                        && m_preSends.isEmpty()
+                        && m_sheet->get_audio_tracks().contains(this);
+
+        if (eligible != (m_renderAheadTrack != 0)) {
+                if (eligible) {
+                        m_renderAheadTrack = engine->add_track(this);
+                } else {
+                        // The render thread doesn't touch it anymore, the audio
+                        // thread might until it processed the Tsar event.
+                        engine->detach_track(m_renderAheadTrack);
+                        m_retiredRenderAheadTracks.append(m_renderAheadTrack);
+                        m_renderAheadTrack = 0;
+                }
+
+                ++m_pendingRenderAheadChanges;
+                THREAD_SAVE_INVOKE_AND_EMIT_SIGNAL(this, m_renderAheadTrack, private_set_render_ahead(TRenderAheadTrack*), renderAheadChanged(TRenderAheadTrack*));
+        }
+
+        update_render_watch();
+}
+
+void AudioTrack::private_set_render_ahead(TRenderAheadTrack* track)
+{
+        m_renderAhead = track;
+
+        if (m_renderAhead) {
+                m_renderAhead->activate();
+        }
+}
+
+void AudioTrack::render_ahead_changed(TRenderAheadTrack* track)
+{
+        Q_UNUSED(track);
+
+        // Once the audio thread processed all our changes,
+        // it no longer uses the retired ones.
+        if (--m_pendingRenderAheadChanges == 0) {
+                qDeleteAll(m_retiredRenderAheadTracks);
+                m_retiredRenderAheadTracks.clear();
+        }
+}
+
 
 TCommand* AudioTrack::toggle_arm()
 {
@@ -351,6 +586,17 @@ TCommand* AudioTrack::toggle_arm()
 }
 
 
+TCommand* AudioTrack::toggle_freeze()
+{
+        if (m_freezeClip || m_freezeThread) {
+                unfreeze();
+        } else {
+                freeze();
+        }
+        return (TCommand*) 0;
+}
+
+
 TCommand* AudioTrack::silence_others( )
 {
         PCommand* command = new PCommand(this, "solo", tr("Silence Other Tracks"));
@@ -397,6 +643,24 @@ QList< AudioClip * > AudioTrack::get_cliplist() const
 }
 
 
+/**
+ * @return The clips overlapping \a start to \a end. The clip list is sorted
+ *	on track start location, so the search stops at the first clip after \a end.
+ */
+QList<AudioClip*> AudioTrack::get_clips_in_range(const TimeRef& start, const TimeRef& end) const
+{
+        QList<AudioClip*> list;
+        apill_foreach(AudioClip* clip, AudioClip, m_clips) {
+                if (clip->get_track_start_location() > end) {
+                        break;
+                }
+                if (clip->get_track_end_location() >= start) {
+                        list.append(clip);
+                }
+        }
+        return list;
+}
+
 AudioClip* AudioTrack::get_clip_after(const TimeRef& pos)
 {
         apill_foreach(AudioClip* clip, AudioClip, m_clips) {
@@ -477,3 +741,429 @@ TCommand* AudioTrack::toggle_show_clip_volume_automation()
 
 	return (TCommand*) 0;
 }
+
+
+/**
+ * Renders the clips, fades, gain automation and plugins of this Track into
+ * a float audio file in the background. Once finished, the Track streams
+ * the rendered file instead of processing all it's clips and plugins.
+ *
+ * The freeze is dropped again as soon as anything that was rendered into it
+ * changes.
+ *
+ * The transport has to be stopped, and can't be started until the render finished.
+ *
+ * @return 1 if the render was started, -1 otherwise
+ */
+int AudioTrack::freeze()
+{
+        PENTER;
+
+        if (m_freezeThread) {
+                return -1;
+        }
+
+        if (m_isArmed) {
+                info().warning(tr("Track %1 is armed for recording, unable to freeze it").arg(m_name));
+                return -1;
+        }
+
+        // Pre fader sends tap the signal before the plugins and fader
+        // which isn't available anymore when frozen.
+        if (!m_preSends.isEmpty()) {
+                info().warning(tr("Track %1 uses pre fader sends, unable to freeze it").arg(m_name));
+                return -1;
+        }
+
+        TimeRef startlocation, endlocation;
+        get_render_range(startlocation, endlocation);
+
+        if (m_clips.isEmpty() || endlocation <= startlocation) {
+                info().information(tr("Track %1 has no audio to freeze").arg(m_name));
+                return -1;
+        }
+
+        if (!m_pluginChain->get_plugin_list().isEmpty()) {
+                endlocation = endlocation + TimeRef(qint64(FREEZE_PLUGIN_TAIL_SECONDS) * UNIVERSAL_SAMPLE_RATE);
+        }
+
+        unfreeze();
+
+        nframes_t blocksize = audiodevice().get_buffer_size();
+        m_freezeResumeLocation = m_sheet->get_transport_location();
+
+        if (m_sheet->prepare_offline_render(startlocation, blocksize) < 0) {
+                info().warning(tr("Stop the transport before freezing Track %1").arg(m_name));
+                return -1;
+        }
+
+        ExportSpecification* spec = new ExportSpecification();
+        spec->startLocation = startlocation;
+        spec->endLocation = endlocation;
+        spec->totalTime = endlocation - startlocation;
+        spec->pos = startlocation;
+        spec->isRecording = false;
+        spec->exportdir = m_sheet->get_audio_sources_dir();
+        spec->writerType = "sndfile";
+        spec->extraFormat["filetype"] = "wav";
+        spec->data_width = 1;	// 1 means float
+        spec->channels = m_processBus->get_channel_count();
+        spec->sample_rate = audiodevice().get_sample_rate();
+        spec->blocksize = blocksize;
+        spec->name = "Freeze-" + QString::number(m_id);
+        spec->dataF = new audio_sample_t[blocksize * spec->channels];
+        spec->running = true;
+        spec->stop = false;
+
+        m_freezeSpec = spec;
+        m_freezeInvalidated = false;
+        m_freezeResult = 0;
+
+        m_freezeThread = new FreezeThread(this);
+        connect(m_freezeThread, SIGNAL(finished()), this, SLOT(freeze_finished()));
+
+        // Changes made during the render invalidate it as well
+        update_render_watch();
+        update_render_ahead_state();
+
+        m_freezeThread->start();
+
+        info().information(tr("Freezing Track %1").arg(m_name));
+
+        return 1;
+}
+
+/**
+ * Stops a running freeze render, or drops the frozen render so the
+ * Track is processed from it's clips and plugins again.
+ */
+void AudioTrack::unfreeze()
+{
+        PENTER;
+
+        if (m_freezeThread) {
+                m_freezeInvalidated = true;
+                m_freezeSpec->stop = true;
+                return;
+        }
+
+        if (m_freezeClip) {
+                set_freeze_clip(0);
+        }
+}
+
+//
+//  Called from the FreezeThread only, the transport is stopped and the
+//  Sheet prepared for an offline render.
+//
+void AudioTrack::render_freeze()
+{
+        ExportSpecification* spec = m_freezeSpec;
+        int rate = audiodevice().get_sample_rate();
+        int channelcount = spec->channels;
+        audio_sample_t* channels[channelcount];
+
+        WriteSource* writesource = new WriteSource(spec);
+        if (writesource->prepare_export() == -1) {
+                delete writesource;
+                m_freezeResult = -1;
+                return;
+        }
+        // Generate the peak data while rendering, so we don't have to
+        // read the whole file again to show it.
+        writesource->set_process_peaks(true);
+
+        m_freezeRendering = 1;
+
+        while (spec->pos < spec->endLocation && !spec->stop) {
+                nframes_t diff = (spec->endLocation - spec->pos).to_frame(rate);
+                nframes_t nframes = std::min(diff, nframes_t(spec->blocksize));
+
+                if (nframes == 0) {
+                        break;
+                }
+
+                // The audio thread keeps processing Tsar events, which
+                // could modify the clips and plugins we are walking.
+                tsar().block_event_processing();
+                process(spec->blocksize);
+                tsar().unblock_event_processing();
+
+                for (int chan=0; chan<channelcount; ++chan) {
+                        channels[chan] = m_processBus->get_buffer(chan, spec->blocksize);
+                        writesource->get_peak()->process(chan, channels[chan], nframes);
+                }
+
+                Mixer::interleave_buffers(spec->dataF, channels, channelcount, nframes);
+
+                if (writesource->process(nframes)) {
+                        spec->stop = true;
+                        break;
+                }
+
+                spec->pos.add_frames(nframes, rate);
+                m_sheet->advance_offline_render(spec->blocksize);
+        }
+
+        m_freezeRendering = 0;
+
+        writesource->finish_export();
+        delete writesource;
+
+        m_freezeResult = spec->stop ? -1 : 1;
+}
+
+void AudioTrack::freeze_finished()
+{
+        PENTER;
+
+        m_freezeThread->wait();
+        delete m_freezeThread;
+        m_freezeThread = 0;
+
+        m_sheet->finish_offline_render();
+        m_sheet->set_transport_pos(m_freezeResumeLocation);
+
+        ExportSpecification* spec = m_freezeSpec;
+        m_freezeSpec = 0;
+        TimeRef startlocation = spec->startLocation;
+        QString dir = spec->exportdir;
+        QString name = spec->name + ".wav";
+        int channels = spec->channels;
+        delete [] spec->dataF;
+        delete spec;
+
+        if (m_freezeResult < 0 || m_freezeInvalidated) {
+                remove_freeze_files(dir, name, channels);
+                update_render_ahead_state();
+                info().information(tr("Freezing Track %1 stopped").arg(m_name));
+                return;
+        }
+
+        ReadSource* source = new ReadSource(dir, name);
+        source->ref();
+        if (source->init() < 0) {
+                info().warning(tr("Unable to use the frozen render of Track %1 (Reason: %2)")
+                                .arg(m_name).arg(source->get_error_string()));
+                delete source;
+                remove_freeze_files(dir, name, channels);
+                update_render_ahead_state();
+                return;
+        }
+
+        // The freeze clip is private to this Track, it's not added to the
+        // ResourcesManager and never saved in the project file. It's files
+        // are removed when it's dropped, see delete_freeze_clip().
+        AudioClip* clip = new AudioClip(tr("Frozen %1").arg(m_name));
+        clip->set_audio_source(source);
+        clip->set_sheet(m_sheet);
+        clip->set_track_start_location(startlocation);
+        clip->set_track(this);
+
+        set_freeze_clip(clip);
+}
+
+void AudioTrack::set_freeze_clip(AudioClip* clip)
+{
+        m_retiredFreezeClip = m_freezeClip;
+
+        THREAD_SAVE_INVOKE_AND_EMIT_SIGNAL(this, clip, private_set_freeze_clip(AudioClip*), freezeClipChanged(AudioClip*));
+}
+
+/**
+ * Deletes \a clip, and the audio and peak files of the freeze render. Nothing
+ * else refers to them, and a frozen Track isn't restored from the project file.
+ */
+void AudioTrack::delete_freeze_clip(AudioClip* clip)
+{
+        if (!clip) {
+                return;
+        }
+
+        ReadSource* source = clip->get_readsource();
+        QString dir, name;
+        int channels = 0;
+
+        if (source) {
+                dir = source->get_dir();
+                name = source->get_name();
+                channels = source->get_channel_count();
+        }
+
+        delete clip;
+
+        if (source) {
+                remove_freeze_files(dir, name, channels);
+        }
+}
+
+void AudioTrack::private_set_freeze_clip(AudioClip* clip)
+{
+        m_freezeClip = clip;
+}
+
+void AudioTrack::freeze_clip_changed(AudioClip* clip)
+{
+        // The audio thread no longer uses the previous freeze clip
+        // so it's safe to delete it now.
+        delete_freeze_clip(m_retiredFreezeClip);
+        m_retiredFreezeClip = 0;
+
+        if (clip) {
+                info().information(tr("Track %1 is frozen").arg(m_name));
+        }
+
+        // (de)activates the ReadSources of our clips
+        emit audibleStateChanged();
+        emit freezeChanged(clip != 0);
+
+        update_render_ahead_state();
+}
+
+void AudioTrack::invalidate_freeze()
+{
+        if (m_freezeThread) {
+                m_freezeInvalidated = true;
+                m_freezeSpec->stop = true;
+                return;
+        }
+
+        if (m_freezeClip) {
+                unfreeze();
+        }
+}
+
+void AudioTrack::invalidate_render()
+{
+        if (m_renderAheadTrack) {
+                m_renderAheadTrack->invalidate();
+        }
+
+        invalidate_freeze();
+}
+
+/**
+ * Watches for changes that invalidate the audio rendered by a freeze
+ * or the render ahead engine, as long as one of them is in use.
+ */
+void AudioTrack::update_render_watch()
+{
+        bool needed = m_freezeThread || m_freezeClip || m_renderAheadTrack;
+
+        if (needed == m_renderWatchActive) {
+                return;
+        }
+
+        if (needed) {
+                start_render_watch();
+        } else {
+                stop_render_watch();
+        }
+}
+
+void AudioTrack::start_render_watch()
+{
+        m_renderWatchActive = true;
+
+        connect(this, SIGNAL(audioClipAdded(AudioClip*)), this, SLOT(watched_clip_added(AudioClip*)));
+        connect(this, SIGNAL(audioClipRemoved(AudioClip*)), this, SLOT(invalidate_render()));
+        connect(this, SIGNAL(stateChanged()), this, SLOT(invalidate_render()));
+        connect(this, SIGNAL(panChanged()), this, SLOT(invalidate_render()));
+        connect(this, SIGNAL(routingConfigurationChanged()), this, SLOT(watched_routing_changed()));
+        connect(m_pluginChain, SIGNAL(pluginAdded(Plugin*)), this, SLOT(watched_plugin_added(Plugin*)));
+        connect(m_pluginChain, SIGNAL(pluginRemoved(Plugin*)), this, SLOT(invalidate_render()));
+
+        watch_curve(m_fader->get_curve());
+
+        foreach(Plugin* plugin, m_pluginChain->get_plugin_list()) {
+                watch_plugin(plugin);
+        }
+
+        apill_foreach(AudioClip* clip, AudioClip, m_clips) {
+                watch_clip(clip);
+        }
+}
+
+void AudioTrack::stop_render_watch()
+{
+        disconnect(this, SIGNAL(audioClipAdded(AudioClip*)), this, SLOT(watched_clip_added(AudioClip*)));
+        disconnect(this, SIGNAL(audioClipRemoved(AudioClip*)), this, SLOT(invalidate_render()));
+        disconnect(this, SIGNAL(stateChanged()), this, SLOT(invalidate_render()));
+        disconnect(this, SIGNAL(panChanged()), this, SLOT(invalidate_render()));
+        disconnect(this, SIGNAL(routingConfigurationChanged()), this, SLOT(watched_routing_changed()));
+        disconnect(m_pluginChain, SIGNAL(pluginAdded(Plugin*)), this, SLOT(watched_plugin_added(Plugin*)));
+        disconnect(m_pluginChain, SIGNAL(pluginRemoved(Plugin*)), this, SLOT(invalidate_render()));
+
+        foreach(QPointer<QObject> object, m_renderWatchList) {
+                if (object) {
+                        disconnect(object, 0, this, 0);
+                }
+        }
+        m_renderWatchList.clear();
+
+        m_renderWatchActive = false;
+}
+
+void AudioTrack::watch_curve(Curve* curve)
+{
+        if (!curve) {
+                return;
+        }
+
+        connect(curve, SIGNAL(stateChanged()), this, SLOT(invalidate_render()));
+        connect(curve, SIGNAL(nodeAdded(CurveNode*)), this, SLOT(invalidate_render()));
+        connect(curve, SIGNAL(nodeRemoved(CurveNode*)), this, SLOT(invalidate_render()));
+        connect(curve, SIGNAL(nodePositionChanged()), this, SLOT(invalidate_render()));
+        m_renderWatchList.append(curve);
+}
+
+void AudioTrack::watch_clip(AudioClip* clip)
+{
+        connect(clip, SIGNAL(positionChanged()), this, SLOT(invalidate_render()));
+        connect(clip, SIGNAL(muteChanged()), this, SLOT(invalidate_render()));
+        connect(clip, SIGNAL(gainChanged()), this, SLOT(invalidate_render()));
+        connect(clip, SIGNAL(fadeAdded(FadeCurve*)), this, SLOT(watched_fade_added(FadeCurve*)));
+        connect(clip, SIGNAL(fadeRemoved(FadeCurve*)), this, SLOT(invalidate_render()));
+        m_renderWatchList.append(clip);
+
+        watch_curve(clip->get_plugin_chain()->get_fader()->get_curve());
+        watch_curve(clip->get_fade_in());
+        watch_curve(clip->get_fade_out());
+}
+
+void AudioTrack::watch_plugin(Plugin* plugin)
+{
+        connect(plugin, SIGNAL(bypassChanged()), this, SLOT(invalidate_render()));
+        m_renderWatchList.append(plugin);
+
+        foreach(PluginControlPort* port, plugin->get_control_ports()) {
+                connect(port, SIGNAL(controlValueChanged(float)), this, SLOT(invalidate_render()));
+                m_renderWatchList.append(port);
+                watch_curve(port->get_curve());
+        }
+}
+
+void AudioTrack::watched_clip_added(AudioClip* clip)
+{
+        watch_clip(clip);
+        invalidate_render();
+}
+
+void AudioTrack::watched_fade_added(FadeCurve* fade)
+{
+        watch_curve(fade);
+        invalidate_render();
+}
+
+void AudioTrack::watched_plugin_added(Plugin* plugin)
+{
+        watch_plugin(plugin);
+        invalidate_render();
+}
+
+void AudioTrack::watched_routing_changed()
+{
+        if (!m_preSends.isEmpty()) {
+                invalidate_render();
+        }
+}
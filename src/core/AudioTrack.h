@@ -26,6 +26,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QString>
 #include <QDomDocument>
 #include <QList>
+#include <QPointer>
 
 #include "ContextItem.h"
 #include "GainEnvelope.h"
@@ -34,6 +35,13 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "defines.h"
 
 class Sheet;
+class AudioClip;
+class Curve;
+class FadeCurve;
+class FreezeThread;
+class TRenderAheadTrack;
+struct ExportSpecification;
+struct TRenderContext;
 
 
 class AudioTrack : public Track
@@ -53,16 +61,25 @@ public :
         Sheet* get_sheet() const {return m_sheet;}
         QDomNode get_state(QDomDocument doc, bool istemplate=false);
         QList<AudioClip*> get_cliplist() const;
+        QList<AudioClip*> get_clips_in_range(const TimeRef& start, const TimeRef& end) const;
         void get_render_range(TimeRef& startlocation, TimeRef& endlocation);
         int get_total_clips();
 	bool show_clip_volume_automation() const {return m_showClipVolumeAutomation;}
+        bool is_frozen() const {return m_freezeClip != 0;}
+        bool is_freezing() const {return m_freezeThread != 0;}
+        AudioClip* get_freeze_clip() const {return m_freezeClip;}
+        TRenderAheadTrack* get_render_ahead_track() const {return m_renderAheadTrack;}
 
         int set_state( const QDomNode& node );
 
         int arm();
         bool armed();
         int disarm();
+        int freeze();
+        void unfreeze();
         int process(nframes_t nframes);
+        int render_ahead(nframes_t nframes, TRenderContext* context);
+        void locate_render_ahead(const TimeRef& location);
 
 protected:
         void add_input_bus(AudioBus* bus);
@@ -74,26 +91,78 @@ private :
         bool            m_isArmed;
 	bool		m_showClipVolumeAutomation;
 
+        // Track freeze
+        AudioClip*              m_freezeClip;
+        AudioClip*              m_retiredFreezeClip;
+        FreezeThread*           m_freezeThread;
+        ExportSpecification*    m_freezeSpec;
+        TimeRef                 m_freezeResumeLocation;
+        volatile size_t         m_freezeRendering;
+        bool                    m_freezeInvalidated;
+        int                     m_freezeResult;
+
+        // Render ahead, m_renderAhead is the audio thread copy
+        // of m_renderAheadTrack, set through Tsar
+        TRenderAheadTrack*      m_renderAhead;
+        TRenderAheadTrack*      m_renderAheadTrack;
+        QList<TRenderAheadTrack*> m_retiredRenderAheadTracks;
+        int                     m_pendingRenderAheadChanges;
+
+        // Freeze and render ahead both watch for changes
+        // that invalidate the rendered audio
+        QList<QPointer<QObject> > m_renderWatchList;
+        bool                    m_renderWatchActive;
+
         void set_armed(bool armed);
         void init();
+        void render_freeze();
+        void set_freeze_clip(AudioClip* clip);
+        void delete_freeze_clip(AudioClip* clip);
+        int process_render_ahead(nframes_t nframes);
+        void process_pan_and_gain(AudioBus* bus, nframes_t nframes, const TimeRef& location, audio_sample_t* gainbuffer=0, bool ramp=false);
+        void update_render_watch();
+        void start_render_watch();
+        void stop_render_watch();
+        void watch_curve(Curve* curve);
+        void watch_clip(AudioClip* clip);
+        void watch_plugin(Plugin* plugin);
+
+        friend class FreezeThread;
 
 signals:
         void audioClipAdded(AudioClip* clip);
         void audioClipRemoved(AudioClip* clip);
 
         void armedChanged(bool isArmed);
+        void freezeChanged(bool isFrozen);
+        void freezeClipChanged(AudioClip* clip);
+        void renderAheadChanged(TRenderAheadTrack* track);
 
 public slots:
         void set_gain(float gain);
         void clip_position_changed(AudioClip* clip);
 
         TCommand* toggle_arm();
+        TCommand* toggle_freeze();
         TCommand* silence_others();
 	TCommand* toggle_show_clip_volume_automation();
 
+        void update_render_ahead_state();
+
 private slots:
         void private_add_clip(AudioClip* clip);
         void private_remove_clip(AudioClip* clip);
+        void private_set_freeze_clip(AudioClip* clip);
+        void freeze_clip_changed(AudioClip* clip);
+        void private_set_render_ahead(TRenderAheadTrack* track);
+        void render_ahead_changed(TRenderAheadTrack* track);
+        void freeze_finished();
+        void invalidate_freeze();
+        void invalidate_render();
+        void watched_clip_added(AudioClip* clip);
+        void watched_fade_added(FadeCurve* fade);
+        void watched_plugin_added(Plugin* plugin);
+        void watched_routing_changed();
 
 };
 
@@ -65,18 +65,23 @@ Curve::~Curve()
 		node = node->next;
 		delete q;
 	}
+	
+	delete (TCurveIndex*)m_index;
+	qDeleteAll(m_retiredIndexes);
 }
 
 void Curve::init( )
 {
 	QObject::tr("Curve");
 	QObject::tr("CurveNode");
-	m_changed = true;
-	m_lookup_cache.left = -1;
+	m_changed = false;
+	m_index = new TCurveIndex;
 	m_defaultValue = 1.0f;
         m_session = 0;
 	
 	connect(this, SIGNAL(nodePositionChanged()), this, SLOT(set_changed()));
+	connect(this, SIGNAL(nodeAdded(CurveNode*)), this, SLOT(update_index()));
+	connect(this, SIGNAL(nodeRemoved(CurveNode*)), this, SLOT(update_index()));
 }
 
 
@@ -120,9 +125,11 @@ int Curve::set_state( const QDomNode & node )
 		double when = whenValueList.at(0).toDouble();
 		double value = whenValueList.at(1).toDouble();
 		CurveNode* node = new CurveNode(this, when, value);
-		private_add_node(node);
+		m_nodes.add_and_sort(node);
 	}
 	
+	set_changed();
+	
 	return 1;
 }
 
@@ -132,7 +139,8 @@ int Curve::process(
 	const TimeRef& endlocation,
 	nframes_t nframes,
 	uint channels,
-	float makeupgain
+	float makeupgain,
+	audio_sample_t* gainbuffer
 	)
 {
 	// Do nothing if there are no nodes!
@@ -155,26 +163,76 @@ int Curve::process(
 		return 1;
 	}
 	
+	// Threads rendering outside the audio thread supply their own buffer
+	if (!gainbuffer) {
+		gainbuffer = m_session->mixdown;
+	}
+	
 	// Calculate the vector, an apply to the buffer including the makeup gain.
-        get_vector(startlocation.universal_frame(), endlocation.universal_frame(), m_session->mixdown, nframes);
+        get_vector(startlocation.universal_frame(), endlocation.universal_frame(), gainbuffer, nframes);
 	
 	for (uint chan=0; chan<channels; ++chan) {
 		for (nframes_t n = 0; n < nframes; ++n) {
-                        buffer[chan][n] *= (m_session->mixdown[n] * makeupgain);
+                        buffer[chan][n] *= (gainbuffer[n] * makeupgain);
 		}
 	}
 	
 	return 1;
 }
 
+/**
+ * Computes the gain for the range \a startlocation to \a endlocation without applying it,
+ * so the caller can combine it with other gain stages in one pass.
+ *
+ * @return 1 if \a vector was filled with \a nframes values, the gain of each frame is then
+ *	vector[frame] * gain, or 0 if the gain is constant over the range, which is returned in \a gain
+ */
+int Curve::get_gain_vector(
+	audio_sample_t* vector,
+	const TimeRef& startlocation,
+	const TimeRef& endlocation,
+	nframes_t nframes,
+	float makeupgain,
+	float& gain
+	)
+{
+	// Same rules as process(): no nodes leaves the audio untouched
+	if (m_nodes.isEmpty()) {
+		gain = 1.0f;
+		return 0;
+	}
+	
+	if (endlocation > qint64(get_range())) {
+		gain = ((CurveNode*)m_nodes.last())->value * makeupgain;
+		return 0;
+	}
+	
+        get_vector(startlocation.universal_frame(), endlocation.universal_frame(), vector, nframes);
+	gain = makeupgain;
+	
+	return 1;
+}
 
+
+// The audio thread, the GUI thread and the render threads evaluate a Curve
+// concurrently. The thread owning the Curve (the GUI thread) solves it after a
+// change into a new index, with the spline coefficients stored in the index
+// entries, and publishes that one. The evaluating threads never allocate, free
+// or lock, see get_vector().
 void Curve::solve ()
 {
 	uint32_t npoints;
 
-	if (!m_changed) {
-		printf("Curve::solve, no data change\n");
-		return;
+	m_changed = false;
+	
+	TCurveIndex* index = new TCurveIndex;
+	index->reserve(m_nodes.size());
+	apill_foreach(CurveNode* node, CurveNode, m_nodes) {
+		TCurvePoint point;
+		point.node = node;
+		point.value = node->value;
+		point.coeff[0] = point.coeff[1] = point.coeff[2] = point.coeff[3] = 0.0;
+		index->append(node->when, point);
 	}
 	
 	if ((npoints = m_nodes.size()) > 2) {
@@ -189,12 +247,9 @@ void Curve::solve ()
 		uint32_t i;
 		QList<CurveNode* >::iterator xx;
 
-		CurveNode* cn;
-		i = 0;
-		for(APILinkedListNode* node = m_nodes.first(); node!=0; node = node->next, ++i) {
-			cn = (CurveNode*)node;
-			x[i] = cn->when;
-			y[i] = cn->value;
+		for (i = 0; i < npoints; ++i) {
+			x[i] = index->key(i);
+			y[i] = index->at(i).value;
 		}
 
 		double lp0, lp1, fpone;
@@ -210,17 +265,7 @@ void Curve::solve ()
 
 		double fplast = 0;
 
-		i = 0;
-		for(APILinkedListNode* node = m_nodes.first(); node!=0; node = node->next, ++i) {
-			
-			cn = (CurveNode*)node;
-			
-			if (cn == 0) {
-/*				qCritical  << _("programming error: ")
-				<< X_("non-CurvePoint event found in event list for a Curve")
-				<< endmsg;*/
-				/*NOTREACHED*/
-			}
+		for (i = 0; i < npoints; ++i) {
 			
 			double xdelta;   /* gcc is wrong about possible uninitialized use */
 			double xdelta2;  /* ditto */
@@ -292,16 +337,23 @@ void Curve::solve ()
 
 			/* store */
 			
-			cn->coeff[0] = y[i-1] - (b * x[i-1]) - (c * xim12) - (d * xim13);
-			cn->coeff[1] = b;
-			cn->coeff[2] = c;
-			cn->coeff[3] = d;
+			double* coeff = index->item(i).coeff;
+			coeff[0] = y[i-1] - (b * x[i-1]) - (c * xim12) - (d * xim13);
+			coeff[1] = b;
+			coeff[2] = c;
+			coeff[3] = d;
 
 			fplast = fpi;
 		}
 	}
 
-	m_changed = false;
+	// A reader that got the previous index before the swap is counted in
+	// m_readers, it's freed once there are none, here or on the next solve().
+	m_retiredIndexes.append(m_index.fetchAndStoreOrdered(index));
+	if (m_readers.fetchAndAddOrdered(0) == 0) {
+		qDeleteAll(m_retiredIndexes);
+		m_retiredIndexes.clear();
+	}
 }
 
 
@@ -425,153 +477,76 @@ void Curve::get_vector (double x0, double x1, float *vec, int32_t veclen)
 		return;
 	}
 
-	if (m_changed) {
-		solve ();
-	}
-
 	rx = lx;
 
 	if (veclen > 1) {
 
 		dx = (hx - lx) / veclen;
 
-		for (i = 0; i < veclen; ++i, rx += dx) {
-			vec[i] = multipoint_eval (rx);
-		}
-	}
-}
+		// The finger is local, so get_vector() can be called from several
+		// threads at once. The index stays valid while we're counted as reader.
+		m_readers.fetchAndAddOrdered(1);
+		const TCurveIndex* index = m_index.fetchAndAddOrdered(0);
+		int finger = -1;
 
-double Curve::multipoint_eval(double x)
-{	
-	if ((m_lookup_cache.left < 0) ||
-		((m_lookup_cache.left > x) || (m_lookup_cache.range.second->when < x))) {
-		
-		CurveNode cn (this, x, 0.0);
-
-		APILinkedListNode* first = m_nodes.first();
-		APILinkedListNode* last = m_nodes.last();
-		APILinkedListNode* middle;
-		bool validrange = false;
-		int len = m_nodes.size() - 1;
-		int half;
-		
-		while (len > 0) {
-			half = len >> 1;
-			middle = first;
-			// advance middle by half
-			int n = half;
-			while (n--) {
-				middle = middle->next;
+		// Nodes were added by the audio thread, and the GUI thread didn't solve yet
+		if (index->size() < 3) {
+			for (i = 0; i < veclen; ++i) {
+				vec[i] = firstnode->value;
 			}
-			//start compare
-			if (((CurveNode*)middle)->when < cn.when) {
-				first = middle;
-				first = first->next;
-				len = len - half - 1;
-			} else if (cn.when < ((CurveNode*)middle)->when) {
-				len = half;
-			} else {
-				// lower bound (using first/middle)
-				APILinkedListNode* lbfirst = first;
-				APILinkedListNode* lblast = middle;
-				APILinkedListNode* lbmiddle;
-				// start distance.
-				int lblen = 0;
-				APILinkedListNode* temp = lbfirst;
-				while (temp != lblast) {
-					temp = temp->next;
-					++lblen;
-				}
-				
-				int lbhalf;
-				while (lblen > 0) {
-					lbhalf = lblen >> 1;
-					lbmiddle = lbfirst;
-					// advance middle by half
-					n = lbhalf;
-					while (n--) {
-						lbmiddle = lbmiddle->next;
-					}
-					if (((CurveNode*)lbmiddle)->when < cn.when) {
-						lbfirst = lbmiddle;
-						lbfirst = lbfirst->next;
-						lblen = lblen - lbhalf - 1;
-					} else {
-						lblen = lbhalf;
-					}
-				}
-				m_lookup_cache.range.first = (CurveNode*)lbfirst;
-				
-
-				// upper bound
-				APILinkedListNode* ubfirst = middle->next;
-				APILinkedListNode* ublast = last;
-				APILinkedListNode* ubmiddle;
-				// start distance.
-				int ublen = 0;
-				temp = ubfirst;
-				while (temp != ublast) {
-					temp = temp->next;
-					++ublen;
-				}
-				
-				int ubhalf;
-				while (ublen > 0) {
-					ubhalf = ublen >> 1;
-					ubmiddle = ubfirst;
-					// advance middle by half
-					n = ubhalf;
-					while (n--) {
-						ubmiddle = ubmiddle->next;
-					}
-					
-					if (cn.when < ((CurveNode*)ubmiddle)->when) {
-						ublen = ubhalf;
-					} else {
-						ubfirst = ubmiddle;
-						ubfirst = ubfirst->next;
-						ublen = ublen - ubhalf - 1;
-					}
-				}
-				m_lookup_cache.range.second = (CurveNode*)ubfirst;
-				
-				validrange = true;
-				break;
+		} else {
+			for (i = 0; i < veclen; ++i, rx += dx) {
+				vec[i] = multipoint_eval (*index, rx, finger);
 			}
 		}
-		if (!validrange) {
-			m_lookup_cache.range.first = (CurveNode*)first;
-			m_lookup_cache.range.second = (CurveNode*)first;
-		}
+		
+		m_readers.fetchAndAddOrdered(-1);
 	}
-	
-	/* EITHER 
-	
-	a) x is an existing control point, so first == existing point, second == next point
+}
 
-	OR
+/**
+ * @return The nodes ordered by position. Only call from the GUI thread,
+ *	which is the one that rebuilds the index.
+ */
+TCurveIndex Curve::get_index()
+{
+	update_index();
+	return *m_index;
+}
 
-	b) x is between control points, so range is empty (first == second, points to where
-	to insert x)
-	
-	*/
+/**
+ * @return The nodes from \a start up to and including \a end, ordered by position
+ */
+QList<CurveNode*> Curve::get_nodes_in_range(double start, double end)
+{
+	QList<CurveNode*> nodes;
+	TCurveIndex index = get_index();
+	int first, last;
 
-	if (m_lookup_cache.range.first == m_lookup_cache.range.second) {
+	index.range(start, end, first, last);
+	for (int i=first; i<last; ++i) {
+		nodes.append(index.at(i).node);
+	}
 
-		/* x does not exist within the list as a control point */
-		
-		m_lookup_cache.left = x;
+	return nodes;
+}
 
-		double x2 = x * x;
-		CurveNode* cn = m_lookup_cache.range.second;
-		
-		return cn->coeff[0] + (cn->coeff[1] * x) + (cn->coeff[2] * x2) + (cn->coeff[3] * x2 * x);
-	} 
+double Curve::multipoint_eval(const TCurveIndex& index, double x, int& finger)
+{
+	int i = index.segment(x, finger);
 
 	/* x is a control point in the data */
-	/* invalidate the cached range because its not usable */
-	m_lookup_cache.left = -1;
-	return m_lookup_cache.range.first->value;
+	if (i >= 0 && index.key(i) == x) {
+		return index.at(i).value;
+	}
+
+	/* x is between control points i and i + 1, the coefficients
+	   of a segment are stored in it's right control point
+	*/
+	const double* coeff = index.at(qBound(0, i + 1, index.size() - 1)).coeff;
+	double x2 = x * x;
+
+	return coeff[0] + (coeff[1] * x) + (coeff[2] * x2) + (coeff[3] * x2 * x);
 }
 
 void Curve::set_range(double when)
@@ -612,12 +587,22 @@ void Curve::x_scale(double factor)
 	apill_foreach(CurveNode* node, CurveNode, m_nodes) {
 		node->set_when(node->when * factor);
 	}
+	
+	set_changed();
 }
 
+// GUI thread only
 void Curve::set_changed( )
 {
-	m_lookup_cache.left = -1;
 	m_changed = true;
+	update_index();
+}
+
+void Curve::update_index()
+{
+	if (m_changed) {
+		solve();
+	}
 }
 
 
@@ -640,8 +625,11 @@ TCommand* Curve::add_node(CurveNode* node, bool historable)
 {
 	PENTER2;
 	
-	apill_foreach(CurveNode* cn, CurveNode, m_nodes) {
-		if (node->when == cn->when && node->value == cn->value) {
+	TCurveIndex index = get_index();
+	int first, last;
+	index.range(node->when, node->when, first, last);
+	for (int i=first; i<last; ++i) {
+		if (node->value == index.at(i).value) {
 			info().warning(tr("There is allready a node at this exact position, not adding a new node"));
 			delete node;
 			return 0;
@@ -692,16 +680,18 @@ TCommand* Curve::remove_node(CurveNode* node, bool historable)
 	return cmd;
 }
 
+// Called in the audio thread, the index is rebuilt by update_index()
+// in the GUI thread, when nodeAdded() or nodeRemoved() is emitted.
 void Curve::private_add_node( CurveNode * node )
 {
 	m_nodes.add_and_sort(node);
-	set_changed();
+	m_changed = true;
 }
 
 void Curve::private_remove_node( CurveNode * node )
 {
 	m_nodes.remove(node);
-	set_changed();
+	m_changed = true;
 }
 
 void Curve::set_sheet(TSession * sheet)
@@ -34,13 +34,25 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QString>
 #include <QList>
 #include <QDomDocument>
+#include <QAtomicInt>
+#include <QAtomicPointer>
 
 #include "CurveNode.h"
+#include "TTimeIndex.h"
 #include "defines.h"
 
 
 class TSession;
 
+// A node, with the coefficients of the segment that ends at it
+struct TCurvePoint {
+	CurveNode*	node;
+	double		value;
+	double		coeff[4];
+};
+
+typedef TTimeIndex<double, TCurvePoint> TCurveIndex;
+
 class Curve : public ContextItem
 {
 	Q_OBJECT
@@ -52,7 +64,8 @@ public:
 
 	QDomNode get_state(QDomDocument doc, const QString& name);
 	virtual int set_state( const QDomNode& node );
-	int process(audio_sample_t** buffer, const TimeRef& startlocation, const TimeRef& endlocation, nframes_t nframes, uint channels, float makeupgain=1.0f);
+	int process(audio_sample_t** buffer, const TimeRef& startlocation, const TimeRef& endlocation, nframes_t nframes, uint channels, float makeupgain=1.0f, audio_sample_t* gainbuffer=0);
+	int get_gain_vector(audio_sample_t* vector, const TimeRef& startlocation, const TimeRef& endlocation, nframes_t nframes, float makeupgain, float& gain);
 	
 	TCommand* add_node(CurveNode* node, bool historable=true);
 	TCommand* remove_node(CurveNode* node, bool historable=true);
@@ -61,6 +74,8 @@ public:
 	double get_range() const;
 	void get_vector (double x0, double x1, float *arg, int32_t veclen);
 	APILinkedList& get_nodes() {return m_nodes;}
+	TCurveIndex get_index();
+	QList<CurveNode*> get_nodes_in_range(double start, double end);
         TSession* get_sheet() const {return m_session;}
 
 	// Set functions
@@ -71,7 +86,7 @@ public:
 		return left->get_when() < right->get_when();
 	}
 	
-	void clear_curve() {m_nodes.clear();}
+	void clear_curve() {m_nodes.clear(); set_changed();}
         void set_start_offset(TimeRef offset) {m_startoffset = offset;}
         TimeRef get_start_offset() const {return m_startoffset;}
 
@@ -81,18 +96,15 @@ protected:
 
 private :
 	APILinkedList m_nodes;
-	struct LookupCache {
-		double left;  /* leftmost x coordinate used when finding "range" */
-		std::pair<CurveNode*, CurveNode*> range;
-		
-	};
-        LookupCache     m_lookup_cache;
-        bool            m_changed;
+        QAtomicPointer<TCurveIndex> m_index;
+        QAtomicInt      m_readers;
+        QList<TCurveIndex*> m_retiredIndexes;
+        volatile bool   m_changed;
         double          m_defaultValue;
         TimeRef		m_startoffset;
 
 	
-	double multipoint_eval (double x);
+	double multipoint_eval (const TCurveIndex& index, double x, int& finger);
 	void x_scale(double factor);
 	void solve ();
 	void init();
@@ -101,6 +113,7 @@ private :
 
 protected slots:
 	void set_changed();
+	void update_index();
 
 private slots:
 	void private_add_node(CurveNode* node);
@@ -35,8 +35,6 @@ public:
 	CurveNode(Curve* curve, double when, double  val)
 		: m_curve(curve)
 	{
-		coeff[0] = coeff[1] = coeff[2] = coeff[3] = 0.0;
-	
 		this->when = when;
 		this->value = val;
 	}
@@ -64,7 +62,6 @@ public:
 	double 	value;
 	
 private:
-	double  coeff[4];
 /*	double 	when;
 	double 	value;*/
 	
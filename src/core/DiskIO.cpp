@@ -75,6 +75,8 @@ const char *to_prio[] = { "none", "realtime", "best-effort", "idle", };
 #include "AudioDevice.h"
 #include "RingBuffer.h"
 #include "TConfig.h"
+#include "TMemoryBudget.h"
+#include "TTimelineTracer.h"
 
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
@@ -82,6 +84,7 @@ const char *to_prio[] = { "none", "realtime", "best-effort", "idle", };
 
 
 #define UPDATE_INTERVAL		20
+#define HEAD_CACHE_INTERVAL	50
 
 
 // DiskIOThread is a private class to be used by
@@ -104,6 +107,8 @@ public:
 protected:
 	void run()
 	{
+                TRACE_THREAD("DiskIO");
+
 #if defined (Q_WS_X11) 
 	if (IOPRIO_SUPPORT) {
 // When using the cfq scheduler we are able to set the priority of the io for what it's worth though :-) 
@@ -138,6 +143,14 @@ protected:
  *	Each Sheet class has it's own DiskIO instance. 
  * 	The DiskIO manages all the AudioSources related to a Sheet, and makes sure the RingBuffers
  * 	from the AudioSources are processed in time. (It at least tries very hard)
+ *
+ *	In the background, the first few hundred milliseconds of each clip, and of the audio
+ *	after each marker, are read into the head cache of the ReadSources. After a seek, the
+ *	ringbuffers of ReadSources with cached audio at the new location are filled from the
+ *	cache, and DiskIO only waits for the others to be read from disk before the seek is
+ *	finished. The cached ones are refilled from disk as usual once the transport runs.
+ *	The cache time and size are set with the Hardware/HeadCacheTime (milliseconds) and
+ *	Hardware/HeadCacheSize (MB) configuration keys.
  */
 DiskIO::DiskIO(Sheet* sheet)
 	: m_sheet(sheet)
@@ -146,8 +159,13 @@ DiskIO::DiskIO(Sheet* sheet)
         m_lastdoWorkReadTime = get_microseconds();
 	m_stopWork = m_seeking = m_sampleRateChanged = 0;
 	m_resampleQuality = config().get_property("Conversion", "RTResamplingConverterType", DEFAULT_RESAMPLE_QUALITY).toInt();
+	m_polyphaseResampling = config().get_property("Conversion", "PolyphaseResampling", false).toBool();
 	m_readBufferFillStatus = m_writeBufferFillStatus = 0;
 	m_hardDiskOverLoadCounter = 0;
+	m_headCacheTime = config().get_property("Hardware", "HeadCacheTime", 300).toInt();
+	m_maxHeadCacheSize = qint64(config().get_property("Hardware", "HeadCacheSize", 64).toInt()) * 1024 * 1024;
+	m_headCacheSize = m_reportedHeadCacheSize = 0;
+	m_headCacheIndex = 0;
 	
 	// TODO This is a LARGE buffer, any ideas how to make it smaller ??
 	framebuffer[0] = new audio_sample_t[audiodevice().get_sample_rate() * writebuffertime];
@@ -158,16 +176,24 @@ DiskIO::DiskIO(Sheet* sheet)
         // Move this instance to the workthread
         moveToThread(m_diskThread);
         m_workTimer.moveToThread(m_diskThread);
+        m_headCacheTimer.moveToThread(m_diskThread);
 
         connect(&m_workTimer, SIGNAL(timeout()), this, SLOT(do_work()));
+        connect(&m_headCacheTimer, SIGNAL(timeout()), this, SLOT(update_head_caches()));
 
         m_diskThread->start();
+
+        if (m_headCacheTime > 0) {
+                // The timer lives in the diskthread, so start it from there
+                QMetaObject::invokeMethod(&m_headCacheTimer, "start", Qt::QueuedConnection, Q_ARG(int, HEAD_CACHE_INTERVAL));
+        }
 }
 
 DiskIO::~DiskIO()
 {
 	PENTERDES;
 	stop();
+	memorybudget().remove(TMemoryBudget::HeadCache, m_reportedHeadCacheSize);
 	delete [] framebuffer[0];
 	delete m_decodebuffer;
 	delete m_resampleDecodeBuffer;
@@ -194,11 +220,20 @@ void DiskIO::seek()
 	
 	TimeRef location = m_sheet->get_new_transport_location();
 
+	// Sources with enough cached audio at the new location don't have
+	// to wait for the disk, they are refilled after the seek finished.
+	nframes_t primeMinimum = nframes_t((qint64(m_headCacheTime) * m_outputRate) / 2000);
+	m_primedReadSources.clear();
+
 	foreach(ReadSource* source, m_readSources) {
 		if (m_sampleRateChanged) {
 			source->set_diskio(this);
 		}
 		source->rb_seek_to_file_position(location);
+		
+		if (m_headCacheTime > 0 && source->prime_from_head_cache() >= primeMinimum) {
+			m_primedReadSources.insert(source);
+		}
 	}
 	
 	m_sampleRateChanged = false;
@@ -211,6 +246,7 @@ void DiskIO::seek()
         t_atomic_int_set(&m_readBufferFillStatus, 0);
 
 	m_seeking = false;
+	m_primedReadSources.clear();
 
 	emit seekFinished();
 }
@@ -229,6 +265,7 @@ void DiskIO::do_work( )
 #if defined (THREAD_CHECK)
 	Q_ASSERT_X(m_sheet->threadId != QThread::currentThreadId (), "DiskIO::do_work", "Error, running in gui thread!!!!!");
 #endif
+        TRACE_SCOPE("DiskIO::do_work");
 
 	QMutexLocker locker(&mutex);
 	
@@ -318,6 +355,10 @@ int DiskIO::there_are_processable_sources( )
 			ReadSource* source = m_readersStatus.at(pair).second;
 			BufferStatus* status = m_readersStatus.at(pair).first;
 			
+			if (m_seeking && m_primedReadSources.contains(source)) {
+				continue;
+			}
+			
 			if (status->priority > i && !status->needSync ) {
 				
 				if ( (! m_seeking) && status->bufferUnderRun ) {
@@ -399,6 +440,8 @@ void DiskIO::register_read_source (ReadSource* source )
 	QMutexLocker locker(&mutex);
 
 	m_readSources.append(source);
+	m_headCacheSize += source->get_head_cache_size();
+	report_head_cache_size();
 }
 
 /**
@@ -428,7 +471,65 @@ void DiskIO::unregister_read_source( ReadSource * source )
 {
         QMutexLocker locker(&mutex);
 	
-	m_readSources.removeAll(source);
+	if (m_readSources.removeAll(source)) {
+		m_headCacheSize -= source->get_head_cache_size();
+		report_head_cache_size();
+	}
+}
+
+/**
+ *	Sets the Sheet locations, like the marker positions, of which the audio
+ *	following it is kept in the head cache of the ReadSources.
+ *
+ *	Note: This function is thread save.
+ */
+void DiskIO::set_head_cache_locations(const QList<TimeRef>& locations)
+{
+	QMutexLocker locker(&mutex);
+	
+	m_headCacheLocations = locations;
+}
+
+// Internal function, reads at most one missing head cache region each
+// time it is called, so it never keeps the diskthread busy for long.
+void DiskIO::update_head_caches()
+{
+	if (m_seeking || !mutex.tryLock()) {
+		return;
+	}
+	
+	nframes_t frames = nframes_t((qint64(m_headCacheTime) * m_outputRate) / 1000);
+	int count = m_readSources.size();
+	qint64 maxCacheSize = memorybudget().get_cache_allowance(TMemoryBudget::HeadCache, m_maxHeadCacheSize);
+	
+	// Over the memory budget, drop the caches of whole ReadSources until it fits again
+	for (int i=0; i<count && m_headCacheSize > maxCacheSize; ++i) {
+		m_readSources.at(i)->update_head_cache(m_decodebuffer, QList<TimeRef>(), 0, m_headCacheSize, 0);
+	}
+	
+	for (int i=0; i<count; ++i) {
+		m_headCacheIndex = (m_headCacheIndex + 1) % count;
+		ReadSource* source = m_readSources.at(m_headCacheIndex);
+		
+		if (source->update_head_cache(m_decodebuffer, m_headCacheLocations, frames, m_headCacheSize, maxCacheSize)) {
+			break;
+		}
+	}
+	
+	report_head_cache_size();
+	
+	mutex.unlock();
+}
+
+// Internal function, call with the mutex locked
+void DiskIO::report_head_cache_size()
+{
+	if (m_headCacheSize == m_reportedHeadCacheSize) {
+		return;
+	}
+	
+	memorybudget().add(TMemoryBudget::HeadCache, m_headCacheSize - m_reportedHeadCacheSize);
+	m_reportedHeadCacheSize = m_headCacheSize;
 }
 
 
@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QMutex>
 #include <QList>
 #include <QTimer>
+#include <QSet>
 #include <QPair>
 
 #include "defines.h"
@@ -64,12 +65,15 @@ public:
 	
 	void unregister_read_source(ReadSource* source);
 	void unregister_write_source(WriteSource* source);
+	
+	void set_head_cache_locations(const QList<TimeRef>& locations);
 
 	trav_time_t get_cpu_time();
 	int get_write_buffers_fill_status();
 	int get_read_buffers_fill_status();
 	int get_output_rate() {return m_outputRate;}
 	int get_resample_quality() {return m_resampleQuality;}
+	bool get_polyphase_resampling() const {return m_polyphaseResampling;}
 	DecodeBuffer* get_resample_decode_buffer() {return m_resampleDecodeBuffer;}
 
 private:
@@ -81,8 +85,11 @@ private:
 	QList<WriteSource*>	m_processableWriteSources;
 	QList<QPair<BufferStatus*, ReadSource*> > m_readersStatus;
 	QList<QPair<int, WriteSource*> > m_writersStatus;
+	QSet<ReadSource*>	m_primedReadSources;
+	QList<TimeRef>		m_headCacheLocations;
 	DiskIOThread*		m_diskThread;
         QTimer			m_workTimer;
+        QTimer			m_headCacheTimer;
         QMutex			mutex;
 	volatile int		m_readBufferFillStatus;
 	volatile int		m_writeBufferFillStatus;
@@ -91,6 +98,7 @@ private:
         trav_time_t		m_lastdoWorkReadTime;
 	bool			m_seeking;
 	int			m_resampleQuality;
+	bool			m_polyphaseResampling;
 	bool			m_sampleRateChanged;
 	int			m_hardDiskOverLoadCounter;
 	audio_sample_t*		framebuffer[2];
@@ -98,9 +106,15 @@ private:
 	DecodeBuffer*		m_decodebuffer;
 	DecodeBuffer*		m_resampleDecodeBuffer;
 	int			m_outputRate;
+	int			m_headCacheTime;
+	int			m_headCacheIndex;
+	qint64			m_headCacheSize;
+	qint64			m_maxHeadCacheSize;
+	qint64			m_reportedHeadCacheSize;
 
 	
 	void update_time_usage();
+	void report_head_cache_size();
 	
         int stop();
 	int there_are_processable_sources();
@@ -114,6 +128,7 @@ public slots:
 
 private slots:
         void do_work();
+	void update_head_caches();
 
 signals:
 	void seekFinished();
@@ -22,6 +22,7 @@
 
 #include "Export.h"
 #include "Project.h"
+#include "TTimelineTracer.h"
 #include <cstdio>
 
 // Always put me below _all_ includes, this is needed
@@ -43,6 +44,7 @@ void ExportThread::set_specification(ExportSpecification * spec)
 
 void ExportThread::run( )
 {
+        TRACE_THREAD("Export");
         m_project->start_export(m_spec);
 }
 
@@ -167,22 +167,29 @@ int FadeCurve::set_state( const QDomNode & node )
 }
 
 
-void FadeCurve::process(AudioBus *bus, nframes_t nframes)
+/**
+ * Applies this fade to \a gain, the gain vector of the \a nframes frames starting at
+ * \a transportLocation, so AudioClip can apply all its gain stages in one pass.
+ *
+ * @param scratch A buffer of at least \a nframes, used to compute the fade vector
+ * @param initialized If false, \a gain is set to 1.0 first
+ * @return 1 if the fade covers (part of) the frames and \a gain has been set, 0 otherwise
+ */
+int FadeCurve::process_gain(audio_sample_t* gain, audio_sample_t* scratch, nframes_t nframes, const TimeRef& transportLocation, bool initialized)
 {
 
         if (is_bypassed()) {
-		return;
+		return 0;
 	}
 	
 	
-        audio_sample_t* mixdown[bus->get_channel_count()];
         int outputRate = audiodevice().get_sample_rate();
         uint framesToProcess = nframes;
+        uint offset = 0;
 
         TimeRef trackStartLocation, trackEndLocation, mix_pos;
         TimeRef fadeRange = TimeRef(get_range());
 
-        TimeRef transportLocation = m_session->get_transport_location();
         TimeRef upperRange = transportLocation + TimeRef(framesToProcess, outputRate);
 
 	
@@ -200,21 +207,13 @@ void FadeCurve::process(AudioBus *bus, nframes_t nframes)
                         // Using to_frame() for both the m_trackStartLocation and transportLocation seems to round
                         // better then using (m_trackStartLocation - transportLocation).to_frame()
                         // TODO : find out why!
-                        uint offset = (trackStartLocation).to_frame(outputRate) - transportLocation.to_frame(outputRate);
+                        offset = (trackStartLocation).to_frame(outputRate) - TimeRef(transportLocation).to_frame(outputRate);
                         mix_pos = TimeRef();
 //                        printf("offset %d\n", offset);
 
-                        for (int chan=0; chan<bus->get_channel_count(); ++chan) {
-                                audio_sample_t* buf = bus->get_buffer(chan, framesToProcess);
-                                mixdown[chan] = buf + offset;
-                        }
                         framesToProcess = framesToProcess - offset;
                 } else {
                         mix_pos = (transportLocation - trackStartLocation);
-
-                        for (int chan=0; chan<bus->get_channel_count(); ++chan) {
-                                mixdown[chan] = bus->get_buffer(chan, framesToProcess);
-                        }
                 }
                 if (trackEndLocation < upperRange) {
                         // Using to_frame() for both the upperRange and m_trackEndLocation seems to round
@@ -224,19 +223,25 @@ void FadeCurve::process(AudioBus *bus, nframes_t nframes)
 // 			printf("if (m_trackEndLocation < upperRange): framesToProcess %d\n", framesToProcess);
                 }
         } else {
-                return;
+                return 0;
         }
 
 
         upperRange = mix_pos + TimeRef(framesToProcess, outputRate);
 
-        get_vector(mix_pos.universal_frame(), upperRange.universal_frame(), m_session->gainbuffer, framesToProcess);
-
-        for (int chan=0; chan<bus->get_channel_count(); ++chan) {
-                for (nframes_t frame = 0; frame < framesToProcess; ++frame) {
-                        mixdown[chan][frame] *= m_session->gainbuffer[frame];
+        if (!initialized) {
+                for (nframes_t frame = 0; frame < nframes; ++frame) {
+                        gain[frame] = 1.0f;
                 }
         }
+
+        get_vector(mix_pos.universal_frame(), upperRange.universal_frame(), scratch, framesToProcess);
+
+        for (nframes_t frame = 0; frame < framesToProcess; ++frame) {
+                gain[offset + frame] *= scratch[frame];
+        }
+
+        return 1;
 }
 
 
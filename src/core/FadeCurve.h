@@ -52,7 +52,7 @@ public:
 	QDomNode get_state(QDomDocument doc);
 	int set_state( const QDomNode & node );
 	
-        void process(AudioBus* bus, nframes_t nframes);
+        int process_gain(audio_sample_t* gain, audio_sample_t* scratch, nframes_t nframes, const TimeRef& transportLocation, bool initialized);
 	
 	float get_bend_factor() {return m_bendFactor;}
 	float get_strength_factor() {return m_strenghtFactor;}
@@ -29,6 +29,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "defines.h"
 #include "Mixer.h"
 #include "FileHelpers.h"
+#include "TTimelineTracer.h"
 #include <QFileInfo>
 #include <QDateTime>
 #include <QMutexLocker>
@@ -54,21 +55,12 @@ Peak::Peak(AudioSource* source)
 	
 	m_peaksAvailable = m_permanentFailure = m_interuptPeakBuild = false;
 	
-	QString sourcename = source->get_name();
-	QString path;
-	Project* project = pm().get_project();
-	if (project) {
-		path = project->get_root_dir() + "/peakfiles/";
-	} else {
-		path = source->get_dir();
-		path = path.replace("audiosources", "peakfiles");
-	}
+	QStringList fileNames = get_peak_file_names(source->get_dir(), source->get_name(), source->get_channel_count());
 	
-	for (uint chan = 0; chan < source->get_channel_count(); ++ chan) {
+	foreach(const QString& fileName, fileNames) {
 		ChannelData* data = new Peak::ChannelData;
 		
-		data->fileName = sourcename + "-ch" + QByteArray::number(chan) + ".peak";
-		data->fileName.prepend(path);
+		data->fileName = fileName;
 		data->pd = 0;
 		data->peakreader = 0;
 		
@@ -87,6 +79,29 @@ Peak::Peak(AudioSource* source)
 	}
 }
 
+/**
+ * @return The names of the peak files of the channels of the AudioSource
+ *	\a sourceName in \a sourceDir
+ */
+QStringList Peak::get_peak_file_names(const QString& sourceDir, const QString& sourceName, uint channelCount)
+{
+	QString path;
+	Project* project = pm().get_project();
+	if (project) {
+		path = project->get_root_dir() + "/peakfiles/";
+	} else {
+		path = sourceDir;
+		path = path.replace("audiosources", "peakfiles");
+	}
+	
+	QStringList fileNames;
+	for (uint chan = 0; chan < channelCount; ++ chan) {
+		fileNames.append(path + sourceName + "-ch" + QByteArray::number(chan) + ".peak");
+	}
+	
+	return fileNames;
+}
+
 Peak::~Peak()
 {
 	PENTERDES;
@@ -589,6 +604,7 @@ void Peak::process(uint channel, audio_sample_t* buffer, nframes_t nframes)
 int Peak::create_from_scratch()
 {
 	PENTER;
+        TRACE_SCOPE("Peak::create_from_scratch");
 	
 // PROFILE_START;
 	
@@ -852,6 +868,7 @@ PPThread::PPThread(PeakProcessor * pp)
 
 void PPThread::run()
 {
+        TRACE_THREAD("PeakBuilder");
 	exec();
 }
 
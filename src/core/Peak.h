@@ -30,6 +30,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QFile>
 #include <QHash>
 #include <QPair>
+#include <QStringList>
 
 #include "defines.h"
 
@@ -124,6 +125,7 @@ public:
 	
 	static QHash<int, int>* cache_index_lut();
 	static int max_zoom_value();
+	static QStringList get_peak_file_names(const QString& sourceDir, const QString& sourceName, uint channelCount);
 
 private:
 	ReadSource* 	m_source;
@@ -189,6 +191,7 @@ private:
 
 	friend class PeakProcessor;
 	friend class PeakDataReader;
+	friend class TBenchmark;
 
 signals:
 	void finished();
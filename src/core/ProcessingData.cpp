@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 
 #include "AudioClip.h"
 #include "AudioClipManager.h"
+#include "AudioBus.h"
 #include "PluginChain.h"
 #include "TSession.h"
 #include "limits"
@@ -45,7 +46,7 @@ ProcessingData::ProcessingData(TSession *session)
 
         m_processBus = 0;
         m_isMuted = false;
-        m_pan = 0.0f;
+        m_skippedCycles = 0;
         m_fader = m_pluginChain->get_fader();
 }
 
@@ -60,22 +61,39 @@ void ProcessingData::set_name( const QString & name )
 void ProcessingData::set_pan(float pan)
 {
         if ( pan < -1.0 ) {
-                m_pan=-1.0;
-        } else {
-                if ( pan > 1.0 ) {
-                        m_pan=1.0;
-                } else {
-                        m_pan=pan;
-                }
+                pan = -1.0;
+        } else if ( pan > 1.0 ) {
+                pan = 1.0;
         }
 
         if (fabs(pan) < std::numeric_limits<float>::epsilon()) {
-                m_pan = 0.0f;
+                pan = 0.0f;
         }
 
+        m_pan.set_target(pan);
+
         emit panChanged();
 }
 
+/**
+ * Attenuates the left channel of \a bus when panned right, and the right channel when
+ * panned left. With \a ramp, the pan moves from the value of the previous cycle to the
+ * current one, else the current value is used for the whole block.
+ */
+void ProcessingData::process_pan(AudioBus* bus, nframes_t nframes, bool ramp)
+{
+        float startPan = ramp ? m_pan.get_start() : m_pan.get_target();
+        float endPan = ramp ? m_pan.get_end() : startPan;
+
+        if ( (bus->get_channel_count() >= 1) && (startPan > 0 || endPan > 0) )  {
+                Mixer::apply_gain(bus->get_buffer(0, nframes), nframes, 1 - qMax(startPan, 0.0f), 1 - qMax(endPan, 0.0f));
+        }
+
+        if ( (bus->get_channel_count() >= 2) && (startPan < 0 || endPan < 0) )  {
+                Mixer::apply_gain(bus->get_buffer(1, nframes), nframes, 1 + qMin(startPan, 0.0f), 1 + qMin(endPan, 0.0f));
+        }
+}
+
 
 
 void ProcessingData::set_muted( bool muted )
@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "ContextItem.h"
 #include "APILinkedList.h"
 #include "GainEnvelope.h"
+#include "TEngineParameter.h"
 #include "defines.h"
 
 class AudioBus;
@@ -48,7 +49,9 @@ public:
         PluginChain* get_plugin_chain() const {return m_pluginChain;}
         TSession* get_session() const {return m_session;}
         QString get_name() const {return m_name;}
-        float get_pan() const {return m_pan;}
+        float get_pan() const {return m_pan.get_target();}
+        // Number of cycles the fader, pan and sends were skipped on silent input
+        qint64 get_skipped_cycles() const {return m_skippedCycles;}
 
         void set_muted(bool muted);
         virtual void set_name(const QString& name);
@@ -67,8 +70,10 @@ protected:
         PluginChain*    m_pluginChain;
         QString		m_name;
         bool            m_isMuted;
-        float           m_pan;
+        TEngineParameter m_pan;
+        qint64          m_skippedCycles;
 
+        void process_pan(AudioBus* bus, nframes_t nframes, bool ramp);
 
 
 public slots:
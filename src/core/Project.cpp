@@ -50,6 +50,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "TSend.h"
 #include "SpectralMeter.h"
 #include "CorrelationMeter.h"
+#include "TMemoryBudget.h"
 
 #define PROJECT_FILE_VERSION 	3
 #define MASTER_OUT_SOFTWARE_BUS_ID 1
@@ -88,9 +89,10 @@ Project::Project(const QString& title)
 	m_sourcesDir = m_rootDir + "/audiosources";
 	m_rate = audiodevice().get_sample_rate();
 	m_bitDepth = audiodevice().get_bit_depth();
+	memorybudget().set_budget(qint64(config().get_property("Memory", "ProjectBudget", 1024).toInt()) * 1024 * 1024);
 
 	m_resourcesManager = new ResourcesManager(this);
-	m_hs = new QUndoStack(pm().get_undogroup());
+	m_hs = pm().create_history_stack();
 
         m_audiodeviceClient = new TAudioDeviceClient("sheet_" + QByteArray::number(get_id()));
         m_audiodeviceClient->set_process_callback( MakeDelegate(this, &Project::process) );
@@ -680,6 +682,8 @@ void Project::prepare_audio_device(QDomDocument doc)
         ads.ditherShape = config().get_property("Hardware", "DitherShape", "None").toString();
         ads.capture = config().get_property("Hardware", "capture", 1).toInt();
         ads.playback = config().get_property("Hardware", "playback", 1).toInt();
+        ads.lockMemory = config().get_property("Hardware", "LockMemory", false).toBool();
+        ads.countPageFaults = config().get_property("Hardware", "CountPageFaults", false).toBool();
 
         if (ads.bufferSize == 0) {
                 qWarning("BufferSize read from Settings is 0 !!!");
@@ -853,8 +857,7 @@ AudioBus* Project::create_software_audio_bus(const BusConfig& conf)
 
         AudioChannel* channel;
         for (int i=0; i< conf.channelNames.size(); ++i) {
-                channel = new AudioChannel(conf.channelNames.at(i), i, bus->get_type());
-                channel->set_buffer_size(audiodevice().get_buffer_size());
+                channel = audiodevice().create_channel(conf.channelNames.at(i), i, bus->get_type());
 
                 audiodevice().add_jack_channel(channel);
                 bus->add_channel(channel);
@@ -1575,11 +1578,6 @@ void Project::audiodevice_params_changed()
         foreach(AudioBus* bus, m_hardwareAudioBuses) {
                 bus->audiodevice_params_changed();
         }
-
-        int bufferSize = audiodevice().get_buffer_size();
-        foreach(AudioChannel* channel, m_softwareAudioChannels) {
-                channel->set_buffer_size(bufferSize);
-        }
 }
 
 void Project::setup_default_hardware_buses()
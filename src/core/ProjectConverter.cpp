@@ -62,6 +62,7 @@ void ProjectConverter::set_project(const QString & rootdir, const QString & name
 	m_filesMerged = 0;
 	if (m_merger) {
 		delete m_merger;
+		m_merger = 0;
 	}
 	m_document.clear();
 	
@@ -338,15 +339,8 @@ void ProjectConverter::finish_2_3_conversion()
 		delete source;
 	}
 	
-	// Exit the FileMerger event loop
-	m_merger->exit(0);	
-	
-	if ( ! m_merger->wait(1000) ) {
-		qWarning("FileMerger:: Still running after 1 second wait, terminating!");
-		m_merger->terminate();
-	}
-	
 	delete m_merger;
+	m_merger = 0;
 	
 	save_converted_document();
 	
@@ -355,7 +349,7 @@ void ProjectConverter::finish_2_3_conversion()
 
 void ProjectConverter::stop_conversion()
 {
-	if (m_merger && m_merger->isRunning()) {
+	if (m_merger && m_merger->is_processing()) {
 		m_merger->stop_merging();
 	}
 }
@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QMessageBox>
 #include <QFileSystemWatcher>
 #include <QTextStream>
+#include <QUndoStack>
 
 
 #include "Project.h"
@@ -323,6 +324,21 @@ QUndoGroup* ProjectManager::get_undogroup() const
         return &m_undogroup;
 }
 
+/**
+ * Creates a history stack in the undo group, limited to the number of commands
+ * set by the config key Project/UndoLimit. When the limit is reached, the oldest
+ * command is deleted, releasing whatever it holds on to.
+ *
+ * QUndoStack only accepts a limit while it is empty, so a changed limit is
+ * used for the stacks created after the change.
+ */
+QUndoStack* ProjectManager::create_history_stack()
+{
+        QUndoStack* stack = new QUndoStack(&m_undogroup);
+        stack->setUndoLimit(qMax(0, config().get_property("Project", "UndoLimit", 500).toInt()));
+        return stack;
+}
+
 
 TCommand* ProjectManager::exit()
 {
@@ -68,6 +68,7 @@ public:
 
 	Project* get_project();
 	QUndoGroup* get_undogroup() const;
+	QUndoStack* create_history_stack();
 
 	void start(const QString& basepath, const QString& projectname);
 
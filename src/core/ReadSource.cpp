@@ -31,7 +31,9 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "AudioDevice.h"
 #include <QFile>
 #include "TConfig.h"
+#include "TMemoryBudget.h"
 #include <limits.h>
+#include <cstring>
 
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
@@ -126,8 +128,9 @@ void ReadSource::private_init()
 ReadSource::~ReadSource()
 {
 	PENTERDES;
-	for(int i=0; i<m_buffers.size(); ++i) {
-		delete m_buffers.at(i);
+	if (m_buffer) {
+		memorybudget().remove(TMemoryBudget::ReadBuffers, m_buffer->storage_size());
+		delete m_buffer;
 	}
 	
 	if (m_audioReader) {
@@ -137,6 +140,10 @@ ReadSource::~ReadSource()
 	if (m_bufferstatus) {
 		delete m_bufferstatus;
 	}
+	
+	for (int i=0; i<m_headCache.size(); ++i) {
+		free_head_cache_region(m_headCache[i]);
+	}
 }
 
 QDomNode ReadSource::get_state( QDomDocument doc )
@@ -239,6 +246,7 @@ int ReadSource::init( )
 	}
 	
 	int converter_type = config().get_property("Conversion", "RTResamplingConverterType", DEFAULT_RESAMPLE_QUALITY).toInt();
+	m_audioReader->set_polyphase_resampling(config().get_property("Conversion", "PolyphaseResampling", false).toBool());
 	m_audioReader->set_converter_type(converter_type);
 	
 	set_output_rate(m_audioReader->get_file_rate());
@@ -369,7 +377,15 @@ int ReadSource::set_file(const QString & filename)
 
 
 
-int ReadSource::rb_read(audio_sample_t** dst, TimeRef& start, nframes_t count)
+/**
+ * Fills \a vectors, one for each channel, with the location of the \a count frames
+ * starting at \a start in the ringbuffers, so the caller can process them in place.
+ * Call rb_read_done() with the returned frame count when finished with the data.
+ *
+ * @return The number of frames available in all vectors, 0 if the ringbuffers
+ *	are not ready or a resync was needed.
+ */
+int ReadSource::rb_get_read_vector(TMultiChannelRingBuffer<audio_sample_t>::rw_vector* vectors, TimeRef& start, nframes_t count)
 {
 	if (m_channelCount == 0) {
 		return count;
@@ -393,7 +409,7 @@ int ReadSource::rb_read(audio_sample_t** dst, TimeRef& start, nframes_t count)
 	
 	if (start != m_rbRelativeFileReadPos) {
 		
-		TimeRef availabletime(nframes_t(m_buffers.at(0)->read_space()), m_outputRate);
+		TimeRef availabletime(nframes_t(m_buffer->read_space()), m_outputRate);
 /*		printf("rb_read:: m_rbRelativeFileReadPos, start: %lld, %lld\n", m_rbRelativeFileReadPos.universal_frame(), start.universal_frame());
 		printf("rb_read:: availabletime %d\n", availabletime.to_frame(m_outputRate));*/
 		
@@ -403,38 +419,49 @@ int ReadSource::rb_read(audio_sample_t** dst, TimeRef& start, nframes_t count)
 			if (availabletime < advance) {
 				printf("available < advance !!!!!!!\n");
 			}
-			for (int i=m_buffers.size()-1; i>=0; --i) {
-				m_buffers.at(i)->increment_read_ptr(advance.to_frame(m_outputRate));
-			}
+			m_buffer->increment_read_ptr(advance.to_frame(m_outputRate));
 			
 			m_rbRelativeFileReadPos += advance;
 /*			printf("rb_read:: advance %d\n", advance.to_frame(m_outputRate));
 			printf("rb_read:: m_rbRelativeFileReadPos after advance %d\n", m_rbRelativeFileReadPos.to_frame(m_outputRate));*/
 		} else {
-			TimeRef synclocation = start + m_clip->get_track_start_location() + m_clip->get_source_start_location();
+			// start is a file position, resync takes a Sheet location
+			TimeRef synclocation = start + m_clip->get_track_start_location() - m_clip->get_source_start_location();
 			start_resync(synclocation);
 			return 0;
 		}
 	}
 
-	nframes_t readcount = 0;
+	nframes_t readcount = count;
 	
-	for (int chan=0; chan<m_channelCount; ++chan) {
-		
-		readcount = m_buffers.at(chan)->read(dst[chan], count);
+	// All channels are read in lock step, so the first vector's length applies to all
+	m_buffer->get_read_vectors(vectors);
+	nframes_t available = vectors[0].len[0] + vectors[0].len[1];
 
-		if (readcount != count) {
-			PMESG("readcount, count: %d, %d", readcount, count);
+	if (available < readcount) {
+		PMESG("available, count: %d, %d", available, count);
 		// Hmm, not sure what to do in this case....
-		}
-		
+		readcount = available;
 	}
 
-	m_rbRelativeFileReadPos.add_frames(readcount, m_outputRate);
-	
 	return readcount;
 }
 
+/**
+ * Moves the ringbuffers read position \a count frames forward, after the frames returned
+ * by rb_get_read_vector() have been processed.
+ */
+void ReadSource::rb_read_done(nframes_t count)
+{
+	if (m_channelCount == 0) {
+		return;
+	}
+
+	m_buffer->increment_read_ptr(count);
+
+	m_rbRelativeFileReadPos.add_frames(count, m_outputRate);
+}
+
 
 int ReadSource::rb_file_read(DecodeBuffer* buffer, nframes_t cnt)
 {
@@ -458,8 +485,8 @@ void ReadSource::rb_seek_to_file_position(TimeRef& position)
 	
 // 	printf("rb_seek_to_file_position:: seeking to %d\n", position);
 	
-	// calculate position relative to the file!
-	TimeRef fileposition = position - m_clip->get_track_start_location() - m_clip->get_source_start_location();
+	// calculate position relative to the file, like AudioClip::process() does
+	TimeRef fileposition = position - m_clip->get_track_start_location() + m_clip->get_source_start_location();
 	
 	// Do nothing if we are allready at the seek position
 	if (m_rbFileReadPos == fileposition) {
@@ -470,7 +497,7 @@ void ReadSource::rb_seek_to_file_position(TimeRef& position)
 	// check if the clip's start position is within the range
 	// if not, fill the buffer from the earliest point this clip
 	// will come into play.
-	if (fileposition < TimeRef()) {
+	if (fileposition < m_clip->get_source_start_location()) {
 // 		printf("not seeking to %ld, but too %d\n\n", fileposition,m_clip->get_source_start_location()); 
 		fileposition = m_clip->get_source_start_location();
 	}
@@ -478,8 +505,8 @@ void ReadSource::rb_seek_to_file_position(TimeRef& position)
 // 	printf("rb_seek_to_file_position:: seeking to relative pos: %d\n", fileposition);
 	
 	// The content of our buffers is no longer valid, so we empty them
-	for (int i=0; i<m_buffers.size(); ++i) {
-		m_buffers.at(i)->reset();
+	if (m_buffer) {
+		m_buffer->reset();
 	}
 	
 	m_rbFileReadPos = fileposition;
@@ -504,7 +531,7 @@ void ReadSource::process_ringbuffer(DecodeBuffer* buffer, bool seeking)
 	}
 	
 	// Calculate the number of samples we can write into the buffer
-	int writeSpace = m_buffers.at(0)->write_space();
+	int writeSpace = m_buffer->write_space();
 
 	// The amount of chunks which can be 'read'
 	int chunkCount = (int)(writeSpace / m_chunkSize);
@@ -545,9 +572,7 @@ void ReadSource::process_ringbuffer(DecodeBuffer* buffer, bool seeking)
 	
 	// and write it to the ringbuffer
 	if (toWrite) {
-		for (int i=m_buffers.size()-1; i>=0; --i) {
-			m_buffers.at(i)->write(buffer->destination[i], toWrite);
-		}
+		m_buffer->write(buffer->destination, toWrite);
 	}
 }
 
@@ -597,7 +622,7 @@ void ReadSource::sync(DecodeBuffer* buffer)
 	// doesn't fill it consitently, and thus giving audible artifacts.
 	process_ringbuffer(buffer);
 	
-	if (m_buffers.at(0)->write_space() == 0) {
+	if (m_buffer->write_space() == 0) {
 		finish_resync();
 	}
 	
@@ -612,13 +637,14 @@ void ReadSource::prepare_rt_buffers( )
 	
 	Q_ASSERT(m_clip);
 	
-	for (int i=0; i<m_buffers.size();++i) {
-		delete m_buffers.at(i);
+	if (m_buffer) {
+		memorybudget().remove(TMemoryBudget::ReadBuffers, m_buffer->storage_size());
+		delete m_buffer;
 	}
-	
-	m_buffers.clear();
 
+	// Shorter buffers when the project is running out of it's memory budget
 	float size = config().get_property("Hardware", "readbuffersize", 1.0).toDouble();
+	size = memorybudget().get_buffer_time(size);
 
         m_bufferSize = (int) (size * m_outputRate);
 
@@ -626,9 +652,8 @@ void ReadSource::prepare_rt_buffers( )
         // have chunck sizes that are multiples of 4KB ?
         m_chunkSize = m_bufferSize / DiskIO::bufferdividefactor;
 
-	for (int i=0; i<m_channelCount; ++i) {
-		m_buffers.append(new RingBufferNPT<float>(m_bufferSize));
-	}
+	m_buffer = new TMultiChannelRingBuffer<audio_sample_t>(m_channelCount, m_bufferSize);
+	memorybudget().add(TMemoryBudget::ReadBuffers, m_buffer->storage_size());
 
         // FIXME: does this really make sense to do still ? :
         TimeRef synclocation = m_clip->get_sheet()->get_transport_location();
@@ -641,7 +666,7 @@ BufferStatus* ReadSource::get_buffer_status()
 		return m_bufferstatus;
 	}
 	
-	int freespace = m_buffers.at(0)->write_space();
+	int freespace = m_buffer->write_space();
 	
 // 	printf("m_rbFileReadPos, m_length %lld, %lld\n", m_rbFileReadPos.universal_frame(), m_length.universal_frame());
 	TimeRef transport = m_clip->get_sheet()->get_transport_location();
@@ -664,6 +689,170 @@ BufferStatus* ReadSource::get_buffer_status()
 	return m_bufferstatus;
 }
 
+/**
+ * Keeps the head cache of this ReadSource in line with the AudioClip: it holds \a frames
+ * frames from the clip's start in the file, and from each of the Sheet \a locations
+ * that fall within the clip. Regions no longer needed are dropped, and at most one missing
+ * region is read, as long as \a cacheSize stays below \a maxCacheSize.
+ *
+ * Only call this function from the DiskIO thread!
+ *
+ * @return True if a region was read from disk
+ */
+bool ReadSource::update_head_cache(DecodeBuffer* buffer, const QList<TimeRef>& locations, nframes_t frames, qint64& cacheSize, qint64 maxCacheSize)
+{
+	if (m_channelCount == 0 || !m_audioReader || !m_clip) {
+		return false;
+	}
+	
+	QList<TimeRef> wanted;
+	
+	if (frames) {
+		TimeRef trackStart = m_clip->get_track_start_location();
+		TimeRef trackEnd = m_clip->get_track_end_location();
+		TimeRef sourceStart = m_clip->get_source_start_location();
+		
+		wanted.append(sourceStart);
+		foreach(const TimeRef& location, locations) {
+			if (location > trackStart && location < trackEnd) {
+				wanted.append(location - trackStart + sourceStart);
+			}
+		}
+	}
+	
+	for (int i=m_headCache.size()-1; i>=0; --i) {
+		HeadCacheRegion& region = m_headCache[i];
+		if (region.rate != m_outputRate || region.frames != frames || !wanted.contains(region.start)) {
+			cacheSize -= qint64(region.frames) * m_channelCount * sizeof(audio_sample_t);
+			free_head_cache_region(region);
+			m_headCache.removeAt(i);
+		}
+	}
+	
+	foreach(const TimeRef& start, wanted) {
+		bool cached = false;
+		foreach(const HeadCacheRegion& region, m_headCache) {
+			if (region.start == start) {
+				cached = true;
+				break;
+			}
+		}
+		
+		if (cached || start >= m_length) {
+			continue;
+		}
+		
+		qint64 size = qint64(frames) * m_channelCount * sizeof(audio_sample_t);
+		if (cacheSize + size > maxCacheSize) {
+			return false;
+		}
+		
+		// Read with an audio reader of it's own: seeking the one of the ringbuffers
+		// resets it's resampler, which would be audible when the transport is rolling.
+		ResampleAudioReader* reader = create_head_cache_reader();
+		if (!reader) {
+			return false;
+		}
+		
+		nframes_t read = reader->read_from(buffer, start, frames);
+		delete reader;
+		
+		HeadCacheRegion region;
+		region.start = start;
+		region.frames = frames;
+		region.rate = m_outputRate;
+		for (int chan=0; chan<m_channelCount; ++chan) {
+			audio_sample_t* data = new audio_sample_t[frames];
+			memcpy(data, buffer->destination[chan], read * sizeof(audio_sample_t));
+			memset(data + read, 0, (frames - read) * sizeof(audio_sample_t));
+			region.buffers.append(data);
+		}
+		
+		m_headCache.append(region);
+		cacheSize += size;
+		
+		return true;
+	}
+	
+	return false;
+}
+
+// The reader is only used for one region, regions are read once and rarely
+ResampleAudioReader* ReadSource::create_head_cache_reader()
+{
+	ResampleAudioReader* reader = new ResampleAudioReader(m_fileName, m_decodertype);
+	
+	if (!reader->is_valid()) {
+		delete reader;
+		return 0;
+	}
+	
+	if (m_diskio) {
+		reader->set_resample_decode_buffer(m_diskio->get_resample_decode_buffer());
+		reader->set_polyphase_resampling(m_diskio->get_polyphase_resampling());
+		reader->set_converter_type(m_diskio->get_resample_quality());
+	}
+	reader->set_output_rate(m_audioReader->get_output_rate());
+	
+	return reader;
+}
+
+/**
+ * Fills the (empty) ringbuffers from the head cache after rb_seek_to_file_position(),
+ * when a cached region contains the new read position.
+ *
+ * Only call this function from the DiskIO thread!
+ *
+ * @return The number of frames written into the ringbuffers
+ */
+nframes_t ReadSource::prime_from_head_cache()
+{
+	if (m_channelCount == 0 || m_buffer->read_space() != 0) {
+		return 0;
+	}
+	
+	foreach(const HeadCacheRegion& region, m_headCache) {
+		if (region.rate != m_outputRate || m_rbFileReadPos < region.start) {
+			continue;
+		}
+		
+		nframes_t offset = (m_rbFileReadPos - region.start).to_frame(m_outputRate);
+		if (offset >= region.frames) {
+			continue;
+		}
+		
+		nframes_t count = qMin(region.frames - offset, nframes_t(m_buffer->write_space()));
+		audio_sample_t* src[m_channelCount];
+		for (int chan=0; chan<m_channelCount; ++chan) {
+			src[chan] = region.buffers.at(chan) + offset;
+		}
+		m_buffer->write(src, count);
+		
+		m_rbFileReadPos.add_frames(count, m_outputRate);
+		
+		return count;
+	}
+	
+	return 0;
+}
+
+qint64 ReadSource::get_head_cache_size() const
+{
+	qint64 size = 0;
+	foreach(const HeadCacheRegion& region, m_headCache) {
+		size += qint64(region.frames) * m_channelCount * sizeof(audio_sample_t);
+	}
+	return size;
+}
+
+void ReadSource::free_head_cache_region(HeadCacheRegion& region)
+{
+	foreach(audio_sample_t* data, region.buffers) {
+		delete [] data;
+	}
+	region.buffers.clear();
+}
+
 void ReadSource::set_active(bool active)
 {
         if (active) {
@@ -691,6 +880,7 @@ void ReadSource::set_diskio(DiskIO * diskio)
 	
 	if (m_audioReader) {
 		m_audioReader->set_resample_decode_buffer(m_diskio->get_resample_decode_buffer());
+		m_audioReader->set_polyphase_resampling(m_diskio->get_polyphase_resampling());
 		m_audioReader->set_converter_type(m_diskio->get_resample_quality());
 	}
 	
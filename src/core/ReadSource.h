@@ -55,7 +55,8 @@ public :
 	int set_state( const QDomNode& node );
 	QDomNode get_state(QDomDocument doc);
 
-	int rb_read(audio_sample_t** dest, TimeRef& start, nframes_t cnt);
+	int rb_get_read_vector(TMultiChannelRingBuffer<audio_sample_t>::rw_vector* vectors, TimeRef& start, nframes_t cnt);
+	void rb_read_done(nframes_t cnt);
 	void rb_seek_to_file_position(TimeRef& position);
 	
 	int file_read(DecodeBuffer* buffer, const TimeRef& start, nframes_t cnt) const;
@@ -79,6 +80,10 @@ public :
 	void prepare_rt_buffers();
 	BufferStatus* get_buffer_status();
 	
+	bool update_head_cache(DecodeBuffer* buffer, const QList<TimeRef>& locations, nframes_t frames, qint64& cacheSize, qint64 maxCacheSize);
+	nframes_t prime_from_head_cache();
+	qint64 get_head_cache_size() const;
+	
 	void set_output_rate(int rate);
 	
 	
@@ -105,15 +110,29 @@ private:
 	
 	BufferStatus*		m_bufferstatus;
 	
+	// The audio at the start of the clip and after the markers, read by
+	// and only used in the DiskIO thread to refill the ringbuffers after a seek.
+	struct HeadCacheRegion {
+		TimeRef start;
+		nframes_t frames;
+		int rate;
+		QList<audio_sample_t*> buffers;
+	};
+	QList<HeadCacheRegion>	m_headCache;
+	
 	int ref() { return m_refcount++;}
 	
 	void private_init();
 	void start_resync(TimeRef& position);
 	void finish_resync();
 	int rb_file_read(DecodeBuffer* buffer, nframes_t cnt);
+	void free_head_cache_region(HeadCacheRegion& region);
+	ResampleAudioReader* create_head_cache_reader();
 
 	friend class ResourcesManager;
 	friend class ProjectConverter;
+	friend class AudioTrack;
+	friend class TRenderAheadTrack;
 
 signals:
 	void stateChanged();
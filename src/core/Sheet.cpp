@@ -59,6 +59,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "Marker.h"
 #include "TInputEventDispatcher.h"                       
 #include "TSend.h"
+#include "TRenderAheadEngine.h"
+#include "TParallelExport.h"
+#include "TExportPipeline.h"
+#include "TScrubEngine.h"
+#include "TTimelineTracer.h"
 #include <Plugin.h>
 #include <PluginChain.h>
 
@@ -119,13 +124,18 @@ Sheet::~Sheet()
 {
 	PENTERDES;
 
+        // Stop the render thread before anything it uses is deleted
+        delete m_renderAhead;
+        m_renderAhead = 0;
+        delete m_scrubEngine;
+        m_scrubEngine = 0;
+
 	delete [] mixdown;
 	delete [] gainbuffer;
 
 	delete m_diskio;
         delete m_masterOut;
 	delete m_renderBus;
-	delete m_clipRenderBus;
 	delete m_hs;
         delete m_audiodeviceClient;
         delete m_snaplist;
@@ -147,7 +157,7 @@ void Sheet::init()
 	int converter_type = config().get_property("Conversion", "RTResamplingConverterType", DEFAULT_RESAMPLE_QUALITY).toInt();
 	m_diskio->set_resample_quality(converter_type);
 
-        m_hs = new QUndoStack(pm().get_undogroup());
+        m_hs = pm().create_history_stack();
         set_history_stack(m_hs);
         m_timeline->set_history_stack(m_hs);
 
@@ -163,6 +173,9 @@ void Sheet::init()
 	connect(&config(), SIGNAL(configChanged()), this, SLOT(config_changed()));
 	connect(this, SIGNAL(transportStarted()), m_diskio, SLOT(start_io()));
 	connect(this, SIGNAL(transportStopped()), m_diskio, SLOT(stop_io()));
+        connect(m_timeline, SIGNAL(markerAdded(Marker*)), this, SLOT(update_head_cache_locations()));
+        connect(m_timeline, SIGNAL(markerRemoved(Marker*)), this, SLOT(update_head_cache_locations()));
+        connect(m_timeline, SIGNAL(markerPositionChanged()), this, SLOT(update_head_cache_locations()));
 
 	mixdown = gainbuffer = 0;
 
@@ -173,18 +186,22 @@ void Sheet::init()
         busConfig.isInternalBus = true;
         m_renderBus = new AudioBus(busConfig);
 
-        busConfig.name = "Sheet Clip Render Bus";
-        m_clipRenderBus = new AudioBus(busConfig);
-
         m_masterOut = new MasterOutSubGroup(this, tr("Sheet Master"));
         m_masterOut->set_gain(0.5);
         resize_buffer(audiodevice().get_buffer_size());
 
+        m_renderAhead = new TRenderAheadEngine(this);
+        m_renderAhead->set_enabled(config().get_property("Sheet", "RenderAhead", false).toBool());
+        connect(this, SIGNAL(trackAdded(Track*)), this, SLOT(update_track_render_ahead_state(Track*)));
+        connect(this, SIGNAL(trackRemoved(Track*)), this, SLOT(update_track_render_ahead_state(Track*)));
+
+        m_scrubEngine = new TScrubEngine(this);
+
         m_resumeTransport = m_readyToRecord = false;
 
 	m_realtimepath = false;
 	m_changed = m_rendering = m_recording = m_prepareRecording = false;
-        m_stopTransport = m_seeking = m_startSeek = 0;
+        m_stopTransport = m_seeking = m_startSeek = m_scrubbing = 0;
 	
 	m_skipTimer.setSingleShot(true);
 	
@@ -218,6 +235,7 @@ int Sheet::set_state( const QDomNode & node )
 	m_mode = e.attribute("mode", "0").toInt();
 	
 	m_timeline->set_state(node.firstChildElement("TimeLine"));
+        update_head_cache_locations();
 
         
         QDomNode masterOutNode = node.firstChildElement("MasterOut");
@@ -341,6 +359,11 @@ int Sheet::prepare_export(ExportSpecification* spec)
 	PENTER;
 	
 	if ( ! (spec->renderpass == ExportSpecification::CREATE_CDRDAO_TOC) ) {
+		if (!begin_rendering()) {
+			info().warning(tr("Sheet %1 is being rendered allready, unable to export it").arg(m_name));
+			return -1;
+		}
+		
 		if (is_transport_rolling()) {
 			spec->resumeTransport = true;
 			// When transport is rolling, this equals stopping the transport!
@@ -348,6 +371,7 @@ int Sheet::prepare_export(ExportSpecification* spec)
 			// to call the function in the correct thread!
 			if (!QMetaObject::invokeMethod(this, "start_transport",  Qt::QueuedConnection)) {
 				printf("Invoking Sheet::start_transport() failed\n");
+				end_rendering();
 				return -1;
 			}
 			int count = 0;
@@ -362,8 +386,6 @@ int Sheet::prepare_export(ExportSpecification* spec)
 			}
 			printf("Sheet::prepare_export: had to wait %d process cycles before the transport was stopped\n", count);
 		}
-		
-		m_rendering = true;
 	}
 
 	spec->startLocation = LONG_LONG_MAX;
@@ -418,17 +440,23 @@ int Sheet::prepare_export(ExportSpecification* spec)
         spec->basename = "Sheet_" + QString::number(m_project->get_sheet_index(m_id)) +"-" + m_name;
 	spec->name = spec->basename;
 
+	QString error;
+	
 	if (spec->startLocation == spec->endLocation) {
-		info().warning(tr("No audio to export! (Is everything muted?)"));
-		return -1;
+		error = tr("No audio to export! (Is everything muted?)");
 	}
 	else if (spec->startLocation > spec->endLocation) {
-		info().warning(tr("Export start frame starts beyond export end frame!!"));
-		return -1;
+		error = tr("Export start frame starts beyond export end frame!!");
+	}
+	else if (spec->channels == 0) {
+		error = tr("Export tries to render to 0 channels wav file??");
 	}
 
-	if (spec->channels == 0) {
-		info().warning(tr("Export tries to render to 0 channels wav file??"));
+	if (!error.isEmpty()) {
+		info().warning(error);
+		if (spec->renderpass != ExportSpecification::CREATE_CDRDAO_TOC) {
+			end_rendering();
+		}
 		return -1;
 	}
 
@@ -449,19 +477,53 @@ int Sheet::finish_audio_export()
 {
         delete renderDecodeBuffer;
         resize_buffer(audiodevice().get_buffer_size());
-        m_rendering = false;
+        end_rendering();
         return 0;
 }
 
+/**
+ * An export and a Track freeze both render with the render buffers and the process
+ * buses of the Tracks, from their own thread. Only one of them can run at a time.
+ *
+ * @return True if no other render is running, the caller has to call end_rendering()
+ */
+bool Sheet::begin_rendering()
+{
+        QMutexLocker locker(&m_renderMutex);
+
+        if (m_rendering) {
+                return false;
+        }
+
+        m_rendering = true;
+        m_renderAhead->suspend();
+
+        return true;
+}
+
+void Sheet::end_rendering()
+{
+        QMutexLocker locker(&m_renderMutex);
+
+        m_rendering = false;
+        m_renderAhead->resume();
+}
+
 // this function is called from the parent project. if several cd-tracks should be exported
 // to separate files, we will call the render() process for each file.
 int Sheet::start_export(ExportSpecification* spec)
 {
         QString message;
         float peakvalue = 0.0;
+        TParallelExport* parallelExport = 0;
 
         spec->markers = m_timeline->get_cdtrack_list(spec);
 
+        // Render segments of the Sheet concurrently when the Tracks don't depend on each other
+        if (TParallelExport::is_enabled() && TParallelExport::is_supported(this)) {
+                parallelExport = new TParallelExport(this, spec);
+        }
+
         for (int i = 0; i < spec->markers.size()-1; ++i) {
                 spec->progress      = 0;
                                       // round down to the start of the CD frame (75th of a sec)
@@ -475,9 +537,11 @@ int Sheet::start_export(ExportSpecification* spec)
 
                 if (spec->renderpass == ExportSpecification::WRITE_TO_HARDDISK) {
                         m_exportSource = new WriteSource(spec);
+                        m_exportSource->set_pipelined(TExportPipeline::is_enabled());
 
                         if (m_exportSource->prepare_export() == -1) {
                                 delete m_exportSource;
+                                delete parallelExport;
                                 return -1;
                         }
 
@@ -489,7 +553,11 @@ int Sheet::start_export(ExportSpecification* spec)
 
                 m_project->set_export_message(message);
 
-                while(render(spec) > 0) {}
+                if (parallelExport) {
+                        parallelExport->render();
+                } else {
+                        while(render(spec) > 0) {}
+                }
 
                 peakvalue = f_max(peakvalue, spec->peakvalue);
                 spec->peakvalue = peakvalue;
@@ -500,15 +568,61 @@ int Sheet::start_export(ExportSpecification* spec)
                 }
         }
 
+        delete parallelExport;
+
         finish_audio_export();
         return 1;
 }
 
+/**
+ * Prepares the Sheet for rendering (part of) it's Tracks outside the audio thread,
+ * like Sheet::prepare_export() does for an export, but without stopping the transport.
+ * Used for example by AudioTrack to render a frozen Track.
+ *
+ * The transport has to be stopped, and will not start untill finish_offline_render()
+ * is called. Call from the GUI thread.
+ *
+ * @return 1 on success, -1 if the transport is rolling or the Sheet is allready rendering
+ */
+int Sheet::prepare_offline_render(const TimeRef& location, nframes_t blocksize)
+{
+        PENTER;
+
+        if (is_transport_rolling() || !begin_rendering()) {
+                return -1;
+        }
+
+        m_transportLocation = location;
+
+        resize_buffer(blocksize);
+
+        renderDecodeBuffer = new DecodeBuffer;
+
+        return 1;
+}
+
+/**
+ * Moves the transport location \a nframes forward, call this after each
+ * rendered block of an offline render.
+ */
+void Sheet::advance_offline_render(nframes_t nframes)
+{
+        m_transportLocation.add_frames(nframes, audiodevice().get_sample_rate());
+}
+
+void Sheet::finish_offline_render()
+{
+        PENTER;
+
+        finish_audio_export();
+}
+
 int Sheet::render(ExportSpecification* spec)
 {
+        TRACE_SCOPE("Sheet::render");
+
 	int chn;
 	uint32_t x;
-        int progress = 0;
 
         nframes_t diff = (spec->cdTrackEnd - spec->pos).to_frame(audiodevice().get_sample_rate());
 	nframes_t nframes = spec->blocksize;
@@ -552,6 +666,19 @@ int Sheet::render(ExportSpecification* spec)
 		}
 	}
 
+        return write_export_block(spec, nframes);
+}
+
+/**
+ * Normalizes and writes \a nframes interleaved frames from the ExportSpecification's
+ * dataF buffer, and advances the export position and progress. Used by render(), and
+ * by TParallelExport for the segments it rendered.
+ *
+ * @return 1 on success, -1 if writing failed
+ */
+int Sheet::write_export_block(ExportSpecification* spec, nframes_t nframes)
+{
+        int progress = 0;
 
 	int bufsize = spec->blocksize * spec->channels;
 	if (spec->normalize) {
@@ -702,6 +829,8 @@ void Sheet::solo_track(Track *track)
 //
 int Sheet::process( nframes_t nframes )
 {
+        TRACE_SCOPE("Sheet::process");
+
 	if (m_startSeek) {
                 printf("process: starting seek\n");
 		start_seek();
@@ -711,6 +840,15 @@ int Sheet::process( nframes_t nframes )
         if (m_seeking) {
                 return 0;
         }
+
+        // Scrubbing replaces normal playback, the transport
+        // location and the DiskIO buffers are left untouched.
+        if (m_scrubbing) {
+                m_masterOut->get_process_bus()->silence_buffers(nframes);
+                m_scrubEngine->process(m_masterOut->get_process_bus(), nframes);
+                m_masterOut->process(nframes);
+                return 1;
+        }
 	
 	// If no need for playback/record, return.
 	if (!is_transport_rolling()) {
@@ -800,7 +938,6 @@ void Sheet::resize_buffer(nframes_t size)
         QList<AudioBus*> buses;
         buses.append(m_masterOut->get_process_bus());
         buses.append(m_renderBus);
-        buses.append(m_clipRenderBus);
         foreach(AudioBus* bus, buses) {
                 for(int i=0; i<bus->get_channel_count(); i++) {
                         if (AudioChannel* chan = bus->get_channel(i)) {
@@ -813,6 +950,7 @@ void Sheet::resize_buffer(nframes_t size)
 void Sheet::audiodevice_params_changed()
 {
         resize_buffer(audiodevice().get_buffer_size());
+        m_renderAhead->audiodevice_params_changed();
 	
 	// The samplerate possibly has been changed, this initiates
 	// a seek in DiskIO, which clears the buffers and refills them
@@ -974,6 +1112,13 @@ TCommand* Sheet::start_transport()
 #if defined (THREAD_CHECK)
 	Q_ASSERT(QThread::currentThreadId() == threadId);
 #endif
+	// Rendering (export or a Track freeze) is in progress
+	// and uses our buffers, the transport has to wait.
+	if (m_rendering && !is_transport_rolling()) {
+		info().information(tr("Unable to start transport while rendering"));
+		return ied().failure();
+	}
+
 	// Delegate the transport start (or if we are rolling stop)
 	// request to the audiodevice. Depending on the driver in use
 	// this call will return directly to us (by a call to transport_control),
@@ -1170,6 +1315,59 @@ void Sheet::set_transport_pos(TimeRef location)
 }
 
 
+/**
+ * Starts playing the Sheet around \a location with the TScrubEngine, without
+ * seeking the DiskIO buffers. Move the scrub location with set_scrub_location()
+ * and finish with stop_scrub().
+ *
+ * @return false if scrubbing is disabled (config key Scrub/Enabled, off by default), or not
+ *	possible while recording or rendering.
+ */
+bool Sheet::start_scrub(const TimeRef& location)
+{
+#if defined (THREAD_CHECK)
+	Q_ASSERT(QThread::currentThreadId() ==  threadId);
+#endif
+        if (m_scrubbing || m_recording || m_rendering || m_seeking) {
+                return false;
+        }
+
+        if (!config().get_property("Scrub", "Enabled", false).toBool()) {
+                return false;
+        }
+
+        m_scrubEngine->start(location, get_audio_tracks());
+        m_scrubbing = 1;
+
+        return true;
+}
+
+void Sheet::set_scrub_location(const TimeRef& location)
+{
+        if (m_scrubbing) {
+                m_scrubEngine->set_location(location);
+        }
+}
+
+/**
+ * Returns to normal playback at the transport location. The caller decides
+ * if the transport has to be moved with set_transport_pos(), which is the only
+ * time the DiskIO buffers are refilled.
+ */
+void Sheet::stop_scrub()
+{
+#if defined (THREAD_CHECK)
+	Q_ASSERT(QThread::currentThreadId() ==  threadId);
+#endif
+        if (!m_scrubbing) {
+                return;
+        }
+
+        m_scrubbing = 0;
+        m_scrubEngine->stop();
+}
+
+
 //
 //  Function is ALWAYS called in RealTime AudioThread processing path
 //  Be EXTREMELY carefull to not call functions() that have blocking behavior!!
@@ -1191,6 +1389,12 @@ void Sheet::start_seek()
 	// only sets a boolean flag, save to call.
 	m_diskio->prepare_for_seek();
 
+	// The render ahead thread doesn't wait for DiskIO, and
+	// can start rendering at the new location right away.
+        apill_foreach(AudioTrack* track, AudioTrack, m_rtAudioTracks) {
+                track->locate_render_ahead(m_newTransportLocation);
+        }
+
 	// 'Tell' the diskio it should start a seek action.
 	RT_THREAD_EMIT(this, NULL, seekStart());
 }
@@ -1220,6 +1424,33 @@ void Sheet::config_changed()
 	if (m_diskio->get_resample_quality() != quality) {
 		m_diskio->set_resample_quality(quality);
 	}
+
+        bool renderAhead = config().get_property("Sheet", "RenderAhead", false).toBool();
+        if (m_renderAhead->is_enabled() != renderAhead) {
+                m_renderAhead->set_enabled(renderAhead);
+                foreach(AudioTrack* track, m_audioTracks) {
+                        track->update_render_ahead_state();
+                }
+        }
+}
+
+void Sheet::update_track_render_ahead_state(Track* track)
+{
+        if (track->get_type() == Track::AUDIOTRACK) {
+                static_cast<AudioTrack*>(track)->update_render_ahead_state();
+        }
+}
+
+// Locating to a marker is common, so the DiskIO caches the audio after each marker.
+void Sheet::update_head_cache_locations()
+{
+        QList<TimeRef> locations;
+
+        foreach(Marker* marker, m_timeline->get_markers()) {
+                locations.append(marker->get_when());
+        }
+
+        m_diskio->set_head_cache_locations(locations);
 }
 
 
@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "TSession.h"
 #include <QDomNode>
 #include <QTimer>
+#include <QMutex>
 #include "defines.h"
 #include "APILinkedList.h"
 
@@ -42,6 +43,8 @@ class SnapList;
 class TimeLine;
 class Snappable;
 class DecodeBuffer;
+class TRenderAheadEngine;
+class TScrubEngine;
 class TBusTrack;
 class Track;
 
@@ -70,7 +73,7 @@ public:
 	DiskIO*	get_diskio() const;
 	AudioClipManager* get_audioclip_manager() const;
 	AudioBus* get_render_bus() const {return m_renderBus;}
-	AudioBus* get_clip_render_bus() const {return m_clipRenderBus;}
+        TRenderAheadEngine* get_render_ahead_engine() const {return m_renderAhead;}
         AudioTrack* get_audio_track_for_index(int index);
         QString get_audio_sources_dir() const;
         TimeRef get_last_location() const;
@@ -94,7 +97,15 @@ public:
 	int process_export(nframes_t nframes);
 	int prepare_export(ExportSpecification* spec);
 	int render(ExportSpecification* spec);
+        int write_export_block(ExportSpecification* spec, nframes_t nframes);
         int start_export(ExportSpecification* spec);
+        int prepare_offline_render(const TimeRef& location, nframes_t blocksize);
+        void advance_offline_render(nframes_t nframes);
+        void finish_offline_render();
+
+        bool start_scrub(const TimeRef& location);
+        void set_scrub_location(const TimeRef& location);
+        void stop_scrub();
 
         void solo_track(Track* track);
 	void create(int tracksToCreate);
@@ -105,6 +116,8 @@ public:
         bool is_changed() const {return m_changed;}
 	bool is_snap_on() const	{return m_isSnapOn;}
         bool is_recording() const {return m_recording;}
+        bool is_rendering() const {return m_rendering;}
+        bool is_scrubbing() const {return m_scrubbing;}
 	bool is_smaller_then(APILinkedListNode* node) {Q_UNUSED(node); return false;}
 
         audio_sample_t*		readbuffer;
@@ -121,7 +134,8 @@ private:
 	WriteSource*		m_exportSource;
         TAudioDeviceClient*	m_audiodeviceClient;
         AudioBus*		m_renderBus;
-	AudioBus*		m_clipRenderBus;
+        TRenderAheadEngine*	m_renderAhead;
+        TScrubEngine*		m_scrubEngine;
 	DiskIO*			m_diskio;
 	AudioClipManager*	m_acmanager;
 	QList<TimeRef>		m_xposList;
@@ -137,11 +151,13 @@ private:
 	volatile size_t		m_seeking;
 	volatile size_t		m_startSeek;
         volatile size_t		m_stopTransport;
+        volatile size_t		m_scrubbing;
 
 
         QString 	m_artists;
 	uint		m_currentSampleRate;
 	bool 		m_rendering;
+        QMutex          m_renderMutex;
         bool 		m_changed;
 	bool		m_resumeTransport;
 	bool		m_realtimepath;
@@ -152,6 +168,8 @@ private:
 	void init();
 
 	int finish_audio_export();
+        bool begin_rendering();
+        void end_rendering();
 	void start_seek();
         void initiate_seek_start(TimeRef location);
 	void start_transport_rolling(bool realtime);
@@ -190,6 +208,8 @@ private slots:
 	void prepare_recording();
 	void clip_finished_recording(AudioClip* clip);
 	void config_changed();
+        void update_track_render_ahead_state(Track* track);
+        void update_head_cache_locations();
 };
 
 #endif
@@ -103,9 +103,9 @@ void SnapList::update_snaplist()
 	}
 
 	// add all on-screen markers
-	QList<Marker*> markerList = m_sheet->get_timeline()->get_markers();
+	QList<Marker*> markerList = m_sheet->get_timeline()->get_markers_in_range(m_rangeStart, m_rangeEnd);
 	for (int i = 0; i < markerList.size(); ++i) {
-		if (markerList.at(i)->is_snappable() && markerList.at(i)->get_when() >= m_rangeStart && markerList.at(i)->get_when() <= m_rangeEnd) {
+		if (markerList.at(i)->is_snappable()) {
 			m_xposList.append(markerList.at(i)->get_when());
 		}
 	}
@@ -0,0 +1,1327 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TBenchmark.h"
+
+#if defined (BENCHMARK)
+
+#include <QDateTime>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QTextStream>
+#include <QThread>
+#include <QTime>
+#include <QTimer>
+#include <cmath>
+#include <cstring>
+#include <samplerate.h>
+
+#include <AudioDevice.h>
+#include "AudioClip.h"
+#include "AudioTrack.h"
+#include "Curve.h"
+#include "CurveNode.h"
+#include "DiskIO.h"
+#include "Export.h"
+#include "memops.h"
+#include "Peak.h"
+#include "PluginChain.h"
+#include "Project.h"
+#include "ProjectManager.h"
+#include "ReadSource.h"
+#include "RingBufferNPT.h"
+#include "ResourcesManager.h"
+#include "Sheet.h"
+#include "TMultiChannelRingBuffer.h"
+#include "TBusTrack.h"
+#include "TCommand.h"
+#include "TPolyphaseResampler.h"
+#include "Utils.h"
+#include "WriteSource.h"
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+/**
+ * \class TBenchmark
+ * \brief Times the main operations on synthetic Projects of increasing size
+ *
+ * Only build when configured with WANT_BENCHMARK. Start Traverso with
+ *
+ *	traverso --benchmark [sweep] [file]
+ *
+ * where sweep is a comma separated list of sizes, each size written as
+ * sheets x tracks x clips (e.g. 1x4x4,2x32x32), and file the JSON file the
+ * results are written to, by default in ~/.traverso/benchmarks.
+ *
+ * For each size, a TSessionGenerator creates the Project in the projects directory,
+ * after which the time is measured of loading and saving it, building the peak files
+ * of all sources, seeking each Sheet until the DiskIO buffers are filled, rendering
+ * each Sheet without writing it (offline playback), and exporting all Sheets to wav.
+ *
+ * The generated audio only depends on the size and the sample rate of the audio
+ * device, so the results of different builds can be compared.
+ * A time of -1 means the operation failed or timed out.
+ *
+ * Finally libsamplerate and TPolyphaseResampler are compared for each converter
+ * type of the resample quality setting: the time to convert a minute of audio,
+ * the signal to noise ratio of a set of pass band tones, and when down sampling,
+ * how much of a tone above the output nyquist frequency aliases into the output.
+ *
+ * Last, TMultiChannelRingBuffer is stress tested against one RingBufferNPT per
+ * channel, like ReadSource used before: a producer thread writes numbered frames
+ * in chunks of varying size, while the GUI thread reads and verifies them. The
+ * time to pass RINGBUFFER_LENGTH frames and the number of wrong samples are reported.
+ *
+ * The memops sample format conversions and copy functions used by the drivers are
+ * timed on stereo interleaved buffers, in ns per sample. The SIMD versions are
+ * checked against their generic versions, except the dithered ones.
+ */
+
+// Length of each generated source, in seconds
+static const int SOURCE_LENGTH = 10;
+// Generated sources are shared by the clips, a project has at most this many
+static const int MAX_SOURCES = 8;
+static const int BUS_TRACKS = 2;
+static const int GAIN_NODES = 8;
+static const int SEEK_TIMEOUT = 30000;
+static const int EXPORT_TIMEOUT = 600000;
+static const char* DEFAULT_SWEEP = "1x4x4,1x16x16,2x32x32,4x64x64";
+// Length of the resampler test signal, in seconds
+static const int RESAMPLE_LENGTH = 60;
+static const nframes_t RESAMPLE_BLOCKSIZE = 4096;
+// Pass band test tones, relative to the lowest nyquist frequency
+static const double RESAMPLE_TONES[] = {0.05, 0.2, 0.45, 0.7};
+static const int RESAMPLE_TONE_COUNT = 4;
+// Frames passed through each ring buffer, and the ring buffer size
+static const nframes_t RINGBUFFER_LENGTH = 48000 * 600;
+static const nframes_t RINGBUFFER_SIZE = 32768;
+static const nframes_t RINGBUFFER_MAX_CHUNK = 4096;
+// Each memops function converts MEMOPS_ITERATIONS blocks of MEMOPS_FRAMES stereo frames
+static const unsigned long MEMOPS_FRAMES = 1024;
+static const int MEMOPS_ITERATIONS = 20000;
+
+
+TSessionGenerator::TSessionGenerator(const TBenchmarkSize& size)
+        : m_size(size)
+{
+}
+
+QString TSessionGenerator::get_project_name() const
+{
+        return QString("benchmark-%1x%2x%3").arg(m_size.sheets).arg(m_size.tracks).arg(m_size.clips);
+}
+
+/**
+ * Creates the Project, replacing the one of a previous run, generates it's audio
+ * sources, and adds the clips, fades, gain automation and sends to the Sheets.
+ * The Project is saved and closed afterwards.
+ *
+ * @return 1 on success, -1 on failure
+ */
+int TSessionGenerator::generate()
+{
+        QString name = get_project_name();
+
+        if (pm().project_exists(name)) {
+                pm().remove_project(name);
+        }
+
+        Project* project = pm().create_new_project(m_size.sheets, m_size.tracks, name);
+        if (!project) {
+                return -1;
+        }
+        project->save();
+        delete project;
+
+        if (pm().load_project(name) < 0) {
+                return -1;
+        }
+        project = pm().get_project();
+
+        if (generate_sources(project) < 0) {
+                pm().close_current_project();
+                return -1;
+        }
+
+        int sheetIndex = 0;
+        foreach(Sheet* sheet, project->get_sheets()) {
+                populate_sheet(sheet, sheetIndex++);
+        }
+
+        project->save();
+        pm().close_current_project();
+
+        return 1;
+}
+
+int TSessionGenerator::generate_sources(Project* project)
+{
+        QStringList formats;
+        formats << "wav" << "flac";
+#if defined MP3_ENCODE_SUPPORT
+        formats << "mp3";
+#endif
+
+        m_sourceNames.clear();
+
+        int count = qBound(1, m_size.clips, MAX_SOURCES);
+        for (int i=0; i<count; ++i) {
+                if (generate_source(project, i, formats.at(i % formats.size())) < 0) {
+                        return -1;
+                }
+        }
+
+        return 1;
+}
+
+/**
+ * Writes a stereo source with a tone and noise that only depend on \a index,
+ * encoded as \a format, using a WriteSource like an export does.
+ */
+int TSessionGenerator::generate_source(Project* project, int index, const QString& format)
+{
+        int rate = audiodevice().get_sample_rate();
+        nframes_t blocksize = 4096;
+        nframes_t length = nframes_t(SOURCE_LENGTH) * rate;
+
+        ExportSpecification* spec = new ExportSpecification;
+        spec->exportdir = project->get_audiosources_dir();
+        spec->name = QString("source-%1").arg(index, 2, 10, QChar('0'));
+        spec->startLocation = TimeRef();
+        spec->endLocation = TimeRef(length, rate);
+        spec->totalTime = spec->endLocation;
+        spec->pos = TimeRef();
+        spec->isRecording = false;
+        spec->channels = 2;
+        spec->sample_rate = rate;
+        spec->blocksize = blocksize;
+        spec->dataF = new audio_sample_t[blocksize * spec->channels];
+
+        if (format == "wav") {
+                spec->writerType = "sndfile";
+                spec->extraFormat["filetype"] = "wav";
+                spec->data_width = 1;	// 1 means float
+        } else if (format == "flac") {
+                spec->writerType = "flac";
+                spec->data_width = 16;
+        } else {
+                spec->writerType = "lame";
+                spec->data_width = 16;
+                spec->extraFormat["method"] = "cbr";
+                spec->extraFormat["maxBitrate"] = "192";
+                spec->extraFormat["quality"] = "5";
+        }
+
+        WriteSource* writesource = new WriteSource(spec);
+        int result = writesource->prepare_export();
+
+        if (result == 0) {
+                float frequency = 110.0f * (1 + index);
+                quint32 seed = 12345 + index;
+                nframes_t position = 0;
+
+                while (position < length) {
+                        nframes_t nframes = qMin(blocksize, length - position);
+
+                        for (nframes_t x=0; x<nframes; ++x) {
+                                seed = seed * 1664525 + 1013904223;
+                                float noise = (float(seed >> 8) / float(1 << 24) - 0.5f) * 0.1f;
+                                float tone = 0.4f * sinf(2.0f * float(M_PI) * frequency * float(position + x) / rate);
+                                spec->dataF[x * 2] = tone + noise;
+                                spec->dataF[x * 2 + 1] = tone - noise;
+                        }
+
+                        writesource->process(nframes);
+                        spec->pos.add_frames(nframes, rate);
+                        position += nframes;
+                }
+
+                writesource->finish_export();
+                m_sourceNames.append(writesource->get_name());
+        }
+
+        delete writesource;
+        delete [] spec->dataF;
+        delete spec;
+
+        return result == 0 ? 1 : -1;
+}
+
+void TSessionGenerator::populate_sheet(Sheet* sheet, int sheetIndex)
+{
+        QList<TBusTrack*> busTracks;
+        for (int i=0; i<BUS_TRACKS; ++i) {
+                TBusTrack* busTrack = new TBusTrack(sheet, QString("Bus %1").arg(i + 1), 2);
+                TCommand::process_command(sheet->add_track(busTrack, false));
+                busTracks.append(busTrack);
+        }
+
+        ResourcesManager* manager = resources_manager();
+        QString dir = pm().get_project()->get_audiosources_dir();
+        double fadeRange = 0.5 * UNIVERSAL_SAMPLE_RATE;
+
+        int trackIndex = 0;
+        foreach(AudioTrack* track, sheet->get_audio_tracks()) {
+                track->add_post_send(busTracks.at(trackIndex % BUS_TRACKS)->get_id());
+
+                TimeRef startLocation;
+                for (int i=0; i<m_size.clips; ++i) {
+                        QString name = m_sourceNames.at((sheetIndex + trackIndex + i) % m_sourceNames.size());
+                        ReadSource* source = manager->import_source(dir, name);
+                        if (!source) {
+                                PERROR("Can't import generated source %s", QS_C(name));
+                                return;
+                        }
+
+                        AudioClip* clip = manager->new_audio_clip(name);
+                        manager->set_source_for_clip(clip, source);
+                        clip->set_sheet(sheet);
+                        clip->set_track(track);
+                        clip->set_track_start_location(startLocation);
+                        clip->set_fade_in(fadeRange);
+                        clip->set_fade_out(fadeRange);
+
+                        Curve* curve = clip->get_plugin_chain()->get_fader()->get_curve();
+                        qint64 length = clip->get_length().universal_frame();
+                        for (int node=1; node<=GAIN_NODES; ++node) {
+                                double when = double(length) * node / (GAIN_NODES + 1);
+                                TCommand::process_command(curve->add_node(new CurveNode(curve, when, (node % 2) ? 0.5 : 1.0), false));
+                        }
+
+                        TCommand::process_command(track->add_clip(clip, false));
+                        startLocation = clip->get_track_end_location();
+                }
+
+                ++trackIndex;
+        }
+}
+
+
+/**
+ * Parses \a sweep (see the class documentation), and uses the default sweep
+ * if it's empty. The results are written to \a fileName, or to a time stamped
+ * file in ~/.traverso/benchmarks if it's empty.
+ */
+TBenchmark::TBenchmark(const QString& sweep, const QString& fileName)
+        : m_fileName(fileName)
+{
+        QStringList sizes = (sweep.isEmpty() ? QString(DEFAULT_SWEEP) : sweep).split(",", QString::SkipEmptyParts);
+
+        foreach(QString string, sizes) {
+                QStringList values = string.split("x");
+                TBenchmarkSize size;
+                if (values.size() != 3) {
+                        printf("TBenchmark: ignoring invalid size %s\n", QS_C(string));
+                        continue;
+                }
+                size.sheets = qMax(1, values.at(0).toInt());
+                size.tracks = qMax(1, values.at(1).toInt());
+                size.clips = qMax(1, values.at(2).toInt());
+                m_sizes.append(size);
+        }
+
+        if (m_fileName.isEmpty()) {
+                m_fileName = QDir::homePath() + "/.traverso/benchmarks/benchmark-" +
+                             QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".json";
+        }
+}
+
+/**
+ * Runs the benchmark for all sizes, and writes the results.
+ * Call from the GUI thread, with no Project loaded.
+ *
+ * @return 0 on success, -1 if a Project couldn't be generated or the results not written
+ */
+int TBenchmark::run()
+{
+        int status = 0;
+
+        foreach(const TBenchmarkSize& size, m_sizes) {
+                TBenchmarkResult result;
+                if (run_size(size, result) < 0) {
+                        status = -1;
+                }
+                m_results.append(result);
+        }
+
+        compare_resamplers();
+        compare_ring_buffers();
+        time_memops();
+
+        if (write_results() < 0) {
+                status = -1;
+        }
+
+        return status;
+}
+
+int TBenchmark::run_size(const TBenchmarkSize& size, TBenchmarkResult& result)
+{
+        QTime time;
+        TSessionGenerator generator(size);
+
+        result.size = size;
+        result.save = result.load = result.peaks = result.seek = result.playback = result.exporting = -1;
+
+        printf("TBenchmark: generating %d sheets, %d tracks, %d clips\n", size.sheets, size.tracks, size.clips);
+
+        time.start();
+        result.generate = generator.generate() < 0 ? -1 : time.elapsed();
+        result.sources = generator.get_source_count();
+
+        if (result.generate < 0) {
+                return -1;
+        }
+
+        time.start();
+        if (pm().load_project(generator.get_project_name()) < 0) {
+                return -1;
+        }
+        result.load = time.elapsed();
+
+        Project* project = pm().get_project();
+
+        time.start();
+        if (project->save() >= 0) {
+                result.save = time.elapsed();
+        }
+
+        time.start();
+        if (build_peaks(project) >= 0) {
+                result.peaks = time.elapsed();
+        }
+
+        time.start();
+        if (seek_sheets(project) >= 0) {
+                result.seek = time.elapsed();
+        }
+
+        time.start();
+        if (play_sheets(project) >= 0) {
+                result.playback = time.elapsed();
+        }
+
+        time.start();
+        if (export_project(project) >= 0) {
+                result.exporting = time.elapsed();
+        }
+
+        pm().close_current_project();
+
+        return 1;
+}
+
+/**
+ * Builds the peak files of all sources used by the clips, one after the other.
+ */
+int TBenchmark::build_peaks(Project* project)
+{
+        QSet<qint64> done;
+
+        foreach(Sheet* sheet, project->get_sheets()) {
+                foreach(AudioTrack* track, sheet->get_audio_tracks()) {
+                        foreach(AudioClip* clip, track->get_cliplist()) {
+                                ReadSource* source = clip->get_readsource();
+                                if (!source || done.contains(clip->get_readsource_id())) {
+                                        continue;
+                                }
+                                done.insert(clip->get_readsource_id());
+
+                                Peak* peak = new Peak(source);
+                                int result = peak->create_from_scratch();
+                                delete peak;
+
+                                if (result < 0) {
+                                        return -1;
+                                }
+                        }
+                }
+        }
+
+        return 1;
+}
+
+/**
+ * Seeks each Sheet to it's start, and waits until DiskIO filled the buffers.
+ */
+int TBenchmark::seek_sheets(Project* project)
+{
+        foreach(Sheet* sheet, project->get_sheets()) {
+                project->set_current_session(sheet->get_id());
+
+                QEventLoop loop;
+                QObject::connect(sheet->get_diskio(), SIGNAL(seekFinished()), &loop, SLOT(quit()));
+                QTimer::singleShot(SEEK_TIMEOUT, &loop, SLOT(quit()));
+
+                QTime time;
+                time.start();
+                sheet->set_transport_pos(TimeRef());
+                loop.exec();
+
+                if (time.elapsed() >= SEEK_TIMEOUT) {
+                        return -1;
+                }
+        }
+
+        return 1;
+}
+
+/**
+ * Renders each Sheet the way the normalisation pass of an export does:
+ * the full playback path, without writing the result.
+ */
+int TBenchmark::play_sheets(Project* project)
+{
+        ExportSpecification spec;
+        spec.channels = 2;
+        spec.sample_rate = audiodevice().get_sample_rate();
+        spec.blocksize = audiodevice().get_buffer_size();
+        spec.dataF = new audio_sample_t[spec.blocksize * spec.channels];
+        spec.renderpass = ExportSpecification::CALC_NORM_FACTOR;
+        spec.normalize = true;
+        spec.isRecording = false;
+        spec.running = true;
+        spec.thread = 0;
+
+        project->disconnect_from_audio_device();
+
+        int result = 1;
+        foreach(Sheet* sheet, project->get_sheets()) {
+                if (sheet->prepare_export(&spec) < 0) {
+                        result = -1;
+                        break;
+                }
+                sheet->start_export(&spec);
+        }
+
+        project->connect_to_audio_device();
+
+        delete [] spec.dataF;
+
+        return result;
+}
+
+/**
+ * Exports all Sheets to 16 bit wav files in the Export directory of \a project,
+ * through Project::export_project() like the export dialog does. An export taking
+ * longer then EXPORT_TIMEOUT is aborted like the export dialog does, and counts as failed.
+ */
+int TBenchmark::export_project(Project* project)
+{
+        ExportSpecification spec;
+        spec.exportdir = project->get_root_dir() + "/Export/";
+        spec.writerType = "sndfile";
+        spec.extraFormat["filetype"] = "wav";
+        spec.data_width = 16;
+        spec.channels = 2;
+        spec.sample_rate = audiodevice().get_sample_rate();
+        spec.allSheets = true;
+        spec.isRecording = false;
+
+        QEventLoop loop;
+        QObject::connect(project, SIGNAL(exportFinished()), &loop, SLOT(quit()));
+        QTimer::singleShot(EXPORT_TIMEOUT, &loop, SLOT(quit()));
+
+        QTime time;
+        time.start();
+
+        if (project->export_project(&spec) < 0) {
+                return -1;
+        }
+
+        loop.exec();
+
+        if (time.elapsed() >= EXPORT_TIMEOUT) {
+                // The export thread uses spec, wait until it stopped
+                if (spec.running) {
+                        spec.stop = true;
+                        spec.breakout = true;
+                        loop.exec();
+                }
+                return -1;
+        }
+
+        return 1;
+}
+
+static void generate_tones(audio_sample_t* buffer, nframes_t frames, int rate, double nyquist)
+{
+        for (nframes_t x=0; x<frames; ++x) {
+                double sample = 0.0;
+                for (int i=0; i<RESAMPLE_TONE_COUNT; ++i) {
+                        sample += 0.2 * sin(2.0 * M_PI * RESAMPLE_TONES[i] * nyquist * x / rate);
+                }
+                buffer[x] = audio_sample_t(sample);
+        }
+}
+
+static nframes_t resample_src(audio_sample_t* input, nframes_t inputFrames, audio_sample_t* output,
+                              nframes_t outputFrames, int inputRate, int outputRate, int converterType)
+{
+        int error;
+        SRC_STATE* state = src_new(converterType, 1, &error);
+        if (!state) {
+                return 0;
+        }
+
+        SRC_DATA data;
+        data.src_ratio = double(outputRate) / inputRate;
+
+        nframes_t inputPos = 0;
+        nframes_t outputPos = 0;
+
+        while (outputPos < outputFrames) {
+                nframes_t frames = qMin(RESAMPLE_BLOCKSIZE, inputFrames - inputPos);
+                data.data_in = input + inputPos;
+                data.input_frames = frames;
+                data.data_out = output + outputPos;
+                data.output_frames = outputFrames - outputPos;
+                data.end_of_input = (inputPos + frames == inputFrames) ? 1 : 0;
+
+                if (src_process(state, &data) || (data.end_of_input && data.output_frames_gen == 0)) {
+                        break;
+                }
+
+                inputPos += data.input_frames_used;
+                outputPos += data.output_frames_gen;
+        }
+
+        src_delete(state);
+
+        return outputPos;
+}
+
+static nframes_t resample_polyphase(audio_sample_t* input, nframes_t inputFrames, audio_sample_t* output,
+                                    nframes_t outputFrames, int inputRate, int outputRate, int converterType)
+{
+        TPolyphaseResampler resampler(1, inputRate, outputRate, TPolyphaseResampler::quality_for_converter_type(converterType));
+
+        nframes_t inputPos = 0;
+        nframes_t outputPos = 0;
+
+        while (outputPos < outputFrames) {
+                nframes_t frames = qMin(RESAMPLE_BLOCKSIZE, inputFrames - inputPos);
+                bool endOfInput = (inputPos + frames == inputFrames);
+                audio_sample_t* in = input + inputPos;
+                audio_sample_t* out = output + outputPos;
+                nframes_t inputUsed;
+
+                nframes_t generated = resampler.process(&in, frames, &out, outputFrames - outputPos, endOfInput, inputUsed);
+
+                inputPos += inputUsed;
+                outputPos += generated;
+
+                if (endOfInput && generated == 0) {
+                        break;
+                }
+        }
+
+        return outputPos;
+}
+
+// Signal to noise ratio in dB of output against reference, skipping the start and end
+static double signal_to_noise(const audio_sample_t* output, const audio_sample_t* reference, nframes_t frames)
+{
+        double signal = 0.0;
+        double noise = 0.0;
+
+        for (nframes_t x=RESAMPLE_BLOCKSIZE; x + RESAMPLE_BLOCKSIZE < frames; ++x) {
+                double error = output[x] - reference[x];
+                signal += double(reference[x]) * reference[x];
+                noise += error * error;
+        }
+
+        return noise > 0.0 ? 10.0 * log10(signal / noise) : 200.0;
+}
+
+// Level in dB of output, relative to a full scale sine, skipping the start and end
+static double aliasing_level(const audio_sample_t* output, nframes_t frames)
+{
+        double power = 0.0;
+        nframes_t count = 0;
+
+        for (nframes_t x=RESAMPLE_BLOCKSIZE; x + RESAMPLE_BLOCKSIZE < frames; ++x) {
+                power += double(output[x]) * output[x];
+                ++count;
+        }
+
+        return power > 0.0 ? 10.0 * log10(2.0 * power / count) : -200.0;
+}
+
+/**
+ * The ring buffer under test, as seen by the producer and consumer.
+ */
+class TRingBufferAdapter
+{
+public:
+        virtual ~TRingBufferAdapter() {}
+        virtual size_t write_space() = 0;
+        virtual size_t write(audio_sample_t* const* src, size_t cnt) = 0;
+        virtual size_t read_space() = 0;
+        virtual size_t read(audio_sample_t* const* dest, size_t cnt) = 0;
+};
+
+class TMultiChannelAdapter : public TRingBufferAdapter
+{
+public:
+        TMultiChannelAdapter(int channels) : m_buffer(channels, RINGBUFFER_SIZE) {}
+
+        size_t write_space() {return m_buffer.write_space();}
+        size_t write(audio_sample_t* const* src, size_t cnt) {return m_buffer.write(src, cnt);}
+        size_t read_space() {return m_buffer.read_space();}
+        size_t read(audio_sample_t* const* dest, size_t cnt) {return m_buffer.read(dest, cnt);}
+
+private:
+        TMultiChannelRingBuffer<audio_sample_t> m_buffer;
+};
+
+// Space is the minimum over all channels, since they are written one after the other
+class TPerChannelAdapter : public TRingBufferAdapter
+{
+public:
+        TPerChannelAdapter(int channels) {
+                for (int chan=0; chan<channels; ++chan) {
+                        m_buffers.append(new RingBufferNPT<audio_sample_t>(RINGBUFFER_SIZE));
+                }
+        }
+        ~TPerChannelAdapter() {qDeleteAll(m_buffers);}
+
+        size_t write_space() {
+                size_t space = m_buffers.at(0)->write_space();
+                for (int chan=1; chan<m_buffers.size(); ++chan) {
+                        space = qMin(space, m_buffers.at(chan)->write_space());
+                }
+                return space;
+        }
+        size_t write(audio_sample_t* const* src, size_t cnt) {
+                size_t count = cnt;
+                for (int chan=0; chan<m_buffers.size(); ++chan) {
+                        count = qMin(count, m_buffers.at(chan)->write(src[chan], cnt));
+                }
+                return count;
+        }
+        size_t read_space() {
+                size_t space = m_buffers.at(0)->read_space();
+                for (int chan=1; chan<m_buffers.size(); ++chan) {
+                        space = qMin(space, m_buffers.at(chan)->read_space());
+                }
+                return space;
+        }
+        size_t read(audio_sample_t* const* dest, size_t cnt) {
+                size_t count = cnt;
+                for (int chan=0; chan<m_buffers.size(); ++chan) {
+                        count = qMin(count, m_buffers.at(chan)->read(dest[chan], cnt));
+                }
+                return count;
+        }
+
+private:
+        QList<RingBufferNPT<audio_sample_t>* > m_buffers;
+};
+
+// Frame numbers are wrapped at 2^24, so they are exact as a float sample
+static audio_sample_t ring_buffer_sample(nframes_t frame, int chan)
+{
+        return audio_sample_t((frame + nframes_t(chan) * 4099) & 0xFFFFFF);
+}
+
+// Chunk sizes of 1 to RINGBUFFER_MAX_CHUNK frames, from a linear congruential generator
+static nframes_t ring_buffer_chunk(uint& seed)
+{
+        seed = seed * 1103515245 + 12345;
+        return 1 + (seed >> 8) % RINGBUFFER_MAX_CHUNK;
+}
+
+class TRingBufferProducer : public QThread
+{
+public:
+        TRingBufferProducer(TRingBufferAdapter* buffer, int channels)
+                : m_buffer(buffer)
+                , m_channels(channels)
+        {}
+
+protected:
+        void run() {
+                audio_sample_t** src = new audio_sample_t*[m_channels];
+                for (int chan=0; chan<m_channels; ++chan) {
+                        src[chan] = new audio_sample_t[RINGBUFFER_MAX_CHUNK];
+                }
+
+                uint seed = 1;
+                nframes_t frame = 0;
+                while (frame < RINGBUFFER_LENGTH) {
+                        nframes_t chunk = qMin(ring_buffer_chunk(seed), RINGBUFFER_LENGTH - frame);
+                        chunk = qMin(chunk, nframes_t(m_buffer->write_space()));
+                        if (chunk == 0) {
+                                yieldCurrentThread();
+                                continue;
+                        }
+
+                        for (int chan=0; chan<m_channels; ++chan) {
+                                for (nframes_t x=0; x<chunk; ++x) {
+                                        src[chan][x] = ring_buffer_sample(frame + x, chan);
+                                }
+                        }
+
+                        frame += m_buffer->write(src, chunk);
+                }
+
+                for (int chan=0; chan<m_channels; ++chan) {
+                        delete [] src[chan];
+                }
+                delete [] src;
+        }
+
+private:
+        TRingBufferAdapter*     m_buffer;
+        int                     m_channels;
+};
+
+/**
+ * Passes RINGBUFFER_LENGTH frames from a producer thread through \a buffer,
+ * reading in chunks of another varying size and checking each sample.
+ *
+ * @return The number of wrong samples, \a time is set to the elapsed time in ms
+ */
+static int stress_ring_buffer(TRingBufferAdapter* buffer, int channels, int& time)
+{
+        audio_sample_t** dest = new audio_sample_t*[channels];
+        for (int chan=0; chan<channels; ++chan) {
+                dest[chan] = new audio_sample_t[RINGBUFFER_MAX_CHUNK];
+        }
+
+        TRingBufferProducer producer(buffer, channels);
+        int errors = 0;
+        uint seed = 7;
+        nframes_t frame = 0;
+
+        QTime timer;
+        timer.start();
+        producer.start();
+
+        while (frame < RINGBUFFER_LENGTH) {
+                nframes_t chunk = qMin(ring_buffer_chunk(seed), nframes_t(buffer->read_space()));
+                if (chunk == 0) {
+                        QThread::yieldCurrentThread();
+                        continue;
+                }
+
+                chunk = buffer->read(dest, chunk);
+
+                for (int chan=0; chan<channels; ++chan) {
+                        for (nframes_t x=0; x<chunk; ++x) {
+                                if (dest[chan][x] != ring_buffer_sample(frame + x, chan)) {
+                                        ++errors;
+                                }
+                        }
+                }
+
+                frame += chunk;
+        }
+
+        producer.wait();
+        time = timer.elapsed();
+
+        for (int chan=0; chan<channels; ++chan) {
+                delete [] dest[chan];
+        }
+        delete [] dest;
+
+        return errors;
+}
+
+/**
+ * Stress tests TMultiChannelRingBuffer and a RingBufferNPT per channel, for
+ * stereo and for a wide (8 channel) source.
+ */
+void TBenchmark::compare_ring_buffers()
+{
+        const int channelCounts[2] = {2, 8};
+
+        for (int i=0; i<2; ++i) {
+                int channels = channelCounts[i];
+
+                for (int type=0; type<2; ++type) {
+                        TRingBufferResult result;
+                        result.channels = channels;
+
+                        TRingBufferAdapter* buffer;
+                        if (type == 0) {
+                                result.type = "TMultiChannelRingBuffer";
+                                buffer = new TMultiChannelAdapter(channels);
+                        } else {
+                                result.type = "RingBufferNPT";
+                                buffer = new TPerChannelAdapter(channels);
+                        }
+
+                        printf("TBenchmark: stress testing %s, %d channels\n", QS_C(result.type), channels);
+
+                        result.errors = stress_ring_buffer(buffer, channels, result.time);
+                        if (result.errors) {
+                                PWARN("TBenchmark: %s read %d wrong samples", QS_C(result.type), result.errors);
+                        }
+
+                        delete buffer;
+                        m_ringBufferResults.append(result);
+                }
+        }
+}
+
+struct TMemOpsWriteFunction {
+        const char*                     name;
+        MemOps::write_function_t        function;
+        MemOps::write_function_t        reference;
+        int                             bytes;
+};
+
+struct TMemOpsReadFunction {
+        const char*                     name;
+        MemOps::read_function_t         function;
+        MemOps::read_function_t         reference;
+        MemOps::write_function_t        source;
+        int                             bytes;
+};
+
+typedef void (*memops_copy_function_t) (char *dst, char *src, unsigned long src_bytes, unsigned long dst_skip_bytes, unsigned long src_skip_bytes);
+
+struct TMemOpsCopyFunction {
+        const char*                     name;
+        memops_copy_function_t          function;
+        int                             bytes;
+        bool                            interleaved;
+};
+
+static const TMemOpsWriteFunction MEMOPS_WRITE_FUNCTIONS[] = {
+        {"sample_move_d32u24_sS", sample_move_d32u24_sS, 0, 4},
+        {"sample_move_d32u24_sSs", sample_move_d32u24_sSs, 0, 4},
+        {"sample_move_d24_sS", sample_move_d24_sS, 0, 3},
+        {"sample_move_d24_sSs", sample_move_d24_sSs, 0, 3},
+        {"sample_move_d16_sS", sample_move_d16_sS, 0, 2},
+        {"sample_move_d16_sSs", sample_move_d16_sSs, 0, 2},
+        {"sample_move_d32f_sS", sample_move_d32f_sS, 0, 4},
+        {"sample_move_dither_rect_d32u24_sS", sample_move_dither_rect_d32u24_sS, 0, 4},
+        {"sample_move_dither_rect_d32u24_sSs", sample_move_dither_rect_d32u24_sSs, 0, 4},
+        {"sample_move_dither_tri_d32u24_sS", sample_move_dither_tri_d32u24_sS, 0, 4},
+        {"sample_move_dither_tri_d32u24_sSs", sample_move_dither_tri_d32u24_sSs, 0, 4},
+        {"sample_move_dither_shaped_d32u24_sS", sample_move_dither_shaped_d32u24_sS, 0, 4},
+        {"sample_move_dither_shaped_d32u24_sSs", sample_move_dither_shaped_d32u24_sSs, 0, 4},
+        {"sample_move_dither_rect_d24_sS", sample_move_dither_rect_d24_sS, 0, 3},
+        {"sample_move_dither_rect_d24_sSs", sample_move_dither_rect_d24_sSs, 0, 3},
+        {"sample_move_dither_tri_d24_sS", sample_move_dither_tri_d24_sS, 0, 3},
+        {"sample_move_dither_tri_d24_sSs", sample_move_dither_tri_d24_sSs, 0, 3},
+        {"sample_move_dither_shaped_d24_sS", sample_move_dither_shaped_d24_sS, 0, 3},
+        {"sample_move_dither_shaped_d24_sSs", sample_move_dither_shaped_d24_sSs, 0, 3},
+        {"sample_move_dither_rect_d16_sS", sample_move_dither_rect_d16_sS, 0, 2},
+        {"sample_move_dither_rect_d16_sSs", sample_move_dither_rect_d16_sSs, 0, 2},
+        {"sample_move_dither_tri_d16_sS", sample_move_dither_tri_d16_sS, 0, 2},
+        {"sample_move_dither_tri_d16_sSs", sample_move_dither_tri_d16_sSs, 0, 2},
+        {"sample_move_dither_shaped_d16_sS", sample_move_dither_shaped_d16_sS, 0, 2},
+        {"sample_move_dither_shaped_d16_sSs", sample_move_dither_shaped_d16_sSs, 0, 2},
+        {"sample_merge_d32u24_sS", sample_merge_d32u24_sS, 0, 4},
+        {"sample_merge_d16_sS", sample_merge_d16_sS, 0, 2},
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (USE_XMMINTRIN) && defined (__SSE2__)
+        {"x86_sse2_sample_move_d32u24_sS", x86_sse2_sample_move_d32u24_sS, sample_move_d32u24_sS, 4},
+        {"x86_sse2_sample_move_d24_sS", x86_sse2_sample_move_d24_sS, sample_move_d24_sS, 3},
+        {"x86_sse2_sample_move_d16_sS", x86_sse2_sample_move_d16_sS, sample_move_d16_sS, 2},
+        {"x86_sse2_sample_move_d32f_sS", x86_sse2_sample_move_d32f_sS, sample_move_d32f_sS, 4},
+        {"x86_sse2_sample_move_dither_rect_d32u24_sS", x86_sse2_sample_move_dither_rect_d32u24_sS, 0, 4},
+        {"x86_sse2_sample_move_dither_tri_d32u24_sS", x86_sse2_sample_move_dither_tri_d32u24_sS, 0, 4},
+        {"x86_sse2_sample_move_dither_rect_d24_sS", x86_sse2_sample_move_dither_rect_d24_sS, 0, 3},
+        {"x86_sse2_sample_move_dither_tri_d24_sS", x86_sse2_sample_move_dither_tri_d24_sS, 0, 3},
+        {"x86_sse2_sample_move_dither_rect_d16_sS", x86_sse2_sample_move_dither_rect_d16_sS, 0, 2},
+        {"x86_sse2_sample_move_dither_tri_d16_sS", x86_sse2_sample_move_dither_tri_d16_sS, 0, 2},
+#endif
+        {0, 0, 0, 0}
+};
+
+static const TMemOpsReadFunction MEMOPS_READ_FUNCTIONS[] = {
+        {"sample_move_dS_s32u24", sample_move_dS_s32u24, 0, sample_move_d32u24_sS, 4},
+        {"sample_move_dS_s32u24s", sample_move_dS_s32u24s, 0, sample_move_d32u24_sSs, 4},
+        {"sample_move_dS_s24", sample_move_dS_s24, 0, sample_move_d24_sS, 3},
+        {"sample_move_dS_s24s", sample_move_dS_s24s, 0, sample_move_d24_sSs, 3},
+        {"sample_move_dS_s16", sample_move_dS_s16, 0, sample_move_d16_sS, 2},
+        {"sample_move_dS_s16s", sample_move_dS_s16s, 0, sample_move_d16_sSs, 2},
+        {"sample_move_dS_s32f", sample_move_dS_s32f, 0, sample_move_d32f_sS, 4},
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (USE_XMMINTRIN) && defined (__SSE2__)
+        {"x86_sse2_sample_move_dS_s32u24", x86_sse2_sample_move_dS_s32u24, sample_move_dS_s32u24, sample_move_d32u24_sS, 4},
+        {"x86_sse2_sample_move_dS_s24", x86_sse2_sample_move_dS_s24, sample_move_dS_s24, sample_move_d24_sS, 3},
+        {"x86_sse2_sample_move_dS_s16", x86_sse2_sample_move_dS_s16, sample_move_dS_s16, sample_move_d16_sS, 2},
+        {"x86_sse2_sample_move_dS_s32f", x86_sse2_sample_move_dS_s32f, sample_move_dS_s32f, sample_move_d32f_sS, 4},
+#endif
+        {0, 0, 0, 0, 0}
+};
+
+static const TMemOpsCopyFunction MEMOPS_COPY_FUNCTIONS[] = {
+        {"memcpy_fake", memcpy_fake, 4, false},
+        {"merge_memcpy_d16_s16", merge_memcpy_d16_s16, 2, false},
+        {"merge_memcpy_d32_s32", merge_memcpy_d32_s32, 4, false},
+        {"memcpy_interleave_d16_s16", memcpy_interleave_d16_s16, 2, true},
+        {"memcpy_interleave_d24_s24", memcpy_interleave_d24_s24, 3, true},
+        {"memcpy_interleave_d32_s32", memcpy_interleave_d32_s32, 4, true},
+        {"merge_memcpy_interleave_d16_s16", merge_memcpy_interleave_d16_s16, 2, true},
+        {"merge_memcpy_interleave_d24_s24", merge_memcpy_interleave_d24_s24, 3, true},
+        {"merge_memcpy_interleave_d32_s32", merge_memcpy_interleave_d32_s32, 4, true},
+        {0, 0, 0, false}
+};
+
+static double memops_ns_per_sample(int ms)
+{
+        return ms * 1.0e6 / (double(MEMOPS_FRAMES) * 2 * MEMOPS_ITERATIONS);
+}
+
+/**
+ * Times each memops function on MEMOPS_ITERATIONS blocks of MEMOPS_FRAMES stereo frames,
+ * the write and read functions are called once per channel, as the drivers do.
+ * The output of a function with a reference function is compared with the output of
+ * the reference, a mismatch is a sample of which any byte differs.
+ */
+void TBenchmark::time_memops()
+{
+        printf("TBenchmark: timing the memops functions\n");
+
+        audio_sample_t* samples[2];
+        audio_sample_t* readBack[2];
+        for (int chan=0; chan<2; ++chan) {
+                samples[chan] = new audio_sample_t[MEMOPS_FRAMES];
+                readBack[chan] = new audio_sample_t[MEMOPS_FRAMES];
+                for (unsigned long x=0; x<MEMOPS_FRAMES; ++x) {
+                        // Full scale, with some clipping on both sides
+                        samples[chan][x] = audio_sample_t(1.1 * sin(2.0 * M_PI * (x + chan * 17) / 97.0));
+                }
+        }
+
+        // Room for 2 interleaved channels of the widest (4 byte) sample format
+        char* interleaved = new char[MEMOPS_FRAMES * 2 * 4];
+        char* reference = new char[MEMOPS_FRAMES * 2 * 4];
+        dither_state_t state[2];
+        QTime time;
+
+        for (int i=0; MEMOPS_WRITE_FUNCTIONS[i].name; ++i) {
+                const TMemOpsWriteFunction& function = MEMOPS_WRITE_FUNCTIONS[i];
+                unsigned long skip = 2 * function.bytes;
+                memset(state, 0, sizeof(state));
+                memset(interleaved, 0, MEMOPS_FRAMES * skip);
+
+                time.start();
+                for (int n=0; n<MEMOPS_ITERATIONS; ++n) {
+                        for (int chan=0; chan<2; ++chan) {
+                                function.function(interleaved + chan * function.bytes, samples[chan], MEMOPS_FRAMES, skip, &state[chan]);
+                        }
+                }
+
+                TMemOpsResult result;
+                result.function = function.name;
+                result.nsPerSample = memops_ns_per_sample(time.elapsed());
+                result.mismatches = -1;
+
+                if (function.reference) {
+                        for (int chan=0; chan<2; ++chan) {
+                                function.reference(reference + chan * function.bytes, samples[chan], MEMOPS_FRAMES, skip, &state[chan]);
+                        }
+                        result.mismatches = 0;
+                        for (unsigned long x=0; x<MEMOPS_FRAMES * 2; ++x) {
+                                if (memcmp(interleaved + x * function.bytes, reference + x * function.bytes, function.bytes)) {
+                                        ++result.mismatches;
+                                }
+                        }
+                }
+
+                m_memOpsResults.append(result);
+        }
+
+        for (int i=0; MEMOPS_READ_FUNCTIONS[i].name; ++i) {
+                const TMemOpsReadFunction& function = MEMOPS_READ_FUNCTIONS[i];
+                unsigned long skip = 2 * function.bytes;
+
+                for (int chan=0; chan<2; ++chan) {
+                        function.source(interleaved + chan * function.bytes, samples[chan], MEMOPS_FRAMES, skip, &state[chan]);
+                }
+
+                time.start();
+                for (int n=0; n<MEMOPS_ITERATIONS; ++n) {
+                        for (int chan=0; chan<2; ++chan) {
+                                function.function(readBack[chan], interleaved + chan * function.bytes, MEMOPS_FRAMES, skip);
+                        }
+                }
+
+                TMemOpsResult result;
+                result.function = function.name;
+                result.nsPerSample = memops_ns_per_sample(time.elapsed());
+                result.mismatches = -1;
+
+                if (function.reference) {
+                        audio_sample_t* expected = (audio_sample_t*) reference;
+                        result.mismatches = 0;
+                        for (int chan=0; chan<2; ++chan) {
+                                function.reference(expected, interleaved + chan * function.bytes, MEMOPS_FRAMES, skip);
+                                for (unsigned long x=0; x<MEMOPS_FRAMES; ++x) {
+                                        if (memcmp(&expected[x], &readBack[chan][x], sizeof(audio_sample_t))) {
+                                                ++result.mismatches;
+                                        }
+                                }
+                        }
+                }
+
+                m_memOpsResults.append(result);
+        }
+
+        for (int i=0; MEMOPS_COPY_FUNCTIONS[i].name; ++i) {
+                const TMemOpsCopyFunction& function = MEMOPS_COPY_FUNCTIONS[i];
+                unsigned long skip = function.interleaved ? 2 * function.bytes : function.bytes;
+                unsigned long bytes = MEMOPS_FRAMES * function.bytes;
+                // The merge functions add the source to the destination, start from silence
+                memset(interleaved, 0, MEMOPS_FRAMES * 2 * 4);
+                memset(reference, 0, MEMOPS_FRAMES * 2 * 4);
+
+                time.start();
+                for (int n=0; n<MEMOPS_ITERATIONS; ++n) {
+                        for (int chan=0; chan<2; ++chan) {
+                                function.function(interleaved + chan * function.bytes, reference + chan * function.bytes, bytes, skip, skip);
+                        }
+                }
+
+                TMemOpsResult result;
+                result.function = function.name;
+                result.nsPerSample = memops_ns_per_sample(time.elapsed());
+                result.mismatches = -1;
+                m_memOpsResults.append(result);
+        }
+
+        time.start();
+        for (int n=0; n<MEMOPS_ITERATIONS; ++n) {
+                for (int chan=0; chan<2; ++chan) {
+                        memset_interleave(interleaved + chan * 4, 0, MEMOPS_FRAMES * 4, 4, 8);
+                }
+        }
+        TMemOpsResult result;
+        result.function = "memset_interleave";
+        result.nsPerSample = memops_ns_per_sample(time.elapsed());
+        result.mismatches = -1;
+        m_memOpsResults.append(result);
+
+        time.start();
+        for (int n=0; n<MEMOPS_ITERATIONS; ++n) {
+                for (int chan=0; chan<2; ++chan) {
+                        sample_memcpy(readBack[chan], samples[chan], MEMOPS_FRAMES);
+                }
+        }
+        result.function = "sample_memcpy";
+        result.nsPerSample = memops_ns_per_sample(time.elapsed());
+        m_memOpsResults.append(result);
+
+        time.start();
+        for (int n=0; n<MEMOPS_ITERATIONS; ++n) {
+                for (int chan=0; chan<2; ++chan) {
+                        sample_merge(readBack[chan], samples[chan], MEMOPS_FRAMES);
+                }
+        }
+        result.function = "sample_merge";
+        result.nsPerSample = memops_ns_per_sample(time.elapsed());
+        m_memOpsResults.append(result);
+
+        for (int chan=0; chan<2; ++chan) {
+                delete [] samples[chan];
+                delete [] readBack[chan];
+        }
+        delete [] interleaved;
+        delete [] reference;
+}
+
+/**
+ * Converts RESAMPLE_LENGTH seconds of pass band tones between 44.1 and 48 kHz in
+ * both directions, with libsamplerate and TPolyphaseResampler, for each converter type.
+ * When down sampling, a tone halfway the output and input nyquist frequency is
+ * converted as well, all of it that reaches the output is aliasing.
+ */
+void TBenchmark::compare_resamplers()
+{
+        const int rates[2][2] = {{44100, 48000}, {48000, 44100}};
+
+        for (int r=0; r<2; ++r) {
+                int inputRate = rates[r][0];
+                int outputRate = rates[r][1];
+                double nyquist = qMin(inputRate, outputRate) / 2.0;
+
+                if (!TPolyphaseFilter::is_supported(inputRate, outputRate)) {
+                        continue;
+                }
+
+                nframes_t inputFrames = nframes_t(RESAMPLE_LENGTH) * inputRate;
+                nframes_t outputFrames = nframes_t(RESAMPLE_LENGTH) * outputRate;
+
+                audio_sample_t* input = new audio_sample_t[inputFrames];
+                audio_sample_t* reference = new audio_sample_t[outputFrames];
+                audio_sample_t* output = new audio_sample_t[outputFrames];
+
+                generate_tones(input, inputFrames, inputRate, nyquist);
+                generate_tones(reference, outputFrames, outputRate, nyquist);
+
+                // All of this tone is above the output nyquist frequency
+                audio_sample_t* alias = 0;
+                if (outputRate < inputRate) {
+                        alias = new audio_sample_t[inputFrames];
+                        double frequency = (inputRate + outputRate) / 4.0;
+                        for (nframes_t x=0; x<inputFrames; ++x) {
+                                alias[x] = audio_sample_t(sin(2.0 * M_PI * frequency * x / inputRate));
+                        }
+                }
+
+                for (int type=SRC_SINC_BEST_QUALITY; type<=SRC_LINEAR; ++type) {
+                        TResamplerResult result;
+                        result.inputRate = inputRate;
+                        result.outputRate = outputRate;
+                        result.converterType = type;
+                        result.srcAliasing = result.polyphaseAliasing = 0.0;
+
+                        printf("TBenchmark: resampling %d to %d Hz, converter type %d\n", inputRate, outputRate, type);
+
+                        QTime time;
+                        time.start();
+                        nframes_t frames = resample_src(input, inputFrames, output, outputFrames, inputRate, outputRate, type);
+                        result.srcTime = time.elapsed();
+                        result.srcSnr = signal_to_noise(output, reference, frames);
+
+                        time.start();
+                        frames = resample_polyphase(input, inputFrames, output, outputFrames, inputRate, outputRate, type);
+                        result.polyphaseTime = time.elapsed();
+                        result.polyphaseSnr = signal_to_noise(output, reference, frames);
+
+                        if (alias) {
+                                frames = resample_src(alias, inputFrames, output, outputFrames, inputRate, outputRate, type);
+                                result.srcAliasing = aliasing_level(output, frames);
+                                frames = resample_polyphase(alias, inputFrames, output, outputFrames, inputRate, outputRate, type);
+                                result.polyphaseAliasing = aliasing_level(output, frames);
+                        }
+
+                        m_resamplerResults.append(result);
+                }
+
+                delete [] input;
+                delete [] reference;
+                delete [] output;
+                delete [] alias;
+        }
+}
+
+int TBenchmark::write_results()
+{
+        QDir dir;
+        if (!dir.mkpath(QFileInfo(m_fileName).absolutePath())) {
+                PERROR("Unable to create directory for %s", QS_C(m_fileName));
+                return -1;
+        }
+
+        QFile file(m_fileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+                PERROR("Unable to open %s for writing", QS_C(m_fileName));
+                return -1;
+        }
+
+        QTextStream stream(&file);
+
+        stream << "{\n";
+        stream << "  \"date\": \"" << QDateTime::currentDateTime().toString(Qt::ISODate) << "\",\n";
+        stream << "  \"rate\": " << audiodevice().get_sample_rate() << ",\n";
+        stream << "  \"buffersize\": " << audiodevice().get_buffer_size() << ",\n";
+        stream << "  \"threads\": " << QThread::idealThreadCount() << ",\n";
+        stream << "  \"results\": [\n";
+
+        for (int i=0; i<m_results.size(); ++i) {
+                const TBenchmarkResult& result = m_results.at(i);
+                stream << "    {"
+                       << "\"sheets\": " << result.size.sheets
+                       << ", \"tracks\": " << result.size.tracks
+                       << ", \"clips\": " << result.size.clips
+                       << ", \"sources\": " << result.sources
+                       << ", \"generate_ms\": " << result.generate
+                       << ", \"load_ms\": " << result.load
+                       << ", \"save_ms\": " << result.save
+                       << ", \"peaks_ms\": " << result.peaks
+                       << ", \"seek_ms\": " << result.seek
+                       << ", \"playback_ms\": " << result.playback
+                       << ", \"export_ms\": " << result.exporting
+                       << "}" << (i < m_results.size() - 1 ? ",\n" : "\n");
+        }
+
+        stream << "  ],\n";
+        stream << "  \"resampling\": [\n";
+
+        for (int i=0; i<m_resamplerResults.size(); ++i) {
+                const TResamplerResult& result = m_resamplerResults.at(i);
+                stream << "    {"
+                       << "\"input_rate\": " << result.inputRate
+                       << ", \"output_rate\": " << result.outputRate
+                       << ", \"converter_type\": " << result.converterType
+                       << ", \"src_ms\": " << result.srcTime
+                       << ", \"polyphase_ms\": " << result.polyphaseTime
+                       << ", \"src_snr_db\": " << QString::number(result.srcSnr, 'f', 1)
+                       << ", \"polyphase_snr_db\": " << QString::number(result.polyphaseSnr, 'f', 1);
+                if (result.outputRate < result.inputRate) {
+                        stream << ", \"src_aliasing_db\": " << QString::number(result.srcAliasing, 'f', 1)
+                               << ", \"polyphase_aliasing_db\": " << QString::number(result.polyphaseAliasing, 'f', 1);
+                }
+                stream << "}" << (i < m_resamplerResults.size() - 1 ? ",\n" : "\n");
+        }
+
+        stream << "  ],\n";
+        stream << "  \"ringbuffers\": [\n";
+
+        for (int i=0; i<m_ringBufferResults.size(); ++i) {
+                const TRingBufferResult& result = m_ringBufferResults.at(i);
+                stream << "    {"
+                       << "\"type\": \"" << result.type << "\""
+                       << ", \"channels\": " << result.channels
+                       << ", \"frames\": " << RINGBUFFER_LENGTH
+                       << ", \"ms\": " << result.time
+                       << ", \"errors\": " << result.errors
+                       << "}" << (i < m_ringBufferResults.size() - 1 ? ",\n" : "\n");
+        }
+
+        stream << "  ],\n";
+        stream << "  \"memops\": [\n";
+
+        for (int i=0; i<m_memOpsResults.size(); ++i) {
+                const TMemOpsResult& result = m_memOpsResults.at(i);
+                stream << "    {"
+                       << "\"function\": \"" << result.function << "\""
+                       << ", \"ns_per_sample\": " << QString::number(result.nsPerSample, 'f', 3);
+                if (result.mismatches >= 0) {
+                        stream << ", \"mismatches\": " << result.mismatches;
+                }
+                stream << "}" << (i < m_memOpsResults.size() - 1 ? ",\n" : "\n");
+        }
+
+        stream << "  ]\n";
+        stream << "}\n";
+
+        printf("TBenchmark: results written to %s\n", QS_C(m_fileName));
+
+        return 1;
+}
+
+#endif
+
+//eof
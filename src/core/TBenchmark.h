@@ -0,0 +1,133 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TBENCHMARK_H
+#define TBENCHMARK_H
+
+#if defined (BENCHMARK)
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "defines.h"
+
+class Project;
+class Sheet;
+
+struct TBenchmarkSize {
+        int     sheets;
+        int     tracks;
+        int     clips;
+};
+
+struct TBenchmarkResult {
+        TBenchmarkSize  size;
+        int             sources;
+        int             generate;
+        int             save;
+        int             load;
+        int             peaks;
+        int             seek;
+        int             playback;
+        int             exporting;
+};
+
+struct TResamplerResult {
+        int             inputRate;
+        int             outputRate;
+        int             converterType;
+        int             srcTime;
+        int             polyphaseTime;
+        double          srcSnr;
+        double          polyphaseSnr;
+        double          srcAliasing;
+        double          polyphaseAliasing;
+};
+
+struct TMemOpsResult {
+        QString         function;
+        double          nsPerSample;
+        int             mismatches;
+};
+
+struct TRingBufferResult {
+        QString         type;
+        int             channels;
+        int             time;
+        int             errors;
+};
+
+
+/**
+ * Creates a synthetic Project of a given size, with generated audio sources.
+ */
+class TSessionGenerator
+{
+public:
+        TSessionGenerator(const TBenchmarkSize& size);
+
+        QString get_project_name() const;
+        int get_source_count() const {return m_sourceNames.size();}
+
+        int generate();
+
+private:
+        TBenchmarkSize  m_size;
+        QStringList     m_sourceNames;
+
+        int generate_sources(Project* project);
+        int generate_source(Project* project, int index, const QString& format);
+        void populate_sheet(Sheet* sheet, int sheetIndex);
+};
+
+
+class TBenchmark
+{
+public:
+        TBenchmark(const QString& sweep, const QString& fileName);
+
+        int run();
+
+private:
+        QList<TBenchmarkSize>   m_sizes;
+        QList<TBenchmarkResult> m_results;
+        QList<TResamplerResult> m_resamplerResults;
+        QList<TRingBufferResult> m_ringBufferResults;
+        QList<TMemOpsResult>    m_memOpsResults;
+        QString                 m_fileName;
+
+        int run_size(const TBenchmarkSize& size, TBenchmarkResult& result);
+        int build_peaks(Project* project);
+        int seek_sheets(Project* project);
+        int play_sheets(Project* project);
+        int export_project(Project* project);
+        void compare_resamplers();
+        void compare_ring_buffers();
+        void time_memops();
+        int write_results();
+};
+
+#endif
+
+#endif
+
+//eof
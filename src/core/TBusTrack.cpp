@@ -107,27 +107,31 @@ void TBusTrack::set_name( const QString & name )
 
 int TBusTrack::process(nframes_t nframes)
 {
+        begin_cycle();
+
         if (m_isMuted || (get_gain() == 0.0f) ) {
                 return 0;
         }
 
+        // Nothing was send to this bus, only the post fader plugins might
+        // still have to play out their tail.
+        if (m_processBus->is_silent()) {
+                ++m_skippedCycles;
+                if (m_pluginChain->process_post_fader(m_processBus, nframes)) {
+                        m_processBus->process_monitoring(m_vumonitors);
+                        process_post_sends(nframes);
+                        m_processBus->silence_buffers(nframes);
+                }
+                return 1;
+        }
+
         process_pre_sends(nframes);
 
         m_pluginChain->process_pre_fader(m_processBus, nframes);
 
         m_fader->process(m_processBus, nframes);
 
-        float panFactor;
-
-        if ( (m_processBus->get_channel_count() >= 1) && (m_pan > 0) )  {
-                panFactor = 1 - m_pan;
-                Mixer::apply_gain_to_buffer(m_processBus->get_buffer(0, nframes), nframes, panFactor);
-        }
-
-        if ( (m_processBus->get_channel_count() >= 2) && (m_pan < 0) )  {
-                panFactor = 1 + m_pan;
-                Mixer::apply_gain_to_buffer(m_processBus->get_buffer(1, nframes), nframes, panFactor);
-        }
+        process_pan(m_processBus, nframes, true);
 
 	// gain automation curve only understands audio_sample_t** atm
 	// so wrap the process buffers into a audio_sample_t**
@@ -138,7 +142,7 @@ int TBusTrack::process(nframes_t nframes)
 
 	TimeRef location = m_session->get_transport_location();
 	TimeRef endlocation = location + TimeRef(nframes, audiodevice().get_sample_rate());
-	m_fader->process_gain(mixdown, location, endlocation, nframes, m_processBus->get_channel_count());
+	m_fader->process_gain(mixdown, location, endlocation, nframes, m_processBus->get_channel_count(), 0, true);
 
 
         m_pluginChain->process_post_fader(m_processBus, nframes);
@@ -26,6 +26,8 @@ $Id: Command.cpp,v 1.21 2008/02/12 20:39:08 r_sijrier Exp $
 #include <Utils.h>
 #include <Themer.h>
 #include "ContextItem.h"
+#include "TConfig.h"
+#include "TMemoryBudget.h"
 
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
@@ -90,6 +92,7 @@ TCommand::TCommand( const QString& des )
 {
 	m_historyStack = 0;
 	m_isHistorable = true;
+	m_historyMemory = 0;
 }
 
 /**
@@ -106,10 +109,15 @@ TCommand::TCommand(ContextItem* item, const QString& des)
 	Q_ASSERT(item);
 	m_historyStack = item->get_history_stack();
 	m_isHistorable = true;
+	m_historyMemory = 0;
 }
 
 TCommand::~TCommand()
-{}
+{
+	if (m_historyMemory) {
+		memorybudget().remove(TMemoryBudget::History, m_historyMemory);
+	}
+}
 
 /**
  * 	Virtual function, only needs to be reimplemented when making a 
@@ -184,11 +192,52 @@ int TCommand::push_to_history_stack( )
 		return -1;
 	}
 		
+	// Account before pushing, push() deletes this command when it
+	// merges with the previous one.
+	m_historyMemory = get_memory_usage();
+	memorybudget().add(TMemoryBudget::History, m_historyMemory);
+	m_pushTime.start();
+	
 	m_historyStack->push(this);
 	
 	return 1;
 }
 
+/**
+ * 	Reimplement to return the (approximate) memory this command keeps
+	allocated while it's in the history, including lists of
+	original positions and the like.
+ * @return The memory used in bytes
+ */
+qint64 TCommand::get_memory_usage() const
+{
+	return sizeof(TCommand) + text().size() * sizeof(QChar);
+}
+
+/**
+ * 	For use in mergeWith() reimplementations, commands are only merged when
+	\a next was pushed within the merge interval (config key
+	Project/HistoryMergeInterval, in ms) after this one, so separate
+	edits remain separate undo steps.
+
+	Updates the push time of this command, so a continuous series of
+	edits merges into one command.
+ * @param next The command that is about to be merged into this one
+ * @return true if \a next may be merged
+ */
+bool TCommand::is_merge_interval(const TCommand* next)
+{
+	int interval = config().get_property("Project", "HistoryMergeInterval", 1500).toInt();
+	
+	if (m_pushTime.msecsTo(next->m_pushTime) > interval) {
+		return false;
+	}
+	
+	m_pushTime = next->m_pushTime;
+	
+	return true;
+}
+
 /**
  * 	Virtual function, needs to be reimplemented for all
 	type of Commands
@@ -26,6 +26,7 @@
 #include <QObject>
 #include <QUndoCommand>
 #include <QUndoStack>
+#include <QTime>
 
 class ContextItem;
 class QUndoStack;
@@ -64,12 +65,23 @@ public :
         
 
 protected:
+        // Ids for QUndoCommand::id(), for commands that merge with their predecessor
+        enum MergeId {
+                GainMergeId = 1,
+                TrackPanMergeId
+        };
+
         bool 		m_isValid;
         bool		m_isHistorable;
         QString		m_description;
 
+        virtual qint64 get_memory_usage() const;
+        bool is_merge_interval(const TCommand* next);
+
 private:
         QUndoStack* m_historyStack;
+        QTime		m_pushTime;
+        qint64		m_historyMemory;
 };
 
 
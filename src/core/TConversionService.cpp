@@ -0,0 +1,544 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TConversionService.h"
+
+#include <QMutexLocker>
+#include <QVector>
+
+#include "Export.h"
+#include "AbstractAudioReader.h"
+#include "ReadSource.h"
+#include "WriteSource.h"
+#include "Peak.h"
+#include "Mixer.h"
+#include "ProjectManager.h"
+#include "ResourcesManager.h"
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+/**
+ * \class TConversionService
+ * \brief Runs audio file merge, copy and convert jobs on a small pool of worker threads
+ *
+ * Jobs are queued with enqueue_job() and picked up by the first idle TConversionWorker.
+ * The number of workers is bounded by the amount of cpu cores (at most 4, the jobs are
+ * mostly disk bound), workers are created on demand and wait for new jobs when idle.
+ *
+ * A job reads all it's ReadSources in blocks of BUFFER_SIZE frames, interleaves their
+ * channels with Mixer::interleave_buffers() into one output file, and generates the
+ * peak data for the new file on the fly.
+ *
+ * Jobs belong to a group, which is typically owned by an AudioFileMerger or an
+ * AudioFileCopyConvert. The owner releases it's group with release_group() when done
+ * with it. Progress is reported per group with groupProgress(), and for all queued
+ * jobs together with progress() and throughputChanged(), which the progress toolbar
+ * shows. The throughput is the amount of audio converted per second, relative to
+ * realtime. batchFinished() is emitted when the last queued job is done.
+ *
+ * A job can own it's ReadSources and ExportSpecification (see Ownership), which
+ * are released once it finished or was cancelled, so they are not leaked when the
+ * owner of the group is gone before the running jobs noticed the cancel request.
+ *
+ * All signals are emitted from the worker threads, use queued connections!
+ */
+
+TConversionService& conversionservice()
+{
+	static TConversionService service;
+	return service;
+}
+
+
+TConversionWorker::TConversionWorker(TConversionService * service)
+	: m_service(service)
+{
+}
+
+void TConversionWorker::run()
+{
+	while (TConversionService::Job* job = m_service->take_job()) {
+		m_service->process_job(job);
+		m_service->job_done(job);
+	}
+}
+
+
+TConversionService::TConversionService()
+{
+	m_maxWorkers = qBound(1, QThread::idealThreadCount(), 4);
+	m_idleWorkers = 0;
+	m_runningJobs = 0;
+	m_nextJobId = 0;
+	m_nextGroupId = 0;
+	m_progress = 0;
+	m_shuttingDown = false;
+	m_totalFrames = 0;
+	m_processedFrames = 0;
+	m_processedSeconds = 0.0;
+}
+
+TConversionService::~TConversionService()
+{
+	m_mutex.lock();
+	m_shuttingDown = true;
+	// The ResourcesManager may be gone allready, only
+	// the ExportSpecifications are released.
+	while (!m_jobs.isEmpty()) {
+		Job* job = m_jobs.dequeue();
+		if (job->ownership & OwnsSpec) {
+			delete job->spec;
+		}
+		delete job;
+	}
+	for (int i=0; i<m_groups.size(); ++i) {
+		m_groups[i].cancelled = true;
+	}
+	m_jobAvailable.wakeAll();
+	m_mutex.unlock();
+
+	foreach(TConversionWorker* worker, m_workers) {
+		if ( ! worker->wait(1000) ) {
+			qWarning("TConversionService: Worker still running after 1 second wait, terminating!");
+			worker->terminate();
+		}
+		delete worker;
+	}
+}
+
+/**
+ * Creates a new job group, jobs in the same group can be cancelled together
+ * and their progress is reported with groupProgress()
+ *
+ * @return The id of the new group
+ */
+int TConversionService::create_group()
+{
+	QMutexLocker locker(&m_mutex);
+
+	Group group;
+	group.id = ++m_nextGroupId;
+	group.jobCount = 0;
+	group.totalFrames = 0;
+	group.processedFrames = 0;
+	group.progress = 0;
+	group.cancelled = false;
+	group.released = false;
+
+	m_groups.append(group);
+
+	return group.id;
+}
+
+/**
+ * Removes \a group, once it's last job has finished. Call when no
+ * more jobs will be queued in it, after cancel_group() if needed.
+ */
+void TConversionService::release_group(int group)
+{
+	QMutexLocker locker(&m_mutex);
+
+	Group* jobgroup = find_group(group);
+	if (!jobgroup) {
+		return;
+	}
+
+	if (jobgroup->jobCount == 0) {
+		remove_group(group);
+	} else {
+		jobgroup->released = true;
+	}
+}
+
+/**
+ * Queues a job which writes all channels of \a sources interleaved into a float wav
+ * file named \a outfilename in \a dir.
+
+ * \a ownership tells if the job owns the ReadSources (they are removed from the
+ * ResourcesManager) and/or the ExportSpecification (it's deleted) once the job finished
+ * or was cancelled. What it doesn't own has to stay valid until jobFinished() or
+ * jobCancelled() has been emitted for this job.
+ *
+ * @return The job id, or -1 if the job could not be queued, the caller keeps
+ *	ownership then
+ */
+int TConversionService::enqueue_job(int group, const QList<ReadSource*>& sources, ExportSpecification* spec,
+	const QString& dir, const QString& outfilename, const QString& description, int ownership)
+{
+	if (sources.isEmpty() || !spec) {
+		return -1;
+	}
+
+	QMutexLocker locker(&m_mutex);
+
+	Group* jobgroup = find_group(group);
+	if (!jobgroup || jobgroup->released || m_shuttingDown) {
+		return -1;
+	}
+
+	Job* job = new Job;
+	job->id = ++m_nextJobId;
+	job->group = group;
+	job->sources = sources;
+	job->spec = spec;
+	job->dir = dir;
+	job->outFileName = outfilename;
+	job->description = description;
+	job->ownership = ownership;
+
+	qint64 frames = sources.first()->get_length().universal_frame();
+
+	if (m_totalFrames == 0) {
+		m_batchTime.start();
+		m_processedFrames = 0;
+		m_processedSeconds = 0.0;
+		m_progress = 0;
+	}
+
+	m_totalFrames += frames;
+	jobgroup->totalFrames += frames;
+	jobgroup->jobCount++;
+	jobgroup->cancelled = false;
+
+	m_jobs.enqueue(job);
+
+	if (m_idleWorkers == 0 && m_workers.size() < m_maxWorkers) {
+		TConversionWorker* worker = new TConversionWorker(this);
+		m_workers.append(worker);
+		worker->start();
+	}
+
+	m_jobAvailable.wakeOne();
+
+	return job->id;
+}
+
+/**
+ * Removes all queued jobs of \a group and stops the ones that are being processed.
+ * jobCancelled() is emitted for each of them, followed by groupStopped() once the
+ * last job of the group has finished.
+ *
+ * @return The ids of the jobs that were removed from the queue, they never started
+ */
+QList<int> TConversionService::cancel_group(int group)
+{
+	QList<Job*> removed;
+	QList<int> removedIds;
+
+	m_mutex.lock();
+
+	Group* jobgroup = find_group(group);
+	if (!jobgroup) {
+		m_mutex.unlock();
+		return removedIds;
+	}
+
+	jobgroup->cancelled = true;
+
+	for (int i=m_jobs.size() - 1; i>=0; --i) {
+		Job* job = m_jobs.at(i);
+		if (job->group == group) {
+			removed.prepend(m_jobs.takeAt(i));
+			m_totalFrames -= job->sources.first()->get_length().universal_frame();
+		}
+	}
+
+	jobgroup->jobCount -= removed.size();
+	bool stopped = (jobgroup->jobCount == 0);
+	if (stopped) {
+		jobgroup->totalFrames = jobgroup->processedFrames = 0;
+		jobgroup->progress = 0;
+		jobgroup->cancelled = false;
+		if (jobgroup->released) {
+			remove_group(group);
+		}
+	}
+
+	bool finished = !removed.isEmpty() && m_jobs.isEmpty() && (m_runningJobs == 0);
+	if (finished) {
+		m_totalFrames = m_processedFrames = 0;
+	}
+
+	m_mutex.unlock();
+
+	foreach(Job* job, removed) {
+		removedIds.append(job->id);
+		emit jobCancelled(group, job->id);
+		delete_job(job);
+	}
+
+	if (stopped) {
+		emit groupStopped(group);
+	}
+	if (finished) {
+		emit batchFinished();
+	}
+
+	return removedIds;
+}
+
+int TConversionService::get_pending_job_count()
+{
+	QMutexLocker locker(&m_mutex);
+	return m_jobs.size();
+}
+
+TConversionService::Job* TConversionService::take_job()
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_idleWorkers++;
+	while (m_jobs.isEmpty() && !m_shuttingDown) {
+		m_jobAvailable.wait(&m_mutex);
+	}
+	m_idleWorkers--;
+
+	if (m_shuttingDown) {
+		return 0;
+	}
+
+	m_runningJobs++;
+
+	return m_jobs.dequeue();
+}
+
+void TConversionService::process_job(Job* job)
+{
+	emit jobStarted(job->group, job->id, job->description);
+
+	ExportSpecification* spec = job->spec;
+	ReadSource* master = job->sources.first();
+	int rate = master->get_rate();
+
+	int channelcount = 0;
+	foreach(ReadSource* source, job->sources) {
+		channelcount += source->get_channel_count();
+	}
+
+	spec->startLocation = TimeRef();
+	spec->endLocation = master->get_length();
+	spec->totalTime = spec->endLocation;
+	spec->pos = TimeRef();
+	spec->isRecording = false;
+
+	spec->exportdir = job->dir;
+	spec->writerType = "sndfile";
+	spec->extraFormat["filetype"] = "wav";
+	spec->data_width = 1;	// 1 means float
+	spec->channels = channelcount;
+	spec->sample_rate = rate;
+	spec->blocksize = BUFFER_SIZE;
+	spec->name = job->outFileName;
+	spec->dataF = new audio_sample_t[BUFFER_SIZE * channelcount];
+
+	QVector<DecodeBuffer*> decodebuffers(job->sources.size());
+	for (int i=0; i<decodebuffers.size(); ++i) {
+		decodebuffers[i] = new DecodeBuffer;
+	}
+	QVector<audio_sample_t*> channels(channelcount);
+
+	WriteSource* writesource = new WriteSource(spec);
+	bool failedToPrepareWritesource = false;
+	bool cancelled = false;
+
+	if (writesource->prepare_export() == -1) {
+		failedToPrepareWritesource = true;
+		goto out;
+	}
+	// Enable on the fly generation of peak data to speedup conversion
+	// (no need to re-read all the audio files to generate peaks)
+	writesource->set_process_peaks(true);
+
+	while (spec->pos != spec->totalTime) {
+		nframes_t diff = (spec->endLocation - spec->pos).to_frame(rate);
+		nframes_t nframes = std::min(diff, BUFFER_SIZE);
+
+		int channel = 0;
+		for (int i=0; i<job->sources.size(); ++i) {
+			ReadSource* source = job->sources.at(i);
+			source->file_read(decodebuffers[i], spec->pos, nframes);
+			for (int chan=0; chan<source->get_channel_count(); ++chan) {
+				channels[channel++] = decodebuffers[i]->destination[chan];
+			}
+		}
+
+		Mixer::interleave_buffers(spec->dataF, channels.data(), channelcount, nframes);
+
+		// due the fact peak generating does _not_ happen in writesource->process
+		// but in a function used by DiskIO, we have to hack the peak processing
+		// in here.
+		for (int chan=0; chan<channelcount; ++chan) {
+			writesource->get_peak()->process(chan, channels[chan], nframes);
+		}
+
+		// Process the data, and write to disk
+		writesource->process(nframes);
+
+		TimeRef oldpos = spec->pos;
+		spec->pos.add_frames(nframes, rate);
+
+		// if the user asked to stop processing, jump out of this
+		// loop, and cleanup any resources in use.
+		if (update_progress(job, (spec->pos - oldpos).universal_frame(), double(nframes) / rate)) {
+			cancelled = true;
+			break;
+		}
+	}
+
+out:
+	if (!failedToPrepareWritesource) {
+		writesource->finish_export();
+	}
+	delete writesource;
+	delete [] spec->dataF;
+	spec->dataF = 0;
+	foreach(DecodeBuffer* buffer, decodebuffers) {
+		delete buffer;
+	}
+
+	if (cancelled) {
+		emit jobCancelled(job->group, job->id);
+	} else {
+		emit jobFinished(job->group, job->id, job->description, job->dir + "/" + job->outFileName + ".wav");
+	}
+}
+
+/**
+ * Adds \a frames (universal frames) and \a seconds of processed audio to the totals
+ * of the job's group and the service, and emits the progress signals if needed.
+ *
+ * @return true if the job's group was cancelled
+ */
+bool TConversionService::update_progress(Job* job, qint64 frames, double seconds)
+{
+	m_mutex.lock();
+
+	Group* group = find_group(job->group);
+	bool cancelled = group->cancelled;
+
+	group->processedFrames += frames;
+	m_processedFrames += frames;
+	m_processedSeconds += seconds;
+
+	int groupprogress = group->totalFrames ? int(double(group->processedFrames) / group->totalFrames * 100) : 0;
+	int totalprogress = m_totalFrames ? int(double(m_processedFrames) / m_totalFrames * 100) : 0;
+	int elapsed = m_batchTime.elapsed();
+	double throughput = elapsed ? m_processedSeconds / (elapsed / 1000.0) : 0.0;
+
+	bool groupchanged = groupprogress > group->progress;
+	bool totalchanged = totalprogress > m_progress;
+	if (groupchanged) {
+		group->progress = groupprogress;
+	}
+	if (totalchanged) {
+		m_progress = totalprogress;
+	}
+
+	m_mutex.unlock();
+
+	if (groupchanged) {
+		emit groupProgress(job->group, groupprogress);
+	}
+	if (totalchanged) {
+		emit progress(totalprogress);
+		emit throughputChanged(throughput);
+	}
+
+	return cancelled;
+}
+
+void TConversionService::job_done(Job* job)
+{
+	m_mutex.lock();
+
+	Group* group = find_group(job->group);
+	group->jobCount--;
+
+	bool stopped = false;
+	if (group->jobCount == 0) {
+		stopped = group->cancelled;
+		group->totalFrames = group->processedFrames = 0;
+		group->progress = 0;
+		group->cancelled = false;
+		if (group->released) {
+			remove_group(job->group);
+		}
+	}
+
+	// The service is idle if this was the last job, start
+	// with fresh totals for the next batch of jobs.
+	m_runningJobs--;
+	bool finished = m_jobs.isEmpty() && (m_runningJobs == 0);
+	if (finished) {
+		m_totalFrames = m_processedFrames = 0;
+	}
+
+	m_mutex.unlock();
+
+	if (stopped) {
+		emit groupStopped(job->group);
+	}
+	if (finished) {
+		emit batchFinished();
+	}
+
+	delete_job(job);
+}
+
+// Releases what the job owns, and the job itself
+void TConversionService::delete_job(Job* job)
+{
+	if (job->ownership & OwnsSources) {
+		foreach(ReadSource* source, job->sources) {
+			resources_manager()->remove_source(source);
+		}
+	}
+	if (job->ownership & OwnsSpec) {
+		delete job->spec;
+	}
+
+	delete job;
+}
+
+TConversionService::Group* TConversionService::find_group(int id)
+{
+	for (int i=0; i<m_groups.size(); ++i) {
+		if (m_groups.at(i).id == id) {
+			return &m_groups[i];
+		}
+	}
+	return 0;
+}
+
+// Call with m_mutex locked
+void TConversionService::remove_group(int id)
+{
+	for (int i=0; i<m_groups.size(); ++i) {
+		if (m_groups.at(i).id == id) {
+			m_groups.removeAt(i);
+			return;
+		}
+	}
+}
+
+//eof
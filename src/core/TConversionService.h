@@ -0,0 +1,147 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TCONVERSION_SERVICE_H
+#define TCONVERSION_SERVICE_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QList>
+#include <QTime>
+
+#include "defines.h"
+
+class ReadSource;
+class TConversionService;
+struct ExportSpecification;
+
+class TConversionWorker : public QThread
+{
+public:
+	TConversionWorker(TConversionService* service);
+
+protected:
+	void run();
+
+private:
+	TConversionService* m_service;
+};
+
+
+class TConversionService : public QObject
+{
+	Q_OBJECT
+
+public:
+	static const nframes_t BUFFER_SIZE = 65536;
+
+	// What a job owns, and releases once it finished or was cancelled
+	enum Ownership {
+		OwnsNothing = 0,
+		OwnsSources = 1,
+		OwnsSpec = 2
+	};
+
+	int create_group();
+	void release_group(int group);
+	int enqueue_job(int group, const QList<ReadSource*>& sources, ExportSpecification* spec,
+			const QString& dir, const QString& outfilename, const QString& description,
+			int ownership=OwnsNothing);
+	QList<int> cancel_group(int group);
+
+	int get_max_workers() const {return m_maxWorkers;}
+	int get_pending_job_count();
+
+private:
+	TConversionService();
+	~TConversionService();
+	TConversionService(const TConversionService&);
+
+	// allow this function to create one instance
+	friend TConversionService& conversionservice();
+	friend class TConversionWorker;
+
+	struct Job {
+		int id;
+		int group;
+		QList<ReadSource*> sources;
+		ExportSpecification* spec;
+		QString dir;
+		QString outFileName;
+		QString description;
+		int ownership;
+	};
+
+	struct Group {
+		int id;
+		int jobCount;
+		qint64 totalFrames;
+		qint64 processedFrames;
+		int progress;
+		bool cancelled;
+		bool released;
+	};
+
+	QList<TConversionWorker*> m_workers;
+	QQueue<Job*>	m_jobs;
+	QList<Group>	m_groups;
+	QMutex		m_mutex;
+	QWaitCondition	m_jobAvailable;
+	QTime		m_batchTime;
+	int		m_maxWorkers;
+	int		m_idleWorkers;
+	int		m_runningJobs;
+	int		m_nextJobId;
+	int		m_nextGroupId;
+	int		m_progress;
+	bool		m_shuttingDown;
+	qint64		m_totalFrames;
+	qint64		m_processedFrames;
+	double		m_processedSeconds;
+
+	Job* take_job();
+	void process_job(Job* job);
+	bool update_progress(Job* job, qint64 frames, double seconds);
+	void job_done(Job* job);
+	void delete_job(Job* job);
+	Group* find_group(int id);
+	void remove_group(int id);
+
+signals:
+	void jobStarted(int group, int job, QString description);
+	void jobFinished(int group, int job, QString description, QString filename);
+	void jobCancelled(int group, int job);
+	void groupProgress(int group, int progress);
+	void groupStopped(int group);
+	void progress(int);
+	void throughputChanged(double);
+	void batchFinished();
+};
+
+// use this function to access the conversion service
+TConversionService& conversionservice();
+
+#endif
+
+//eof
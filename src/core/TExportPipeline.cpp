@@ -0,0 +1,336 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TExportPipeline.h"
+
+#include <QMutexLocker>
+#include <cstring>
+
+#include "TConfig.h"
+#include "TMemoryBudget.h"
+#include "TTimelineTracer.h"
+#include "WriteSource.h"
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+/**
+ * \class TExportPipeline
+ * \brief Runs the sample rate conversion, dithering and encoding of an export on their own threads
+ *
+ * Without the pipeline, the export thread renders a block of the Sheet and then waits for
+ * the WriteSource to convert, dither and encode it, before it can render the next one.
+ * With the pipeline, the export is split in three stages that run concurrently:
+ *
+ * - render: the export thread mixes the Sheet and push()'es the interleaved block
+ * - convert: sample rate conversion and dithering (WriteSource::convert())
+ * - encode: the AbstractAudioWriter writes the converted block (WriteSource::encode())
+ *
+ * The stages are connected by TExportBlockQueue's with a fixed number of blocks (config key
+ * Export/PipelineDepth), so a slow stage makes the stage before it wait instead of growing
+ * the memory use, and the total export time approaches the time of the slowest stage.
+ *
+ * The order of the blocks is kept, so the exported file is identical to one exported
+ * without the pipeline.
+ *
+ * When a stage fails, both queues are aborted and push() returns -1 from then on.
+ */
+
+
+/**
+ * \class TExportBlockQueue
+ * \brief A bounded queue of equally sized blocks, for one producer and one consumer
+ *
+ * The blocks are allocated up front. The producer acquire()'s a free block, fills it
+ * and push()'es it, the consumer take()'s the filled blocks in order and release()'s
+ * them when done.
+ */
+
+TExportBlockQueue::TExportBlockQueue(int blockCount, size_t blockSize)
+        : m_blockSize(blockSize)
+        , m_closed(false)
+        , m_aborted(false)
+{
+        for (int i=0; i<blockCount; ++i) {
+                m_buffers.append(new char[blockSize]);
+        }
+        m_free = m_buffers;
+}
+
+TExportBlockQueue::~TExportBlockQueue()
+{
+        foreach(char* buffer, m_buffers) {
+                delete [] buffer;
+        }
+}
+
+/**
+ * Waits for a free block.
+ *
+ * @return The free block, or 0 if the queue was aborted
+ */
+char* TExportBlockQueue::acquire()
+{
+        QMutexLocker locker(&m_mutex);
+
+        while (m_free.isEmpty() && !m_aborted) {
+                m_freeAvailable.wait(&m_mutex);
+        }
+
+        if (m_aborted) {
+                return 0;
+        }
+
+        return m_free.takeFirst();
+}
+
+void TExportBlockQueue::push(char* data, nframes_t frames, bool endOfInput)
+{
+        QMutexLocker locker(&m_mutex);
+
+        Block block;
+        block.data = data;
+        block.frames = frames;
+        block.endOfInput = endOfInput;
+
+        m_filled.append(block);
+        m_blockAvailable.wakeAll();
+}
+
+/**
+ * Tells the consumer no more blocks will be pushed, take() returns false
+ * once the pushed blocks have been taken.
+ */
+void TExportBlockQueue::close()
+{
+        QMutexLocker locker(&m_mutex);
+
+        m_closed = true;
+        m_blockAvailable.wakeAll();
+}
+
+/**
+ * Waits for the next filled block.
+ *
+ * @return False if the queue is closed and empty, or was aborted
+ */
+bool TExportBlockQueue::take(Block& block)
+{
+        QMutexLocker locker(&m_mutex);
+
+        while (m_filled.isEmpty() && !m_closed && !m_aborted) {
+                m_blockAvailable.wait(&m_mutex);
+        }
+
+        if (m_aborted || m_filled.isEmpty()) {
+                return false;
+        }
+
+        block = m_filled.takeFirst();
+
+        return true;
+}
+
+void TExportBlockQueue::release(char* data)
+{
+        QMutexLocker locker(&m_mutex);
+
+        m_free.append(data);
+        m_freeAvailable.wakeAll();
+}
+
+/**
+ * Wakes up and stops both the producer and the consumer, the blocks still
+ * in the queue are dropped.
+ */
+void TExportBlockQueue::abort()
+{
+        QMutexLocker locker(&m_mutex);
+
+        m_aborted = true;
+        m_freeAvailable.wakeAll();
+        m_blockAvailable.wakeAll();
+}
+
+
+TExportStageThread::TExportStageThread(TExportPipeline* pipeline, Stage stage)
+        : m_pipeline(pipeline)
+        , m_stage(stage)
+{
+}
+
+void TExportStageThread::run()
+{
+        if (m_stage == Convert) {
+                TRACE_THREAD("ExportConvert");
+                m_pipeline->run_convert();
+        } else {
+                TRACE_THREAD("ExportEncode");
+                m_pipeline->run_encode();
+        }
+}
+
+
+/**
+ * Creates the queues of the pipeline of \a source. The render queue holds blocks of
+ * \a blocksize interleaved frames of \a channels channels, the encode queue blocks of
+ * \a outputBlockSize bytes, the largest block WriteSource::convert() produces.
+ */
+TExportPipeline::TExportPipeline(WriteSource* source, int channels, nframes_t blocksize, size_t outputBlockSize)
+        : m_source(source)
+        , m_channels(channels)
+        , m_failed(false)
+{
+        int depth = qMax(2, config().get_property("Export", "PipelineDepth", 8).toInt());
+
+        m_renderQueue = new TExportBlockQueue(depth, blocksize * channels * sizeof(audio_sample_t));
+        m_encodeQueue = new TExportBlockQueue(depth, outputBlockSize);
+
+        memorybudget().add(TMemoryBudget::WriteBuffers, m_renderQueue->storage_size() + m_encodeQueue->storage_size());
+
+        m_convertThread = new TExportStageThread(this, TExportStageThread::Convert);
+        m_encodeThread = new TExportStageThread(this, TExportStageThread::Encode);
+}
+
+TExportPipeline::~TExportPipeline()
+{
+        if (m_convertThread->isRunning() || m_encodeThread->isRunning()) {
+                fail();
+                m_convertThread->wait();
+                m_encodeThread->wait();
+        }
+
+        delete m_convertThread;
+        delete m_encodeThread;
+
+        memorybudget().remove(TMemoryBudget::WriteBuffers, m_renderQueue->storage_size() + m_encodeQueue->storage_size());
+
+        delete m_renderQueue;
+        delete m_encodeQueue;
+}
+
+/**
+ * @return True if pipelined export is enabled in the configuration (Export/PipelinedEncode),
+ *	and there is more then one core to run the stages on.
+ */
+bool TExportPipeline::is_enabled()
+{
+        return config().get_property("Export", "PipelinedEncode", true).toBool() && QThread::idealThreadCount() > 1;
+}
+
+void TExportPipeline::start()
+{
+        m_convertThread->start();
+        m_encodeThread->start();
+}
+
+/**
+ * Called from the export thread: queues a copy of \a frames interleaved frames of
+ * \a data for conversion, waits when the render queue is full.
+ *
+ * @return 0 on success, -1 if a stage of the pipeline failed
+ */
+int TExportPipeline::push(const audio_sample_t* data, nframes_t frames, bool endOfInput)
+{
+        char* block = has_failed() ? 0 : m_renderQueue->acquire();
+
+        if (!block) {
+                return -1;
+        }
+
+        memcpy(block, data, frames * m_channels * sizeof(audio_sample_t));
+        m_renderQueue->push(block, frames, endOfInput);
+
+        return 0;
+}
+
+/**
+ * Waits until all pushed blocks are converted and encoded, and stops the stage threads.
+ *
+ * @return 0 on success, -1 if a stage of the pipeline failed
+ */
+int TExportPipeline::finish()
+{
+        m_renderQueue->close();
+
+        m_convertThread->wait();
+        m_encodeThread->wait();
+
+        return has_failed() ? -1 : 0;
+}
+
+/**
+ * Called from the convert stage, waits for a free block in the encode queue.
+ *
+ * @return The block to convert into, or 0 if the pipeline failed
+ */
+void* TExportPipeline::acquire_output()
+{
+        return m_encodeQueue->acquire();
+}
+
+void TExportPipeline::push_output(void* data, nframes_t frames)
+{
+        m_encodeQueue->push((char*) data, frames, false);
+}
+
+void TExportPipeline::run_convert()
+{
+        TExportBlockQueue::Block block;
+
+        while (m_renderQueue->take(block)) {
+                int result = m_source->convert((audio_sample_t*) block.data, block.frames, block.endOfInput);
+                m_renderQueue->release(block.data);
+
+                if (result < 0) {
+                        fail();
+                        break;
+                }
+        }
+
+        m_encodeQueue->close();
+}
+
+void TExportPipeline::run_encode()
+{
+        TExportBlockQueue::Block block;
+
+        while (m_encodeQueue->take(block)) {
+                nframes_t written = m_source->encode(block.data, block.frames);
+                m_encodeQueue->release(block.data);
+
+                if (written < block.frames) {
+                        PERROR("TExportPipeline: only %d of %d frames were written", written, block.frames);
+                        fail();
+                        break;
+                }
+        }
+}
+
+void TExportPipeline::fail()
+{
+        m_failed.fetchAndStoreOrdered(1);
+        m_renderQueue->abort();
+        m_encodeQueue->abort();
+}
+
+//eof
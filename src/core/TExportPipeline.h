@@ -0,0 +1,127 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TEXPORT_PIPELINE_H
+#define TEXPORT_PIPELINE_H
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QList>
+
+#include "defines.h"
+
+class TExportPipeline;
+class WriteSource;
+
+class TExportBlockQueue
+{
+public:
+        struct Block {
+                char*           data;
+                nframes_t       frames;
+                bool            endOfInput;
+        };
+
+        TExportBlockQueue(int blockCount, size_t blockSize);
+        ~TExportBlockQueue();
+
+        // Producer
+        char* acquire();
+        void push(char* data, nframes_t frames, bool endOfInput);
+        void close();
+
+        // Consumer
+        bool take(Block& block);
+        void release(char* data);
+
+        void abort();
+        size_t storage_size() const {return m_buffers.size() * m_blockSize;}
+
+private:
+        QList<char*>    m_buffers;
+        QList<char*>    m_free;
+        QList<Block>    m_filled;
+        QMutex          m_mutex;
+        QWaitCondition  m_freeAvailable;
+        QWaitCondition  m_blockAvailable;
+        size_t          m_blockSize;
+        bool            m_closed;
+        bool            m_aborted;
+};
+
+
+class TExportStageThread : public QThread
+{
+public:
+        enum Stage {
+                Convert,
+                Encode
+        };
+
+        TExportStageThread(TExportPipeline* pipeline, Stage stage);
+
+protected:
+        void run();
+
+private:
+        TExportPipeline*        m_pipeline;
+        Stage                   m_stage;
+};
+
+
+class TExportPipeline
+{
+public:
+        TExportPipeline(WriteSource* source, int channels, nframes_t blocksize, size_t outputBlockSize);
+        ~TExportPipeline();
+
+        static bool is_enabled();
+
+        void start();
+        int push(const audio_sample_t* data, nframes_t frames, bool endOfInput);
+        int finish();
+
+        // Convert stage
+        void* acquire_output();
+        void push_output(void* data, nframes_t frames);
+
+private:
+        WriteSource*            m_source;
+        TExportBlockQueue*      m_renderQueue;
+        TExportBlockQueue*      m_encodeQueue;
+        TExportStageThread*     m_convertThread;
+        TExportStageThread*     m_encodeThread;
+        int                     m_channels;
+        QAtomicInt              m_failed;
+
+        void run_convert();
+        void run_encode();
+        void fail();
+        bool has_failed() const {return const_cast<QAtomicInt&>(m_failed).fetchAndAddAcquire(0);}
+
+        friend class TExportStageThread;
+};
+
+#endif
+
+//eof
@@ -147,8 +147,6 @@ int TInputEventDispatcher::dispatch_shortcut(TShortcut* shortCut, bool autorepea
 		list = cpointer().get_context_items();
 	}
 
-	QString slotsignature = "";
-
 	if (m_holdingCommand) {
 		list.prepend(m_holdingCommand);
 	}
@@ -164,77 +162,25 @@ int TInputEventDispatcher::dispatch_shortcut(TShortcut* shortCut, bool autorepea
 			continue;
 		}
 
-		TFunction* function = 0;
-
-		const QMetaObject* metaobject = item->metaObject();
-		// traverse upwards till no more superclasses are found
-		// this supports inheritance on QObjects.
-		while (metaobject)
-		{
-			QList<TFunction*> functions = shortCut->getFunctionsForObject(metaobject->className());
-
-			foreach(TFunction* f, functions) {
-				if (!f) {
-					continue;
-				}
-
-				if (m_activeModifierKeys.size())
-				{
-					if (modifierKeysMatch(m_activeModifierKeys, f->getModifierKeys())) {
-						function = f;
-						PMESG("found match in objectUsingModierKeys");
-						break;
-					} else {
-						PMESG("m_activeModifierKeys doesn't contain code %d", shortCut->getKeyValue());
-					}
-				}
-				else
-				{
-					if (f->getModifierKeys().isEmpty())
-					{
-						function = f;
-						PMESG("found match in obects NOT using modifier keys");
-						break;
-					}
-				}
-			}
-
-			if (function)
-			{
-				// Now that we found a match, we still have to check if
-				// the current mode is valid for this data!
-				QString currentmode = m_modes.key(cpointer().get_current_mode());
-				QString allmodes = m_modes.key(0);
-				if ( function->modes.size() && (! function->modes.contains(currentmode)) && (! function->modes.contains(allmodes))) {
-					PMESG("%s on %s is not valid for mode %s", QS_C(function->getKeySequence()), item->metaObject()->className(), QS_C(currentmode));
-					continue;
-				}
-
-				break;
-			}
-
-			metaobject = metaobject->superClass();
-		}
-
+		// A copy, invoked slots can dispatch again, which changes the cache
+		const TDispatchEntry entry = resolve_dispatch_entry(shortCut, item);
+		TFunction* function = entry.function;
 
 		if (! function ) {
 			PMESG("No data found for object %s", item->metaObject()->className());
 			continue;
 		}
 
-		PMESG("Function found for %s!", metaobject->className());
+		PMESG("Function found for %s!", entry.metaObject->className());
 		PMESG("setting slotsignature to %s", QS_C(function->getSlotSignature()));
 		PMESG("setting pluginname to %s", QS_C(function->pluginname));
 		PMESG("setting plugincommand to %s", QS_C(function->commandName));
 
-		slotsignature = function->getSlotSignature();
-		QString pluginname = function->pluginname;
-		QString commandname = function->commandName;
-
 		if (item == m_holdingCommand) {
 			PMESG("Dispatching to holdcommand");
-			if (QMetaObject::invokeMethod(item, QS_C(slotsignature), Qt::DirectConnection, Q_ARG(bool, autorepeat))) {
-				PMESG("HIT, invoking %s::%s", m_holdingCommand->metaObject()->className(), QS_C(slotsignature));
+			if (entry.holdMethodIndex >= 0 &&
+			    item->metaObject()->method(entry.holdMethodIndex).invoke(item, Qt::DirectConnection, Q_ARG(bool, autorepeat))) {
+				PMESG("HIT, invoking %s::%s", m_holdingCommand->metaObject()->className(), QS_C(function->getSlotSignature()));
 				// only now we know which object this hold modifier key was dispatched on.
 				// the process_hold_modifier_keys() only knows about the corresonding ieaction
 				// next time it'll be called, autorepeat interval of the object + keysequence will
@@ -249,21 +195,20 @@ int TInputEventDispatcher::dispatch_shortcut(TShortcut* shortCut, bool autorepea
 		// We first try to find if there is a match in the loaded plugins.
 		if ( ! m_holdingCommand ) {
 
-			if ( ! pluginname.isEmpty() ) {
-				CommandPlugin* plug = tShortCutManager().getCommandPlugin(pluginname);
-				if (!plug)
+			if ( ! function->pluginname.isEmpty() ) {
+				if (!entry.plugin)
 				{
-					info().critical(tr("Command Plugin %1 not found!").arg(pluginname));
+					info().critical(tr("Command Plugin %1 not found!").arg(function->pluginname));
 					continue;
 				}
 
-				if ( ! plug->implements(commandname) )
+				if ( ! entry.plugin->implements(function->commandName) )
 				{
-					info().critical(tr("Plugin %1 doesn't implement Command %2").arg(pluginname).arg(commandname));
+					info().critical(tr("Plugin %1 doesn't implement Command %2").arg(function->pluginname).arg(function->commandName));
 				} else
 				{
-					PMESG("InputEngine:: Using plugin %s for command %s", QS_C(pluginname), QS_C(function->commandName));
-					k = plug->create(item, commandname, function->arguments);
+					PMESG("InputEngine:: Using plugin %s for command %s", QS_C(function->pluginname), QS_C(function->commandName));
+					k = entry.plugin->create(item, function->commandName, function->arguments);
 				}
 			}
 		}
@@ -271,31 +216,25 @@ int TInputEventDispatcher::dispatch_shortcut(TShortcut* shortCut, bool autorepea
 		// Either the plugins didn't have a match, or we are holding.
 		if ( ! k )
 		{
-			// FIXME shortCut->getFunctionsForObject() returns a list,
-			// we need to iterate over the list for a match or what ?
-			QString delegatedobject;
-			QList<TFunction*> objectFunctions;
+			QByteArray delegateClass = entry.delegateClass;
+			QByteArray delegateSlot = entry.delegateSlot;
 
 			if (m_holdingCommand) {
-				objectFunctions = shortCut->getFunctionsForObject("HoldCommand");
-				delegatedobject = "HoldCommand";
-			} else {
-				delegatedobject = metaobject->className();
-				if (m_activeModifierKeys.size() > 0) {
-					//FIXME: objects has values inserted with insertMulti()
-					// do we have to use values(delegatedobject) instead of value(delegatedobject)
-					// here too?
-					objectFunctions = shortCut->getFunctionsForObject(delegatedobject);
-				} else {
-					objectFunctions = shortCut->getFunctionsForObject(delegatedobject);
+				// Only happens while holding, not worth caching
+				QList<TFunction*> objectFunctions = shortCut->getFunctionsForObject("HoldCommand");
+				function = objectFunctions.size() ? objectFunctions.first() : 0;
+				if (function) {
+					QStringList strlist = function->getSlotSignature().split("::");
+					if (strlist.size() == 2) {
+						delegateClass = strlist.at(0).toLatin1();
+						delegateSlot = strlist.at(1).toLatin1();
+					} else {
+						delegateClass.clear();
+					}
 				}
-				PMESG("delegatedobject is %s", QS_C(delegatedobject));
-			}
-
-			if (objectFunctions.size()) {
-				function = objectFunctions.first();
 			} else {
-				function = 0;
+				function = entry.delegateFunction;
+				PMESG("delegatedobject is %s", entry.metaObject->className());
 			}
 
 			if ( ! function) {
@@ -303,12 +242,8 @@ int TInputEventDispatcher::dispatch_shortcut(TShortcut* shortCut, bool autorepea
 				continue;
 			}
 
-			QStringList strlist = function->getSlotSignature().split("::");
-
-			if (strlist.size() == 2) {
+			if (!delegateClass.isEmpty()) {
 				PMESG("Detected delegate action, checking if it is valid!");
-				QString classname = strlist.at(0);
-				QString slot = strlist.at(1);
 				QObject* obj = 0;
 				bool validobject = false;
 
@@ -316,7 +251,7 @@ int TInputEventDispatcher::dispatch_shortcut(TShortcut* shortCut, bool autorepea
 					obj = list.at(j);
 					const QMetaObject* mo = obj->metaObject();
 					while (mo) {
-						if (mo->className() == classname) {
+						if (delegateClass == mo->className()) {
 							PMESG("Found an item in the objects list that equals delegated object");
 							validobject = true;
 							break;
@@ -330,18 +265,19 @@ int TInputEventDispatcher::dispatch_shortcut(TShortcut* shortCut, bool autorepea
 				}
 
 				if (validobject) {
-					if (QMetaObject::invokeMethod(obj, QS_C(slot),  Qt::DirectConnection, Q_RETURN_ARG(TCommand*, k))) {
-						PMESG("HIT, invoking (delegated) %s::%s", QS_C(classname), QS_C(slot));
+					if (QMetaObject::invokeMethod(obj, delegateSlot.constData(),  Qt::DirectConnection, Q_RETURN_ARG(TCommand*, k))) {
+						PMESG("HIT, invoking (delegated) %s::%s", delegateClass.constData(), delegateSlot.constData());
 					} else {
 						PMESG("Delegated object slot call didn't work out, sorry!");
-						PMESG("%s::%s() --> %s::%s()", item->metaObject()->className(), QS_C(slot), QS_C(classname), QS_C(slot));
+						PMESG("%s::%s() --> %s::%s()", item->metaObject()->className(), delegateSlot.constData(), delegateClass.constData(), delegateSlot.constData());
 					}
 				} else {
-					PMESG("Delegated object %s was not found in the context items list!", QS_C(classname));
+					PMESG("Delegated object %s was not found in the context items list!", delegateClass.constData());
 				}
 			} else {
-				if (QMetaObject::invokeMethod(item, QS_C(slotsignature), Qt::DirectConnection, Q_RETURN_ARG(TCommand*, k))) {
-					PMESG("HIT, invoking %s::%s", item->metaObject()->className(), QS_C(slotsignature));
+				if (entry.methodIndex >= 0 &&
+				    item->metaObject()->method(entry.methodIndex).invoke(item, Qt::DirectConnection, Q_RETURN_ARG(TCommand*, k))) {
+					PMESG("HIT, invoking %s::%s", item->metaObject()->className(), QS_C(entry.function->getSlotSignature()));
 				} else {
 					PMESG("nope %s wasn't the right one, next ...", item->metaObject()->className());
 				}
@@ -854,3 +790,131 @@ bool TInputEventDispatcher::modifierKeysMatch(QList<int> first, QList<int> secon
 
 	return true;
 }
+
+/**
+ * Returns the dispatch entry of \a shortCut for the class of \a item, the
+ * currently active modifier keys and the current mode.
+ *
+ * Resolving walks the class hierarchy of \a item, matches the modifier keys
+ * of each function and looks up the slots by name. This is done once, the
+ * result is cached in \a shortCut, so a repeated key press on the same kind
+ * of item costs a few hash lookups.
+ */
+const TDispatchEntry& TInputEventDispatcher::resolve_dispatch_entry(TShortcut* shortCut, QObject* item)
+{
+	int modifierMask = 0;
+	bool cacheable = true;
+
+	// Modifier keys (from the context menu) that are not in m_modifierKeys can't
+	// be expressed in the cache key, resolve those each time.
+	foreach(int key, m_activeModifierKeys) {
+		int index = m_modifierKeys.indexOf(key);
+		if (index < 0 || (modifierMask & (1 << index))) {
+			cacheable = false;
+			break;
+		}
+		modifierMask |= (1 << index);
+	}
+
+	if (!cacheable) {
+		static TDispatchEntry uncached;
+		uncached = TDispatchEntry();
+		fill_dispatch_entry(uncached, shortCut, item);
+		return uncached;
+	}
+
+	int key = (cpointer().get_current_mode() << m_modifierKeys.size()) | modifierMask;
+
+	QHash<int, TDispatchEntry>& entries = shortCut->dispatchCache[item->metaObject()];
+	QHash<int, TDispatchEntry>::iterator it = entries.find(key);
+
+	if (it == entries.end()) {
+		it = entries.insert(key, TDispatchEntry());
+		fill_dispatch_entry(it.value(), shortCut, item);
+	}
+
+	return it.value();
+}
+
+void TInputEventDispatcher::fill_dispatch_entry(TDispatchEntry& entry, TShortcut* shortCut, QObject* item)
+{
+	TFunction* function = 0;
+
+	const QMetaObject* metaobject = item->metaObject();
+	// traverse upwards till no more superclasses are found
+	// this supports inheritance on QObjects.
+	while (metaobject)
+	{
+		QList<TFunction*> functions = shortCut->getFunctionsForObject(metaobject->className());
+
+		foreach(TFunction* f, functions) {
+			if (!f) {
+				continue;
+			}
+
+			if (m_activeModifierKeys.size())
+			{
+				if (modifierKeysMatch(m_activeModifierKeys, f->getModifierKeys())) {
+					function = f;
+					PMESG("found match in objectUsingModierKeys");
+					break;
+				} else {
+					PMESG("m_activeModifierKeys doesn't contain code %d", shortCut->getKeyValue());
+				}
+			}
+			else
+			{
+				if (f->getModifierKeys().isEmpty())
+				{
+					function = f;
+					PMESG("found match in obects NOT using modifier keys");
+					break;
+				}
+			}
+		}
+
+		if (function)
+		{
+			// Now that we found a match, we still have to check if
+			// the current mode is valid for this data!
+			QString currentmode = m_modes.key(cpointer().get_current_mode());
+			QString allmodes = m_modes.key(0);
+			if ( function->modes.size() && (! function->modes.contains(currentmode)) && (! function->modes.contains(allmodes))) {
+				PMESG("%s on %s is not valid for mode %s", QS_C(function->getKeySequence()), item->metaObject()->className(), QS_C(currentmode));
+				return;
+			}
+
+			break;
+		}
+
+		metaobject = metaobject->superClass();
+	}
+
+	if (!function) {
+		return;
+	}
+
+	entry.function = function;
+	entry.metaObject = metaobject;
+
+	if (!function->pluginname.isEmpty()) {
+		entry.plugin = tShortCutManager().getCommandPlugin(function->pluginname);
+	}
+
+	const QMetaObject* itemMetaObject = item->metaObject();
+	QByteArray slot = function->getSlotSignature().toLatin1();
+	entry.methodIndex = itemMetaObject->indexOfMethod(QMetaObject::normalizedSignature(slot + "()"));
+	entry.holdMethodIndex = itemMetaObject->indexOfMethod(QMetaObject::normalizedSignature(slot + "(bool)"));
+
+	// FIXME shortCut->getFunctionsForObject() returns a list,
+	// we need to iterate over the list for a match or what ?
+	QList<TFunction*> objectFunctions = shortCut->getFunctionsForObject(metaobject->className());
+	if (objectFunctions.size()) {
+		entry.delegateFunction = objectFunctions.first();
+		QStringList strlist = entry.delegateFunction->getSlotSignature().split("::");
+		if (strlist.size() == 2) {
+			entry.delegateClass = strlist.at(0).toLatin1();
+			entry.delegateSlot = strlist.at(1).toLatin1();
+		}
+	}
+}
@@ -39,6 +39,7 @@ class QWheelEvent;
 class QMouseEvent;
 
 struct TShortcut;
+struct TDispatchEntry;
 
 
 class TInputEventDispatcher : public QObject
@@ -125,6 +126,8 @@ private:
 	void process_release_event(int keyValue);
 	bool is_modifier_keyfact(int eventcode);
 	bool modifierKeysMatch(QList<int> first, QList<int> second);
+	const TDispatchEntry& resolve_dispatch_entry(TShortcut* shortCut, QObject* item);
+	void fill_dispatch_entry(TDispatchEntry& entry, TShortcut* shortCut, QObject* item);
         void clear_hold_modifier_keys();
 
 
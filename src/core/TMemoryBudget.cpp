@@ -0,0 +1,161 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TMemoryBudget.h"
+
+#include <QObject>
+#include <QMutexLocker>
+
+#include "TConfig.h"
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+/**
+ * \class TMemoryBudget
+ * \brief Accounts the memory of the audio buffers and caches, and keeps it within a budget
+ *
+ * The ReadSource and WriteSource ring buffers, the DiskIO head cache, the render ahead
+ * buffers, the scrub cache and the commands in the undo history add and remove their
+ * allocations here. The budget is set
+ * from the config key Memory/ProjectBudget (MB) when a Project is loaded.
+ *
+ * The budget is enforced by the subsystems themselves:
+ *
+ * - ReadSource ring buffers get a shorter duration from get_buffer_time() once the total
+ *   usage gets close to the budget, down to a quarter of the configured duration.
+ * - Caches ask get_cache_allowance() how much they may keep, and evict what is above it.
+ *
+ * The usage is shown in the system resources info widget.
+ *
+ * Not for use in the audio thread.
+ */
+
+// Above this fraction of the budget, ring buffer durations are shortened
+static const float BUFFER_PRESSURE_THRESHOLD = 0.75;
+// The shortest ring buffer duration, relative to the configured one
+static const float MINIMUM_BUFFER_TIME_SCALE = 0.25;
+
+
+TMemoryBudget& memorybudget()
+{
+        static TMemoryBudget budget;
+        return budget;
+}
+
+TMemoryBudget::TMemoryBudget()
+        : m_total(0)
+{
+        for (int i=0; i<CategoryCount; ++i) {
+                m_usage[i] = 0;
+        }
+
+        set_budget(qint64(config().get_property("Memory", "ProjectBudget", 1024).toInt()) * 1024 * 1024);
+}
+
+void TMemoryBudget::add(Category category, qint64 bytes)
+{
+        QMutexLocker locker(&m_mutex);
+
+        m_usage[category] += bytes;
+        m_total += bytes;
+}
+
+void TMemoryBudget::remove(Category category, qint64 bytes)
+{
+        QMutexLocker locker(&m_mutex);
+
+        m_usage[category] -= bytes;
+        m_total -= bytes;
+}
+
+void TMemoryBudget::set_budget(qint64 bytes)
+{
+        QMutexLocker locker(&m_mutex);
+
+        // Don't allow a budget that leaves no room for playback at all
+        m_budget = qMax(qint64(16 * 1024 * 1024), bytes);
+}
+
+qint64 TMemoryBudget::get_usage(Category category)
+{
+        QMutexLocker locker(&m_mutex);
+        return m_usage[category];
+}
+
+qint64 TMemoryBudget::get_total()
+{
+        QMutexLocker locker(&m_mutex);
+        return m_total;
+}
+
+qint64 TMemoryBudget::get_budget()
+{
+        QMutexLocker locker(&m_mutex);
+        return m_budget;
+}
+
+/**
+ * @return How much of \a requested bytes the cache \a category may use, which
+ *	is what is left of the budget after all other categories.
+ */
+qint64 TMemoryBudget::get_cache_allowance(Category category, qint64 requested)
+{
+        QMutexLocker locker(&m_mutex);
+
+        qint64 available = m_budget - (m_total - m_usage[category]);
+
+        return qBound(qint64(0), available, requested);
+}
+
+/**
+ * @return The ring buffer duration in seconds to use for a \a requested duration,
+ *	shortened when the usage is close to or over the budget.
+ */
+float TMemoryBudget::get_buffer_time(float requested)
+{
+        QMutexLocker locker(&m_mutex);
+
+        float pressure = float(m_total) / m_budget;
+        if (pressure <= BUFFER_PRESSURE_THRESHOLD) {
+                return requested;
+        }
+
+        float scale = 1.0 - (pressure - BUFFER_PRESSURE_THRESHOLD) / (1.0 - BUFFER_PRESSURE_THRESHOLD) * (1.0 - MINIMUM_BUFFER_TIME_SCALE);
+
+        return requested * qMax(MINIMUM_BUFFER_TIME_SCALE, scale);
+}
+
+QString TMemoryBudget::get_category_name(Category category)
+{
+        switch (category) {
+                case ReadBuffers: return QObject::tr("Read buffers");
+                case WriteBuffers: return QObject::tr("Write buffers");
+                case HeadCache: return QObject::tr("Head cache");
+                case RenderAhead: return QObject::tr("Render ahead");
+                case ScrubCache: return QObject::tr("Scrub cache");
+                case History: return QObject::tr("Undo history");
+                default: return QString();
+        }
+}
+
+//eof
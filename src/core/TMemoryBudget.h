@@ -0,0 +1,70 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TMEMORY_BUDGET_H
+#define TMEMORY_BUDGET_H
+
+#include <QMutex>
+#include <QString>
+
+class TMemoryBudget
+{
+public:
+        enum Category {
+                ReadBuffers,
+                WriteBuffers,
+                HeadCache,
+                RenderAhead,
+                ScrubCache,
+                History,
+                CategoryCount
+        };
+
+        void add(Category category, qint64 bytes);
+        void remove(Category category, qint64 bytes);
+        void set_budget(qint64 bytes);
+
+        qint64 get_usage(Category category);
+        qint64 get_total();
+        qint64 get_budget();
+        qint64 get_cache_allowance(Category category, qint64 requested);
+        float get_buffer_time(float requested);
+
+        static QString get_category_name(Category category);
+
+private:
+        TMemoryBudget();
+        TMemoryBudget(const TMemoryBudget&);
+
+        QMutex          m_mutex;
+        qint64          m_usage[CategoryCount];
+        qint64          m_total;
+        qint64          m_budget;
+
+        friend TMemoryBudget& memorybudget();
+};
+
+// use this function to access the memory budget
+TMemoryBudget& memorybudget();
+
+#endif
+
+//eof
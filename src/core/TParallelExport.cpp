@@ -0,0 +1,421 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TParallelExport.h"
+
+#include <QDomDocument>
+#include <QMutexLocker>
+#include <cstring>
+
+#include "AbstractAudioReader.h"
+#include <AudioBus.h>
+#include <AudioDevice.h>
+#include "AudioTrack.h"
+#include "Export.h"
+#include "Mixer.h"
+#include "PluginChain.h"
+#include "Sheet.h"
+#include "TBusTrack.h"
+#include "TConfig.h"
+#include "TSend.h"
+#include "Tsar.h"
+#include "TTimelineTracer.h"
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+/**
+ * \class TParallelExport
+ * \brief Renders an export range in segments on several threads at once
+ *
+ * The export range is split in segments of equal length (config key Export/SegmentLength,
+ * in seconds), which are rendered concurrently by TExportSegmentWorker threads. Each worker
+ * has it's own render buffers, DecodeBuffer and ReadSource copies (TRenderContext), and a
+ * private copy of the PluginChain of each AudioTrack.
+ *
+ * A segment is rendered from a pre-roll time (Export/PreRollTime, in milliseconds) before
+ * it's start, the pre-rolled audio is dropped. Fades and gain automation only depend on the
+ * location, the pre-roll gives the plugins the chance to build up their state, like the
+ * tail of a reverb or the envelope of a compressor.
+ *
+ * The export thread writes the finished segments in order through Sheet::write_export_block(),
+ * the same way Sheet::render() does, so normalizing and the WriteSource work unchanged.
+ * The number of segments in flight is limited, so memory use doesn't grow with the export length,
+ * and their buffers together don't take more then Export/SegmentBufferMemory MB.
+ *
+ * Only Sheets where each AudioTrack renders independently of the others can be exported this
+ * way, see is_supported(), the others are rendered by Sheet::render() as before.
+ */
+
+// Render threads used when Export/RenderThreads isn't set
+static const int MAX_DEFAULT_THREADS = 4;
+// Default limit of the segment buffers, in MB (Export/SegmentBufferMemory)
+static const int DEFAULT_BUFFER_MEMORY = 64;
+
+static int export_thread_count()
+{
+        int threads = config().get_property("Export", "RenderThreads", 0).toInt();
+        if (threads <= 0) {
+                threads = qMin(QThread::idealThreadCount(), MAX_DEFAULT_THREADS);
+        }
+        return qMax(1, threads);
+}
+
+
+TExportSegmentWorker::TExportSegmentWorker(TParallelExport* exporter, int rate)
+        : m_exporter(exporter)
+        , m_sources(rate)
+{
+        nframes_t blocksize = exporter->m_spec->blocksize;
+
+        BusConfig busConfig;
+        busConfig.name = "Export Segment Bus";
+        busConfig.channelcount = 2;
+        busConfig.type = "output";
+        busConfig.isInternalBus = true;
+        m_context.processBus = new AudioBus(busConfig);
+
+        busConfig.name = "Export Segment Master";
+        busConfig.channelcount = exporter->m_sheet->get_master_out()->get_process_bus()->get_channel_count();
+        m_masterBus = new AudioBus(busConfig);
+
+        for(int i=0; i<m_context.processBus->get_channel_count(); i++) {
+                if (AudioChannel* chan = m_context.processBus->get_channel(i)) {
+                        chan->set_buffer_size(blocksize);
+                }
+        }
+        for(int i=0; i<m_masterBus->get_channel_count(); i++) {
+                if (AudioChannel* chan = m_masterBus->get_channel(i)) {
+                        chan->set_buffer_size(blocksize);
+                }
+        }
+
+        m_context.decodeBuffer = new DecodeBuffer;
+        m_context.mixdown = new audio_sample_t[blocksize];
+        m_context.gainBuffer = new audio_sample_t[blocksize];
+        m_context.sources = &m_sources;
+
+        // Plugins keep state between process calls, each worker needs it's own.
+        QDomDocument doc("PluginChain");
+        foreach(AudioTrack* track, exporter->m_tracks) {
+                PluginChain* chain = new PluginChain(0, exporter->m_sheet);
+                chain->set_state(track->get_plugin_chain()->get_state(doc));
+                m_pluginChains.insert(track, chain);
+        }
+}
+
+TExportSegmentWorker::~TExportSegmentWorker()
+{
+        qDeleteAll(m_pluginChains);
+
+        delete m_context.processBus;
+        delete m_masterBus;
+        delete m_context.decodeBuffer;
+        delete [] m_context.mixdown;
+        delete [] m_context.gainBuffer;
+}
+
+void TExportSegmentWorker::run()
+{
+        TRACE_THREAD("ExportSegment");
+        TParallelExport::Segment segment;
+
+        while (m_exporter->take_segment(segment)) {
+                m_exporter->render_segment(this, segment);
+                m_exporter->segment_finished(segment);
+        }
+}
+
+
+/**
+ * Creates the worker threads and their render buffers for exporting \a sheet
+ * with \a spec. Call from the export thread, after Sheet::prepare_export().
+ */
+TParallelExport::TParallelExport(Sheet* sheet, ExportSpecification* spec)
+        : m_sheet(sheet)
+        , m_spec(spec)
+        , m_totalFrames(0)
+        , m_segmentCount(0)
+        , m_nextSegment(0)
+        , m_abort(false)
+{
+        m_rate = audiodevice().get_sample_rate();
+        m_tracks = sheet->get_audio_tracks();
+
+        nframes_t blocksize = spec->blocksize;
+
+        // Segments and pre-roll are whole blocks, so all blocks start at the
+        // same locations as they do when the export range is rendered in one go.
+        int segmentLength = qMax(1, config().get_property("Export", "SegmentLength", 10).toInt());
+        m_segmentFrames = nframes_t(segmentLength) * m_rate;
+        m_segmentFrames = ((m_segmentFrames + blocksize - 1) / blocksize) * blocksize;
+
+        int preRollTime = qMax(0, config().get_property("Export", "PreRollTime", 2000).toInt());
+        m_preRollFrames = nframes_t((qint64(preRollTime) * m_rate) / 1000);
+        m_preRollFrames = ((m_preRollFrames + blocksize - 1) / blocksize) * blocksize;
+
+        // Two segments per worker keeps all of them busy while the export thread
+        // writes out the oldest one. The memory of the segment buffers is limited,
+        // a worker without a buffer to render in would only wait.
+        qint64 bufferSize = qint64(m_segmentFrames) * spec->channels * sizeof(audio_sample_t);
+        qint64 maxMemory = qint64(qMax(1, config().get_property("Export", "SegmentBufferMemory", DEFAULT_BUFFER_MEMORY).toInt())) * 1024 * 1024;
+        int threads = export_thread_count();
+        int buffers = int(qBound(qint64(2), maxMemory / bufferSize, qint64(2 * threads)));
+        threads = qMin(threads, buffers);
+
+        for (int i=0; i<threads; ++i) {
+                m_workers.append(new TExportSegmentWorker(this, m_rate));
+        }
+
+        for (int i=0; i<buffers; ++i) {
+                m_freeBuffers.append(new audio_sample_t[m_segmentFrames * spec->channels]);
+        }
+}
+
+TParallelExport::~TParallelExport()
+{
+        qDeleteAll(m_workers);
+
+        foreach(audio_sample_t* buffer, m_freeBuffers) {
+                delete [] buffer;
+        }
+}
+
+/**
+ * @return True if parallel export is enabled in the configuration,
+ *	and there is more then one thread to render with.
+ */
+bool TParallelExport::is_enabled()
+{
+        return config().get_property("Export", "ParallelRender", false).toBool() && export_thread_count() > 1;
+}
+
+/**
+ * Checks if the AudioTracks of \a sheet can be rendered independently of each other
+ * and of the previous audio, which is the case when there are no armed or frozen
+ * AudioTracks, and the AudioTracks only have post fader sends to the Sheet master.
+ * Bus Tracks other then the Sheet master only receive audio from sends, so they
+ * are silent, but their plugins are not allowed to produce audio on their own.
+ */
+bool TParallelExport::is_supported(Sheet* sheet)
+{
+        TBusTrack* masterOut = sheet->get_master_out();
+        AudioBus* masterBus = masterOut->get_process_bus();
+
+        foreach(AudioTrack* track, sheet->get_audio_tracks()) {
+                if (track->armed() || track->is_frozen() || track->is_freezing()) {
+                        return false;
+                }
+
+                if (!track->get_pre_sends().isEmpty()) {
+                        return false;
+                }
+
+                foreach(TSend* send, track->get_post_sends()) {
+                        if (send->get_bus() != masterBus) {
+                                return false;
+                        }
+                }
+        }
+
+        foreach(TBusTrack* busTrack, sheet->get_bus_tracks()) {
+                if (busTrack != masterOut && !busTrack->get_plugin_chain()->get_plugin_list().isEmpty()) {
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+/**
+ * Renders the current CD track of the ExportSpecification, from cdTrackStart to
+ * cdTrackEnd, and writes it with Sheet::write_export_block().
+ *
+ * @return 1 when the range was rendered or the export was stopped, -1 on write errors
+ */
+int TParallelExport::render()
+{
+        int result = 1;
+        nframes_t blocksize = m_spec->blocksize;
+
+        m_totalFrames = (m_spec->cdTrackEnd - m_spec->cdTrackStart).to_frame(m_rate);
+        m_segmentCount = (m_totalFrames + m_segmentFrames - 1) / m_segmentFrames;
+        m_nextSegment = 0;
+        m_abort = false;
+
+        foreach(TExportSegmentWorker* worker, m_workers) {
+                worker->start();
+        }
+
+        for (int index=0; index<m_segmentCount && result > 0; ++index) {
+                m_mutex.lock();
+                // Wake up now and then to see if the user stopped the export
+                while (!m_finished.contains(index) && m_spec->running && !m_spec->stop) {
+                        m_segmentFinished.wait(&m_mutex, 100);
+                }
+                if (!m_finished.contains(index)) {
+                        m_mutex.unlock();
+                        break;
+                }
+                Segment segment = m_finished.take(index);
+                m_mutex.unlock();
+
+                for (nframes_t offset=0; offset<segment.frames; offset += blocksize) {
+                        nframes_t nframes = qMin(blocksize, segment.frames - offset);
+
+                        memcpy(m_spec->dataF, segment.data + offset * m_spec->channels, sizeof(audio_sample_t) * nframes * m_spec->channels);
+
+                        if (m_sheet->write_export_block(m_spec, nframes) < 0) {
+                                result = -1;
+                                break;
+                        }
+                }
+
+                m_mutex.lock();
+                m_freeBuffers.append(segment.data);
+                m_segmentAvailable.wakeAll();
+                m_mutex.unlock();
+        }
+
+        m_mutex.lock();
+        m_abort = true;
+        m_segmentAvailable.wakeAll();
+        m_mutex.unlock();
+
+        foreach(TExportSegmentWorker* worker, m_workers) {
+                worker->wait();
+        }
+
+        foreach(const Segment& segment, m_finished) {
+                m_freeBuffers.append(segment.data);
+        }
+        m_finished.clear();
+
+        return result;
+}
+
+//
+//  Called by the worker threads
+//
+bool TParallelExport::take_segment(Segment& segment)
+{
+        QMutexLocker locker(&m_mutex);
+
+        while (!m_abort && m_nextSegment < m_segmentCount && m_freeBuffers.isEmpty()) {
+                m_segmentAvailable.wait(&m_mutex);
+        }
+
+        if (m_abort || m_nextSegment >= m_segmentCount) {
+                return false;
+        }
+
+        segment.index = m_nextSegment++;
+        segment.frames = qMin(m_segmentFrames, m_totalFrames - nframes_t(segment.index) * m_segmentFrames);
+        segment.data = m_freeBuffers.takeLast();
+
+        return true;
+}
+
+void TParallelExport::segment_finished(const Segment& segment)
+{
+        QMutexLocker locker(&m_mutex);
+
+        m_finished.insert(segment.index, segment);
+        m_segmentFinished.wakeAll();
+}
+
+void TParallelExport::render_segment(TExportSegmentWorker* worker, Segment& segment)
+{
+        TRACE_SCOPE("TParallelExport::render_segment");
+
+        nframes_t blocksize = m_spec->blocksize;
+        nframes_t start = nframes_t(segment.index) * m_segmentFrames;
+        nframes_t end = start + segment.frames;
+        nframes_t position = start - qMin(m_preRollFrames, start);
+        int channels = m_spec->channels;
+
+        while (position < end && !m_abort) {
+                // The audio thread keeps processing Tsar events, which
+                // could modify the clips and plugins we are walking.
+                tsar().block_event_processing();
+                render_block(worker, m_spec->cdTrackStart + TimeRef(position, m_rate));
+                tsar().unblock_event_processing();
+
+                if (position + blocksize > start) {
+                        nframes_t from = (position < start) ? start - position : 0;
+                        nframes_t count = qMin(blocksize - from, end - position - from);
+                        audio_sample_t* data = segment.data + (position + from - start) * channels;
+
+                        for (int chn=0; chn<channels; ++chn) {
+                                audio_sample_t* buf = worker->m_masterBus->get_buffer(chn, blocksize);
+
+                                if (!buf) {
+                                        // Exporting to more channels then the master bus has, use the first
+                                        buf = worker->m_masterBus->get_buffer(0, blocksize);
+                                }
+
+                                for (nframes_t x=0; x<count; ++x) {
+                                        data[chn + x * channels] = buf[from + x];
+                                }
+                        }
+                }
+
+                position += blocksize;
+        }
+}
+
+//
+//  Does for one block what Sheet::process_export() does, in the buffers of the worker.
+//
+void TParallelExport::render_block(TExportSegmentWorker* worker, const TimeRef& location)
+{
+        nframes_t nframes = m_spec->blocksize;
+        TRenderContext& context = worker->m_context;
+        AudioBus* masterBus = worker->m_masterBus;
+
+        context.location = location;
+        masterBus->silence_buffers(nframes);
+
+        foreach(AudioTrack* track, m_tracks) {
+                if (track->is_muted() || track->is_muted_by_solo()) {
+                        continue;
+                }
+
+                context.processBus->silence_buffers(nframes);
+                context.pluginChain = worker->m_pluginChains.value(track);
+
+                if (track->render_ahead(nframes, &context) <= 0) {
+                        continue;
+                }
+
+                foreach(TSend* send, track->get_post_sends()) {
+                        Track::mix_send(send, context.processBus, masterBus, nframes);
+                }
+        }
+
+        float gain = m_sheet->get_master_out()->get_gain();
+        for (int chan=0; chan<masterBus->get_channel_count() && chan<2; ++chan) {
+                Mixer::apply_gain_to_buffer(masterBus->get_buffer(chan, nframes), nframes, gain);
+        }
+}
+
+//eof
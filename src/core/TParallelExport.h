@@ -0,0 +1,106 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TPARALLEL_EXPORT_H
+#define TPARALLEL_EXPORT_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QList>
+
+#include "defines.h"
+#include "TRenderAheadEngine.h"
+
+class AudioBus;
+class AudioTrack;
+class PluginChain;
+class Sheet;
+class TParallelExport;
+struct ExportSpecification;
+
+class TExportSegmentWorker : public QThread
+{
+public:
+        TExportSegmentWorker(TParallelExport* exporter, int rate);
+        ~TExportSegmentWorker();
+
+protected:
+        void run();
+
+private:
+        TParallelExport*                        m_exporter;
+        TRenderContext                          m_context;
+        TRenderSources                          m_sources;
+        AudioBus*                               m_masterBus;
+        QHash<AudioTrack*, PluginChain*>        m_pluginChains;
+
+        friend class TParallelExport;
+};
+
+
+class TParallelExport
+{
+public:
+        TParallelExport(Sheet* sheet, ExportSpecification* spec);
+        ~TParallelExport();
+
+        static bool is_enabled();
+        static bool is_supported(Sheet* sheet);
+
+        int render();
+
+private:
+        struct Segment {
+                int             index;
+                nframes_t       frames;
+                audio_sample_t* data;
+        };
+
+        Sheet*                          m_sheet;
+        ExportSpecification*            m_spec;
+        QList<TExportSegmentWorker*>    m_workers;
+        QList<AudioTrack*>              m_tracks;
+        QList<audio_sample_t*>          m_freeBuffers;
+        QHash<int, Segment>             m_finished;
+        QMutex                          m_mutex;
+        QWaitCondition                  m_segmentAvailable;
+        QWaitCondition                  m_segmentFinished;
+        nframes_t                       m_segmentFrames;
+        nframes_t                       m_preRollFrames;
+        nframes_t                       m_totalFrames;
+        int                             m_rate;
+        int                             m_segmentCount;
+        int                             m_nextSegment;
+        volatile bool                   m_abort;
+
+        bool take_segment(Segment& segment);
+        void segment_finished(const Segment& segment);
+        void render_segment(TExportSegmentWorker* worker, Segment& segment);
+        void render_block(TExportSegmentWorker* worker, const TimeRef& location);
+
+        friend class TExportSegmentWorker;
+};
+
+#endif
+
+//eof
@@ -0,0 +1,598 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TRenderAheadEngine.h"
+
+#include <QMutexLocker>
+#include <QSet>
+#include <cstring>
+
+#include "AbstractAudioReader.h"
+#include <AudioBus.h>
+#include <AudioDevice.h>
+#include "AudioClip.h"
+#include "AudioTrack.h"
+#include "ReadSource.h"
+#include "Sheet.h"
+#include "TConfig.h"
+#include "TMemoryBudget.h"
+#include "Tsar.h"
+#include "TTimelineTracer.h"
+#include "Utils.h"
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+/**
+ * \class TRenderAheadEngine
+ * \brief Renders non armed AudioTracks ahead of the transport in a background thread
+ *
+ * For each AudioTrack that qualifies (not armed, not frozen and no pre fader sends),
+ * the render thread processes the clips, fades, gain automation and plugins one
+ * block at a time into a TRenderAheadTrack ring buffer, up to the configured lead
+ * time ahead of the last location read by the audio thread.
+ *
+ * The audio thread then only copies the rendered audio into the Track's process bus
+ * and does the monitoring and post fader sends. This moves the heavy lifting out of
+ * the audio thread, so small buffer sizes can be used with large sessions.
+ *
+ * The render thread walks the same clip, curve node and plugin lists as the audio
+ * thread, each block is rendered while Tsar event processing is blocked. It uses
+ * private ReadSource copies to read the audio files, and it's own render buffers
+ * (TRenderContext), so it never touches data used by the audio thread.
+ *
+ * Edits invalidate the not yet played part of the rendered audio, which is
+ * rendered again from 2 blocks after the current read position.
+ */
+
+
+TRenderAheadTrack::TRenderAheadTrack(AudioTrack* track, int channels, nframes_t capacity, int rate)
+        : m_track(track)
+        , m_capacity(0)
+        , m_rate(rate)
+        , m_requestIsSeek(false)
+        , m_handledRequest(0)
+        , m_started(false)
+        , m_underruns(0)
+        , m_sources(rate)
+{
+        for (int chan=0; chan<channels; ++chan) {
+                m_buffers.append(0);
+        }
+
+        reset(capacity, rate);
+}
+
+TRenderAheadTrack::~TRenderAheadTrack()
+{
+        memorybudget().remove(TMemoryBudget::RenderAhead, qint64(m_capacity) * m_buffers.size() * sizeof(audio_sample_t));
+        foreach(audio_sample_t* buffer, m_buffers) {
+                delete [] buffer;
+        }
+}
+
+/**
+ * (Re)allocates the ring buffer for \a capacity frames at samplerate \a rate
+ * and drops everything rendered so far. Only call this when the render thread
+ * doesn't process this TRenderAheadTrack, and the audio driver is stopped.
+ */
+void TRenderAheadTrack::reset(nframes_t capacity, int rate)
+{
+        if (capacity != m_capacity) {
+                memorybudget().remove(TMemoryBudget::RenderAhead, qint64(m_capacity) * m_buffers.size() * sizeof(audio_sample_t));
+                memorybudget().add(TMemoryBudget::RenderAhead, qint64(capacity) * m_buffers.size() * sizeof(audio_sample_t));
+        }
+
+        for (int chan=0; chan<m_buffers.size(); ++chan) {
+                if (capacity != m_capacity || !m_buffers.at(chan)) {
+                        delete [] m_buffers.at(chan);
+                        m_buffers[chan] = new audio_sample_t[capacity];
+                }
+        }
+
+        m_sources.set_rate(rate);
+
+        m_capacity = capacity;
+        m_rate = rate;
+
+        m_generation.fetchAndAddOrdered(1);
+        m_validFrom.fetchAndStoreOrdered(0);
+        m_renderedUntil.fetchAndStoreOrdered(0);
+        m_generation.fetchAndAddOrdered(1);
+        m_started = false;
+}
+
+//
+//  Function called in RealTime AudioThread processing path
+//
+/**
+ * Copies \a nframes rendered frames starting at \a location into \a bus.
+ * Pass a null \a bus to only advance the read position, like a muted Track does.
+ *
+ * @return 1 on success, 0 if the requested audio wasn't rendered (yet).
+ */
+int TRenderAheadTrack::read(AudioBus* bus, const TimeRef& location, nframes_t nframes)
+{
+        int generation = m_generation.fetchAndAddAcquire(0);
+
+        // The render thread is restarting at another location
+        if (generation & 1) {
+                ++m_underruns;
+                return 0;
+        }
+
+        qint64 start = (location.universal_frame() - m_origin.universal_frame()) / (UNIVERSAL_SAMPLE_RATE / m_rate);
+        qint64 validFrom = m_validFrom.fetchAndAddAcquire(0);
+        qint64 renderedUntil = m_renderedUntil.fetchAndAddAcquire(0);
+
+        if (start < validFrom || start + nframes > renderedUntil) {
+                // When the location is close to the rendered range, the render thread
+                // is just catching up, else ask it to continue somewhat ahead of us.
+                qint64 margin = m_capacity / 4;
+                if (start < validFrom - margin || start > renderedUntil + margin) {
+                        request_location(location + TimeRef(nframes_t(margin), m_rate), false);
+                }
+                ++m_underruns;
+                return 0;
+        }
+
+        if (bus) {
+                nframes_t offset = nframes_t(start % m_capacity);
+                nframes_t first = qMin(nframes, m_capacity - offset);
+                int channels = qMin(bus->get_channel_count(), m_buffers.size());
+
+                for (int chan=0; chan<channels; ++chan) {
+                        audio_sample_t* buf = bus->get_buffer(chan, nframes);
+                        memcpy(buf, m_buffers.at(chan) + offset, first * sizeof(audio_sample_t));
+                        if (first < nframes) {
+                                memcpy(buf + first, m_buffers.at(chan), (nframes - first) * sizeof(audio_sample_t));
+                        }
+                }
+        }
+
+        // The render thread restarted, or overwrote the data while we copied it
+        if (m_generation.fetchAndAddAcquire(0) != generation || start < m_validFrom.fetchAndAddAcquire(0)) {
+                if (bus) {
+                        bus->silence_buffers(nframes);
+                }
+                ++m_underruns;
+                return 0;
+        }
+
+        m_readPosition.fetchAndStoreRelease(int(start + nframes));
+        m_readGeneration.fetchAndStoreRelease(generation);
+
+        return 1;
+}
+
+//
+//  Function called in RealTime AudioThread processing path
+//
+/**
+ * Asks the render thread to render from \a location on. A \a seek request
+ * always restarts rendering, other requests only when \a location is outside
+ * of the rendered range.
+ */
+void TRenderAheadTrack::request_location(const TimeRef& location, bool seek)
+{
+        // odd sequence number: write in progress
+        m_requestSequence.fetchAndAddOrdered(1);
+        m_requestedLocation = location;
+        m_requestIsSeek = seek;
+        m_requestSequence.fetchAndAddOrdered(1);
+}
+
+void TRenderAheadTrack::restart(const TimeRef& location)
+{
+        m_generation.fetchAndAddOrdered(1);
+        m_origin = location;
+        m_validFrom.fetchAndStoreOrdered(0);
+        m_renderedUntil.fetchAndStoreOrdered(0);
+        m_generation.fetchAndAddOrdered(1);
+
+        m_started = true;
+
+        m_sources.remove_unused(m_track->get_cliplist());
+}
+
+/**
+ * Renders one block of \a blocksize frames, if there is room for it and the
+ * rendered audio is less then \a lead frames ahead of the read position.
+ * Called by the render thread with Tsar event processing blocked.
+ *
+ * @return true if a block was rendered, false if there was nothing to do.
+ */
+bool TRenderAheadTrack::render(TRenderContext* context, nframes_t blocksize, nframes_t lead)
+{
+        // The audio thread isn't using us yet, and might still process
+        // the Track itself.
+        if (! m_active.fetchAndAddAcquire(0)) {
+                return false;
+        }
+
+        int sequence = m_requestSequence.fetchAndAddAcquire(0);
+        if ( ! (sequence & 1) && sequence != m_handledRequest) {
+                TimeRef location = m_requestedLocation;
+                bool seek = m_requestIsSeek;
+
+                if (m_requestSequence.fetchAndAddAcquire(0) == sequence) {
+                        m_handledRequest = sequence;
+
+                        qint64 position = (location.universal_frame() - m_origin.universal_frame()) / (UNIVERSAL_SAMPLE_RATE / m_rate);
+                        if (seek || !m_started || position < m_validFrom || position > m_renderedUntil) {
+                                restart(location);
+                        }
+                }
+        }
+
+        if (!m_started) {
+                return false;
+        }
+
+        int generation = m_generation.fetchAndAddAcquire(0);
+        int readPosition = 0;
+        if (m_readGeneration.fetchAndAddAcquire(0) == generation) {
+                readPosition = m_readPosition.fetchAndAddAcquire(0);
+        }
+
+        int validFrom = m_validFrom.fetchAndAddAcquire(0);
+        int renderedUntil = m_renderedUntil.fetchAndAddAcquire(0);
+
+        // Keep what the audio thread is about to read, and render the rest again.
+        if (m_invalidated.fetchAndStoreOrdered(0)) {
+                m_sources.remove_unused(m_track->get_cliplist());
+                renderedUntil = qMax(validFrom, qMin(renderedUntil, readPosition + int(2 * blocksize)));
+                m_renderedUntil.fetchAndStoreRelease(renderedUntil);
+        }
+
+        if (renderedUntil - readPosition >= int(lead)) {
+                return false;
+        }
+
+        // Never overwrite audio the audio thread still has to read
+        int newValidFrom = renderedUntil + int(blocksize) - int(m_capacity);
+        if (newValidFrom > readPosition) {
+                return false;
+        }
+        if (newValidFrom > validFrom) {
+                m_validFrom.fetchAndStoreOrdered(newValidFrom);
+        }
+
+        context->sources = &m_sources;
+        context->location = m_origin + TimeRef(nframes_t(renderedUntil), m_rate);
+        context->processBus->silence_buffers(blocksize);
+
+        m_track->render_ahead(blocksize, context);
+
+        nframes_t offset = nframes_t(renderedUntil) % m_capacity;
+        nframes_t first = qMin(blocksize, m_capacity - offset);
+        int channels = qMin(context->processBus->get_channel_count(), m_buffers.size());
+
+        for (int chan=0; chan<channels; ++chan) {
+                audio_sample_t* buf = context->processBus->get_buffer(chan, blocksize);
+                memcpy(m_buffers.at(chan) + offset, buf, first * sizeof(audio_sample_t));
+                if (first < blocksize) {
+                        memcpy(m_buffers.at(chan), buf + first, (blocksize - first) * sizeof(audio_sample_t));
+                }
+        }
+
+        m_renderedUntil.fetchAndStoreRelease(renderedUntil + int(blocksize));
+
+        return true;
+}
+
+TRenderSources::TRenderSources(int rate)
+        : m_rate(rate)
+{
+}
+
+TRenderSources::~TRenderSources()
+{
+        clear();
+}
+
+/**
+ * Returns the private ReadSource copy for \a clip, which is created on first use.
+ * The audio thread keeps streaming from the clip's own ReadSource through DiskIO,
+ * a render thread can't share it.
+ *
+ * @return The ReadSource copy, or 0 if it couldn't be initialized.
+ */
+ReadSource* TRenderSources::get_source(AudioClip* clip)
+{
+        ReadSource* original = clip->get_readsource();
+        if (!original) {
+                return 0;
+        }
+
+        QHash<AudioClip*, ClipSource>::iterator it = m_sources.find(clip);
+        if (it != m_sources.end()) {
+                if (it->original == original) {
+                        return it->copy;
+                }
+                delete it->copy;
+        }
+
+        ClipSource source;
+        source.original = original;
+        source.copy = original->deep_copy();
+        source.copy->ref();
+
+        if (source.copy->init() < 0) {
+                PERROR("TRenderSources: unable to open a copy of ReadSource %s", QS_C(original->get_filename()));
+                delete source.copy;
+                source.copy = 0;
+        } else {
+                source.copy->set_output_rate(m_rate);
+        }
+
+        m_sources.insert(clip, source);
+
+        return source.copy;
+}
+
+/**
+ * Deletes the ReadSource copies of the AudioClips which are not in \a clips anymore.
+ */
+void TRenderSources::remove_unused(const QList<AudioClip*>& clips)
+{
+        if (m_sources.isEmpty()) {
+                return;
+        }
+
+        QSet<AudioClip*> used = clips.toSet();
+
+        QHash<AudioClip*, ClipSource>::iterator it = m_sources.begin();
+        while (it != m_sources.end()) {
+                if (used.contains(it.key())) {
+                        ++it;
+                } else {
+                        delete it->copy;
+                        it = m_sources.erase(it);
+                }
+        }
+}
+
+void TRenderSources::set_rate(int rate)
+{
+        // The ReadSource copies resample to the old rate
+        if (rate != m_rate) {
+                clear();
+        }
+
+        m_rate = rate;
+}
+
+void TRenderSources::clear()
+{
+        foreach(const ClipSource& source, m_sources) {
+                delete source.copy;
+        }
+
+        m_sources.clear();
+}
+
+
+TRenderAheadThread::TRenderAheadThread(TRenderAheadEngine* engine)
+        : m_engine(engine)
+{
+}
+
+void TRenderAheadThread::run()
+{
+        TRACE_THREAD("RenderAhead");
+        m_engine->run();
+}
+
+
+TRenderAheadEngine::TRenderAheadEngine(Sheet* sheet)
+        : m_sheet(sheet)
+        , m_thread(0)
+        , m_blocksize(0)
+        , m_leadFrames(0)
+        , m_rate(0)
+        , m_suspended(false)
+        , m_enabled(false)
+        , m_stop(false)
+{
+        create_buffers();
+}
+
+TRenderAheadEngine::~TRenderAheadEngine()
+{
+        set_enabled(false);
+        m_tracks.clear();
+        delete_buffers();
+}
+
+/**
+ * Starts or stops the render thread. The AudioTracks have to be
+ * updated afterwards, see AudioTrack::update_render_ahead_state()
+ */
+void TRenderAheadEngine::set_enabled(bool enabled)
+{
+        if (enabled == m_enabled) {
+                return;
+        }
+
+        m_enabled = enabled;
+
+        if (m_enabled) {
+                m_stop = false;
+                m_thread = new TRenderAheadThread(this);
+                m_thread->start();
+                return;
+        }
+
+        m_mutex.lock();
+        m_stop = true;
+        m_wakeup.wakeAll();
+        m_mutex.unlock();
+
+        m_thread->wait();
+        delete m_thread;
+        m_thread = 0;
+}
+
+/**
+ * Creates the TRenderAheadTrack for \a track. The render thread doesn't render
+ * it before the audio thread activated it with TRenderAheadTrack::activate().
+ */
+TRenderAheadTrack* TRenderAheadEngine::add_track(AudioTrack* track)
+{
+        QMutexLocker locker(&m_mutex);
+
+        TRenderAheadTrack* renderTrack = new TRenderAheadTrack(track, m_context.processBus->get_channel_count(), get_capacity(), m_rate);
+        // Not used by the audio thread yet, so it's safe to request from here
+        renderTrack->request_location(m_sheet->get_transport_location(), true);
+
+        m_tracks.append(renderTrack);
+        m_wakeup.wakeAll();
+
+        return renderTrack;
+}
+
+/**
+ * Removes \a track from the render thread, which doesn't touch it anymore
+ * once this function returns. The caller owns \a track.
+ */
+void TRenderAheadEngine::detach_track(TRenderAheadTrack* track)
+{
+        QMutexLocker locker(&m_mutex);
+
+        m_tracks.removeAll(track);
+}
+
+/**
+ * Pauses rendering while the Sheet is exported, or rendered offline
+ * otherwise, both walk the same clips and plugins.
+ */
+void TRenderAheadEngine::suspend()
+{
+        QMutexLocker locker(&m_mutex);
+
+        m_suspended = true;
+}
+
+void TRenderAheadEngine::resume()
+{
+        QMutexLocker locker(&m_mutex);
+
+        m_suspended = false;
+        m_wakeup.wakeAll();
+}
+
+//
+//  Called by the Sheet when the audio driver has been stopped
+//  to change it's buffer size and / or samplerate.
+//
+void TRenderAheadEngine::audiodevice_params_changed()
+{
+        QMutexLocker locker(&m_mutex);
+
+        delete_buffers();
+        create_buffers();
+
+        foreach(TRenderAheadTrack* track, m_tracks) {
+                track->reset(get_capacity(), m_rate);
+                track->request_location(m_sheet->get_transport_location(), true);
+        }
+
+        m_wakeup.wakeAll();
+}
+
+void TRenderAheadEngine::create_buffers()
+{
+        m_blocksize = audiodevice().get_buffer_size();
+        m_rate = audiodevice().get_sample_rate();
+
+        int leadTime = config().get_property("Sheet", "RenderAheadTime", 300).toInt();
+        m_leadFrames = nframes_t((qint64(qMax(leadTime, 10)) * m_rate) / 1000);
+        // Round up to whole blocks
+        m_leadFrames = ((m_leadFrames + m_blocksize - 1) / m_blocksize) * m_blocksize;
+
+        BusConfig busConfig;
+        busConfig.name = "Render Ahead Bus";
+        busConfig.channelcount = 2;
+        busConfig.type = "output";
+        busConfig.isInternalBus = true;
+        m_context.processBus = new AudioBus(busConfig);
+
+        for(int i=0; i<m_context.processBus->get_channel_count(); i++) {
+                if (AudioChannel* chan = m_context.processBus->get_channel(i)) {
+                        chan->set_buffer_size(m_blocksize);
+                }
+        }
+
+        m_context.decodeBuffer = new DecodeBuffer;
+        m_context.mixdown = new audio_sample_t[m_blocksize];
+        m_context.gainBuffer = new audio_sample_t[m_blocksize];
+}
+
+void TRenderAheadEngine::delete_buffers()
+{
+        delete m_context.processBus;
+        delete m_context.decodeBuffer;
+        delete [] m_context.mixdown;
+        delete [] m_context.gainBuffer;
+
+        m_context = TRenderContext();
+}
+
+void TRenderAheadEngine::run()
+{
+        m_mutex.lock();
+
+        while (!m_stop) {
+                if (m_suspended || m_tracks.isEmpty()) {
+                        m_wakeup.wait(&m_mutex);
+                        continue;
+                }
+
+                bool rendered = false;
+                bool postponed = false;
+
+                // Render one block for each Track, the mutex is released in between
+                // so the GUI thread doesn't have to wait for all of them.
+                for (int i=0; i<m_tracks.size() && !m_stop && !m_suspended; ++i) {
+                        tsar().block_event_processing();
+                        rendered |= m_tracks.at(i)->render(&m_context, m_blocksize, m_leadFrames);
+                        tsar().unblock_event_processing();
+
+                        postponed |= tsar().event_processing_postponed();
+
+                        m_mutex.unlock();
+                        m_mutex.lock();
+                }
+
+                // Nothing left to render, or the audio thread had to postpone it's
+                // events because of us, give it some time before continuing.
+                if (!rendered || postponed) {
+                        uint msecs = qMax(uint(1), uint((m_blocksize * 1000) / m_rate));
+                        m_wakeup.wait(&m_mutex, msecs);
+                }
+        }
+
+        m_mutex.unlock();
+}
+
+//eof
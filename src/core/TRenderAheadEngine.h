@@ -0,0 +1,203 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TRENDER_AHEAD_ENGINE_H
+#define TRENDER_AHEAD_ENGINE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QHash>
+#include <QList>
+
+#include "defines.h"
+
+class AudioBus;
+class AudioClip;
+class AudioTrack;
+class DecodeBuffer;
+class PluginChain;
+class ReadSource;
+class Sheet;
+class TRenderAheadEngine;
+class TRenderSources;
+
+/**
+ * The buffers and location used to process a Track outside the audio thread.
+ * AudioTrack and AudioClip use the Sheet's buffers and transport
+ * location when no render context is given.
+ *
+ * When pluginChain is set, it is used instead of the Track's own PluginChain.
+ */
+struct TRenderContext {
+        TRenderContext()
+                : processBus(0)
+                , decodeBuffer(0)
+                , mixdown(0)
+                , gainBuffer(0)
+                , sources(0)
+                , pluginChain(0)
+        {}
+
+        AudioBus*               processBus;
+        DecodeBuffer*           decodeBuffer;
+        audio_sample_t*         mixdown;
+        audio_sample_t*         gainBuffer;
+        TRenderSources*         sources;
+        PluginChain*            pluginChain;
+        TimeRef                 location;
+};
+
+
+/**
+ * Private ReadSource copies for the AudioClips rendered outside the audio thread.
+ */
+class TRenderSources
+{
+public:
+        TRenderSources(int rate);
+        ~TRenderSources();
+
+        ReadSource* get_source(AudioClip* clip);
+        void remove_unused(const QList<AudioClip*>& clips);
+        void set_rate(int rate);
+
+private:
+        struct ClipSource {
+                ClipSource() : original(0), copy(0) {}
+                ReadSource*     original;
+                ReadSource*     copy;
+        };
+
+        QHash<AudioClip*, ClipSource>   m_sources;
+        int                             m_rate;
+
+        void clear();
+};
+
+
+class TRenderAheadTrack
+{
+public:
+        TRenderAheadTrack(AudioTrack* track, int channels, nframes_t capacity, int rate);
+        ~TRenderAheadTrack();
+
+        // Audio thread only
+        int read(AudioBus* bus, const TimeRef& location, nframes_t nframes);
+        void request_location(const TimeRef& location, bool seek);
+        void activate() {m_active.fetchAndStoreOrdered(1);}
+
+        // GUI thread
+        void invalidate() {m_invalidated.fetchAndStoreOrdered(1);}
+        qint64 get_underrun_count() const {return m_underruns;}
+
+        // Render thread only, or while the audio driver is stopped
+        bool render(TRenderContext* context, nframes_t blocksize, nframes_t lead);
+        void reset(nframes_t capacity, int rate);
+
+        AudioTrack* get_track() const {return m_track;}
+
+private:
+        AudioTrack*             m_track;
+        QList<audio_sample_t*>  m_buffers;
+        nframes_t               m_capacity;
+        int                     m_rate;
+
+        // Frame positions are relative to m_origin, which is
+        // only changed by the render thread while m_generation is odd.
+        TimeRef                 m_origin;
+        QAtomicInt              m_generation;
+        QAtomicInt              m_validFrom;
+        QAtomicInt              m_renderedUntil;
+        QAtomicInt              m_readPosition;
+        QAtomicInt              m_readGeneration;
+        QAtomicInt              m_invalidated;
+        QAtomicInt              m_active;
+
+        // Location requests from the audio thread, protected by m_requestSequence
+        TimeRef                 m_requestedLocation;
+        QAtomicInt              m_requestSequence;
+        bool                    m_requestIsSeek;
+        int                     m_handledRequest;
+        bool                    m_started;
+        qint64                  m_underruns;
+
+        TRenderSources          m_sources;
+
+        void restart(const TimeRef& location);
+};
+
+
+class TRenderAheadThread : public QThread
+{
+public:
+        TRenderAheadThread(TRenderAheadEngine* engine);
+
+protected:
+        void run();
+
+private:
+        TRenderAheadEngine* m_engine;
+};
+
+
+class TRenderAheadEngine
+{
+public:
+        TRenderAheadEngine(Sheet* sheet);
+        ~TRenderAheadEngine();
+
+        TRenderAheadTrack* add_track(AudioTrack* track);
+        void detach_track(TRenderAheadTrack* track);
+
+        void suspend();
+        void resume();
+        void audiodevice_params_changed();
+
+        bool is_enabled() const {return m_enabled;}
+        void set_enabled(bool enabled);
+
+private:
+        Sheet*                          m_sheet;
+        TRenderAheadThread*             m_thread;
+        QList<TRenderAheadTrack*>       m_tracks;
+        QMutex                          m_mutex;
+        QWaitCondition                  m_wakeup;
+        TRenderContext                  m_context;
+        nframes_t                       m_blocksize;
+        nframes_t                       m_leadFrames;
+        int                             m_rate;
+        bool                            m_suspended;
+        bool                            m_enabled;
+        bool                            m_stop;
+
+        void run();
+        void create_buffers();
+        void delete_buffers();
+        nframes_t get_capacity() const {return m_leadFrames + 4 * m_blocksize;}
+
+        friend class TRenderAheadThread;
+};
+
+#endif
+
+//eof
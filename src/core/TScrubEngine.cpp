@@ -0,0 +1,402 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TScrubEngine.h"
+
+#include <QMutexLocker>
+#include <cmath>
+#include <cstring>
+
+#include "AbstractAudioReader.h"
+#include <AudioBus.h>
+#include <AudioDevice.h>
+#include "AudioTrack.h"
+#include "PluginChain.h"
+#include "Sheet.h"
+#include "TConfig.h"
+#include "TMemoryBudget.h"
+#include "TSend.h"
+#include "Tsar.h"
+#include "TTimelineTracer.h"
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+/**
+ * \class TScrubEngine
+ * \brief Plays a Sheet around a moving scrub location, without seeking the DiskIO buffers
+ *
+ * Moving the transport with PlayHeadMove used to seek the Sheet for each mouse movement,
+ * which resets and refills the ring buffers of every ReadSource. The scrub engine instead
+ * renders the mix of the AudioTracks (clips, fades, gain and panning, plugins are bypassed)
+ * in blocks of SCRUB_BLOCK_FRAMES into a small cache, using it's own ReadSource copies.
+ *
+ * The scrub thread renders the blocks around the current play position, first those in the
+ * direction of motion up to Scrub/ReadAheadTime milliseconds ahead, then a few behind it.
+ *
+ * The audio thread follows the scrub location set by the GUI thread with a variable speed,
+ * up to Scrub/MaxSpeed times the normal speed, and in reverse when Scrub/Reverse is true.
+ * Blocks not rendered yet are played as silence.
+ *
+ * The DiskIO buffers are untouched, the Sheet seeks them only once when scrubbing stops.
+ */
+
+static const nframes_t SCRUB_BLOCK_FRAMES = 4096;
+// Blocks kept behind the play position, for small changes of direction
+static const int SCRUB_BEHIND_BLOCKS = 2;
+// Time in seconds the play position needs to catch up with the scrub location
+static const double SCRUB_RESPONSE_TIME = 0.05;
+
+
+TScrubThread::TScrubThread(TScrubEngine* engine)
+        : m_engine(engine)
+{
+}
+
+void TScrubThread::run()
+{
+        TRACE_THREAD("Scrub");
+        m_engine->run();
+}
+
+
+TScrubEngine::TScrubEngine(Sheet* sheet)
+        : m_sheet(sheet)
+        , m_thread(0)
+        , m_sources(audiodevice().get_sample_rate())
+        , m_stop(false)
+        , m_blockIndex(0)
+        , m_blockData(0)
+        , m_slotCount(0)
+        , m_aheadBlocks(0)
+        , m_rate(audiodevice().get_sample_rate())
+        , m_playPosition(0)
+        , m_velocity(0)
+        , m_maxSpeed(4)
+        , m_reverse(true)
+{
+        BusConfig busConfig;
+        busConfig.name = "Scrub Bus";
+        busConfig.channelcount = 2;
+        busConfig.type = "output";
+        busConfig.isInternalBus = true;
+        m_context.processBus = new AudioBus(busConfig);
+
+        busConfig.name = "Scrub Mix";
+        m_mixBus = new AudioBus(busConfig);
+
+        for(int i=0; i<2; i++) {
+                m_context.processBus->get_channel(i)->set_buffer_size(SCRUB_BLOCK_FRAMES);
+                m_mixBus->get_channel(i)->set_buffer_size(SCRUB_BLOCK_FRAMES);
+        }
+
+        m_context.decodeBuffer = new DecodeBuffer;
+        m_context.mixdown = new audio_sample_t[SCRUB_BLOCK_FRAMES];
+        m_context.gainBuffer = new audio_sample_t[SCRUB_BLOCK_FRAMES];
+        m_context.sources = &m_sources;
+
+        // An empty PluginChain, so the Tracks render without their plugins
+        m_bypassChain = new PluginChain(0, sheet);
+        m_context.pluginChain = m_bypassChain;
+}
+
+TScrubEngine::~TScrubEngine()
+{
+        stop();
+
+        delete m_bypassChain;
+        delete m_context.processBus;
+        delete m_mixBus;
+        delete m_context.decodeBuffer;
+        delete [] m_context.mixdown;
+        delete [] m_context.gainBuffer;
+        delete [] m_blockIndex;
+        delete [] m_blockData;
+        memorybudget().remove(TMemoryBudget::ScrubCache, qint64(m_slotCount) * 2 * SCRUB_BLOCK_FRAMES * sizeof(audio_sample_t));
+}
+
+/**
+ * The cache is created the first time scrubbing starts, and is kept afterwards.
+ * The audio thread can still be in process() shortly after the Sheet stopped
+ * scrubbing, so it's never resized.
+ */
+void TScrubEngine::create_cache()
+{
+        double readAhead = config().get_property("Scrub", "ReadAheadTime", 1500).toDouble() / 1000;
+
+        m_aheadBlocks = qMax(1, int(ceil(readAhead * m_rate / SCRUB_BLOCK_FRAMES)));
+        m_slotCount = 2 * (m_aheadBlocks + SCRUB_BEHIND_BLOCKS) + 1;
+
+        m_blockIndex = new QAtomicInt[m_slotCount];
+        m_blockData = new audio_sample_t[m_slotCount * 2 * SCRUB_BLOCK_FRAMES];
+        memorybudget().add(TMemoryBudget::ScrubCache, qint64(m_slotCount) * 2 * SCRUB_BLOCK_FRAMES * sizeof(audio_sample_t));
+}
+
+/**
+ * Starts rendering \a tracks around \a location. The Sheet
+ * calls process() only after this function returned.
+ */
+void TScrubEngine::start(const TimeRef& location, const QList<AudioTrack*>& tracks)
+{
+        stop();
+
+        m_rate = audiodevice().get_sample_rate();
+        m_sources.set_rate(m_rate);
+
+        if (!m_blockIndex) {
+                create_cache();
+        }
+
+        // The slots of the blocks ahead and behind of the play position
+        // may never be shared, see run()
+        m_aheadBlocks = qMin(m_aheadBlocks, (m_slotCount - 1) / 2 - SCRUB_BEHIND_BLOCKS);
+
+        for (int i=0; i<m_slotCount; ++i) {
+                m_blockIndex[i].fetchAndStoreOrdered(-1);
+        }
+
+        m_tracks = tracks;
+
+        QList<AudioClip*> clips;
+        foreach(AudioTrack* track, m_tracks) {
+                clips += track->get_cliplist();
+        }
+        m_sources.remove_unused(clips);
+
+        TimeRef start = location;
+        int frame = int(start.to_frame(m_rate));
+        m_targetFrame.fetchAndStoreOrdered(frame);
+        m_playFrame.fetchAndStoreOrdered(frame);
+        m_direction.fetchAndStoreOrdered(1);
+
+        m_playPosition = frame;
+        m_velocity = 0;
+        m_maxSpeed = qMax(1.0, config().get_property("Scrub", "MaxSpeed", 4).toDouble());
+        m_reverse = config().get_property("Scrub", "Reverse", true).toBool();
+
+        m_stop = false;
+        m_thread = new TScrubThread(this);
+        m_thread->start();
+}
+
+/**
+ * Stops the scrub thread, the Sheet has to stop calling process() first.
+ */
+void TScrubEngine::stop()
+{
+        if (!m_thread) {
+                return;
+        }
+
+        m_mutex.lock();
+        m_stop = true;
+        m_wakeup.wakeAll();
+        m_mutex.unlock();
+
+        m_thread->wait();
+        delete m_thread;
+        m_thread = 0;
+
+        m_tracks.clear();
+}
+
+void TScrubEngine::set_location(const TimeRef& location)
+{
+        TimeRef target = location;
+        if (target < TimeRef()) {
+                target = TimeRef();
+        }
+
+        m_targetFrame.fetchAndStoreRelease(int(target.to_frame(m_rate)));
+
+        QMutexLocker locker(&m_mutex);
+        m_wakeup.wakeAll();
+}
+
+bool TScrubEngine::is_cached(int index)
+{
+        return m_blockIndex[index % m_slotCount].fetchAndAddAcquire(0) == index;
+}
+
+const audio_sample_t* TScrubEngine::get_block(int index)
+{
+        if (index < 0 || !is_cached(index)) {
+                return 0;
+        }
+
+        return m_blockData + (index % m_slotCount) * 2 * SCRUB_BLOCK_FRAMES;
+}
+
+/**
+ * Returns the first block the audio thread will need that isn't cached yet, or -1
+ */
+int TScrubEngine::next_missing_block()
+{
+        int current = m_playFrame.fetchAndAddAcquire(0) / SCRUB_BLOCK_FRAMES;
+        int direction = m_direction.fetchAndAddAcquire(0);
+
+        for (int i=0; i<=m_aheadBlocks; ++i) {
+                int index = current + direction * i;
+                if (index >= 0 && !is_cached(index)) {
+                        return index;
+                }
+        }
+
+        for (int i=1; i<=SCRUB_BEHIND_BLOCKS; ++i) {
+                int index = current - direction * i;
+                if (index >= 0 && !is_cached(index)) {
+                        return index;
+                }
+        }
+
+        return -1;
+}
+
+void TScrubEngine::render_block(int index)
+{
+        TRACE_SCOPE("TScrubEngine::render_block");
+
+        nframes_t nframes = SCRUB_BLOCK_FRAMES;
+
+        m_context.location = TimeRef(nframes_t(index) * nframes, m_rate);
+        m_mixBus->silence_buffers(nframes);
+
+        foreach(AudioTrack* track, m_tracks) {
+                if (track->is_muted() || track->is_muted_by_solo()) {
+                        continue;
+                }
+
+                m_context.processBus->silence_buffers(nframes);
+
+                if (track->render_ahead(nframes, &m_context) <= 0) {
+                        continue;
+                }
+
+                foreach(TSend* send, track->get_post_sends()) {
+                        Track::mix_send(send, m_context.processBus, m_mixBus, nframes);
+                }
+        }
+
+        // Invalidate the slot while it's written, so the audio thread
+        // never plays a half written block.
+        int slot = index % m_slotCount;
+        m_blockIndex[slot].fetchAndStoreOrdered(-1);
+
+        audio_sample_t* data = m_blockData + slot * 2 * nframes;
+        for (int chan=0; chan<2; ++chan) {
+                memcpy(data + chan * nframes, m_mixBus->get_buffer(chan, nframes), nframes * sizeof(audio_sample_t));
+        }
+
+        m_blockIndex[slot].fetchAndStoreRelease(index);
+}
+
+/**
+ * Renders the missing blocks around the play position. A block only replaces one at least
+ * m_slotCount blocks away from it, which is never one the audio thread is playing from.
+ */
+void TScrubEngine::run()
+{
+        m_mutex.lock();
+
+        while (!m_stop) {
+                int index = next_missing_block();
+
+                if (index < 0) {
+                        m_wakeup.wait(&m_mutex, 20);
+                        continue;
+                }
+
+                m_mutex.unlock();
+
+                tsar().block_event_processing();
+                render_block(index);
+                tsar().unblock_event_processing();
+
+                m_mutex.lock();
+        }
+
+        m_mutex.unlock();
+}
+
+const audio_sample_t* TScrubEngine::frame_data(int frame, int& block, const audio_sample_t*& data)
+{
+        int index = frame / SCRUB_BLOCK_FRAMES;
+        if (index != block) {
+                block = index;
+                data = get_block(index);
+        }
+
+        return data ? data + (frame % SCRUB_BLOCK_FRAMES) : 0;
+}
+
+/**
+ * Writes the scrubbed audio into \a bus. The speed changes smoothly over the
+ * cycle, and the output is faded by the speed so it's silent when not moving.
+ */
+void TScrubEngine::process(AudioBus* bus, nframes_t nframes)
+{
+        double target = m_targetFrame.fetchAndAddAcquire(0);
+        double velocity = (target - m_playPosition) / (SCRUB_RESPONSE_TIME * m_rate);
+        velocity = qBound(-m_maxSpeed, velocity, m_maxSpeed);
+
+        if (!m_reverse && velocity < 0) {
+                m_playPosition = target;
+                velocity = 0;
+        }
+
+        int channels = qMin(2, bus->get_channel_count());
+        audio_sample_t* out[2];
+        for (int chan=0; chan<channels; ++chan) {
+                out[chan] = bus->get_buffer(chan, nframes);
+        }
+
+        int block0 = -1, block1 = -1;
+        const audio_sample_t* data0 = 0;
+        const audio_sample_t* data1 = 0;
+        double position = m_playPosition;
+
+        for (nframes_t i=0; i<nframes; ++i) {
+                double speed = m_velocity + (velocity - m_velocity) * (i + 1) / nframes;
+                position = qMax(0.0, position + speed);
+
+                int frame = int(position);
+                float fraction = float(position - frame);
+                float gain = float(qMin(1.0, fabs(speed)));
+
+                const audio_sample_t* p0 = frame_data(frame, block0, data0);
+                const audio_sample_t* p1 = frame_data(frame + 1, block1, data1);
+
+                for (int chan=0; chan<channels; ++chan) {
+                        audio_sample_t s0 = p0 ? p0[chan * SCRUB_BLOCK_FRAMES] : 0;
+                        audio_sample_t s1 = p1 ? p1[chan * SCRUB_BLOCK_FRAMES] : 0;
+                        out[chan][i] = (s0 + (s1 - s0) * fraction) * gain;
+                }
+        }
+
+        m_playPosition = position;
+        m_velocity = velocity;
+
+        m_playFrame.fetchAndStoreRelease(int(position));
+        m_direction.fetchAndStoreRelease(velocity < 0 ? -1 : 1);
+}
+
+//eof
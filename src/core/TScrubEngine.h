@@ -0,0 +1,113 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TSCRUB_ENGINE_H
+#define TSCRUB_ENGINE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QList>
+
+#include "defines.h"
+#include "TRenderAheadEngine.h"
+
+class AudioBus;
+class AudioTrack;
+class PluginChain;
+class Sheet;
+class TScrubEngine;
+
+class TScrubThread : public QThread
+{
+public:
+        TScrubThread(TScrubEngine* engine);
+
+protected:
+        void run();
+
+private:
+        TScrubEngine* m_engine;
+};
+
+
+class TScrubEngine
+{
+public:
+        TScrubEngine(Sheet* sheet);
+        ~TScrubEngine();
+
+        // GUI thread
+        void start(const TimeRef& location, const QList<AudioTrack*>& tracks);
+        void stop();
+        void set_location(const TimeRef& location);
+
+        // Audio thread only
+        void process(AudioBus* bus, nframes_t nframes);
+
+private:
+        Sheet*                  m_sheet;
+        TScrubThread*           m_thread;
+        TRenderContext          m_context;
+        TRenderSources          m_sources;
+        AudioBus*               m_mixBus;
+        PluginChain*            m_bypassChain;
+        QList<AudioTrack*>      m_tracks;
+        QMutex                  m_mutex;
+        QWaitCondition          m_wakeup;
+        bool                    m_stop;
+
+        // The block cache, a block is stored in slot (index % m_slotCount).
+        // m_blockIndex holds the index of the block in a slot, or -1 while
+        // the slot is (re)written by the scrub thread.
+        QAtomicInt*             m_blockIndex;
+        audio_sample_t*         m_blockData;
+        int                     m_slotCount;
+        int                     m_aheadBlocks;
+        int                     m_rate;
+
+        // Written by the GUI thread, read by the audio thread
+        QAtomicInt              m_targetFrame;
+        // Written by the audio thread, read by the scrub thread
+        QAtomicInt              m_playFrame;
+        QAtomicInt              m_direction;
+
+        // Audio thread only
+        double                  m_playPosition;
+        double                  m_velocity;
+        double                  m_maxSpeed;
+        bool                    m_reverse;
+
+        void run();
+        void create_cache();
+        void render_block(int index);
+        int next_missing_block();
+        const audio_sample_t* get_block(int index);
+        bool is_cached(int index);
+        const audio_sample_t* frame_data(int frame, int& block, const audio_sample_t*& data);
+
+        friend class TScrubThread;
+};
+
+#endif
+
+//eof
@@ -47,8 +47,10 @@ TSend::TSend(Track* track, AudioBus* bus)
 void TSend::init()
 {
         m_type = POSTSEND;
-        m_gain = 1.0;
-        m_pan = 0.0;
+        m_gain.set_target(1.0);
+        m_gain.reset();
+        m_pan.set_target(0.0);
+        m_pan.reset();
 }
 
 QDomNode TSend::get_state( QDomDocument doc)
@@ -56,8 +58,8 @@ QDomNode TSend::get_state( QDomDocument doc)
         QDomElement node = doc.createElement("Send");
 
         node.setAttribute("id", m_id);
-        node.setAttribute("gain", m_gain);
-        node.setAttribute("pan", m_pan);
+        node.setAttribute("gain", get_gain());
+        node.setAttribute("pan", get_pan());
         if (m_bus) {
                 node.setAttribute("bus", m_bus->get_id());
                 node.setAttribute("busname", m_bus->get_name());
@@ -90,6 +92,8 @@ int TSend::set_state( const QDomNode & node )
         QString busName = e.attribute("busname", "No Busname in Project file");
         set_gain(e.attribute("gain", "1.0").toFloat());
         set_pan(e.attribute("pan", "0.00").toFloat());
+        m_gain.reset();
+        m_pan.reset();
 
         if (type == "post") {
                 m_type = POSTSEND;
@@ -138,12 +142,11 @@ qint64 TSend::get_bus_id() const
 void TSend::set_pan(float pan)
 {
         if ( pan < -1.0 ) {
-                m_pan=-1.0;
+                pan = -1.0;
         } else if ( pan > 1.0 ) {
-                m_pan=1.0;
-        } else {
-                m_pan=pan;
+                pan = 1.0;
         }
+        m_pan.set_target(pan);
 }
 
 void TSend::set_gain(float gain)
@@ -154,5 +157,5 @@ void TSend::set_gain(float gain)
         if (gain > 2.0) {
                 gain = 2.0;
         }
-        m_gain = gain;
+        m_gain.set_target(gain);
 }
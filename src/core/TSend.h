@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #define TSEND_H
 
 #include "APILinkedList.h"
+#include "TEngineParameter.h"
 
 #include <QDomElement>
 
@@ -42,6 +43,7 @@ public:
         void set_type(int type) {m_type = type;}
         void set_gain(float gain);
         void set_pan(float pan);
+        void begin_cycle() {m_gain.begin_cycle(); m_pan.begin_cycle();}
 
 
         enum {
@@ -56,8 +58,10 @@ public:
         qint64 get_id() const {return m_id;}
         qint64 get_bus_id() const;
         int get_type() const {return m_type;}
-        float get_pan() const {return m_pan;}
-        float get_gain() const {return m_gain;}
+        float get_pan() const {return m_pan.get_target();}
+        float get_gain() const {return m_gain.get_target();}
+        const TEngineParameter& get_pan_parameter() const {return m_pan;}
+        const TEngineParameter& get_gain_parameter() const {return m_gain;}
 
 
         bool is_smaller_then(APILinkedListNode* node) {return true;}
@@ -67,8 +71,8 @@ private:
         Track*          m_track;
         qint64          m_id;
         int             m_type;
-        float           m_gain;
-        float           m_pan;
+        TEngineParameter m_gain;
+        TEngineParameter m_pan;
 
         void init();
 };
@@ -25,6 +25,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QObject>
 #include <QVariantList>
 #include <QStringList>
+#include <QHash>
+#include <QByteArray>
 
 class CommandPlugin;
 class TCommand;
@@ -106,6 +108,31 @@ private:
 	friend class TShortcutManager;
 };
 
+/**
+ * The resolved dispatch of a key on a class, for one modifier key combination and mode.
+ * Computed once by TInputEventDispatcher, and cached in TShortcut.
+ */
+struct TDispatchEntry
+{
+	TDispatchEntry() {
+		function = 0;
+		delegateFunction = 0;
+		metaObject = 0;
+		plugin = 0;
+		methodIndex = -1;
+		holdMethodIndex = -1;
+	}
+
+	TFunction*		function;		// 0 if no function applies
+	TFunction*		delegateFunction;
+	const QMetaObject*	metaObject;		// the (super) class the function was found for
+	CommandPlugin*		plugin;
+	int			methodIndex;		// TCommand* slot()
+	int			holdMethodIndex;	// slot(bool autorepeat), for hold commands
+	QByteArray		delegateClass;
+	QByteArray		delegateSlot;
+};
+
 class TShortcut
 {
 public:
@@ -123,6 +150,10 @@ public:
 	int		autorepeatInterval;
 	int		autorepeatStartDelay;
 
+	// Dispatch entries per class, keyed by modifier keys and mode. Shortcuts are
+	// recreated by TShortcutManager::loadShortcuts(), which drops the cache too.
+	QHash<const QMetaObject*, QHash<int, TDispatchEntry> > dispatchCache;
+
 private:
 	QMultiHash<QString, TFunction*> objects;
 	int		m_keyValue;
@@ -194,11 +194,58 @@ void TimeLine::index_markers()
 {
 	qSort(m_markers.begin(), m_markers.end(), smallerMarker);
 	// let the markers know about their position (index)
+	m_index.clear();
+	m_index.reserve(m_markers.size());
 	for (int i = 0; i < m_markers.size(); i++) {
 		m_markers.at(i)->set_index(i+1);
+		m_index.append(m_markers.at(i)->get_when().universal_frame(), m_markers.at(i));
 	}	
 }
 
+/**
+ * @return The first Marker after \a location, 0 if there is none
+ */
+Marker* TimeLine::get_next_marker(const TimeRef& location) const
+{
+	int i = m_index.upper_bound(location.universal_frame());
+	
+	if (i < m_index.size()) {
+		return m_index.at(i);
+	}
+	
+	return 0;
+}
+
+/**
+ * @return The last Marker before \a location, 0 if there is none
+ */
+Marker* TimeLine::get_previous_marker(const TimeRef& location) const
+{
+	int i = m_index.lower_bound(location.universal_frame());
+	
+	if (i > 0) {
+		return m_index.at(i - 1);
+	}
+	
+	return 0;
+}
+
+/**
+ * @return The Markers from \a start up to and including \a end, ordered by position
+ */
+QList<Marker*> TimeLine::get_markers_in_range(const TimeRef& start, const TimeRef& end) const
+{
+	QList<Marker*> markers;
+	int first, last;
+	
+	m_index.range(start.universal_frame(), end.universal_frame(), first, last);
+	for (int i = first; i < last; ++i) {
+		markers.append(m_index.at(i));
+	}
+	
+	return markers;
+}
+
 // returns all markers of type CDTRACK
 // sets 'endmarker' to true if an endmarker is present, else to false.
 QList<Marker*> TimeLine::get_cd_layout(bool & endmarker)
@@ -26,6 +26,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QDomNode>
 #include <QList>
 #include "defines.h"
+#include "TTimeIndex.h"
 
 class TSession;
 class Marker;
@@ -53,6 +54,10 @@ public:
 	bool get_start_location(TimeRef& location);
 	bool has_end_marker();
 
+	Marker* get_next_marker(const TimeRef& location) const;
+	Marker* get_previous_marker(const TimeRef& location) const;
+	QList<Marker*> get_markers_in_range(const TimeRef& start, const TimeRef& end) const;
+
 	TCommand* add_marker(Marker* marker, bool historable=true);
 	TCommand* remove_marker(Marker* marker, bool historable=true);
 
@@ -64,6 +69,7 @@ public:
 private:
         TSession* m_sheet;
 	QList<Marker*> m_markers;
+	TTimeIndex<qint64, Marker*> m_index;
 	void index_markers();
 
 private slots:
@@ -74,7 +74,7 @@ void Track::get_state(QDomDocument& doc, QDomElement& node, bool istemplate)
                 node.setAttribute("id", create_id());
         }
         node.setAttribute("name", m_name);
-        node.setAttribute("pan", m_pan);
+        node.setAttribute("pan", get_pan());
         node.setAttribute("mute", m_isMuted);
         node.setAttribute("solo", m_isSolo);
         node.setAttribute("mutedbysolo", m_mutedBySolo);
@@ -113,6 +113,7 @@ int Track::set_state( const QDomNode & node )
         }
         set_muted_by_solo(e.attribute( "mutedbysolo", "0").toInt());
         set_pan( e.attribute( "pan", "" ).toFloat() );
+        m_pan.reset();
         m_id = e.attribute("id", "0").toLongLong();
         if (m_id == 0) {
                 m_id = create_id();
@@ -413,6 +414,23 @@ void Track::add_input_bus(const QString &name)
         }
 }
 
+/**
+ * Called by the audio thread at the start of the process cycle: picks up the fader,
+ * pan and send values set since the previous cycle, they are ramped to over the block.
+ */
+void Track::begin_cycle()
+{
+        m_fader->begin_cycle();
+        m_pan.begin_cycle();
+
+        apill_foreach(TSend* preSend, TSend, m_preSends) {
+                preSend->begin_cycle();
+        }
+        apill_foreach(TSend* postSend, TSend, m_postSends) {
+                postSend->begin_cycle();
+        }
+}
+
 void Track::process_post_sends(nframes_t nframes)
 {
         apill_foreach(TSend* postSend, TSend, m_postSends) {
@@ -429,33 +447,45 @@ void Track::process_pre_sends(nframes_t nframes)
 
 void Track::process_send(TSend *send, nframes_t nframes)
 {
-        AudioChannel* sender;
-        AudioChannel* receiver;
-        float gainFactor;
-        float panFactor;
-
-        AudioBus* receiverBus = send->get_bus();
-        for (int i=0; i<m_processBus->get_channel_count(); i++) {
-                sender = m_processBus->get_channel(i);
-                receiver = receiverBus->get_channel(i);
-                if (sender && receiver) {
-                        panFactor = 1.0f;
+        mix_send(send, m_processBus, send->get_bus(), nframes, true);
+}
+
+/**
+ * Mixes the channels of \a sender into \a receiver, with the gain and pan of \a send.
+ * With \a ramp, the gain and pan move from the values of the previous cycle to the
+ * current ones, else the current values are used for the whole block.
+ */
+void Track::mix_send(TSend* send, AudioBus* sender, AudioBus* receiver, nframes_t nframes, bool ramp)
+{
+        AudioChannel* senderChannel;
+        AudioChannel* receiverChannel;
+        const TEngineParameter& gain = send->get_gain_parameter();
+        const TEngineParameter& pan = send->get_pan_parameter();
+        float startGain = ramp ? gain.get_start() : gain.get_target();
+        float endGain = ramp ? gain.get_end() : startGain;
+        float startPan = ramp ? pan.get_start() : pan.get_target();
+        float endPan = ramp ? pan.get_end() : startPan;
+        float startFactor;
+        float endFactor;
+
+        for (int i=0; i<sender->get_channel_count(); i++) {
+                senderChannel = sender->get_channel(i);
+                receiverChannel = receiver->get_channel(i);
+                if (senderChannel && receiverChannel && !senderChannel->is_silent()) {
+                        startFactor = startGain;
+                        endFactor = endGain;
                         // Left channel
                         if (i == 0) {
-                                panFactor = 1 - send->get_pan();
+                                startFactor *= 1 - startPan;
+                                endFactor *= 1 - endPan;
                         }
                         // Right channel
                         if (i == 1) {
-                                panFactor = 1 + send->get_pan();
+                                startFactor *= 1 + startPan;
+                                endFactor *= 1 + endPan;
                         }
 
-                        gainFactor = panFactor * send->get_gain();
-
-                        if (gainFactor == 1.0f) {
-                                Mixer::mix_buffers_no_gain(receiver->get_buffer(nframes), sender->get_buffer(nframes), nframes);
-                        } else {
-                                Mixer::mix_buffers_with_gain(receiver->get_buffer(nframes), sender->get_buffer(nframes), nframes, gainFactor);
-                        }
+                        Mixer::mix_with_gain(receiverChannel->get_buffer(nframes), senderChannel->get_buffer(nframes), nframes, startFactor, endFactor);
                 }
 
         }
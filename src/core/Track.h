@@ -81,6 +81,8 @@ public:
         QList<TSend*> get_pre_sends() const;
         TSend* get_send(qint64 sendId);
 
+        static void mix_send(TSend* send, AudioBus* sender, AudioBus* receiver, nframes_t nframes, bool ramp=false);
+
 
 protected:
         VUMonitors      m_vumonitors;
@@ -98,6 +100,7 @@ protected:
         AudioBus*       m_inputBus;
         QString         m_busInName;
 
+        void begin_cycle();
         void process_post_sends(nframes_t nframes);
         void process_pre_sends(nframes_t nframes);
         virtual void add_input_bus(AudioBus* bus);
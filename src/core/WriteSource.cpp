@@ -31,6 +31,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "Peak.h"
 #include "Utils.h"
 #include "DiskIO.h"
+#include "TMemoryBudget.h"
+#include "TExportPipeline.h"
 
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
@@ -44,17 +46,24 @@ WriteSource::WriteSource( ExportSpecification* specification )
 	m_diskio = 0;
 	m_writer = 0;
 	m_peak = 0;
+	m_pipeline = 0;
+	m_pipelined = false;
 }
 
 WriteSource::~WriteSource()
 {
 	PENTERDES;
+	if (m_pipeline) {
+		delete m_pipeline;
+	}
+	
 	if (m_peak) {
 		delete m_peak;
 	}
 	
-	for(int i=0; i<m_buffers.size(); ++i) {
-		delete m_buffers.at(i);
+	if (m_buffer) {
+		memorybudget().remove(TMemoryBudget::WriteBuffers, m_buffer->storage_size());
+		delete m_buffer;
 	}
 	
 	if (m_spec->isRecording) {
@@ -66,19 +75,38 @@ WriteSource::~WriteSource()
 }
 
 int WriteSource::process (nframes_t nframes)
+{
+	// nframes MUST be greater then 0, this is a precondition !
+	Q_ASSERT(nframes);
+
+	int rate = audiodevice().get_sample_rate();
+	bool endOfInput = (m_spec->pos + TimeRef(nframes, rate)) >= m_spec->endLocation;
+
+	if (m_pipeline) {
+		// The convert and encode stages run on their own threads
+		return m_pipeline->push(m_spec->dataF, nframes, endOfInput);
+	}
+
+	return convert(m_spec->dataF, nframes, endOfInput);
+}
+
+/**
+ * Does the sample rate conversion and dithering of \a nframes interleaved frames
+ * of \a input, and hands the result to encode(), or to the encode stage of the
+ * TExportPipeline when exporting pipelined.
+ *
+ * @return 0 on success, -1 on conversion errors
+ */
+int WriteSource::convert(audio_sample_t* input, nframes_t nframes, bool endOfInput)
 {
 	float* float_buffer = 0;
+	void* output_data = 0;
 	int chn;
 	uint32_t x;
 	uint32_t i;
-	nframes_t written;
 	nframes_t to_write = 0;
 	int cnt = 0;
 
-	// nframes MUST be greater then 0, this is a precondition !
-	Q_ASSERT(nframes);
-
-
 	do {
 
 		/* now do sample rate conversion */
@@ -88,8 +116,7 @@ int WriteSource::process (nframes_t nframes)
 			int err;
 
 			m_src_data.output_frames = m_out_samples_max / m_channelCount;
-			int rate = audiodevice().get_sample_rate();
-			m_src_data.end_of_input = (m_spec->pos + TimeRef(nframes, rate)) >= m_spec->endLocation;
+			m_src_data.end_of_input = endOfInput;
 			m_src_data.data_out = m_dataF2;
 
 			if (m_leftover_frames > 0) {
@@ -102,7 +129,7 @@ int WriteSource::process (nframes_t nframes)
 
 					/* first time, append new data from dataF into the m_leftoverF buffer */
 
-					memcpy (m_leftoverF + (m_leftover_frames * m_channelCount), m_spec->dataF, nframes * m_channelCount * sizeof(float));
+					memcpy (m_leftoverF + (m_leftover_frames * m_channelCount), input, nframes * m_channelCount * sizeof(float));
 					m_src_data.input_frames = nframes + m_leftover_frames;
 				} else {
 
@@ -115,7 +142,7 @@ int WriteSource::process (nframes_t nframes)
 				}
 			} else {
 
-				m_src_data.data_in = m_spec->dataF;
+				m_src_data.data_in = input;
 				m_src_data.input_frames = nframes;
 
 			}
@@ -147,11 +174,20 @@ int WriteSource::process (nframes_t nframes)
 
 			to_write = nframes;
 			m_leftover_frames = 0;
-			float_buffer = m_spec->dataF;
+			float_buffer = input;
 		}
 
-		if (m_output_data) {
-			memset (m_output_data, 0, m_sample_bytes * to_write * m_channelCount);
+		if (m_pipeline) {
+			// Convert into a block of the encode queue
+			if (! (output_data = m_pipeline->acquire_output())) {
+				return -1;
+			}
+		} else {
+			output_data = m_output_data;
+		}
+
+		if (m_sample_bytes) {
+			memset (output_data, 0, m_sample_bytes * to_write * m_channelCount);
 		}
 
 		switch (m_spec->data_width) {
@@ -159,16 +195,14 @@ int WriteSource::process (nframes_t nframes)
 		case 16:
 		case 24:
 			for (chn = 0; chn < m_channelCount; ++chn) {
-				gdither_runf (m_dither, chn, to_write, float_buffer, m_output_data);
+				gdither_runf (m_dither, chn, to_write, float_buffer, output_data);
 			}
-			/* and export to disk */
-			written = m_writer->write(m_output_data, to_write);
 			break;
 
 		case 32:
 			for (chn = 0; chn < m_channelCount; ++chn) {
 
-				int *ob = (int *) m_output_data;
+				int *ob = (int *) output_data;
 				const double int_max = (float) INT_MAX;
 				const double int_min = (float) INT_MIN;
 
@@ -188,8 +222,6 @@ int WriteSource::process (nframes_t nframes)
 					}
 				}
 			}
-			/* and export to disk */
-			written = m_writer->write(m_output_data, to_write);
 			break;
 
 		default:
@@ -200,16 +232,32 @@ int WriteSource::process (nframes_t nframes)
 					float_buffer[x] = -1.0f;
 				}
 			}
-			/* and export to disk */
-			written = m_writer->write(float_buffer, to_write);
+			if (m_pipeline) {
+				memcpy (output_data, float_buffer, to_write * m_channelCount * sizeof(float));
+			} else {
+				output_data = float_buffer;
+			}
 			break;
 		}
 
+		/* and export to disk */
+		if (m_pipeline) {
+			m_pipeline->push_output(output_data, to_write);
+		} else if (encode(output_data, to_write) < to_write) {
+			PERROR("WriteSource::convert : the writer failed to write %d frames", to_write);
+			return -1;
+		}
+
 	} while (m_leftover_frames >= nframes);
 
 	return 0;
 }
 
+nframes_t WriteSource::encode(void* data, nframes_t frames)
+{
+	return m_writer->write(data, frames);
+}
+
 int WriteSource::prepare_export()
 {
 	PENTER;
@@ -314,6 +362,12 @@ int WriteSource::prepare_export()
 	if (m_sample_bytes) {
 		m_output_data = (void*) malloc (m_sample_bytes * m_out_samples_max);
 	}
+	
+	if (m_pipelined) {
+		m_pipeline = new TExportPipeline(this, m_channelCount, m_spec->blocksize,
+						 m_out_samples_max * qMax(size_t(m_sample_bytes), sizeof(float)));
+		m_pipeline->start();
+	}
 
 	return 0;
 }
@@ -322,6 +376,15 @@ int WriteSource::prepare_export()
 int WriteSource::finish_export( )
 {
 	PENTER;
+	
+	if (m_pipeline) {
+		// Let the convert and encode stages finish the queued blocks
+		if (m_pipeline->finish() < 0) {
+			PERROR("WriteSource::finish_export : the export pipeline failed!");
+		}
+		delete m_pipeline;
+		m_pipeline = 0;
+	}
 
 	if (m_writer) {
 		m_writer->close();
@@ -369,16 +432,16 @@ int WriteSource::rb_write(AudioBus* bus, nframes_t nframes)
                 return 0;
         }
 
-	int written = 0;
-	
-        for (int i=m_channelCount-1; i>=0; --i) {
+        audio_sample_t* src[m_channelCount];
+        for (int i=0; i<m_channelCount; ++i) {
                 AudioChannel* chan = bus->get_channel(i);
-                if (chan) {
-                        written = m_buffers.at(i)->write(chan->get_buffer(nframes), nframes);
+                if (!chan) {
+                        return 0;
                 }
+                src[i] = chan->get_buffer(nframes);
 	}
 	
-	return written;
+	return m_buffer->write(src, nframes);
 }
 
 void WriteSource::set_process_peaks( bool process )
@@ -411,15 +474,16 @@ int WriteSource::rb_file_write(nframes_t cnt)
 	audio_sample_t* readbuffer[m_channelCount];
 	
 	for (chan=0; chan<m_channelCount; ++chan) {
-		
 		readbuffer[chan] = new audio_sample_t[cnt * m_channelCount];
-
-		read = m_buffers.at(chan)->read(readbuffer[chan], cnt);
-		
-		if (read != cnt) {
-			printf("WriteSource::rb_file_write() : could only process %d frames, %d were requested!\n", read, cnt);
-		}
-		
+	}
+	
+	read = m_buffer->read(readbuffer, cnt);
+	
+	if (read != cnt) {
+		printf("WriteSource::rb_file_write() : could only process %d frames, %d were requested!\n", read, cnt);
+	}
+	
+	for (chan=0; chan<m_channelCount; ++chan) {
 		m_peak->process(chan, readbuffer[chan], read);
 	}
 
@@ -453,7 +517,7 @@ void WriteSource::set_recording( int rec )
 void WriteSource::process_ringbuffer(audio_sample_t* buffer)
 {
 	m_spec->dataF = buffer;
-	int readSpace = m_buffers.at(0)->read_space();
+	int readSpace = m_buffer->read_space();
 
 	if (! m_isRecording ) {
 		PMESG("Writing remaining  (%d) samples to ringbuffer", readSpace);
@@ -469,9 +533,8 @@ void WriteSource::prepare_rt_buffers( )
 {
 	m_bufferSize = m_sampleRate * DiskIO::writebuffertime;
 	m_chunkSize = m_bufferSize / DiskIO::bufferdividefactor;
-	for (int i=0; i<m_channelCount; ++i) {
-		m_buffers.append(new RingBufferNPT<audio_sample_t>(m_bufferSize));
-	}
+	m_buffer = new TMultiChannelRingBuffer<audio_sample_t>(m_channelCount, m_bufferSize);
+	memorybudget().add(TMemoryBudget::WriteBuffers, m_buffer->storage_size());
 }
 
 void WriteSource::set_diskio( DiskIO * io )
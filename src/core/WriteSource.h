@@ -32,6 +32,7 @@ class Peak;
 class DiskIO;
 class AbstractAudioWriter;
 class AudioBus;
+class TExportPipeline;
 
 /// WriteSource is an AudioSource used for writing (recording, rendering) purposes
 class WriteSource : public AudioSource
@@ -55,6 +56,7 @@ public :
 	int prepare_export();
 	int finish_export();
 	void set_process_peaks(bool process);
+	void set_pipelined(bool pipelined) {m_pipelined = pipelined;}
 	void set_recording(int rec);
 
 	size_t is_recording() const;
@@ -83,8 +85,14 @@ private:
 	float*		m_dataF2;
 	void*           m_output_data;
 	
+	TExportPipeline* m_pipeline;
+	bool		m_pipelined;
 	
 	void prepare_rt_buffers();
+	int convert(audio_sample_t* input, nframes_t nframes, bool endOfInput);
+	nframes_t encode(void* data, nframes_t frames);
+	
+	friend class TExportPipeline;
 	
 signals:
 	void exportFinished();
@@ -93,7 +101,7 @@ signals:
 
 inline int WriteSource::get_processable_buffer_space( ) const
 {
-	return m_buffers.at(0)->read_space();
+	return m_buffer->read_space();
 }
 
 inline size_t WriteSource::is_recording( ) const
@@ -372,14 +372,14 @@ void AlsaDriver::setup_io_function_pointers()
 			fprintf (stderr,"Rectangular dithering at 16 bits\n");
 			write_via_copy = quirk_bswap?
 				sample_move_dither_rect_d16_sSs:
-				sample_move_dither_rect_d16_sS;
+				MemOps::sample_move_dither_rect_d16_sS;
 			break;
 
 		case Triangular:
 			printf("Triangular dithering at 16 bits\n");
 			write_via_copy = quirk_bswap?
 				sample_move_dither_tri_d16_sSs:
-				sample_move_dither_tri_d16_sS;
+				MemOps::sample_move_dither_tri_d16_sS;
 			break;
 
 		case Shaped:
@@ -391,7 +391,7 @@ void AlsaDriver::setup_io_function_pointers()
 
 		default:
 			write_via_copy = quirk_bswap?
-				sample_move_d16_sSs : sample_move_d16_sS;
+				sample_move_d16_sSs : MemOps::sample_move_d16_sS;
 			break;
 		}
 		break;
@@ -408,14 +408,14 @@ void AlsaDriver::setup_io_function_pointers()
 			printf("Rectangular dithering at 24 bits\n");
 			write_via_copy = quirk_bswap?
 				sample_move_dither_rect_d24_sSs:
-				sample_move_dither_rect_d24_sS;
+				MemOps::sample_move_dither_rect_d24_sS;
 			break;
 
 		case Triangular:
 			printf("Triangular dithering at 24 bits\n");
 			write_via_copy = quirk_bswap?
 				sample_move_dither_tri_d24_sSs:
-				sample_move_dither_tri_d24_sS;
+				MemOps::sample_move_dither_tri_d24_sS;
 			break;
 
 		case Shaped:
@@ -427,7 +427,7 @@ void AlsaDriver::setup_io_function_pointers()
 
 			default:
 			write_via_copy = quirk_bswap?
-				sample_move_d24_sSs : sample_move_d24_sS;
+				sample_move_d24_sSs : MemOps::sample_move_d24_sS;
 				break;
 		}
 		break;
@@ -444,14 +444,14 @@ void AlsaDriver::setup_io_function_pointers()
 			printf("Rectangular dithering at 32 bits\n");
 			write_via_copy = quirk_bswap?
 				sample_move_dither_rect_d32u24_sSs:
-				sample_move_dither_rect_d32u24_sS;
+				MemOps::sample_move_dither_rect_d32u24_sS;
 			break;
 
 		case Triangular:
 			printf("Triangular dithering at 16 bits\n");
 			write_via_copy = quirk_bswap?
 				sample_move_dither_tri_d32u24_sSs:
-				sample_move_dither_tri_d32u24_sS;
+				MemOps::sample_move_dither_tri_d32u24_sS;
 			break;
 
 		case Shaped:
@@ -463,7 +463,7 @@ void AlsaDriver::setup_io_function_pointers()
 
 		default:
 			write_via_copy = quirk_bswap?
-				sample_move_d32u24_sSs : sample_move_d32u24_sS;
+				sample_move_d32u24_sSs : MemOps::sample_move_d32u24_sS;
 			break;
 		}
 		break;
@@ -472,15 +472,15 @@ void AlsaDriver::setup_io_function_pointers()
 	switch (capture_sample_bytes) {
 	case 2:
 		read_via_copy = quirk_bswap?
-			sample_move_dS_s16s : sample_move_dS_s16;
+			sample_move_dS_s16s : MemOps::sample_move_dS_s16;
 		break;
 	case 3:
 		read_via_copy = quirk_bswap?
-			sample_move_dS_s24s : sample_move_dS_s24;
+			sample_move_dS_s24s : MemOps::sample_move_dS_s24;
 		break;
 	case 4:
 		read_via_copy = quirk_bswap?
-			sample_move_dS_s32u24s : sample_move_dS_s32u24;
+			sample_move_dS_s32u24s : MemOps::sample_move_dS_s32u24;
 		break;
 	}
 }
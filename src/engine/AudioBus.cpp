@@ -51,6 +51,7 @@ AudioBus::AudioBus(const BusConfig& config)
         m_isMonitoring = true;
 
         m_channelCount = 0;
+        m_channelArray = 0;
         m_name = config.name;
         if (config.type == "input") {
                 m_type = ChannelIsInput;
@@ -87,6 +88,7 @@ AudioBus::AudioBus(const BusConfig& config)
 
 AudioBus::~ AudioBus( )
 {
+        delete [] m_channelArray;
 }
 
 
@@ -102,6 +104,7 @@ void AudioBus::add_channel(AudioChannel* chan)
 	Q_ASSERT(chan);
         m_channels.append(chan);
         m_channelCount++;
+        update_channel_array();
 }
 
 void AudioBus::add_channel(const QString &channel)
@@ -141,6 +144,7 @@ void AudioBus::audiodevice_params_changed()
 {
         m_channels.clear();
         m_channelCount = 0;
+        update_channel_array();
 
         AudioChannel* channel;
 
@@ -157,6 +161,21 @@ void AudioBus::audiodevice_params_changed()
         }
 }
 
+void AudioBus::update_channel_array()
+{
+        delete [] m_channelArray;
+        m_channelArray = 0;
+
+        if (m_channels.isEmpty()) {
+                return;
+        }
+
+        m_channelArray = new AudioChannel*[m_channels.size()];
+        for (int i=0; i<m_channels.size(); ++i) {
+                m_channelArray[i] = m_channels.at(i);
+        }
+}
+
 bool AudioBus::is_valid() const
 {
         if (m_channels.count()) {
@@ -57,7 +57,7 @@ public:
 	 * @return 
 	 */
         audio_sample_t* get_buffer(int channel, nframes_t nframes) {
-                return m_channels.at(channel)->get_buffer(nframes);
+                return m_channelArray[channel]->get_buffer(nframes);
 	}
 
         void set_monitoring(bool monitor);
@@ -71,14 +71,14 @@ public:
         void set_name(const QString& name) {m_name = name;}
 
         void process_monitoring() {
-                for (int i=0; i<m_channels.size(); ++i) {
-                        m_channels.at(i)->process_monitoring();
+                for (int i=0; i<m_channelCount; ++i) {
+                        m_channelArray[i]->process_monitoring();
 		}
 	}
 
         void process_monitoring(VUMonitors vumonitors) {
-                for (int i=0; i<m_channels.size(); ++i) {
-                        m_channels.at(i)->process_monitoring(vumonitors.at(i));
+                for (int i=0; i<m_channelCount; ++i) {
+                        m_channelArray[i]->process_monitoring(vumonitors.at(i));
                 }
         }
 
@@ -88,15 +88,31 @@ public:
 	 */
 	void silence_buffers(nframes_t nframes)
 	{
-                for (int i=0; i<m_channels.size(); ++i) {
-                        m_channels.at(i)->silence_buffer(nframes);
+                for (int i=0; i<m_channelCount; ++i) {
+                        m_channelArray[i]->silence_buffer(nframes);
 		}
 	}
 
+        /**
+         *        @return true if all AudioChannel buffers are known to be silent,
+         *        see AudioChannel::is_silent()
+         */
+        bool is_silent() const
+        {
+                for (int i=0; i<m_channelCount; ++i) {
+                        if (!m_channelArray[i]->is_silent()) {
+                                return false;
+                        }
+                }
+                return true;
+        }
+
         bool is_smaller_then(APILinkedListNode* node) {return true;}
 
 private:
         QList<AudioChannel* >	m_channels;
+        // m_channels as a plain array, for the audio processing functions
+        AudioChannel**          m_channelArray;
         QStringList             m_channelNames;
 	QString			m_name;
 	
@@ -107,6 +123,8 @@ private:
         int                     m_busType;
         qint64                  m_id;
 
+        void update_channel_array();
+
 signals:
 	void monitoringPeaksStarted();
 	void monitoringPeaksStopped();
@@ -122,7 +140,7 @@ signals:
 inline AudioChannel * AudioBus::get_channel( int channelNumber )
 {
         if (channelNumber < m_channelCount) {
-                return m_channels.at(channelNumber);
+                return m_channelArray[channelNumber];
         }
         return 0;
 }
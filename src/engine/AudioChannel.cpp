@@ -21,14 +21,11 @@
 
 #include "AudioChannel.h"
 #include "AudioDevice.h"
+#include "TBufferArena.h"
 
 #include "Tsar.h"
 #include "Utils.h"
 
-#ifdef USE_MLOCK
-#include <sys/mman.h>
-#endif /* USE_MLOCK */
-
 #include <QString>
 
 // Always put me below _all_ includes, this is needed
@@ -41,6 +38,12 @@
  *
  * An AudioChannel has a audio_sample_t* buffer, a name and some functions for setting the buffer size, 
  * and monitoring the highest peak value, which is handy to use by for example a VU meter. 
+ * The monitored values are published through the TMeterBus, read them with get_vumonitor().
+ * The buffer is owned by the AudioDevice's TBufferArena.
+ *
+ * The AudioChannel keeps track of its buffer being silent: silence_buffer() marks it as
+ * silent, and get_buffer() marks it as possibly containing audio. This allows the
+ * processing path to skip work on silent buffers without having to scan them.
  */
 
 
@@ -52,7 +55,7 @@ AudioChannel::AudioChannel(const QString& name, uint channelNumber, int type, qi
         m_monitoring = true;
         m_buffer = 0;
         m_bufferSize = 0;
-        mlocked = 0;
+        m_silent = false;
         if (id == 0) {
                 m_id = create_id();
         } else {
@@ -63,15 +66,6 @@ AudioChannel::AudioChannel(const QString& name, uint channelNumber, int type, qi
 AudioChannel::~ AudioChannel( )
 {
         PENTERDES2;
-
-#ifdef USE_MLOCK
-
-        if (mlocked) {
-                munlock (m_buffer, m_bufferSize);
-        }
-#endif /* USE_MLOCK */
-
-        delete [] m_buffer;
 }
 
 void AudioChannel::set_latency( uint latency )
@@ -79,47 +73,60 @@ void AudioChannel::set_latency( uint latency )
         m_latency = latency;
 }
 
+/**
+ * Changes the buffer size of this AudioChannel only, all AudioChannels are
+ * resized by the AudioDevice when the driver buffer size changes.
+ * Not real time safe!
+ */
 void AudioChannel::set_buffer_size( nframes_t size )
 {
-#ifdef USE_MLOCK
-        if (mlocked) {
-                if (munlock (m_buffer, m_bufferSize) == -1) {
-                	PERROR("Couldn't lock buffer into memory");
-				}
-                mlocked = 0;
-        }
-#endif /* USE_MLOCK */
+        audiodevice().get_buffer_arena()->resize_channel(this, size);
+}
 
+/**
+ * Called by the TBufferArena which owns the buffers of all AudioChannels.
+ * Only when the audio thread isn't processing, or before this AudioChannel
+ * is used by the audio thread!
+ */
+void AudioChannel::set_buffer(audio_sample_t* buffer, nframes_t size)
+{
+        m_buffer = buffer;
+        m_bufferSize = size;
+        m_silent = false;
         if (m_buffer) {
-                delete [] m_buffer;
+                silence_buffer(size);
         }
+}
 
-        m_buffer = new audio_sample_t[size];
-        m_bufferSize = size;
-        silence_buffer(size);
 
-#ifdef USE_MLOCK
-        if (mlock (m_buffer, size) == -1) {
-        	PERROR("Couldn't lock buffer into memory");
+static inline float compute_squares(const audio_sample_t* buf, nframes_t nframes)
+{
+        float squares = 0.0f;
+        for (nframes_t i=0; i<nframes; ++i) {
+                squares += buf[i] * buf[i];
         }
-        mlocked = 1;
-#endif /* USE_MLOCK */
+        return squares;
 }
 
-
 void AudioChannel::process_monitoring(VUMonitor* monitor)
 {
         Q_ASSERT(m_bufferSize > 0);
         float peakValue = 0;
-        peakValue = Mixer::compute_peak( m_buffer, m_bufferSize, peakValue );
+        float squares = 0.0f;
+
+        // A silent buffer has no peak and no energy, don't bother scanning it.
+        if (!m_silent) {
+                peakValue = Mixer::compute_peak( m_buffer, m_bufferSize, peakValue );
+                if (meterbus().is_rms_enabled()) {
+                        squares = compute_squares(m_buffer, m_bufferSize);
+                }
+        }
 
         if (monitor) {
-                monitor->process(peakValue);
+                monitor->process(peakValue, squares, m_bufferSize);
         }
 
-        apill_foreach(VUMonitor* internalmonitor, VUMonitor, m_monitors) {
-                internalmonitor->process(peakValue);
-        }
+        m_vumonitor.process(peakValue, squares, m_bufferSize);
 }
 
 void AudioChannel::set_monitoring( bool monitor )
@@ -128,31 +135,10 @@ void AudioChannel::set_monitoring( bool monitor )
 }
 
 
-void AudioChannel::private_add_monitor(VUMonitor *monitor)
-{
-        m_monitors.append(monitor);
-}
-
-void AudioChannel::private_remove_monitor(VUMonitor *monitor)
-{
-        if (!m_monitors.remove(monitor)) {
-                printf("AudioChannel:: VUMonitor was not in monitors list, failed to remove it!\n");
-        }
-}
-
-void AudioChannel::add_monitor(VUMonitor *monitor)
-{
-        THREAD_SAVE_INVOKE(this, monitor, private_add_monitor(VUMonitor*));
-}
-
-void AudioChannel::remove_monitor(VUMonitor *monitor)
-{
-        THREAD_SAVE_INVOKE(this, monitor, private_remove_monitor(VUMonitor*));
-}
-
 void AudioChannel::read_from_hardware_port(audio_sample_t *buf, nframes_t nframes)
 {
         memcpy (m_buffer, buf, sizeof(audio_sample_t) * nframes);
+        m_silent = false;
         if (m_monitoring) {
                 process_monitoring();
                 audiodevice().send_to_master_out(this, m_bufferSize);
@@ -162,18 +148,30 @@ void AudioChannel::read_from_hardware_port(audio_sample_t *buf, nframes_t nframe
 
 /**
  *
- * @return The highest peak value since the previous call to this function,
- *		 call this at least 10 times each second to keep data consistent
+ * @return The highest peak value in the last TMeterBus snapshot, that is since the
+ *		 previous meterbus().update_snapshot() call. GUI thread only!
  */
 audio_sample_t VUMonitor::get_peak_value( )
 {
-        if (m_flag) {
+        if (m_slot < 0) {
                 return 0.0;
         }
 
-        float result = m_peak;
+        return meterbus().get_value(m_slot).peak;
+}
+
+/**
+ *
+ * @return The rms value over the period covered by the last TMeterBus snapshot.
+ *		 GUI thread only!
+ */
+audio_sample_t VUMonitor::get_rms_value( )
+{
+        if (m_slot < 0) {
+                return 0.0;
+        }
 
-        return result;
+        return meterbus().get_value(m_slot).rms;
 }
 
 //eof
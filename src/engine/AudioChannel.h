@@ -27,38 +27,32 @@ $Id: AudioChannel.h,v 1.8 2008/11/24 21:11:04 r_sijrier Exp $
 #include <QString>
 #include "Mixer.h"
 #include "RingBuffer.h"
-#include "APILinkedList.h"
+#include "TMeterBus.h"
 
 class RingBuffer;
 class AudioDevice;
 
-class VUMonitor : public APILinkedListNode
+class VUMonitor
 {
 public:
         VUMonitor() {
-                m_flag = 0;
+                m_slot = meterbus().acquire_slot();
+        }
+        ~VUMonitor() {
+                meterbus().release_slot(m_slot);
         }
-        ~VUMonitor() {}
-
-        bool is_smaller_then(APILinkedListNode* /*node*/) {return true;}
-
-        void process(float peakValue) {
-                if (m_flag) {
-                        m_peak = 0.0f;
-                        m_flag = 0;
-                }
 
-                if (peakValue > m_peak) {
-                        m_peak = peakValue;
+        void process(float peakValue, float squares, nframes_t nframes) {
+                if (m_slot >= 0) {
+                        meterbus().process(m_slot, peakValue, squares, nframes);
                 }
         }
 
         audio_sample_t get_peak_value();
-        inline void set_read() {m_flag = 1;}
+        audio_sample_t get_rms_value();
 
 private:
-        int    m_flag;
-        audio_sample_t m_peak;
+        int     m_slot;
 };
 
 class AudioChannel : public QObject
@@ -69,22 +63,37 @@ public:
         AudioChannel(const QString& name, uint channelNumber, int type, qint64 id=0);
         ~AudioChannel();
 
+        /**
+         *        Get the buffer of this AudioChannel. The caller is assumed to
+         *        write into it, so the buffer is no longer known to be silent.
+         */
         audio_sample_t* get_buffer(nframes_t ) {
+                m_silent = false;
                 return m_buffer;
 	}
 
 	void set_latency(unsigned int latency);
 
         void silence_buffer(nframes_t nframes) {
+                // no need to zero a buffer nobody wrote into since the last time
+                if (m_silent && nframes <= m_bufferSize) {
+                        return;
+                }
                 memset (m_buffer, 0, sizeof (audio_sample_t) * nframes);
+                m_silent = (nframes >= m_bufferSize);
 	}
 
-	void set_buffer_size(nframes_t size);
+        /**
+         *        @return true if the buffer was silenced and nobody requested
+         *        it with get_buffer() since then, the buffer only contains zero's.
+         */
+        bool is_silent() const {return m_silent;}
+
+        void set_buffer_size(nframes_t size);
         void set_monitoring(bool monitor);
         void process_monitoring(VUMonitor* monitor=0);
 
-        void add_monitor(VUMonitor* monitor);
-        void remove_monitor(VUMonitor* monitor);
+        VUMonitor* get_vumonitor() {return &m_vumonitor;}
 
         QString get_name() const {return m_name;}
         uint get_number() const {return m_number;}
@@ -93,15 +102,15 @@ public:
         qint64 get_id() const {return m_id;}
 
 private:
-        APILinkedList           m_monitors;
+        VUMonitor               m_vumonitor;
         audio_sample_t* 	m_buffer;
         uint 			m_bufferSize;
 	uint 			m_latency;
 	uint 			m_number;
         qint64                  m_id;
         int                     m_type;
-	bool			mlocked;
         bool			m_monitoring;
+        bool			m_silent;
 	QString 		m_name;
 
 	friend class JackDriver;
@@ -110,12 +119,11 @@ private:
 	friend class PulseAudioDriver;
         friend class TAudioDriver;
 	friend class CoreAudioDriver;
+        friend class TBufferArena;
 
-        void read_from_hardware_port(audio_sample_t* buf, nframes_t nframes);
+        void set_buffer(audio_sample_t* buffer, nframes_t size);
 
-private slots:
-        void private_add_monitor(VUMonitor* monitor);
-        void private_remove_monitor(VUMonitor* monitor);
+        void read_from_hardware_port(audio_sample_t* buf, nframes_t nframes);
 };
 
 #endif
@@ -50,11 +50,16 @@ RELAYTOOL_JACK
 #include "TAudioDeviceClient.h"
 #include "AudioChannel.h"
 #include "AudioBus.h"
+#include "TMeterBus.h"
+#include "TBufferArena.h"
+#include "TRTMemoryPolicy.h"
 #include "Tsar.h"
 #include "Mixer.h"
+#include "TTimelineTracer.h"
 
 //#include <sys/mman.h>
 #include <QDebug>
+#include <QMutexLocker>
 
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
@@ -160,6 +165,10 @@ AudioDevice::AudioDevice()
         m_rate = 44100;
 	m_xrunCount = 0;
 	m_cpuTime = new RingBufferNPT<trav_time_t>(4096);
+        m_bufferArena = new TBufferArena();
+        m_rtMemory = new TRTMemoryPolicy();
+        m_stackReserved = 0;
+        m_bufferArena->set_buffer_size(m_bufferSize, m_channels);
 
 	m_driverType = tr("No Driver Loaded");
 
@@ -215,6 +224,8 @@ AudioDevice::~AudioDevice()
 	}
 	
 	delete m_cpuTime;
+        delete m_bufferArena;
+        delete m_rtMemory;
 }
 
 /**
@@ -231,9 +242,9 @@ void AudioDevice::set_buffer_size( nframes_t size )
 	Q_ASSERT(size > 0);
 	m_bufferSize = size;
 
-        for (int i=0; i<m_channels.size(); i++) {
-                m_channels.at(i)->set_buffer_size(m_bufferSize);
-        }
+        // lays out the buffers of all AudioChannels again, in one block
+        QMutexLocker locker(&m_channelMutex);
+        m_bufferArena->set_buffer_size(m_bufferSize, m_channels);
 
 }
 
@@ -249,6 +260,17 @@ void AudioDevice::set_bit_depth( uint depth )
 
 int AudioDevice::run_cycle( nframes_t nframes, float delayed_usecs )
 {
+        // Registers the driver's thread on the first cycle, which for
+        // jack is not the AudioDeviceThread
+        TRACE_THREAD("Audio");
+        TRACE_SCOPE("AudioDevice::run_cycle");
+
+        if (!m_stackReserved) {
+                m_rtMemory->reserve_stack();
+                m_stackReserved = 1;
+        }
+        m_rtMemory->cycle_start();
+
         if (m_masterOutBus) {
                 m_masterOutBus->silence_buffers(nframes);
         }
@@ -270,6 +292,8 @@ int AudioDevice::run_cycle( nframes_t nframes, float delayed_usecs )
 
 	post_process();
 
+        m_rtMemory->cycle_end();
+
 	return 1;
 }
 
@@ -322,6 +346,9 @@ void AudioDevice::set_parameters(AudioDeviceSetup ads)
 
 	shutdown();
 
+        m_rtMemory->set_policy(ads.lockMemory, ads.countPageFaults);
+        m_stackReserved = 0;
+
         if (create_driver(ads.driverType, ads.capture, ads.playback, ads.cardDevice) < 0) {
                 set_parameters(m_fallBackSetup);
 		return;
@@ -387,6 +414,9 @@ void AudioDevice::set_parameters(AudioDeviceSetup ads)
 		}
 	}
 
+        // The buses and driver buffers exist now, lock them
+        m_rtMemory->prepare();
+
 	emit started();
 }
 
@@ -515,9 +545,11 @@ int AudioDevice::shutdown( )
 
                 QList<AudioChannel*> channels = m_driver->get_capture_channels();
                 channels.append(m_driver->get_playback_channels());
+                m_channelMutex.lock();
                 foreach(AudioChannel* chan, channels) {
                         m_channels.removeAll(chan);
                 }
+                m_channelMutex.unlock();
 
                 delete m_driver;
                 m_driver = 0;
@@ -641,17 +673,26 @@ AudioChannel* AudioDevice::get_playback_channel_by_name(const QString &name)
         return m_driver->get_playback_channel_by_name(name);
 }
 
+/**
+ * Creates an AudioChannel with a buffer from the TBufferArena. Not real time safe,
+ * but can be called from any other thread, like the export threads do.
+ */
 AudioChannel* AudioDevice::create_channel(const QString& name, int channelNumber, int type)
 {
+        QMutexLocker locker(&m_channelMutex);
+
         AudioChannel* chan = new AudioChannel(name, channelNumber, type);
-        chan->set_buffer_size(m_bufferSize);
+        m_bufferArena->add_channel(chan);
         m_channels.append(chan);
         return chan;
 }
 
 void AudioDevice::delete_channel(AudioChannel* channel)
 {
+        QMutexLocker locker(&m_channelMutex);
+
         m_channels.removeAll(channel);
+        m_bufferArena->remove_channel(channel);
         delete channel;
 }
 
@@ -729,6 +770,16 @@ QString AudioDevice::get_driver_information() const
  * 
  * @return The cpu load, call this at least 1 time per second to keep data consistent 
  */
+/**
+ * Returns the page faults in the audio thread since the previous call, and the
+ * number of cycles they occured in. Only counted with Hardware/CountPageFaults,
+ * on systems that report the usage per thread.
+ */
+void AudioDevice::get_page_faults(int& minor, int& major, int& cycles)
+{
+        m_rtMemory->get_page_faults(minor, major, cycles);
+}
+
 trav_time_t AudioDevice::get_cpu_time( )
 {
 #if defined (JACK_SUPPORT)
@@ -763,6 +814,7 @@ trav_time_t AudioDevice::get_cpu_time( )
 void AudioDevice::post_process( )
 {
 	tsar().process_events();
+	meterbus().publish();
 
         apill_foreach(TAudioDeviceClient* client, TAudioDeviceClient, m_clients) {
                 if (client->wants_to_be_disconnected_from_audiodevice()) {
@@ -828,6 +880,8 @@ void AudioDevice::audiothread_finished()
 
 void AudioDevice::xrun( )
 {
+        TRACE_XRUN();
+
 	RT_THREAD_EMIT(this, NULL, bufferUnderRun());
 	
 	m_xrunCount++;
@@ -882,6 +936,9 @@ int AudioDevice::transport_control(transport_state_t state)
 
 void AudioDevice::transport_start(TAudioDeviceClient * client)
 {
+        // Lock what was allocated since the driver started, if that isn't done automatically
+        m_rtMemory->relock();
+
 #if defined (JACK_SUPPORT)
 	JackDriver* jackdriver = slaved_jack_driver();
 	if (jackdriver) {
@@ -30,6 +30,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QByteArray>
 #include <QTimer>
 #include <QVariant>
+#include <QMutex>
 
 
 #include "RingBufferNPT.h"
@@ -41,6 +42,8 @@ class TAudioDriver;
 class TAudioDeviceClient;
 class AudioChannel;
 class AudioBus;
+class TBufferArena;
+class TRTMemoryPolicy;
 #if defined (JACK_SUPPORT)
 class JackDriver;
 #endif
@@ -81,6 +84,7 @@ public:
         AudioChannel* get_capture_channel_by_name(const QString& name);
 
         void delete_channel(AudioChannel* channel);
+        TBufferArena* get_buffer_arena() const {return m_bufferArena;}
 
         void set_master_out_bus(AudioBus* bus);
         void send_to_master_out(AudioChannel* channel, nframes_t nframes);
@@ -121,6 +125,7 @@ public:
 	int shutdown();
 	
 	trav_time_t get_cpu_time();
+        void get_page_faults(int& minor, int& major, int& cycles);
 
 
 private:
@@ -147,6 +152,9 @@ private:
         AudioDeviceThread* 	m_audioThread;
         APILinkedList		m_clients;
         QList<AudioChannel* >   m_channels;
+        QMutex                  m_channelMutex;
+        TBufferArena*           m_bufferArena;
+        TRTMemoryPolicy*        m_rtMemory;
         QList<BusConfig>        m_busConfigs;
         QList<ChannelConfig>    m_channelConfigs;
         QStringList		m_availableDrivers;
@@ -159,6 +167,7 @@ private:
 
 	RingBufferNPT<trav_time_t>*	m_cpuTime;
 	volatile size_t		m_runAudioThread;
+        volatile size_t		m_stackReserved;
 	trav_time_t		m_cycleStartTime;
 	trav_time_t		m_lastCpuReadTime;
 	uint 			m_bufferSize;
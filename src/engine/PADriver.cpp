@@ -57,13 +57,11 @@ int PADriver::_read(nframes_t nframes)
 		return 0;
 	}
 
-        int index = 0;
-        for(nframes_t i=0; i<nframes; i++) {
-                for (int chan=0; chan<m_captureChannels.size(); chan++) {
-                        AudioChannel* channel = m_captureChannels.at(chan);
-                        audio_sample_t* buf = channel->get_buffer(nframes);
-                        buf[i] = in[index++];
-                }
+        unsigned long skip = m_captureChannels.size() * sizeof(float);
+
+        for (int chan=0; chan<m_captureChannels.size(); chan++) {
+                audio_sample_t* buf = m_captureChannels.at(chan)->get_buffer(nframes);
+                MemOps::sample_move_dS_s32f(buf, (char*)(in + chan), nframes, skip);
         }
 
 	return 1;
@@ -78,11 +76,11 @@ int PADriver::_write(nframes_t nframes)
         float* out = (float*) m_paOutputBuffer;
 
 
-        int index = 0;
-        for(nframes_t i=0; i<nframes; i++) {
-                for (int chan=0; chan<m_playbackChannels.size(); chan++) {
-                        out[index++] = m_playbackChannels.at(chan)->get_buffer(nframes)[i];
-                }
+        unsigned long skip = m_playbackChannels.size() * sizeof(float);
+
+        for (int chan=0; chan<m_playbackChannels.size(); chan++) {
+                audio_sample_t* buf = m_playbackChannels.at(chan)->get_buffer(nframes);
+                MemOps::sample_move_d32f_sS((char*)(out + chan), buf, nframes, skip, 0);
         }
 	
         for (int chan=0; chan<m_playbackChannels.size(); chan++) {
@@ -0,0 +1,255 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TBufferArena.h"
+
+#include "AudioChannel.h"
+
+#include <QMutexLocker>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef USE_MLOCK
+#include <sys/mman.h>
+#endif /* USE_MLOCK */
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+/**
+ * \class TBufferArena
+ * \brief Holds the buffers of all AudioChannels in a few large, locked memory blocks
+ *
+ * Every AudioChannel buffer starts at a 64 byte (cache line) boundary, so the mixing
+ * routines can rely on aligned buffers, and the buffers that are used in one audio cycle
+ * are close to each other in memory instead of being scattered over the heap.
+ *
+ * set_buffer_size() lays out all buffers in one block, in the order the AudioChannels
+ * were created. Channels added later get a free slot, or a new block when there is none,
+ * existing buffers are never moved by add_channel() so the audio thread can keep using them.
+ * set_buffer_size() however moves all buffers and may only be called while the audio
+ * driver isn't processing, which is the case when the AudioDevice changes the buffer size.
+ * AudioChannels that need a larger buffer for a while, like the Sheet buses during export,
+ * get a separate buffer from resize_channel().
+ *
+ * Blocks of 2 MB or more are aligned to, and advised to be backed by, huge pages
+ * where the system supports it.
+ *
+ * The arena is protected by a mutex, so non real time threads like the parallel
+ * export threads can create and resize their own AudioChannels.
+ */
+
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+TBufferArena::TBufferArena()
+        : m_mutex(QMutex::Recursive)
+{
+        m_bufferSize = 0;
+        m_slotSize = 0;
+}
+
+TBufferArena::~TBufferArena()
+{
+        free_blocks();
+}
+
+/**
+ * Assigns a buffer to \a channel. Not real time safe, but the buffers of the other
+ * AudioChannels stay where they are.
+ */
+void TBufferArena::add_channel(AudioChannel* channel)
+{
+        QMutexLocker locker(&m_mutex);
+
+        Q_ASSERT(!m_slots.contains(channel));
+        Q_ASSERT(m_slotSize);
+
+        if (m_freeSlots.isEmpty()) {
+                add_block(qMax(16, m_slots.size() / 2));
+        }
+
+        if (m_freeSlots.isEmpty()) {
+                channel->set_buffer(0, 0);
+                return;
+        }
+
+        audio_sample_t* buffer = m_freeSlots.takeFirst();
+        m_slots.insert(channel, buffer);
+        channel->set_buffer(buffer, m_bufferSize);
+}
+
+void TBufferArena::remove_channel(AudioChannel* channel)
+{
+        QMutexLocker locker(&m_mutex);
+
+        release_oversized(channel);
+
+        audio_sample_t* buffer = m_slots.take(channel);
+        if (buffer) {
+                m_freeSlots.prepend(buffer);
+        }
+        channel->set_buffer(0, 0);
+}
+
+/**
+ * Changes the buffer size of \a channel only, for example to process larger blocks
+ * during export. The buffer stays in place when \a size fits in the slot of
+ * \a channel, else it gets a separate buffer until it fits in its slot again.
+ * Not real time safe, \a channel must not be in use by the audio thread!
+ */
+void TBufferArena::resize_channel(AudioChannel* channel, nframes_t size)
+{
+        QMutexLocker locker(&m_mutex);
+
+        if (!m_slots.contains(channel)) {
+                return;
+        }
+
+        release_oversized(channel);
+
+        if (size * sizeof(audio_sample_t) <= m_slotSize) {
+                channel->set_buffer(m_slots.value(channel), size);
+                return;
+        }
+
+        Block block;
+        if (!allocate_block(block, size * sizeof(audio_sample_t))) {
+                channel->set_buffer(m_slots.value(channel), m_bufferSize);
+                return;
+        }
+
+        m_oversized.insert(channel, block);
+        channel->set_buffer((audio_sample_t*) block.start, size);
+}
+
+/**
+ * Frees all blocks and lays out the buffers of \a channels, which must contain all
+ * the AudioChannels known to this arena, in one new block.
+ * The audio thread must not be processing when calling this function!
+ */
+void TBufferArena::set_buffer_size(nframes_t size, const QList<AudioChannel*>& channels)
+{
+        QMutexLocker locker(&m_mutex);
+
+        free_blocks();
+        m_freeSlots.clear();
+        m_slots.clear();
+
+        m_bufferSize = size;
+        m_slotSize = ((size * sizeof(audio_sample_t) + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+
+        // leave room for the channels of a few new tracks
+        add_block(channels.size() + 16);
+
+        foreach(AudioChannel* channel, channels) {
+                add_channel(channel);
+        }
+}
+
+bool TBufferArena::allocate_block(Block& block, size_t size)
+{
+        block.size = ((size + ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+        block.locked = false;
+
+        size_t alignment = block.size >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : ALIGNMENT;
+
+#ifdef NO_POSIX_MEMALIGN
+        block.memory = (char*) malloc(block.size + alignment);
+        block.start = (char*) (((size_t) block.memory + alignment - 1) & ~(alignment - 1));
+#else
+        if (posix_memalign((void**) &block.memory, alignment, block.size) != 0) {
+                block.memory = 0;
+        }
+        block.start = block.memory;
+#endif
+        if (!block.memory) {
+                PERROR("TBufferArena: could not allocate %d bytes", (int)block.size);
+                return false;
+        }
+
+#if defined (USE_MLOCK) && defined (MADV_HUGEPAGE)
+        if (alignment == HUGE_PAGE_SIZE) {
+                madvise(block.start, block.size, MADV_HUGEPAGE);
+        }
+#endif
+
+        memset(block.start, 0, block.size);
+
+#ifdef USE_MLOCK
+        if (mlock(block.start, block.size) == -1) {
+                PERROR("Couldn't lock buffer into memory");
+        } else {
+                block.locked = true;
+        }
+#endif /* USE_MLOCK */
+
+        return true;
+}
+
+void TBufferArena::free_block(Block& block)
+{
+#ifdef USE_MLOCK
+        if (block.locked) {
+                munlock(block.start, block.size);
+        }
+#endif /* USE_MLOCK */
+        free(block.memory);
+}
+
+void TBufferArena::add_block(int slotCount)
+{
+        Block block;
+        if (!allocate_block(block, slotCount * m_slotSize)) {
+                return;
+        }
+
+        for (int i=0; i<slotCount; ++i) {
+                m_freeSlots.append((audio_sample_t*) (block.start + i * m_slotSize));
+        }
+
+        m_blocks.append(block);
+}
+
+void TBufferArena::free_blocks()
+{
+        for (int i=0; i<m_blocks.size(); ++i) {
+                free_block(m_blocks[i]);
+        }
+        m_blocks.clear();
+
+        QList<AudioChannel*> oversized = m_oversized.keys();
+        foreach(AudioChannel* channel, oversized) {
+                release_oversized(channel);
+        }
+}
+
+void TBufferArena::release_oversized(AudioChannel* channel)
+{
+        if (!m_oversized.contains(channel)) {
+                return;
+        }
+
+        Block block = m_oversized.take(channel);
+        free_block(block);
+}
+
+//eof
@@ -0,0 +1,73 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TBUFFER_ARENA_H
+#define TBUFFER_ARENA_H
+
+#include <QList>
+#include <QHash>
+#include <QMutex>
+
+#include "defines.h"
+
+class AudioChannel;
+
+class TBufferArena
+{
+public:
+        TBufferArena();
+        ~TBufferArena();
+
+        static const size_t ALIGNMENT = 64;
+
+        void add_channel(AudioChannel* channel);
+        void remove_channel(AudioChannel* channel);
+        void resize_channel(AudioChannel* channel, nframes_t size);
+        void set_buffer_size(nframes_t size, const QList<AudioChannel*>& channels);
+
+        nframes_t get_buffer_size() const {return m_bufferSize;}
+
+private:
+        struct Block {
+                char*   memory;
+                char*   start;
+                size_t  size;
+                bool    locked;
+        };
+
+        QMutex                                  m_mutex;
+        QList<Block>                            m_blocks;
+        QList<audio_sample_t*>                  m_freeSlots;
+        QHash<AudioChannel*, audio_sample_t*>   m_slots;
+        QHash<AudioChannel*, Block>             m_oversized;
+        nframes_t                               m_bufferSize;
+        size_t                                  m_slotSize;
+
+        bool allocate_block(Block& block, size_t size);
+        void free_block(Block& block);
+        void add_block(int slotCount);
+        void free_blocks();
+        void release_oversized(AudioChannel* channel);
+};
+
+#endif
+
+//eof
@@ -0,0 +1,189 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TMeterBus.h"
+
+#include <QMutexLocker>
+#include <cmath>
+#include <cstring>
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+/**
+ * \class TMeterBus
+ * \brief Lock free snapshot of all peak and rms values measured in the audio thread
+ *
+ * Every VUMonitor owns one slot in the TMeterBus. The audio thread accumulates
+ * the peak and rms data of all slots during a cycle, and publishes them at the end
+ * of the cycle in one go by AudioDevice::post_process(). Publishing is protected by
+ * a sequence counter (seqlock), the audio thread never waits for the GUI.
+ *
+ * The GUI thread calls update_snapshot() at display rate, which copies a consistent
+ * snapshot and emits snapshotUpdated(), so all meters can read their value with
+ * get_value() without touching data written by the audio thread.
+ *
+ * Peak values are held by the audio thread until the GUI has read them, no peaks
+ * get lost when the display rate is lower then the audio cycle rate.
+ *
+ * Rms values are only measured while a meter that shows them called add_rms_user().
+ */
+
+TMeterBus& meterbus()
+{
+        static TMeterBus bus;
+        return bus;
+}
+
+TMeterBus::TMeterBus()
+{
+        memset(m_cyclePeak, 0, sizeof(m_cyclePeak));
+        memset(m_cycleSquares, 0, sizeof(m_cycleSquares));
+        memset(m_cycleFrames, 0, sizeof(m_cycleFrames));
+        memset(m_accumPeak, 0, sizeof(m_accumPeak));
+        memset(m_accumSquares, 0, sizeof(m_accumSquares));
+        memset(m_accumFrames, 0, sizeof(m_accumFrames));
+        memset(m_snapshot, 0, sizeof(m_snapshot));
+        memset(m_guiSnapshot, 0, sizeof(m_guiSnapshot));
+}
+
+TMeterBus::~TMeterBus()
+{
+}
+
+/**
+ * Reserves a slot for a VUMonitor. Not real time safe, call from the GUI thread
+ * or while setting up the AudioDriver. The values a reused slot accumulated for
+ * its previous owner are cleared by the audio thread on the next publish().
+ *
+ * @return The slot index, or -1 if all slots are in use
+ */
+int TMeterBus::acquire_slot()
+{
+        QMutexLocker locker(&m_slotMutex);
+
+        if (!m_freeSlots.isEmpty()) {
+                int slot = m_freeSlots.takeLast();
+                m_guiSnapshot[slot].peak = m_guiSnapshot[slot].rms = 0.0f;
+                m_resetSlot[slot].fetchAndStoreRelease(1);
+                return slot;
+        }
+
+        int slot = m_slotCount.fetchAndAddAcquire(0);
+        if (slot >= MAX_SLOTS) {
+                PERROR("TMeterBus: all %d meter slots are in use!", MAX_SLOTS);
+                return -1;
+        }
+
+        m_slotCount.fetchAndAddRelease(1);
+
+        return slot;
+}
+
+void TMeterBus::release_slot(int slot)
+{
+        if (slot < 0) {
+                return;
+        }
+
+        QMutexLocker locker(&m_slotMutex);
+        m_freeSlots.append(slot);
+}
+
+/**
+ * Called by the AudioDevice at the end of each cycle, moves the values
+ * accumulated during the cycle into the shared snapshot.
+ */
+void TMeterBus::publish()
+{
+        int count = m_slotCount.fetchAndAddAcquire(0);
+        int sequence = m_sequence.fetchAndAddAcquire(0);
+
+        // The GUI read the snapshot we published last time, start
+        // accumulating from scratch, else hold on to the peaks.
+        bool consumed = (m_readSequence.fetchAndAddAcquire(0) == sequence);
+
+        for (int i=0; i<count; ++i) {
+                // Cycle values are cleared on each publish, only the accumulated
+                // values of a reused slot can still hold those of its previous owner
+                if (int(m_resetSlot[i]) && m_resetSlot[i].fetchAndStoreAcquire(0)) {
+                        m_accumPeak[i] = m_accumSquares[i] = 0.0f;
+                        m_accumFrames[i] = 0;
+                }
+
+                if (consumed) {
+                        m_accumPeak[i] = m_cyclePeak[i];
+                        m_accumSquares[i] = m_cycleSquares[i];
+                        m_accumFrames[i] = m_cycleFrames[i];
+                } else {
+                        if (m_cyclePeak[i] > m_accumPeak[i]) {
+                                m_accumPeak[i] = m_cyclePeak[i];
+                        }
+                        m_accumSquares[i] += m_cycleSquares[i];
+                        m_accumFrames[i] += m_cycleFrames[i];
+                }
+
+                m_cyclePeak[i] = m_cycleSquares[i] = 0.0f;
+                m_cycleFrames[i] = 0;
+        }
+
+        // odd sequence number: write in progress
+        m_sequence.fetchAndAddOrdered(1);
+
+        for (int i=0; i<count; ++i) {
+                m_snapshot[i].peak = m_accumPeak[i];
+                m_snapshot[i].rms = m_accumFrames[i] ? sqrtf(m_accumSquares[i] / m_accumFrames[i]) : 0.0f;
+        }
+
+        m_sequence.fetchAndAddOrdered(1);
+}
+
+/**
+ * Copies the last published snapshot into the GUI side buffer and emits
+ * snapshotUpdated(). Call this from the GUI thread at display rate, it is the
+ * only place where the shared snapshot is read.
+ */
+void TMeterBus::update_snapshot()
+{
+        int count = m_slotCount.fetchAndAddAcquire(0);
+
+        // A write only takes a few micro seconds, if we fail to read a consistent
+        // snapshot a couple of times, keep the previous one and try next time.
+        for (int tries=0; tries<4; ++tries) {
+                int before = m_sequence.fetchAndAddAcquire(0);
+                if (before & 1) {
+                        continue;
+                }
+
+                memcpy(m_guiSnapshot, m_snapshot, count * sizeof(MeterValue));
+
+                // Ordered, so the copy can't be moved past this read
+                int after = m_sequence.fetchAndAddOrdered(0);
+                if (before == after) {
+                        m_readSequence.fetchAndStoreRelease(after);
+                        emit snapshotUpdated();
+                        return;
+                }
+        }
+}
+
+//eof
@@ -0,0 +1,119 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TMETERBUS_H
+#define TMETERBUS_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QList>
+
+#include "defines.h"
+
+struct MeterValue {
+        audio_sample_t  peak;
+        audio_sample_t  rms;
+};
+
+class TMeterBus : public QObject
+{
+        Q_OBJECT
+
+public:
+        enum {
+                MAX_SLOTS = 1024
+        };
+
+        int acquire_slot();
+        void release_slot(int slot);
+
+        // GUI thread, for each meter that shows rms values
+        void add_rms_user() {m_rmsUsers.fetchAndAddOrdered(1);}
+        void remove_rms_user() {m_rmsUsers.fetchAndAddOrdered(-1);}
+        // Audio thread, no need for the squares if nobody shows them
+        bool is_rms_enabled() const {return int(m_rmsUsers) > 0;}
+
+        // Audio thread only
+        void process(int slot, audio_sample_t peak, audio_sample_t squares, nframes_t nframes) {
+                if (peak > m_cyclePeak[slot]) {
+                        m_cyclePeak[slot] = peak;
+                }
+                m_cycleSquares[slot] += squares;
+                m_cycleFrames[slot] += nframes;
+        }
+
+        // GUI thread only
+        const MeterValue& get_value(int slot) const {return m_guiSnapshot[slot];}
+
+        void update_snapshot();
+
+private:
+        TMeterBus();
+        ~TMeterBus();
+        TMeterBus(const TMeterBus&);
+
+        // allow this function to create one instance
+        friend TMeterBus& meterbus();
+        // The AudioDevice instance is the _only_ one who
+        // is allowed to call publish() !!
+        friend class AudioDevice;
+
+        // Written by the audio thread during the cycle
+        audio_sample_t  m_cyclePeak[MAX_SLOTS];
+        audio_sample_t  m_cycleSquares[MAX_SLOTS];
+        nframes_t       m_cycleFrames[MAX_SLOTS];
+
+        // Accumulated by the audio thread until the GUI consumed them
+        audio_sample_t  m_accumPeak[MAX_SLOTS];
+        audio_sample_t  m_accumSquares[MAX_SLOTS];
+        nframes_t       m_accumFrames[MAX_SLOTS];
+        // Set for reused slots, the audio thread clears the accumulated values
+        QAtomicInt      m_resetSlot[MAX_SLOTS];
+
+        // Shared, protected by m_sequence
+        MeterValue      m_snapshot[MAX_SLOTS];
+        QAtomicInt      m_sequence;
+        QAtomicInt      m_readSequence;
+        QAtomicInt      m_slotCount;
+        QAtomicInt      m_rmsUsers;
+
+        // GUI thread copy of the last consistent snapshot
+        MeterValue      m_guiSnapshot[MAX_SLOTS];
+        QList<int>      m_freeSlots;
+        QMutex          m_slotMutex;
+
+        void publish();
+
+signals:
+        /**
+         *      Emitted from the GUI thread each time a new consistent
+         *      snapshot has been copied and can be read with get_value()
+         */
+        void snapshotUpdated();
+};
+
+// use this function to access the meter bus
+TMeterBus& meterbus();
+
+#endif
+
+//eof
@@ -0,0 +1,238 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#include "TRTMemoryPolicy.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef USE_MLOCK
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif /* USE_MLOCK */
+
+#if defined (Q_WS_X11) || defined (Q_WS_MAC)
+#include <sys/time.h>
+#include <sys/resource.h>
+#define PAGE_FAULT_COUNTING
+#endif
+
+// Without per thread usage the counts would include the page faults of all
+// threads, the disk and GUI threads fault all the time, don't count at all.
+#if defined (PAGE_FAULT_COUNTING) && !defined (RUSAGE_THREAD)
+#undef PAGE_FAULT_COUNTING
+#endif
+
+#include "defines.h"
+
+// Always put me below _all_ includes, this is needed
+// in case we run with memory leak detection enabled!
+#include "Debugger.h"
+
+/**
+ * \class TRTMemoryPolicy
+ * \brief Keeps the memory used by the audio thread resident, and counts the page faults it still gets
+ *
+ * Locking single buffers (RingBuffer::mlock_buffer(), TBufferArena) leaves the DecodeBuffers,
+ * plugin instances, clips and everything else the audio thread touches pageable. After the
+ * machine has been idle for a while, the first cycle that touches such a page faults,
+ * which shows up as a random xrun.
+ *
+ * When memory locking is enabled (config key Hardware/LockMemory, off by default), prepare()
+ * locks all mapped memory of the process with mlockall(), which also faults in every page.
+ * AudioDevice calls it once the driver started, it does nothing after the first successful
+ * call. Future mappings are locked as well when the locked memory limit allows it. Otherwise
+ * AudioDevice calls relock() at each transport start, which locks the memory allocated since,
+ * like the buffers of clips added after the driver started. A failure to lock is reported once.
+ *
+ * reserve_stack() faults in the stack of the audio thread, before it's first cycle.
+ *
+ * With Hardware/CountPageFaults (off by default) the minor and major page faults of the audio
+ * thread are counted for each cycle with getrusage(RUSAGE_THREAD), the DSP load display shows
+ * them. Where per thread usage isn't available nothing is counted, the process wide counts
+ * would blame the audio thread for the page faults of all other threads.
+ */
+
+// Stack pre-faulted for the audio thread
+static const int RT_STACK_RESERVE = 128 * 1024;
+
+
+TRTMemoryPolicy::TRTMemoryPolicy()
+        : m_lockMemory(false)
+        , m_countPageFaults(false)
+        , m_locked(false)
+        , m_lockedFuture(false)
+        , m_warned(false)
+        , m_cycleMinorFaults(0)
+        , m_cycleMajorFaults(0)
+{
+}
+
+TRTMemoryPolicy::~TRTMemoryPolicy()
+{
+#ifdef USE_MLOCK
+        if (m_lockMemory) {
+                munlockall();
+        }
+#endif /* USE_MLOCK */
+}
+
+/**
+ * Changes the policy, only call this while the audio thread isn't running.
+ */
+void TRTMemoryPolicy::set_policy(bool lockMemory, bool countPageFaults)
+{
+#ifdef USE_MLOCK
+        if (m_lockMemory && !lockMemory) {
+                munlockall();
+                m_locked = m_lockedFuture = false;
+        }
+#endif /* USE_MLOCK */
+
+#if !defined (PAGE_FAULT_COUNTING)
+        if (countPageFaults && !m_countPageFaults) {
+                PWARN("RT memory: counting page faults per thread is not supported on this system");
+        }
+#endif
+
+        m_lockMemory = lockMemory;
+        m_countPageFaults = countPageFaults;
+}
+
+/**
+ * Locks and pre-faults the memory the audio thread can reach, when enabled.
+ * This is not a real time operation.
+ */
+void TRTMemoryPolicy::prepare()
+{
+        if (m_lockMemory) {
+                lock_memory();
+        }
+}
+
+/**
+ * Locks the memory mapped since prepare(), when enabled and future mappings
+ * couldn't be locked. Not a real time operation, call it from the GUI thread.
+ */
+void TRTMemoryPolicy::relock()
+{
+#ifdef USE_MLOCK
+        if (!m_lockMemory || !m_locked || m_lockedFuture) {
+                return;
+        }
+
+        if (mlockall(MCL_CURRENT)) {
+                PWARN("RT memory: could not lock memory (%s)", strerror(errno));
+        }
+#endif /* USE_MLOCK */
+}
+
+void TRTMemoryPolicy::lock_memory()
+{
+#ifdef USE_MLOCK
+        if (m_locked) {
+                return;
+        }
+
+        // Locking future mappings beyond the limit makes allocations fail,
+        // only do that when the limit is high enough to never be reached.
+        struct rlimit limit;
+        bool unlimited = (getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur == RLIM_INFINITY);
+
+        if (unlimited && mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+                m_locked = m_lockedFuture = true;
+                PMESG("RT memory: locked all current and future memory");
+                return;
+        }
+
+        if (mlockall(MCL_CURRENT) == 0) {
+                m_locked = true;
+                PMESG("RT memory: locked all current memory");
+                return;
+        }
+
+        if (m_warned) {
+                return;
+        }
+        m_warned = true;
+
+        PWARN("RT memory: could not lock memory (%s), raise the locked memory limit to avoid page faults in the audio thread", strerror(errno));
+#endif /* USE_MLOCK */
+}
+
+/**
+ * Touches RT_STACK_RESERVE bytes of the calling thread's stack, so
+ * growing the stack later on doesn't fault.
+ */
+void TRTMemoryPolicy::reserve_stack()
+{
+        volatile char stack[RT_STACK_RESERVE];
+        for (int i=0; i<RT_STACK_RESERVE; i+=1024) {
+                stack[i] = 0;
+        }
+}
+
+void TRTMemoryPolicy::cycle_start()
+{
+#if defined (PAGE_FAULT_COUNTING)
+        if (!m_countPageFaults) {
+                return;
+        }
+
+        struct rusage usage;
+        getrusage(RUSAGE_THREAD, &usage);
+        m_cycleMinorFaults = usage.ru_minflt;
+        m_cycleMajorFaults = usage.ru_majflt;
+#endif
+}
+
+void TRTMemoryPolicy::cycle_end()
+{
+#if defined (PAGE_FAULT_COUNTING)
+        if (!m_countPageFaults) {
+                return;
+        }
+
+        struct rusage usage;
+        getrusage(RUSAGE_THREAD, &usage);
+        int minor = int(usage.ru_minflt - m_cycleMinorFaults);
+        int major = int(usage.ru_majflt - m_cycleMajorFaults);
+
+        if (minor || major) {
+                m_minorFaults.fetchAndAddRelaxed(minor);
+                m_majorFaults.fetchAndAddRelaxed(major);
+                m_faultingCycles.fetchAndAddRelaxed(1);
+        }
+#endif
+}
+
+/**
+ * Returns the page faults of the audio thread since the previous call,
+ * and the number of cycles in which they occured.
+ */
+void TRTMemoryPolicy::get_page_faults(int& minor, int& major, int& cycles)
+{
+        minor = m_minorFaults.fetchAndStoreRelaxed(0);
+        major = m_majorFaults.fetchAndStoreRelaxed(0);
+        cycles = m_faultingCycles.fetchAndStoreRelaxed(0);
+}
+
+//eof
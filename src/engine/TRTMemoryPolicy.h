@@ -0,0 +1,64 @@
+/*
+Copyright (C) 2010 Remon Sijrier
+
+This file is part of Traverso
+
+Traverso is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
+
+*/
+
+#ifndef TRT_MEMORY_POLICY_H
+#define TRT_MEMORY_POLICY_H
+
+#include <QAtomicInt>
+
+class TRTMemoryPolicy
+{
+public:
+        TRTMemoryPolicy();
+        ~TRTMemoryPolicy();
+
+        // GUI thread
+        void set_policy(bool lockMemory, bool countPageFaults);
+        void prepare();
+        void relock();
+        void get_page_faults(int& minor, int& major, int& cycles);
+
+        // Audio thread only
+        void reserve_stack();
+        void cycle_start();
+        void cycle_end();
+
+private:
+        bool            m_lockMemory;
+        bool            m_countPageFaults;
+        bool            m_locked;
+        bool            m_lockedFuture;
+        bool            m_warned;
+
+        // Audio thread only
+        long            m_cycleMinorFaults;
+        long            m_cycleMajorFaults;
+
+        QAtomicInt      m_minorFaults;
+        QAtomicInt      m_majorFaults;
+        QAtomicInt      m_faultingCycles;
+
+        void lock_memory();
+};
+
+#endif
+
+//eof
@@ -33,6 +33,10 @@
 
 #include <memops.h> 
 
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (USE_XMMINTRIN) && defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #define SAMPLE_MAX_24BIT  8388608.0f
 #define SAMPLE_MAX_16BIT  32768.0f
 
@@ -46,6 +50,23 @@ inline unsigned int fast_rand() {
 	return seed;
 } 
 
+MemOps::write_function_t MemOps::sample_move_d32u24_sS = ::sample_move_d32u24_sS;
+MemOps::write_function_t MemOps::sample_move_d24_sS = ::sample_move_d24_sS;
+MemOps::write_function_t MemOps::sample_move_d16_sS = ::sample_move_d16_sS;
+MemOps::write_function_t MemOps::sample_move_dither_rect_d32u24_sS = ::sample_move_dither_rect_d32u24_sS;
+MemOps::write_function_t MemOps::sample_move_dither_tri_d32u24_sS = ::sample_move_dither_tri_d32u24_sS;
+MemOps::write_function_t MemOps::sample_move_dither_rect_d24_sS = ::sample_move_dither_rect_d24_sS;
+MemOps::write_function_t MemOps::sample_move_dither_tri_d24_sS = ::sample_move_dither_tri_d24_sS;
+MemOps::write_function_t MemOps::sample_move_dither_rect_d16_sS = ::sample_move_dither_rect_d16_sS;
+MemOps::write_function_t MemOps::sample_move_dither_tri_d16_sS = ::sample_move_dither_tri_d16_sS;
+
+MemOps::read_function_t MemOps::sample_move_dS_s32u24 = ::sample_move_dS_s32u24;
+MemOps::read_function_t MemOps::sample_move_dS_s24 = ::sample_move_dS_s24;
+MemOps::read_function_t MemOps::sample_move_dS_s16 = ::sample_move_dS_s16;
+
+MemOps::write_function_t MemOps::sample_move_d32f_sS = ::sample_move_d32f_sS;
+MemOps::read_function_t MemOps::sample_move_dS_s32f = ::sample_move_dS_s32f;
+
 void sample_move_d32u24_sSs (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
 
 {
@@ -1022,6 +1043,28 @@ void sample_move_dS_s16 (audio_sample_t *dst, char *src, unsigned long nsamples,
 	}
 }	
 
+/* 32 bit float, as used by PortAudio, only needs (de)interleaving */
+
+void sample_move_d32f_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *)
+
+{
+	while (nsamples--) {
+		*((float *) dst) = *src;
+		dst += dst_skip;
+		src++;
+	}
+}
+
+void sample_move_dS_s32f (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip)
+
+{
+	while (nsamples--) {
+		*dst = *((float *) src);
+		dst++;
+		src += src_skip;
+	}
+}
+
 void sample_merge_d16_sS (char *dst,  audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *)
 {
 	short val;
@@ -1203,3 +1246,382 @@ memcpy_interleave_d32_s32 (char *dst, char *src, unsigned long src_bytes,
 		src_bytes -= 4;
 	}
 }
+
+
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (USE_XMMINTRIN) && defined (__SSE2__)
+
+/* SSE2 versions of the native byte order conversions. They convert 4 samples
+   at a time and leave the remaining samples to the generic versions above.
+   The results are identical to the generic versions, except for the dither
+   noise, which is taken from 4 interleaved streams of the same generator. */
+
+static unsigned int sse2_rand_seed[4] = {2307294737u, 2782722032u, 4209412123u, 4083925506u};
+
+/* fast_rand() advanced by 4 steps in each lane: seed * a^4 + c * (a^3 + a^2 + a + 1) */
+static inline __m128i
+sse2_fast_rand (__m128i& seed)
+{
+	const __m128i mul = _mm_set1_epi32(1292206641);
+	const __m128i add = _mm_set1_epi32(524322964);
+
+	__m128i even = _mm_mul_epu32(seed, mul);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(seed, 32), mul);
+	seed = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+	seed = _mm_add_epi32(seed, add);
+
+	return seed;
+}
+
+/* (float)fast_rand() * scale, fast_rand() is unsigned, so convert half of it */
+static inline __m128
+sse2_rand_float (__m128i& seed, float scale)
+{
+	return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(sse2_fast_rand(seed), 1)), _mm_set1_ps(2.0f * scale));
+}
+
+/* t << shift, where t is clamped to limit at most, and t == limit
+   doesn't fit after shifting, so it becomes max */
+static inline __m128i
+sse2_shift_saturate (__m128i t, int limit, int shift, int max)
+{
+	__m128i over = _mm_cmpeq_epi32(t, _mm_set1_epi32(limit));
+	__m128i y = _mm_sll_epi32(t, _mm_cvtsi32_si128(shift));
+
+	return _mm_or_si128(_mm_andnot_si128(over, y), _mm_and_si128(over, _mm_set1_epi32(max)));
+}
+
+static inline __m128
+sse2_clamp (__m128 x, float min, float max)
+{
+	return _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(min)), _mm_set1_ps(max));
+}
+
+static inline void
+sse2_store_d32 (char *dst, __m128i y, unsigned long dst_skip)
+{
+	if (dst_skip == 4) {
+		_mm_storeu_si128((__m128i *) dst, y);
+		return;
+	}
+
+	int tmp[4];
+	_mm_storeu_si128((__m128i *) tmp, y);
+	for (int i = 0; i < 4; ++i) {
+		*((int *) dst) = tmp[i];
+		dst += dst_skip;
+	}
+}
+
+static inline void
+sse2_store_d24 (char *dst, __m128i y, unsigned long dst_skip)
+{
+	int tmp[4];
+	_mm_storeu_si128((__m128i *) tmp, y);
+	for (int i = 0; i < 4; ++i) {
+		memcpy (dst, &tmp[i], 3);
+		dst += dst_skip;
+	}
+}
+
+static inline void
+sse2_store_d16 (char *dst, __m128i y, unsigned long dst_skip)
+{
+	__m128i s = _mm_packs_epi32(y, y);
+
+	if (dst_skip == 2) {
+		_mm_storel_epi64((__m128i *) dst, s);
+		return;
+	}
+
+	short tmp[8];
+	_mm_storeu_si128((__m128i *) tmp, s);
+	for (int i = 0; i < 4; ++i) {
+		*((short *) dst) = tmp[i];
+		dst += dst_skip;
+	}
+}
+
+/* The triangular dither noise r - rm1 for 4 samples, rm1 holds the
+   last r of the previous 4 samples in all lanes */
+static inline __m128
+sse2_tri_noise (__m128i& seed, __m128& rm1)
+{
+	__m128 r = _mm_sub_ps(sse2_rand_float(seed, 2.0f / (float)INT_MAX), _mm_set1_ps(1.0f));
+	__m128 prev = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(r), 4));
+	prev = _mm_move_ss(prev, rm1);
+	rm1 = _mm_shuffle_ps(r, r, _MM_SHUFFLE(3,3,3,3));
+
+	return _mm_sub_ps(r, prev);
+}
+
+void x86_sse2_sample_move_d32u24_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+
+{
+	const __m128 scale = _mm_set1_ps(SAMPLE_MAX_24BIT);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = sse2_clamp(_mm_mul_ps(_mm_loadu_ps(src), scale), -SAMPLE_MAX_24BIT, SAMPLE_MAX_24BIT);
+		__m128i y = sse2_shift_saturate(_mm_cvttps_epi32(x), 8388608, 8, INT_MAX);
+		sse2_store_d32(dst, y, dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	sample_move_d32u24_sS(dst, src, nsamples, dst_skip, state);
+}
+
+void x86_sse2_sample_move_dither_rect_d32u24_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+
+{
+	const __m128 scale = _mm_set1_ps(SAMPLE_MAX_16BIT);
+	__m128i seed = _mm_loadu_si128((__m128i *) sse2_rand_seed);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), scale);
+		x = _mm_sub_ps(x, sse2_rand_float(seed, 1.0f / (float)INT_MAX));
+		x = sse2_clamp(x, -SAMPLE_MAX_16BIT, SAMPLE_MAX_16BIT);
+		__m128i y = sse2_shift_saturate(_mm_cvtps_epi32(x), 32768, 16, INT_MAX);
+		sse2_store_d32(dst, y, dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	_mm_storeu_si128((__m128i *) sse2_rand_seed, seed);
+
+	sample_move_dither_rect_d32u24_sS(dst, src, nsamples, dst_skip, state);
+}
+
+void x86_sse2_sample_move_dither_tri_d32u24_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+
+{
+	const __m128 scale = _mm_set1_ps(SAMPLE_MAX_16BIT);
+	__m128i seed = _mm_loadu_si128((__m128i *) sse2_rand_seed);
+	__m128 rm1 = _mm_set1_ps(state->rm1);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), scale);
+		x = _mm_add_ps(x, sse2_tri_noise(seed, rm1));
+		x = sse2_clamp(x, -SAMPLE_MAX_16BIT, SAMPLE_MAX_16BIT);
+		__m128i y = sse2_shift_saturate(_mm_cvtps_epi32(x), 32768, 16, INT_MAX);
+		sse2_store_d32(dst, y, dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	_mm_storeu_si128((__m128i *) sse2_rand_seed, seed);
+	_mm_store_ss(&state->rm1, rm1);
+
+	sample_move_dither_tri_d32u24_sS(dst, src, nsamples, dst_skip, state);
+}
+
+void x86_sse2_sample_move_d24_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+
+{
+	const __m128 scale = _mm_set1_ps(SAMPLE_MAX_24BIT);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = sse2_clamp(_mm_mul_ps(_mm_loadu_ps(src), scale), -SAMPLE_MAX_24BIT, SAMPLE_MAX_24BIT - 1.0f);
+		sse2_store_d24(dst, _mm_cvttps_epi32(x), dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	sample_move_d24_sS(dst, src, nsamples, dst_skip, state);
+}
+
+void x86_sse2_sample_move_dither_rect_d24_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+
+{
+	const __m128 scale = _mm_set1_ps(SAMPLE_MAX_16BIT);
+	__m128i seed = _mm_loadu_si128((__m128i *) sse2_rand_seed);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), scale);
+		x = _mm_sub_ps(x, sse2_rand_float(seed, 1.0f / (float)INT_MAX));
+		x = sse2_clamp(x, -SAMPLE_MAX_16BIT, SAMPLE_MAX_16BIT);
+		__m128i y = sse2_shift_saturate(_mm_cvtps_epi32(x), 32768, 8, INT_MAX >> 8);
+		sse2_store_d24(dst, y, dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	_mm_storeu_si128((__m128i *) sse2_rand_seed, seed);
+
+	sample_move_dither_rect_d24_sS(dst, src, nsamples, dst_skip, state);
+}
+
+void x86_sse2_sample_move_dither_tri_d24_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+
+{
+	const __m128 scale = _mm_set1_ps(SAMPLE_MAX_16BIT);
+	__m128i seed = _mm_loadu_si128((__m128i *) sse2_rand_seed);
+	__m128 rm1 = _mm_set1_ps(state->rm1);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), scale);
+		x = _mm_add_ps(x, sse2_tri_noise(seed, rm1));
+		x = sse2_clamp(x, -SAMPLE_MAX_16BIT, SAMPLE_MAX_16BIT);
+		__m128i y = sse2_shift_saturate(_mm_cvtps_epi32(x), 32768, 8, INT_MAX >> 8);
+		sse2_store_d24(dst, y, dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	_mm_storeu_si128((__m128i *) sse2_rand_seed, seed);
+	_mm_store_ss(&state->rm1, rm1);
+
+	sample_move_dither_tri_d24_sS(dst, src, nsamples, dst_skip, state);
+}
+
+void x86_sse2_sample_move_d16_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+
+{
+	const __m128 scale = _mm_set1_ps(SAMPLE_MAX_16BIT);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = sse2_clamp(_mm_mul_ps(_mm_loadu_ps(src), scale), SHRT_MIN, SHRT_MAX);
+		sse2_store_d16(dst, _mm_cvtps_epi32(x), dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	sample_move_d16_sS(dst, src, nsamples, dst_skip, state);
+}
+
+void x86_sse2_sample_move_dither_rect_d16_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+
+{
+	const __m128 scale = _mm_set1_ps(SAMPLE_MAX_16BIT);
+	__m128i seed = _mm_loadu_si128((__m128i *) sse2_rand_seed);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), scale);
+		x = _mm_sub_ps(x, sse2_rand_float(seed, 1.0f / (float)INT_MAX));
+		x = sse2_clamp(x, SHRT_MIN, SHRT_MAX);
+		sse2_store_d16(dst, _mm_cvtps_epi32(x), dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	_mm_storeu_si128((__m128i *) sse2_rand_seed, seed);
+
+	sample_move_dither_rect_d16_sS(dst, src, nsamples, dst_skip, state);
+}
+
+void x86_sse2_sample_move_dither_tri_d16_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+
+{
+	const __m128 scale = _mm_set1_ps(SAMPLE_MAX_16BIT);
+	__m128i seed = _mm_loadu_si128((__m128i *) sse2_rand_seed);
+	__m128 rm1 = _mm_set1_ps(state->rm1);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(src), scale);
+		x = _mm_add_ps(x, sse2_tri_noise(seed, rm1));
+		x = sse2_clamp(x, SHRT_MIN, SHRT_MAX);
+		sse2_store_d16(dst, _mm_cvtps_epi32(x), dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	_mm_storeu_si128((__m128i *) sse2_rand_seed, seed);
+	_mm_store_ss(&state->rm1, rm1);
+
+	sample_move_dither_tri_d16_sS(dst, src, nsamples, dst_skip, state);
+}
+
+/* The capture conversions divide by a power of two, multiplying
+   by its reciprocal gives the same result */
+
+void x86_sse2_sample_move_dS_s32u24 (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / SAMPLE_MAX_24BIT);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128i x;
+		if (src_skip == 4) {
+			x = _mm_loadu_si128((__m128i *) src);
+		} else {
+			x = _mm_setr_epi32(*((int *) src), *((int *) (src + src_skip)),
+					   *((int *) (src + 2 * src_skip)), *((int *) (src + 3 * src_skip)));
+		}
+		x = _mm_srai_epi32(x, 8);
+		_mm_storeu_ps(dst, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+		dst += 4;
+		src += 4 * src_skip;
+	}
+
+	sample_move_dS_s32u24(dst, src, nsamples, src_skip);
+}
+
+void x86_sse2_sample_move_dS_s24 (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / SAMPLE_MAX_24BIT);
+	int tmp[4];
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		for (int i = 0; i < 4; ++i) {
+			memcpy((char*)&tmp[i] + 1, src, 3);
+			src += src_skip;
+		}
+		__m128i x = _mm_srai_epi32(_mm_loadu_si128((__m128i *) tmp), 8);
+		_mm_storeu_ps(dst, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+		dst += 4;
+	}
+
+	sample_move_dS_s24(dst, src, nsamples, src_skip);
+}
+
+void x86_sse2_sample_move_dS_s16 (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / SAMPLE_MAX_16BIT);
+
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128i x;
+		if (src_skip == 2) {
+			x = _mm_loadl_epi64((__m128i *) src);
+		} else {
+			x = _mm_setr_epi16(*((short *) src), *((short *) (src + src_skip)),
+					   *((short *) (src + 2 * src_skip)), *((short *) (src + 3 * src_skip)), 0, 0, 0, 0);
+		}
+		/* sign extend the 4 shorts to ints */
+		x = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+		_mm_storeu_ps(dst, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+		dst += 4;
+		src += 4 * src_skip;
+	}
+
+	sample_move_dS_s16(dst, src, nsamples, src_skip);
+}
+
+void x86_sse2_sample_move_d32f_sS (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state)
+
+{
+	for (; nsamples >= 4; nsamples -= 4) {
+		sse2_store_d32(dst, _mm_castps_si128(_mm_loadu_ps(src)), dst_skip);
+		dst += 4 * dst_skip;
+		src += 4;
+	}
+
+	sample_move_d32f_sS(dst, src, nsamples, dst_skip, state);
+}
+
+void x86_sse2_sample_move_dS_s32f (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip)
+{
+	for (; nsamples >= 4; nsamples -= 4) {
+		__m128 x;
+		if (src_skip == 4) {
+			x = _mm_loadu_ps((float *) src);
+		} else {
+			x = _mm_setr_ps(*((float *) src), *((float *) (src + src_skip)),
+					*((float *) (src + 2 * src_skip)), *((float *) (src + 3 * src_skip)));
+		}
+		_mm_storeu_ps(dst, x);
+		dst += 4;
+		src += 4 * src_skip;
+	}
+
+	sample_move_dS_s32f(dst, src, nsamples, src_skip);
+}
+
+#endif
@@ -75,9 +75,59 @@ void sample_move_dS_s24s             (audio_sample_t *dst, char *src, unsigned l
 void sample_move_dS_s16              (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip);
 void sample_move_dS_s16s             (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip);
 
+void sample_move_d32f_sS             (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void sample_move_dS_s32f             (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip);
+
 void sample_merge_d16_sS             (char *dst,  audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
 void sample_merge_d32u24_sS          (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
 
+#if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (USE_XMMINTRIN) && defined (__SSE2__)
+void x86_sse2_sample_move_d32u24_sS              (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_d24_sS                 (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_d16_sS                 (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_dither_rect_d32u24_sS  (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_dither_tri_d32u24_sS   (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_dither_rect_d24_sS     (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_dither_tri_d24_sS      (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_dither_rect_d16_sS     (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_dither_tri_d16_sS      (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+
+void x86_sse2_sample_move_dS_s32u24              (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip);
+void x86_sse2_sample_move_dS_s24                 (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip);
+void x86_sse2_sample_move_dS_s16                 (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip);
+
+void x86_sse2_sample_move_d32f_sS                (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+void x86_sse2_sample_move_dS_s32f                (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip);
+#endif
+
+/* The native byte order conversions used by the audio drivers, the 32 bit float ones
+   by PADriver. They point to the
+   generic versions above, Traverso::init_sse() replaces them with the SIMD versions
+   when the cpu supports them. */
+class MemOps
+{
+public:
+	typedef void (*write_function_t) (char *dst, audio_sample_t *src, unsigned long nsamples, unsigned long dst_skip, dither_state_t *state);
+	typedef void (*read_function_t)  (audio_sample_t *dst, char *src, unsigned long nsamples, unsigned long src_skip);
+
+	static write_function_t sample_move_d32u24_sS;
+	static write_function_t sample_move_d24_sS;
+	static write_function_t sample_move_d16_sS;
+	static write_function_t sample_move_dither_rect_d32u24_sS;
+	static write_function_t sample_move_dither_tri_d32u24_sS;
+	static write_function_t sample_move_dither_rect_d24_sS;
+	static write_function_t sample_move_dither_tri_d24_sS;
+	static write_function_t sample_move_dither_rect_d16_sS;
+	static write_function_t sample_move_dither_tri_d16_sS;
+
+	static read_function_t sample_move_dS_s32u24;
+	static read_function_t sample_move_dS_s24;
+	static read_function_t sample_move_dS_s16;
+
+	static write_function_t sample_move_d32f_sS;
+	static read_function_t sample_move_dS_s32f;
+};
+
 static __inline__ void
 sample_merge (audio_sample_t *dst, audio_sample_t *src, unsigned long cnt)
 
@@ -22,7 +22,9 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "Plugin.h"
 
 #include "AddRemove.h"
+#include "AudioDevice.h"
 #include "Curve.h"
+#include "TConfig.h"
 #include "TSession.h"
 #include "Sheet.h"
 
@@ -33,6 +35,11 @@ Plugin::Plugin(TSession* session)
         , m_session(session)
 {
 	m_bypass = false;
+	m_autoBypassedCycles = 0;
+
+	// A negative tail disables auto bypassing
+	double tail = config().get_property("Plugins", "AutoBypassTail", 2.0).toDouble();
+	m_tail = tail < 0 ? TimeRef(qint64(-1)) : TimeRef(tail * UNIVERSAL_SAMPLE_RATE);
 }
 
 QDomNode Plugin::get_state(QDomDocument doc)
@@ -85,6 +92,34 @@ TCommand* Plugin::toggle_bypass( )
 	return (TCommand*) 0;
 }
 
+/**
+ * Called by the PluginChain in the audio processing thread before running this
+ * Plugin. Once the input has been silent for longer then the tail of the Plugin,
+ * running it would only produce silence, so the cycle can be skipped.
+ *
+ * Plugins without audio inputs (generators, analysers) are never auto bypassed.
+ *
+ * @param silentInput true if the input buffers only contain zero's
+ * @param nframes The buffer size of this cycle
+ * @return true if processing this cycle can be skipped
+ */
+bool Plugin::skip_silent_cycle(bool silentInput, nframes_t nframes)
+{
+	if (!silentInput || m_audioInputPorts.isEmpty() || m_tail < TimeRef()) {
+		m_silentTime = TimeRef();
+		return false;
+	}
+
+	if (m_silentTime <= m_tail) {
+		m_silentTime.add_frames(nframes, audiodevice().get_sample_rate());
+		return false;
+	}
+
+	++m_autoBypassedCycles;
+
+	return true;
+}
+
 PluginControlPort* Plugin::get_control_port_by_index(int index) const
 {
 	foreach(PluginControlPort* port, m_controlPorts) {
@@ -222,6 +257,7 @@ QString PluginControlPort::get_symbol()
 void PluginControlPort::set_control_value(float value)
 {
 	m_value = value;
+	emit controlValueChanged(m_value);
 }
 
 void PluginControlPort::set_use_automation(bool automation)
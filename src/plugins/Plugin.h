@@ -71,6 +71,9 @@ public:
 	bool is_bypassed() const {return m_bypass;}
 	
 	void automate_port(int index, bool automate);
+
+	bool skip_silent_cycle(bool silentInput, nframes_t nframes);
+	qint64 get_auto_bypassed_cycles() const {return m_autoBypassedCycles;}
 	
 protected:
         Plugin*                         m_slave;
@@ -80,6 +83,10 @@ protected:
 	QList<AudioOutputPort* >	m_audioOutputPorts;
 	
 	bool	m_bypass;
+	// Time the Plugin keeps running on silent input before it is auto bypassed
+	TimeRef	m_tail;
+	TimeRef	m_silentTime;
+	qint64	m_autoBypassedCycles;
 	
 	
 signals:
@@ -159,6 +166,9 @@ protected:
 	
 public slots:
 	void set_control_value(float value);
+
+signals:
+	void controlValueChanged(float value);
 };
 
 
@@ -28,9 +28,9 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QDomNode>
 #include "Plugin.h"
 #include "GainEnvelope.h"
+#include "AudioBus.h"
 
 class TSession;
-class AudioBus;
 
 class PluginChain : public ContextItem
 {
@@ -87,13 +87,20 @@ inline int PluginChain::process_post_fader(AudioBus * bus, unsigned long nframes
 		return 0;
 	}
 	
+	int result = 0;
+	
 	for (int i=0; i<m_pluginList.size(); ++i) {
 		Plugin* plugin = m_pluginList.at(i);
 // 		if (plugin == m_fader) continue;
+		// The bus stays silent as long as all Plugins are skipped
+		if (plugin->skip_silent_cycle(bus->is_silent(), nframes)) {
+			continue;
+		}
 		plugin->process(bus, nframes);
+		result = 1;
 	}
 	
-	return 1;
+	return result;
 }
 
 #endif
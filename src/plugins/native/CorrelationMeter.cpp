@@ -41,7 +41,7 @@ CorrelationMeter::CorrelationMeter()
 	: Plugin()
 {
 	// constructs a ringbuffer that can hold 150 CorrelationMeterData structs
-	m_databuffer = new RingBufferNPT<CorrelationMeterData>(RINGBUFFER_SIZE);
+	m_databuffer = new TMultiChannelRingBuffer<CorrelationMeterData>(1, RINGBUFFER_SIZE);
 	
 	// Initialize member variables, that need to be initialized
 	calculate_fract();
@@ -145,16 +145,13 @@ void CorrelationMeter::process(AudioBus* bus, unsigned long nframes)
 	// The ringbuffer::write function acts like it's appending the data
 	// to the end of the buffer.
 	// The amount of CorrelationMeterData structs we want to write is 1, and 
-	// we have to provide a pointer to the data we want to write, which
-	// is done by dereferencing (the & in front of) data.
-	//
-	// This would also have worked (since it's essentially the same):
-	// CorrelationMeterData* datatowrite = &data;
-	// m_databuffer->write(datatowrite, 1);
+	// we have to provide a pointer to the data we want to write for each
+	// channel of the ringbuffer, which has only 1 channel.
 	// 
 	// If we want to write more then 1 CorrelationMeterData struct, we have to 
 	// place them into an array, but well, there's only one now :-)
-	m_databuffer->write(&data, 1);
+	CorrelationMeterData* src = &data;
+	m_databuffer->write(&src, 1);
 }
 
 
@@ -234,9 +231,10 @@ int CorrelationMeter::get_data(float& r, float& direction)
 	} else {
 		m_bufferreadouts = 0;
 
+		CorrelationMeterData* dest = &data;
 		for (int i=0; i<readcount; ++i) {
 			// which we fill by reading from the databuffer.
-			m_databuffer->read(&data, 1);
+			m_databuffer->read(&dest, 1);
 		
 			// Calculate the new correlation variable, and merge the old one.
 			// Assign it to r itself, this spares a temp. variable for r ;-)
@@ -26,7 +26,7 @@ $Id: CorrelationMeter.h,v 1.2 2008/02/07 11:46:09 n_doebelin Exp $
 
 #include "Plugin.h"
 #include "defines.h"
-#include <RingBufferNPT.h>
+#include <TMultiChannelRingBuffer.h>
 #include <QObject>
 
 class AudioBus;
@@ -55,7 +55,7 @@ public:
 	int get_data(float& r, float& direction);
 
 private:
-	RingBufferNPT<CorrelationMeterData>*	m_databuffer;
+	TMultiChannelRingBuffer<CorrelationMeterData>*	m_databuffer;
 	CorrelationMeterData			m_history;
 	float					m_fract;
 	int					m_bufferreadouts;
@@ -27,6 +27,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 
 GainEnvelope::GainEnvelope(TSession* session)
         : Plugin(session)
+        , m_gain(1.0f)
 {
 	PluginControlPort* port = new PluginControlPort(this, 0, 1.0);
 	port->set_index(0);
@@ -40,7 +41,7 @@ QDomNode GainEnvelope::get_state(QDomDocument doc)
 {
 	QDomElement node = Plugin::get_state(doc).toElement();
 	node.setAttribute("type", "GainEnvelope");
-	node.setAttribute("gain", m_gain);
+	node.setAttribute("gain", get_gain());
 	
 	return node;
 }
@@ -68,7 +69,8 @@ int GainEnvelope::set_state(const QDomNode & node)
 	}
 	
 	QDomElement e = node.toElement();
-	m_gain = e.attribute("gain", "1.0").toFloat();
+	m_gain.set_target(e.attribute("gain", "1.0").toFloat());
+	m_gain.reset();
 	
 	return 1;
 }
@@ -87,10 +89,11 @@ void GainEnvelope::set_session(TSession * session)
 	}
 }
 
+// Called in the process cycle, after begin_cycle()
 void GainEnvelope::process(AudioBus * bus, unsigned long nframes)
 {
         for (int chan=0; chan<bus->get_channel_count(); ++chan) {
-                Mixer::apply_gain_to_buffer(bus->get_buffer(chan, nframes), nframes, get_gain());
+                Mixer::apply_gain(bus->get_buffer(chan, nframes), nframes, m_gain.get_start(), m_gain.get_end());
         }
 }
 
@@ -104,16 +107,39 @@ Curve * GainEnvelope::get_curve()
 }
 
 
-void GainEnvelope::process_gain(audio_sample_t** buffer, const TimeRef& startlocation, const TimeRef& endlocation, nframes_t nframes, uint channels)
+/**
+ * Applies the gain, or the gain automation, to \a buffer. With \a ramp, from the process
+ * cycle after begin_cycle(), the gain moves from the value of the previous cycle to the
+ * current one, else the current value is used for the whole block.
+ */
+void GainEnvelope::process_gain(audio_sample_t** buffer, const TimeRef& startlocation, const TimeRef& endlocation, nframes_t nframes, uint channels, audio_sample_t* gainbuffer, bool ramp)
 {
         PluginControlPort* port = m_controlPorts.at(0);
+        float startGain = ramp ? m_gain.get_start() : m_gain.get_target();
+        float endGain = ramp ? m_gain.get_end() : startGain;
 
         if (port->use_automation()) {
-                port->get_curve()->process(buffer, startlocation, endlocation, nframes, channels, m_gain);
+                port->get_curve()->process(buffer, startlocation, endlocation, nframes, channels, endGain, gainbuffer);
         } else {
                 for (uint chan=0; chan<channels; ++chan) {
-                        Mixer::apply_gain_to_buffer(buffer[chan], nframes, m_gain);
+                        Mixer::apply_gain(buffer[chan], nframes, startGain, endGain);
                 }
         }
 }
 
+/**
+ * Like process_gain(), but returns the gain instead of applying it, see Curve::get_gain_vector()
+ */
+int GainEnvelope::get_gain_vector(audio_sample_t* vector, const TimeRef& startlocation, const TimeRef& endlocation, nframes_t nframes, float& gain)
+{
+        PluginControlPort* port = m_controlPorts.at(0);
+
+        if (port->use_automation()) {
+                return port->get_curve()->get_gain_vector(vector, startlocation, endlocation, nframes, get_gain(), gain);
+        }
+
+        gain = get_gain();
+
+        return 0;
+}
+
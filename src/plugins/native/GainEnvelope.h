@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #define GAIN_ENVELOPE_H
 
 #include "Plugin.h"
+#include "TEngineParameter.h"
 
 class Curve;
 class TSession;
@@ -39,17 +40,19 @@ public:
 	QDomNode get_state(QDomDocument doc);
 	int set_state(const QDomNode & node );
 	void process(AudioBus* bus, unsigned long nframes);
-	void process_gain(audio_sample_t** buffer, const TimeRef& startlocation, const TimeRef& endlocation, nframes_t nframes, uint channels);
+	void process_gain(audio_sample_t** buffer, const TimeRef& startlocation, const TimeRef& endlocation, nframes_t nframes, uint channels, audio_sample_t* gainbuffer=0, bool ramp=false);
+	int get_gain_vector(audio_sample_t* vector, const TimeRef& startlocation, const TimeRef& endlocation, nframes_t nframes, float& gain);
 	
         void set_session(TSession* session);
-	void set_gain(float gain) {m_gain = gain;}
+	void set_gain(float gain) {m_gain.set_target(gain);}
+	void begin_cycle() {m_gain.begin_cycle();}
 	
-	float get_gain() const {return m_gain;}
+	float get_gain() const {return m_gain.get_target();}
         Curve* get_curve();
 	QString get_name();
 	
 private:
-	float m_gain;
+	TEngineParameter m_gain;
 };
 
 #endif
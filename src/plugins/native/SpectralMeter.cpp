@@ -44,16 +44,14 @@ SpectralMeter::SpectralMeter()
 
 	(int) init();
 
-	// constructs a ringbuffer that can hold 16384 samples
-	m_databufferL = new RingBufferNPT<float>(16384);
-	m_databufferR = new RingBufferNPT<float>(16384);
+	// constructs a stereo ringbuffer that can hold 16384 samples per channel
+	m_databuffer = new TMultiChannelRingBuffer<float>(2, 16384);
 }
 
 
 SpectralMeter::~SpectralMeter()
 {
-	delete m_databufferL;
-	delete m_databufferR;
+	delete m_databuffer;
 }
 
 
@@ -150,8 +148,8 @@ void SpectralMeter::process(AudioBus* bus, unsigned long nframes)
 	// The nframes is the amount of samples there are in the buffers
 	// we have to process. No need to get the buffersize, we _have_ to
 	// use the nframes variable !
-	m_databufferL->write(bus->get_buffer(0, nframes), nframes);
-	m_databufferR->write(bus->get_buffer(1, nframes), nframes);
+	float* src[2] = {bus->get_buffer(0, nframes), bus->get_buffer(1, nframes)};
+	m_databuffer->write(src, nframes);
 }
 
 
@@ -163,7 +161,7 @@ QString SpectralMeter::get_name( )
 // writes the fft output into two qvector<float> (left and right channel).
 int SpectralMeter::get_data(QVector<float> &specl, QVector<float> &specr)
 {
-	int readcount = m_databufferL->read_space();
+	int readcount = m_databuffer->read_space();
 	
 	// If there is not enough new data for an FFT window in the ringbuffer,
 	// decide if the cycle should be ignored or if the fft spectrum should
@@ -194,19 +192,19 @@ int SpectralMeter::get_data(QVector<float> &specl, QVector<float> &specr)
 	specl.clear();
 	specr.clear();
 
-	// Create an empty SpectralMeterData struct data,
-	float left = 0.0;
-	float right = 0.0;
+	float left[m_frlen];
+	float right[m_frlen];
+	float* dest[2] = {left, right};
 
-	// read samples (in chunks of buffer_size) from the ringbuffer until the FFT window is filled
-	m_databufferL->read(&left, 1);
-	m_databufferR->read(&right, 1);
+	// skip one sample, and read the FFT window from the ringbuffer in one go.
+	// When the window can't be filled completely, the last sample is repeated.
+	m_databuffer->increment_read_ptr(1);
+	int read = m_databuffer->read(dest, m_frlen);
 
 	for (int i = 0; i < m_frlen; ++i) {
-		m_databufferL->read(&left, 1);
-		m_databufferR->read(&right, 1);
-		fftsigl[i] = (double)left * win[i];
-		fftsigr[i] = (double)right * win[i];
+		int index = qMin(i, read - 1);
+		fftsigl[i] = index < 0 ? 0.0 : (double)left[index] * win[i];
+		fftsigr[i] = index < 0 ? 0.0 : (double)right[index] * win[i];
 	}
 
 	// do the FFT calculations for the left and right channel
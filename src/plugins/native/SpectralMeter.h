@@ -27,7 +27,7 @@ $Id: SpectralMeter.h,v 1.5 2008/02/07 12:52:57 n_doebelin Exp $
 #include "Plugin.h"
 #include "defines.h"
 #include <fftw3.h>
-#include <RingBufferNPT.h>
+#include <TMultiChannelRingBuffer.h>
 #include <QVector>
 
 class AudioBus;
@@ -68,8 +68,7 @@ private:
 	fftw_plan pfegl, pfegr;
 	fftw_complex *fftspecl,*fftspecr;
 	double *fftsigl,*fftsigr,*win;
-	RingBufferNPT<float>*	m_databufferL;
-	RingBufferNPT<float>*	m_databufferR;
+	TMultiChannelRingBuffer<float>*	m_databuffer;
 
 	float   *NFArray(int size){
 		float *p;
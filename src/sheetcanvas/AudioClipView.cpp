@@ -20,6 +20,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 */
 
 #include <QPainter>
+#include <QPixmapCache>
 #include <QFont>
 #include <QGraphicsSimpleTextItem>
 
@@ -52,6 +53,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "dialogs/AudioClipEditDialog.h"
 #include "Fade.h"
 #include "AudioDevice.h"
+#include "TTimelineTracer.h"
 
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
@@ -71,6 +73,14 @@ AudioClipView::AudioClipView(SheetView* sv, AudioTrackView* parent, AudioClip* c
         m_sv = sv;
         m_sheet = m_clip->get_sheet();
 
+        m_waveformTileKey.scalefactor = -1;
+        m_waveformTileKey.xpos = 0;
+        m_waveformTileKey.sourceStart = 0;
+        m_waveformTileKey.length = 0;
+        m_waveformTileKey.gain = 0;
+        m_waveformTileKey.height = 0;
+        m_waveformTileKey.state = 0;
+
         load_theme_data();
 
         m_waitingForPeaks = false;
@@ -90,6 +100,14 @@ AudioClipView::AudioClipView(SheetView* sv, AudioTrackView* parent, AudioClip* c
         m_gainCurveView->set_start_offset(m_clip->get_source_start_location());
         connect(m_gainCurveView, SIGNAL(curveModified()), m_sv, SLOT(stop_follow_play_head()));
 
+        // The rendered waveform tiles include the gain curve and track automation
+        Curve* curves[] = {m_gainCurveView->get_curve(), m_tv->get_gain_curve_view()->get_curve()};
+        for (int i=0; i<2; ++i) {
+                connect(curves[i], SIGNAL(nodeAdded(CurveNode*)), this, SLOT(invalidate_waveform_tiles()));
+                connect(curves[i], SIGNAL(nodeRemoved(CurveNode*)), this, SLOT(invalidate_waveform_tiles()));
+                connect(curves[i], SIGNAL(nodePositionChanged()), this, SLOT(invalidate_waveform_tiles()));
+        }
+
         connect(m_clip, SIGNAL(muteChanged()), this, SLOT(repaint()));
         connect(m_clip, SIGNAL(stateChanged()), this, SLOT(clip_state_changed()));
         connect(m_clip, SIGNAL(activeContextChanged()), this, SLOT(active_context_changed()));
@@ -109,11 +127,13 @@ AudioClipView::AudioClipView(SheetView* sv, AudioTrackView* parent, AudioClip* c
 AudioClipView::~ AudioClipView()
 {
         PENTERDES;
+        invalidate_waveform_tiles();
 }
 
 void AudioClipView::paint(QPainter* painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
         PENTER2;
+        TRACE_SCOPE("AudioClipView::paint");
         Q_UNUSED(widget);
 
 //        printf("AudioClipView:: %s PAINT :: exposed rect is: x=%f, y=%f,? w=%f, h=%f\n", QS_C(m_clip->get_name()), option->exposedRect.x(), option->exposedRect.y(), option->exposedRect.width(), option->exposedRect.height());
@@ -191,8 +211,11 @@ void AudioClipView::paint(QPainter* painter, const QStyleOptionGraphicsItem *opt
                         painter->drawText(r, Qt::AlignVCenter, buildProcess);
 
                 } else if (m_clip->recording_state() == AudioClip::NO_RECORDING) {
+                        int state = (mousehover ? 1 : 0) | (m_clip->is_selected() ? 2 : 0) |
+                                    (m_clip->is_muted() ? 4 : 0) | (m_classicView ? 8 : 0) |
+                                    (m_mergedView ? 16 : 0) | (m_sheet->get_mode() << 5);
 //                        PROFILE_START;
-                        draw_peaks(painter, option->exposedRect.x(), pixelcount);
+                        draw_waveform(painter, option->exposedRect.x(), pixelcount, state);
 //                        PROFILE_END("draw peaks");
                 }
         }
@@ -217,7 +240,83 @@ void AudioClipView::paint(QPainter* painter, const QStyleOptionGraphicsItem *opt
         painter->restore();
 }
 
-void AudioClipView::draw_peaks(QPainter* p, qreal xstart, int pixelcount)
+/**
+ * Paints the waveform by blitting pre rendered tiles of WAVEFORM_TILE_WIDTH pixels,
+ * only tiles that are not in the QPixmapCache are rendered with draw_peaks().
+ *
+ * All tiles are dropped when anything that changes the look of the waveform
+ * changes: zoom level, height, view mode, clip state, gain, position, source
+ * start, length, or one of the gain and fade curves. Note that the Peak data is not thread safe, so tiles are
+ * rendered on demand in the GUI thread.
+ */
+void AudioClipView::draw_waveform(QPainter* painter, qreal xstart, int pixelcount, int state)
+{
+        WaveformTileKey key;
+        key.scalefactor = m_sv->timeref_scalefactor;
+        key.xpos = pos().x();
+        key.sourceStart = m_clip->get_source_start_location().universal_frame();
+        key.length = m_clip->get_length().universal_frame();
+        key.gain = m_clip->get_gain();
+        key.height = m_height;
+        key.state = state;
+
+        if (key != m_waveformTileKey) {
+                invalidate_waveform_tiles();
+                m_waveformTileKey = key;
+        }
+
+        int clipwidth = int(ceil(m_boundingRect.width()));
+        int firsttile = int(xstart) / WAVEFORM_TILE_WIDTH;
+        int lasttile = int(xstart + pixelcount) / WAVEFORM_TILE_WIDTH;
+
+        for (int tile = firsttile; tile <= lasttile; ++tile) {
+                int tilex = tile * WAVEFORM_TILE_WIDTH;
+                int tilewidth = qMin(WAVEFORM_TILE_WIDTH, clipwidth - tilex);
+                if (tilewidth <= 0) {
+                        break;
+                }
+
+                QString cachekey = waveform_tile_cache_key(tile);
+                QPixmap pixmap;
+
+                if (!QPixmapCache::find(cachekey, pixmap)) {
+                        pixmap = QPixmap(tilewidth, m_height);
+                        pixmap.fill(Qt::transparent);
+
+                        QPainter tilepainter(&pixmap);
+                        tilepainter.translate(-tilex, 0);
+                        bool complete = draw_peaks(&tilepainter, tilex, tilewidth);
+                        tilepainter.end();
+
+                        // Peaks are being build, or failed to load, try again next time
+                        if (!complete) {
+                                painter->drawPixmap(tilex, 0, pixmap);
+                                return;
+                        }
+
+                        if (QPixmapCache::insert(cachekey, pixmap)) {
+                                m_waveformTiles.append(tile);
+                        }
+                }
+
+                painter->drawPixmap(tilex, 0, pixmap);
+        }
+}
+
+QString AudioClipView::waveform_tile_cache_key(int tile) const
+{
+        return QString("AudioClipView:%1:%2").arg(quintptr(this)).arg(tile);
+}
+
+void AudioClipView::invalidate_waveform_tiles()
+{
+        foreach(int tile, m_waveformTiles) {
+                QPixmapCache::remove(waveform_tile_cache_key(tile));
+        }
+        m_waveformTiles.clear();
+}
+
+bool AudioClipView::draw_peaks(QPainter* p, qreal xstart, int pixelcount)
 {
 	PENTER4;
 
@@ -233,7 +332,7 @@ void AudioClipView::draw_peaks(QPainter* p, qreal xstart, int pixelcount)
 
         if (!peak) {
                 PERROR("No Peak object available for clip %s", QS_C(m_clip->get_name()));
-                return;
+                return false;
         }
 
         bool microView = m_sheet->get_hzoom() < 64 ? 1 : 0;
@@ -320,11 +419,11 @@ void AudioClipView::draw_peaks(QPainter* p, qreal xstart, int pixelcount)
                         connect(peak, SIGNAL(finished()), this, SLOT (peak_creation_finished()));
                         m_waitingForPeaks = true;
                         peak->start_peak_loading();
-                        return;
+                        return false;
                 }
 
                 if (availpeaks == Peak::PERMANENT_FAILURE || availpeaks == Peak::NO_PEAKDATA_FOUND) {
-                        return;
+                        return false;
                 }
 
                 if (m_mergedView && channels == 2 && chan == 0) continue;
@@ -526,6 +625,8 @@ void AudioClipView::draw_peaks(QPainter* p, qreal xstart, int pixelcount)
 
                 p->restore();
         }
+
+        return true;
 }
 
 void AudioClipView::draw_clipinfo_area(QPainter* p, int xstart, int pixelcount)
@@ -674,6 +775,7 @@ void AudioClipView::update_progress_info( int progress )
 void AudioClipView::peak_creation_finished()
 {
         m_waitingForPeaks = false;
+        invalidate_waveform_tiles();
         update();
 }
 
@@ -683,6 +785,9 @@ void AudioClipView::add_new_fade_curve_view( FadeCurve * fade )
         FadeCurveView* view = new FadeCurveView(m_sv, this, fade);
         m_FadeCurveViews.append(view);
         connect(view, SIGNAL(fadeModified()), m_sv, SLOT(stop_follow_play_head()));
+        connect(fade, SIGNAL(stateChanged()), this, SLOT(invalidate_waveform_tiles()));
+        connect(fade, SIGNAL(rangeChanged()), this, SLOT(invalidate_waveform_tiles()));
+        invalidate_waveform_tiles();
 }
 
 void AudioClipView::remove_fade_curve_view( FadeCurve * fade )
@@ -693,6 +798,8 @@ void AudioClipView::remove_fade_curve_view( FadeCurve * fade )
                         m_FadeCurveViews.takeAt(i);
                         scene()->removeItem(view);
                         delete view;
+                        disconnect(fade, 0, this, 0);
+                        invalidate_waveform_tiles();
                         break;
                 }
         }
@@ -808,6 +915,7 @@ void AudioClipView::load_theme_data()
 
 	create_brushes();
 	create_clipinfo_string();
+        invalidate_waveform_tiles();
 }
 
 
@@ -896,6 +1004,7 @@ TCommand * AudioClipView::set_audio_file()
                 }
 
                 resources_manager()->set_source_for_clip(m_clip, rs);
+                invalidate_waveform_tiles();
 
 
                 // FIXME This is a hack. When a ReadSource didn't have a valid file it wasn't added
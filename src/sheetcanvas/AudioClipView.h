@@ -58,7 +58,27 @@ public:
 	void calculate_bounding_rect();
 	void load_theme_data();
 	
+	static const int WAVEFORM_TILE_WIDTH = 256;
+
 private:
+	// Everything that changes the look of the rendered waveform
+	// but isn't tracked by a signal ends up in here
+	struct WaveformTileKey {
+		qreal	scalefactor;
+		qreal	xpos;		// track automation is mixed in at the clip position
+		qint64	sourceStart;
+		qint64	length;
+		float	gain;
+		int	height;
+		int	state;
+
+		bool operator!=(const WaveformTileKey& other) const {
+			return scalefactor != other.scalefactor || xpos != other.xpos ||
+				sourceStart != other.sourceStart || length != other.length ||
+				gain != other.gain || height != other.height || state != other.state;
+		}
+	};
+
 	AudioTrackView* 	m_tv;
         QList<FadeCurveView*> m_FadeCurveViews;
 	AudioClip* 	m_clip;
@@ -67,6 +87,8 @@ private:
 	QPolygonF 	m_polygon;
 	QPixmap 	m_clipInfo;
 	QTimer 		m_recordingTimer;
+	QList<int>	m_waveformTiles;
+	WaveformTileKey	m_waveformTileKey;
 
 	float m_progress;
 	int m_peakloadingcount;
@@ -109,7 +131,9 @@ private:
 
 	void draw_clipinfo_area(QPainter* painter, int xstart, int pixelcount);
 	void draw_db_lines(QPainter* painter, qreal xstart, int pixelcount);
-	void draw_peaks(QPainter* painter, qreal xstart, int pixelcount);
+	bool draw_peaks(QPainter* painter, qreal xstart, int pixelcount);
+	void draw_waveform(QPainter* painter, qreal xstart, int pixelcount, int state);
+	QString waveform_tile_cache_key(int tile) const;
 	void create_brushes();
 
 	friend class FadeCurveView;
@@ -138,6 +162,7 @@ private slots:
 	void update_recording();
 	void clip_state_changed();
         void active_context_changed();
+	void invalidate_waveform_tiles();
 };
 
 #endif
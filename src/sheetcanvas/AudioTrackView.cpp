@@ -83,19 +83,115 @@ void AudioTrackView::paint(QPainter* painter, const QStyleOptionGraphicsItem* op
 	}
 }
 
+/**
+ * AudioClipViews are only created for the clips in the visible part of the sheet,
+ * set by SheetView with update_clip_views(), so the scene doesn't hold the views
+ * (and their fade and curve views) of all clips in large sheets.
+ */
 void AudioTrackView::add_new_audioclipview( AudioClip * clip )
 {
 	PENTER;
+	// A clip that is moved into the visible range gets it's view from clip_position_changed()
+	connect(clip, SIGNAL(positionChanged()), this, SLOT(clip_position_changed()));
+
+	if (clip->get_track_end_location() >= m_visibleStart && clip->get_track_start_location() <= m_visibleEnd) {
+		create_clip_view(clip);
+	}
+}
+
+AudioClipView* AudioTrackView::create_clip_view(AudioClip* clip)
+{
 	AudioClipView* clipView = new AudioClipView(m_sv, this, clip);
 	m_clipViews.append(clipView);
 	if (!m_track->show_clip_volume_automation()) {
 		clipView->get_gain_curve_view()->hide();
 	}
+	return clipView;
+}
+
+/**
+ * Deletes \a view, unless it's in use: pointed at, moving or recording.
+ * @return true if the view was deleted.
+ */
+bool AudioTrackView::release_clip_view(AudioClipView* view)
+{
+	AudioClip* clip = view->get_clip();
+	if (clip->has_active_context() || clip->is_moving() || clip->recording_state() == AudioClip::RECORDING) {
+		return false;
+	}
+
+	m_clipViews.removeAll(view);
+	scene()->removeItem(view);
+	delete view;
+
+	return true;
+}
+
+/**
+ * Creates the AudioClipViews of the clips within \a start and \a end, and deletes the
+ * ones of clips outside \a releaseStart and \a releaseEnd. Views in between are kept,
+ * so scrolling back and forth doesn't create and delete the same views over and over.
+ */
+void AudioTrackView::update_clip_views(const TimeRef& start, const TimeRef& end, const TimeRef& releaseStart, const TimeRef& releaseEnd)
+{
+	m_visibleStart = start;
+	m_visibleEnd = end;
+
+	foreach(AudioClipView* view, m_clipViews) {
+		AudioClip* clip = view->get_clip();
+		if (clip->get_track_end_location() < releaseStart || clip->get_track_start_location() > releaseEnd) {
+			release_clip_view(view);
+		}
+	}
+
+	foreach(AudioClip* clip, m_track->get_clips_in_range(start, end)) {
+		get_clip_view(clip);
+	}
+}
+
+/**
+ * Deletes all AudioClipViews, for a track scrolled out of view.
+ */
+void AudioTrackView::release_clip_views()
+{
+	m_visibleStart = m_visibleEnd = TimeRef();
+
+	foreach(AudioClipView* view, m_clipViews) {
+		release_clip_view(view);
+	}
+}
+
+/**
+ * @return The AudioClipView of \a clip, which is created when it didn't exist yet.
+ */
+AudioClipView* AudioTrackView::get_clip_view(AudioClip* clip)
+{
+	foreach(AudioClipView* view, m_clipViews) {
+		if (view->get_clip() == clip) {
+			return view;
+		}
+	}
+
+	return create_clip_view(clip);
+}
+
+void AudioTrackView::clip_position_changed()
+{
+	AudioClip* clip = qobject_cast<AudioClip*>(sender());
+	if (!clip || clip->get_track() != m_track) {
+		return;
+	}
+
+	if (clip->get_track_end_location() >= m_visibleStart && clip->get_track_start_location() <= m_visibleEnd) {
+		get_clip_view(clip);
+	}
 }
 
 void AudioTrackView::remove_audioclipview( AudioClip * clip )
 {
 	PENTER;
+	disconnect(clip, SIGNAL(positionChanged()), this, SLOT(clip_position_changed()));
+
 	foreach(AudioClipView* view, m_clipViews) {
 		if (view->get_clip() == clip) {
 			m_clipViews.removeAll(view);
@@ -136,24 +232,19 @@ void AudioTrackView::to_front(AudioClipView * view)
 	view->setZValue(zValue() + 2);
 }
 
-AudioClipView* AudioTrackView::get_nearest_audioclip_view(TimeRef location) const
+AudioClipView* AudioTrackView::get_nearest_audioclip_view(TimeRef location)
 {
         PENTER;
-        if (!m_clipViews.size()) {
-                return (AudioClipView*) 0;
-        }
-
-        AudioClipView* nearestClipView = 0;
+        // Search the clips, not the views, the nearest clip can be outside the visible range
+        AudioClip* nearestClip = 0;
         TimeRef shortestDistance(LONG_LONG_MAX);
 
-        foreach(AudioClipView* clipview, m_clipViews) {
-                AudioClip* clip = clipview->get_clip();
-
-                // check if location is in the clipviews start/end range
-                // if so, we found the 'nearest' clipview, so return it.
+        foreach(AudioClip* clip, m_track->get_cliplist()) {
+                // check if location is in the clips start/end range
+                // if so, we found the 'nearest' clip, so return it's view.
                 if (clip->get_track_start_location() < location &&
                     clip->get_track_end_location() > location) {
-                        return clipview;
+                        return get_clip_view(clip);
                 }
 
                 // this clip is left of of location.
@@ -161,7 +252,7 @@ AudioClipView* AudioTrackView::get_nearest_audioclip_view(TimeRef location) cons
                         TimeRef diff = location - clip->get_track_end_location();
                         if (diff < shortestDistance) {
                                 shortestDistance = diff;
-                                nearestClipView = clipview;
+                                nearestClip = clip;
                         }
                 }
                 // this clip is right of location
@@ -169,12 +260,16 @@ AudioClipView* AudioTrackView::get_nearest_audioclip_view(TimeRef location) cons
                         TimeRef diff = clip->get_track_start_location() - location;
                         if (diff < shortestDistance) {
                                 shortestDistance = diff;
-                                nearestClipView = clipview;
+                                nearestClip = clip;
                         }
                 }
         }
 
-        return nearestClipView;
+        if (!nearestClip) {
+                return (AudioClipView*) 0;
+        }
+
+        return get_clip_view(nearestClip);
 }
 
 TCommand* AudioTrackView::show_track_gain_curve()
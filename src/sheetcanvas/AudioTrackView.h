@@ -41,7 +41,8 @@ public:
 	void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
 	
         AudioTrack* get_track() const {return m_track;}
-        AudioClipView* get_nearest_audioclip_view(TimeRef location) const;
+        AudioClipView* get_nearest_audioclip_view(TimeRef location);
+        AudioClipView* get_clip_view(AudioClip* clip);
         QList<AudioClipView* > get_clipviews() {return m_clipViews;}
 	CurveView* get_gain_curve_view() const {return m_curveView;}
 	
@@ -50,10 +51,18 @@ public:
 	void load_theme_data();
 	
 	void to_front(AudioClipView* view);
+
+	void update_clip_views(const TimeRef& start, const TimeRef& end, const TimeRef& releaseStart, const TimeRef& releaseEnd);
+	void release_clip_views();
 	
 private:
         AudioTrack*		m_track;
 	QList<AudioClipView* >	m_clipViews;
+	TimeRef			m_visibleStart;
+	TimeRef			m_visibleEnd;
+
+	AudioClipView* create_clip_view(AudioClip* clip);
+	bool release_clip_view(AudioClipView* view);
 
 public slots:
 	TCommand* insert_silence();
@@ -65,6 +74,7 @@ protected slots:
 private slots:
 	void add_new_audioclipview(AudioClip* clip);
 	void remove_audioclipview(AudioClip* clip);
+	void clip_position_changed();
 };
 
 
@@ -31,6 +31,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "RemoveClip.h"
 
 #include "AudioDevice.h"
+#include "TTimelineTracer.h"
 
 #include <QScrollBar>
 #include <QSet>
@@ -58,11 +59,16 @@ void ClipsViewPort::resizeEvent( QResizeEvent * e )
 {
 	ViewPort::resizeEvent(e);
 //	m_sw->get_sheetview()->clipviewport_resize_event();
+	// A larger viewport exposes clips which have no view yet
+	if (m_sw->get_sheetview()) {
+		m_sw->get_sheetview()->update_visible_views();
+	}
 }
 
 
 void ClipsViewPort::paintEvent(QPaintEvent * e)
 {
+        TRACE_SCOPE("ClipsViewPort::paintEvent");
 	QGraphicsView::paintEvent(e);
 }
 
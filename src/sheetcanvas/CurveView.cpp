@@ -79,10 +79,6 @@ CurveView::~ CurveView( )
 	delete m_guicurve;
 }
 
-static bool smallerpoint(const QPointF& left, const QPointF& right) {
-	return left.x() < right.x();
-}
-
 void CurveView::paint( QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget )
 {
 	Q_UNUSED(widget);
@@ -166,25 +162,28 @@ void CurveView::paint( QPainter * painter, const QStyleOptionGraphicsItem * opti
     				vector,
     				pixelcount);
 	
+	// Depending on the zoom level, curve nodes can end up to be aligned 
+	// vertically at the exact same x position. The curve line won't be painted
+	// by the vector points (it doesn't catch the second node position obviously)
+	// so we add the on-screen curvenodes _always_ to solve this problem easily :-)
+	// They come ordered by position from the curve index, so merging them with
+	// the vector points keeps the polygon sorted.
+	QList<CurveNode*> nodes = m_guicurve->get_nodes_in_range(xstart + offset, xstart + pixelcount + offset);
+	int nodeindex = 0;
+	
 	for (int i=0; i<pixelcount; i+=3) {
+		while (nodeindex < nodes.size() && (nodes.at(nodeindex)->when - offset) <= (xstart + i)) {
+			CurveNodeView* view = static_cast<CurveNodeView*>(nodes.at(nodeindex++));
+			polygon <<  QPointF(view->when - offset, (height - (view->get_curve_node()->get_value() * height)));
+		}
 		polygon <<  QPointF(xstart + i, height - (vector[i] * height) );
 	}
 	
-	// Depending on the zoom level, curve nodes can end up to be aligned 
-	// vertically at the exact same x position. The curve line won't be painted
-	// by the routine above (it doesn't catch the second node position obviously)
-	// so we add curvenodes _always_ to solve this problem easily :-)
-	apill_foreach(CurveNodeView* view, CurveNodeView, m_nodeViews) {
-		qreal x = view->x();
-		if ( (x > xstart) && x < (xstart + pixelcount)) {
-			polygon <<  QPointF( x + view->boundingRect().width() / 2,
-					(height - (view->get_curve_node()->get_value() * height)) );
-		}
+	while (nodeindex < nodes.size()) {
+		CurveNodeView* view = static_cast<CurveNodeView*>(nodes.at(nodeindex++));
+		polygon <<  QPointF(view->when - offset, (height - (view->get_curve_node()->get_value() * height)));
 	}
 	
-	// Which means we have to sort the polygon *sigh* (rather cpu costly, but what can I do?)
-	qSort(polygon.begin(), polygon.end(), smallerpoint);
-
 /*	for (int i=0; i<polygon.size(); ++i) {
 		printf("polygin %d, x=%d, y=%d\n", i, (int)polygon.at(i).x(), (int)polygon.at(i).y());
 	}*/
@@ -136,6 +136,8 @@ SheetView::SheetView(SheetWidget* sheetwidget,
 	connect(m_hScrollBar, SIGNAL(actionTriggered(int)), this, SLOT(hscrollbar_action(int)));
 	connect(m_hScrollBar, SIGNAL(valueChanged(int)), this, SLOT(hscrollbar_value_changed(int)));
 	connect(m_vScrollBar, SIGNAL(valueChanged(int)), m_clipsViewPort->verticalScrollBar(), SLOT(setValue(int)));
+	connect(m_clipsViewPort->horizontalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(update_visible_views()));
+	connect(m_clipsViewPort->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(update_visible_views()));
 
 	connect(&cpointer(), SIGNAL(contextChanged()), this, SLOT(context_changed()));
 
@@ -210,36 +212,38 @@ void SheetView::sheet_mode_changed()
 
 AudioTrackView* SheetView::get_audio_trackview_under( QPointF point )
 {
-	AudioTrackView* view = 0;
-	QList<QGraphicsItem*> views = m_clipsViewPort->items(m_clipsViewPort->mapFromScene(point));
-
-	for (int i=0; i<views.size(); ++i) {
-		view = dynamic_cast<AudioTrackView*>(views.at(i));
-		if (view) {
-			return view;
-		}
-	}
-	return  0;
-
+	return qobject_cast<AudioTrackView*>(get_trackview_under(point));
 }
 
+/**
+ * Finds the TrackView at the vertical position of \a point, in the clips or the
+ * track panel area. layout_tracks() places the track views top to bottom in the
+ * order of get_track_views(), so it's a binary search on their positions instead
+ * of a query of all items in the scene.
+ */
 TrackView* SheetView::get_trackview_under( QPointF point )
 {
-	QList<QGraphicsItem*> views = m_clipsViewPort->items(m_clipsViewPort->mapFromScene(point));
+	QList<TrackView*> views = get_track_views();
 
-	for (int i=0; i<views.size(); ++i) {
-		TrackView* view = dynamic_cast<TrackView*>(views.at(i));
-		if (view) {
-			return view;
-		}
-		TrackPanelView* tpv = dynamic_cast<TrackPanelView*>(views.at(i));
-		if (tpv)
-		{
-			return tpv->get_track_view();
+	int low = 0;
+	int high = views.size() - 1;
+	TrackView* view = 0;
+
+	while (low <= high) {
+		int middle = (low + high) / 2;
+		if (views.at(middle)->scenePos().y() <= point.y()) {
+			view = views.at(middle);
+			low = middle + 1;
+		} else {
+			high = middle - 1;
 		}
 	}
-	return  0;
 
+	if (view && point.y() < view->scenePos().y() + view->get_total_height()) {
+		return view;
+	}
+
+	return  0;
 }
 
 
@@ -500,6 +504,38 @@ void SheetView::clipviewport_resize_event()
 	update_scrollbars();
 }
 
+/**
+ * Lets the AudioTrackViews of the tracks in (or near) the visible part of the sheet
+ * create the views for their clips in (or near) the visible time range, and release
+ * the ones far outside of it. Tracks far outside the visible part release all their
+ * clip views.
+ */
+void SheetView::update_visible_views()
+{
+	int width = m_clipsViewPort->width();
+	int height = m_clipsViewPort->height();
+	int x = m_clipsViewPort->horizontalScrollBar()->value();
+	int y = m_clipsViewPort->verticalScrollBar()->value();
+
+	// Create views half a page around the visible area, release them beyond 2 pages
+	TimeRef start(qint64(qMax(0, x - width / 2)) * timeref_scalefactor);
+	TimeRef end(qint64(x + width + width / 2) * timeref_scalefactor);
+	TimeRef releaseStart(qint64(qMax(0, x - 2 * width)) * timeref_scalefactor);
+	TimeRef releaseEnd(qint64(x + 3 * width) * timeref_scalefactor);
+
+	foreach(TrackView* view, m_audioTrackViews) {
+		AudioTrackView* atv = qobject_cast<AudioTrackView*>(view);
+		int top = int(view->scenePos().y());
+		int bottom = top + view->get_total_height();
+
+		if (bottom >= y - height / 2 && top <= y + height + height / 2) {
+			atv->update_clip_views(start, end, releaseStart, releaseEnd);
+		} else if (bottom < y - 2 * height || top > y + 3 * height) {
+			atv->release_clip_views();
+		}
+	}
+}
+
 void SheetView::vzoom(qreal factor)
 {
 	PENTER;
@@ -589,6 +625,7 @@ void SheetView::layout_tracks()
 	m_meanTrackHeight = float(totalTrackHeightPrimaryLanes) / (m_audioTrackViews.size() + m_busTrackViews.size() + 1);
 
 	update_scrollbars();
+	update_visible_views();
 }
 
 void SheetView::update_tracks_bounding_rect()
@@ -1260,13 +1297,8 @@ TCommand* SheetView::browse_to_next_context_item()
 			return 0;
 		}
 
-		QList<AudioClipView*> views = data.atv->get_clipviews();
-		foreach(AudioClipView* view, views) {
-			if (view->get_clip() == nextClip) {
-				browse_to_audio_clip_view(view);
-				return 0;
-			}
-		}
+		browse_to_audio_clip_view(data.atv->get_clip_view(nextClip));
+		return 0;
 	}
 
 	if (data.currentContext == "AudioTrackView") {
@@ -1316,13 +1348,8 @@ TCommand* SheetView::browse_to_previous_context_item()
 			return 0;
 		}
 
-		QList<AudioClipView*> views = data.atv->get_clipviews();
-		foreach(AudioClipView* view, views) {
-			if (view->get_clip() == nextClip) {
-				browse_to_audio_clip_view(view);
-				return 0;
-			}
-		}
+		browse_to_audio_clip_view(data.atv->get_clip_view(nextClip));
+		return 0;
 	}
 
 	if (data.currentContext == "AudioTrackView") {
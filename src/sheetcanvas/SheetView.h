@@ -168,6 +168,7 @@ private:
 
 public slots:
 	void set_snap_range(int);
+	void update_visible_views();
 	void update_scrollbars();
 	void stop_follow_play_head();
 	void follow_play_head();
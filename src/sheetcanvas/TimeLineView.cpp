@@ -50,11 +50,6 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 
 #define MARKER_SOFT_SELECTION_DISTANCE 50
 
-static bool smallerMarker(const MarkerView* left, const MarkerView* right )
-{
-        return left->get_marker()->get_when() < right->get_marker()->get_when();
-}
-
 
 TimeLineView::TimeLineView(SheetView* view)
 	: ViewItem(0, view->get_sheet()->get_timeline())
@@ -218,19 +213,18 @@ void TimeLineView::add_new_marker_view(Marker * marker)
 	MarkerView* view = new MarkerView(marker, m_sv, this);
 	view->set_active(false);
 	m_markerViews.append(view);
+	m_markerViewsByMarker.insert(marker, view);
 	view->update();
 }
 
 void TimeLineView::remove_marker_view(Marker * marker)
 {
-	foreach(MarkerView* view, m_markerViews) {
-		if (view->get_marker() == marker) {
-			m_markerViews.removeAll(view);
-			scene()->removeItem(view);
-			m_blinkingMarker = 0;
-			delete view;
-			return;
-		}
+	MarkerView* view = m_markerViewsByMarker.take(marker);
+	if (view) {
+		m_markerViews.removeAll(view);
+		scene()->removeItem(view);
+		m_blinkingMarker = 0;
+		delete view;
 	}
 }
 
@@ -417,28 +411,18 @@ void TimeLineView::load_theme_data()
 
 MarkerView* TimeLineView::get_marker_view_after(TimeRef location)
 {
-        // FIXME: only keep this list sorted if markers are added/moved??
-        qSort(m_markerViews.begin(), m_markerViews.end(), smallerMarker);
-
-        foreach(MarkerView* markerView, m_markerViews) {
-                if (markerView->get_marker()->get_when() > location) {
-                        return markerView;
-                }
+        Marker* marker = m_timeline->get_next_marker(location);
+        if (!marker) {
+                return 0;
         }
-        return 0;
+        return get_marker_view(marker);
 }
 
 MarkerView* TimeLineView::get_marker_view_before(TimeRef location)
 {
-        // FIXME: only keep this list sorted if markers are added/moved??
-        qSort(m_markerViews.begin(), m_markerViews.end(), smallerMarker);
-
-        for (int i=m_markerViews.size() - 1; i>= 0; --i) {
-                MarkerView* markerView = m_markerViews.at(i);
-                if (markerView->get_marker()->get_when() < location) {
-                        return markerView;
-                }
+        Marker* marker = m_timeline->get_previous_marker(location);
+        if (!marker) {
+                return 0;
         }
-
-        return 0;
+        return get_marker_view(marker);
 }
@@ -46,11 +46,13 @@ public:
         void mouse_hover_move_event();
         QList<MarkerView*> get_marker_views() const { return m_markerViews;}
 
+        MarkerView* get_marker_view(Marker* marker) const {return m_markerViewsByMarker.value(marker);}
         MarkerView* get_marker_view_after(TimeRef location);
         MarkerView* get_marker_view_before(TimeRef location);
 
 private:
 	QList<MarkerView* > m_markerViews;
+	QHash<Marker*, MarkerView*> m_markerViewsByMarker;
 	TimeLine* 	m_timeline;
 	MarkerView* 	m_blinkingMarker;
 	QColor		m_blinkColor;
@@ -262,6 +262,17 @@ AudioTrackPanelView::AudioTrackPanelView(AudioTrackView* trackView)
         }
 
         connect(m_tv->get_track(), SIGNAL(armedChanged(bool)), m_recLed, SLOT(ison_changed(bool)));
+
+        m_freezeLed = new TrackPanelLed(this, m_track, "F", "toggle_freeze");
+        m_freezeLed->set_bounding_rect(QRectF(0, 0, LED_WIDTH, LED_HEIGHT));
+
+        m_ledViews.insert(13, m_freezeLed);
+
+        if (m_tv->get_track()->is_frozen()) {
+                m_freezeLed->ison_changed(true);
+        }
+
+        connect(m_tv->get_track(), SIGNAL(freezeChanged(bool)), m_freezeLed, SLOT(ison_changed(bool)));
 }
 
 AudioTrackPanelView::~AudioTrackPanelView( )
@@ -139,6 +139,7 @@ protected:
 private:
         AudioTrackView*	m_tv;
         TrackPanelLed*  m_recLed;
+        TrackPanelLed*  m_freezeLed;
 };
 
 
@@ -264,7 +264,6 @@ void VUMeterRulerView::set_bounding_rect(QRectF rect)
  */
 
 static const int OVER_SAMPLES_COUNT = 2;	// sensitivity of the 'over' indicator
-static const int RMS_SAMPLES = 50;		// number of updates to be stored for RMS calculation
 static const int PEAK_HOLD_TIME = 1000;		// peak hold time (ms)
 static const int PEAK_HOLD_MODE = 1;		// 0 = no peak hold, 1 = dynamic, 2 = constant
 static const bool SHOW_RMS = false;		// toggle RMS lines on / off
@@ -277,7 +276,7 @@ VUMeterLevelView::VUMeterLevelView(ViewItem* parent, VUMonitor* monitor)
 
 	m_boundingRect = QRectF(0, 0, parent->boundingRect().width(), 5);
         m_tailDeltaY = m_peakHoldValue = m_rms = -120.0;
-        m_overCount = m_rmsIndex = 0;
+        m_overCount = 0;
         m_peakHoldFalling = false;
         m_peak = 0.0;
         m_orientation = Qt::Vertical;
@@ -285,19 +284,23 @@ VUMeterLevelView::VUMeterLevelView(ViewItem* parent, VUMonitor* monitor)
         // falloff speed, according to IEC 60268-18: 20 dB in 1.7 sec.
         m_maxFalloff = 20.0 / (1700.0 / (float)TMainWindow::instance()->get_vulevel_update_frequency());
 
-        for (int i = 0; i < RMS_SAMPLES; i++) {
-                m_peakHistory[i] = 0.0;
-        }
-
         connect(themer(), SIGNAL(themeLoaded()), this, SLOT(load_theme_data()), Qt::QueuedConnection);
         load_theme_data();
 
         TMainWindow::instance()->register_vumeter_level(this);
+
+        if (SHOW_RMS) {
+                meterbus().add_rms_user();
+        }
 }
 
 VUMeterLevelView::~VUMeterLevelView()
 {
         TMainWindow::instance()->unregister_vumeter_level(this);
+
+        if (SHOW_RMS) {
+                meterbus().remove_rms_user();
+        }
 }
 
 void VUMeterLevelView::paint(QPainter* painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
@@ -419,22 +422,7 @@ void VUMeterLevelView::update_peak( )
 
         // RMS lines
         if (SHOW_RMS) {
-                // use some kind of 'ring buffer' to store the last couple of peak values
-                if (m_rmsIndex >= RMS_SAMPLES) {
-                        m_rmsIndex = 0;
-                }
-
-                m_peakHistory[m_rmsIndex] = m_peak;
-
-                // calculate the RMS
-                float squares = 0.0;
-
-                for (int i = 0; i < RMS_SAMPLES; i++) {
-                        squares += m_peakHistory[i] * m_peakHistory[i];
-                }
-
-                m_rms = sqrt(squares / float(RMS_SAMPLES));
-                m_rmsIndex++;
+                m_rms = m_monitor->get_rms_value();
         }
 
         // 'over' detection
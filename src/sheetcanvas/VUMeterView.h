@@ -142,8 +142,6 @@ private:
         float			m_rms;
         float			m_maxFalloff;
         float			m_peakHoldValue;
-        float			m_peakHistory[50];
-        short unsigned int	m_rmsIndex;
         short unsigned int	m_overCount;
 
         void resize_level_pixmap();
@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 
 #include "AudioChannel.h"
 #include <AudioDevice.h>
+#include "TMeterBus.h"
 
 #include <QDockWidget>
 #include <QUndoView>
@@ -53,6 +54,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "TimeLine.h"
 #include "Themer.h"
 #include "AudioFileCopyConvert.h"
+#include "TConversionService.h"
 
 #include "../sheetcanvas/SheetWidget.h"
 
@@ -218,6 +220,10 @@ TMainWindow::TMainWindow()
 	m_progressBar->setObjectName("Progress Toolbar");
 	addToolBar(Qt::BottomToolBarArea, m_progressBar);
 	m_progressBar->hide();
+	// All file imports and conversions together
+	connect(&conversionservice(), SIGNAL(progress(int)), m_progressBar, SLOT(set_progress(int)), Qt::QueuedConnection);
+	connect(&conversionservice(), SIGNAL(throughputChanged(double)), m_progressBar, SLOT(set_throughput(double)), Qt::QueuedConnection);
+	connect(&conversionservice(), SIGNAL(batchFinished()), m_progressBar, SLOT(batch_finished()), Qt::QueuedConnection);
 
 
 	m_mainMenuToolBar = new QToolBar(this);
@@ -1412,7 +1418,6 @@ TCommand * TMainWindow::show_newproject_dialog()
 		m_newProjectDialog = new NewProjectDialog(this);
 		AudioFileCopyConvert* converter = m_newProjectDialog->get_converter();
 		connect(converter, SIGNAL(taskStarted(QString)), m_progressBar, SLOT(set_label(QString)));
-		connect(converter, SIGNAL(progress(int)), m_progressBar, SLOT(set_progress(int)));
 		connect(m_newProjectDialog, SIGNAL(numberOfFiles(int)), m_progressBar, SLOT(set_num_files(int)));
 	}
 	m_newProjectDialog->show();
@@ -1857,24 +1862,18 @@ void TMainWindow::unregister_vumeter_level(AbstractVUMeterLevel *level)
 
 void TMainWindow::update_vu_levels_peak()
 {
+	// This is the one and only display rate driver for all
+	// the VU meters, the bus monitor's VUMeter widgets update
+	// on TMeterBus::snapshotUpdated()
+	meterbus().update_snapshot();
+
 	if (!m_project) {
 		return;
 	}
 
-
 	for(int i=0; i<m_vuLevels.size(); i++) {
 		m_vuLevels.at(i)->update_peak();
 	}
-
-	QList<Track*> tracks = m_project->get_sheet_tracks();
-	tracks.append(m_project->get_tracks());
-	tracks.append(m_project->get_master_out());
-	for(int i = 0; i< tracks.size(); i++) {
-		VUMonitors monitors = tracks.at(i)->get_vumonitors();
-		for (int j=0; j<monitors.size(); ++j) {
-			monitors.at(j)->set_read();
-		}
-	}
 }
 
 
@@ -25,6 +25,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <QMessageBox>
 #include <QFileInfo>
 #include <QDir>
+#include <QTimer>
 
 #include "Traverso.h"
 #include "Mixer.h"
@@ -35,9 +36,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "TConfig.h"
 #include "TTransport.h"
 #include "AudioDevice.h"
+#include "memops.h"
 #include "ContextPointer.h"
 #include "Information.h"
+#include "TBenchmark.h"
 #include "TShortcutManager.h"
+#include "TTimelineTracer.h"
 #include "widgets/SpectralMeterWidget.h"
 #include "widgets/CorrelationMeterWidget.h"
 
@@ -106,6 +110,8 @@ Traverso::Traverso(int &argc, char **argv )
 	qRegisterMetaType<TimeRef>("TimeRef");
 	
 	config().check_and_load_configuration();
+
+        TRACE_THREAD("GUI");
 	
 	tShortCutManager().add_meta_object(&SpectralMeterView::staticMetaObject);
 	tShortCutManager().add_meta_object(&CorrelationMeterView::staticMetaObject);
@@ -134,6 +140,17 @@ void Traverso::create_interface( )
         TMainWindow* tMainWindow = TMainWindow::instance();
         tMainWindow->show();
 
+#if defined (BENCHMARK)
+	QStringList arguments = QCoreApplication::arguments();
+	int benchmarkIndex = arguments.indexOf("--benchmark");
+	if (benchmarkIndex >= 0) {
+		TBenchmark benchmark(arguments.value(benchmarkIndex + 1), arguments.value(benchmarkIndex + 2));
+		benchmark.run();
+		QTimer::singleShot(0, this, SLOT(quit()));
+		return;
+	}
+#endif
+
 	QString projectToLoad = "";
 	
 	foreach(QString string, QCoreApplication::arguments ()) {
@@ -194,6 +211,10 @@ void Traverso::init_sse( )
 	
 	FPU fpu;
 
+	Mixer::interleave_buffers	= default_interleave_buffers;
+	Mixer::apply_gain_ramp_to_buffer	= default_apply_gain_ramp_to_buffer;
+	Mixer::mix_buffers_with_gain_ramp	= default_mix_buffers_with_gain_ramp;
+
 #if (defined (ARCH_X86) || defined (ARCH_X86_64)) && defined (SSE_OPTIMIZATIONS)
 
 	if (fpu.has_sse()) {
@@ -205,11 +226,38 @@ void Traverso::init_sse( )
 		Mixer::apply_gain_to_buffer 	= x86_sse_apply_gain_to_buffer;
 		Mixer::mix_buffers_with_gain 	= x86_sse_mix_buffers_with_gain;
 		Mixer::mix_buffers_no_gain 	= x86_sse_mix_buffers_no_gain;
+#if defined (USE_XMMINTRIN)
+		Mixer::interleave_buffers	= x86_sse_interleave_buffers;
+		Mixer::apply_gain_ramp_to_buffer	= x86_sse_apply_gain_ramp_to_buffer;
+		Mixer::mix_buffers_with_gain_ramp	= x86_sse_mix_buffers_with_gain_ramp;
+#endif
 
 		generic_mix_functions = false;
 
 	}
 
+#if defined (USE_XMMINTRIN) && defined (__SSE2__)
+	if (fpu.has_sse2()) {
+
+		printf("Using SSE2 optimized sample format conversions\n");
+
+		MemOps::sample_move_d32u24_sS			= x86_sse2_sample_move_d32u24_sS;
+		MemOps::sample_move_d24_sS			= x86_sse2_sample_move_d24_sS;
+		MemOps::sample_move_d16_sS			= x86_sse2_sample_move_d16_sS;
+		MemOps::sample_move_dither_rect_d32u24_sS	= x86_sse2_sample_move_dither_rect_d32u24_sS;
+		MemOps::sample_move_dither_tri_d32u24_sS	= x86_sse2_sample_move_dither_tri_d32u24_sS;
+		MemOps::sample_move_dither_rect_d24_sS		= x86_sse2_sample_move_dither_rect_d24_sS;
+		MemOps::sample_move_dither_tri_d24_sS		= x86_sse2_sample_move_dither_tri_d24_sS;
+		MemOps::sample_move_dither_rect_d16_sS		= x86_sse2_sample_move_dither_rect_d16_sS;
+		MemOps::sample_move_dither_tri_d16_sS		= x86_sse2_sample_move_dither_tri_d16_sS;
+		MemOps::sample_move_dS_s32u24			= x86_sse2_sample_move_dS_s32u24;
+		MemOps::sample_move_dS_s24			= x86_sse2_sample_move_dS_s24;
+		MemOps::sample_move_dS_s16			= x86_sse2_sample_move_dS_s16;
+		MemOps::sample_move_d32f_sS			= x86_sse2_sample_move_d32f_sS;
+		MemOps::sample_move_dS_s32f			= x86_sse2_sample_move_dS_s32f;
+	}
+#endif
+
 #elif defined (__APPLE__) && defined (BUILD_VECLIB_OPTIMIZATIONS)
 	long sysVersion = 0;
 
@@ -34,6 +34,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include "AudioTrack.h"
 #include "Utils.h"
 #include "Mixer.h"
+#include "TMemoryBudget.h"
 
 #include <QPainter>
 #include <QLineEdit>
@@ -77,6 +78,7 @@ SystemResources::SystemResources(QWidget * parent)
 	m_readBufferStatus->setToolTip(tr("Read Buffer Status"));
 	m_writeBufferStatus->setToolTip(tr("Write Buffer Status"));
 	m_cpuUsage = new SystemValueBar(this);
+        m_memoryUsage = new SystemValueBar(this);
 	m_icon = new QPushButton();
 	m_icon->setIcon(find_pixmap(":/memorysmall"));
 	m_icon->setFlat(true);
@@ -105,10 +107,17 @@ SystemResources::SystemResources(QWidget * parent)
 	m_cpuUsage->add_range_color(0, 60, QColor(227, 254, 227));
 	m_cpuUsage->add_range_color(60, 75, QColor(255, 255, 0));
 	m_cpuUsage->add_range_color(75, 100, QColor(255, 0, 0));
+
+        m_memoryUsage->set_range(0, 100);
+        m_memoryUsage->setMinimumWidth(60);
+        m_memoryUsage->add_range_color(0, 75, QColor(227, 254, 227));
+        m_memoryUsage->add_range_color(75, 90, QColor(255, 255, 0));
+        m_memoryUsage->add_range_color(90, 100, QColor(255, 0, 0));
 	
         m_readBufferStatus->set_text("R");
 	m_writeBufferStatus->set_text("W");
         m_cpuUsage->set_text("DSP");
+        m_memoryUsage->set_text("MEM");
 	
         QHBoxLayout* lay = new QHBoxLayout(this);
 	lay->addSpacing(6);
@@ -116,6 +125,7 @@ SystemResources::SystemResources(QWidget * parent)
 	lay->addWidget(m_icon);
 	lay->addWidget(m_writeBufferStatus);
 	lay->addWidget(m_cpuUsage);
+        lay->addWidget(m_memoryUsage);
         lay->addWidget(TMainWindow::instance()->get_track_finder());
         lay->addWidget(m_collectedNumber);
 	lay->setMargin(0);
@@ -151,6 +161,31 @@ void SystemResources::update_status( )
 	m_readBufferStatus->set_value(bufReadStatus);
 	m_writeBufferStatus->set_value(bufWriteStatus);
 	m_cpuUsage->set_value(time);
+
+        // Page faults in the audio thread are a likely cause of xruns, make them visible
+        int minorFaults, majorFaults, faultingCycles;
+        audiodevice().get_page_faults(minorFaults, majorFaults, faultingCycles);
+        if (faultingCycles) {
+                m_cpuUsage->set_text("DSP !");
+                m_cpuUsage->setToolTip(tr("Page faults in the audio thread: %1 minor, %2 major, in %3 cycles")
+                                       .arg(minorFaults).arg(majorFaults).arg(faultingCycles));
+        } else {
+                m_cpuUsage->set_text("DSP");
+                m_cpuUsage->setToolTip(tr("No page faults in the audio thread"));
+        }
+
+        qint64 budget = memorybudget().get_budget();
+        qint64 total = memorybudget().get_total();
+        m_memoryUsage->set_value(qMin(qint64(100), total * 100 / budget));
+
+        QString tooltip = tr("Buffer and cache memory");
+        for (int i=0; i<TMemoryBudget::CategoryCount; ++i) {
+                TMemoryBudget::Category category = TMemoryBudget::Category(i);
+                tooltip += QString("\n%1: %2 MB").arg(TMemoryBudget::get_category_name(category))
+                           .arg(memorybudget().get_usage(category) / (1024 * 1024));
+        }
+        tooltip += "\n" + tr("Total: %1 MB of %2 MB").arg(total / (1024 * 1024)).arg(budget / (1024 * 1024));
+        m_memoryUsage->setToolTip(tooltip);
 }
 
 
@@ -560,6 +595,8 @@ ProgressToolBar::ProgressToolBar(QWidget* parent)
 	m_progressBar->setMinimumWidth(800);
 	addWidget(m_progressBar);
 	m_progressBar->setEnabled(false);
+	m_label = tr("Converting");
+	m_throughput = 0.0;
 	filecount = 1;
 	filenum = 1;
 
@@ -573,17 +610,19 @@ ProgressToolBar::~ProgressToolBar()
 {
 }
 
+// The files are converted concurrently by the TConversionService,
+// i is the progress of all queued files together.
 void ProgressToolBar::set_progress(int i)
 {
 	if (i == m_progressBar->maximum()) {
-		if (filenum == filecount) {
-			hide();
-			m_progressBar->reset();
-			m_progressBar->setEnabled(false);
-			return;
-		} else {
-			++filenum;
-		}
+		hide();
+		m_progressBar->reset();
+		m_progressBar->setEnabled(false);
+		m_label = tr("Converting");
+		m_throughput = 0.0;
+		filenum = 1;
+		update_format();
+		return;
 	}
 
 	if (!m_progressBar->isEnabled()) {
@@ -597,7 +636,11 @@ void ProgressToolBar::set_progress(int i)
 void ProgressToolBar::set_label(QString s)
 {
 	Q_UNUSED(s);
-	m_progressBar->setFormat(tr("Importing file %1 of %2: %p%").arg(filenum).arg(filecount));
+	m_label = tr("Importing file %1 of %2").arg(filenum).arg(filecount);
+	if (filenum < filecount) {
+		++filenum;
+	}
+	update_format();
 }
 
 void ProgressToolBar::set_num_files(int i)
@@ -606,4 +649,26 @@ void ProgressToolBar::set_num_files(int i)
 	filenum = 1;
 }
 
+// Seconds of audio converted per second
+void ProgressToolBar::set_throughput(double throughput)
+{
+	m_throughput = throughput;
+	update_format();
+}
+
+// Also called when the remaining jobs were cancelled, and 100% was never reached
+void ProgressToolBar::batch_finished()
+{
+	set_progress(m_progressBar->maximum());
+}
+
+void ProgressToolBar::update_format()
+{
+	if (m_throughput > 0.0) {
+		m_progressBar->setFormat(tr("%1: %p% (%2x realtime)").arg(m_label).arg(m_throughput, 0, 'f', 1));
+	} else {
+		m_progressBar->setFormat(m_label + ": %p%");
+	}
+}
+
 //eof
@@ -73,6 +73,7 @@ private:
 	SystemValueBar*	m_readBufferStatus;
 	SystemValueBar*	m_writeBufferStatus;
         SystemValueBar*	m_cpuUsage;
+        SystemValueBar*	m_memoryUsage;
         QPushButton*	m_icon;
         QLabel*         m_collectedNumber;
 
@@ -195,11 +196,17 @@ public slots:
 	void set_progress(int);
 	void set_label(QString);
 	void set_num_files(int);
+	void set_throughput(double);
+	void batch_finished();
 
 private:
 	QProgressBar*	m_progressBar;
+	QString		m_label;
+	double		m_throughput;
 	int		filecount;
 	int		filenum;
+
+	void update_format();
 };
 
 #endif
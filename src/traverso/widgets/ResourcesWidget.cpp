@@ -32,7 +32,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #include <Themer.h>
 
 #include <QHeaderView>
-#include <QDirModel>
+#include <QFileSystemModel>
 #include <QListView>
 #include <QPushButton>
 #include <QHBoxLayout>
@@ -52,8 +52,11 @@ void FileWidget::showEvent( QShowEvent * event ) {
 	QPalette palette;
 	palette.setColor(QPalette::AlternateBase, themer()->get_color("ResourcesBin:alternaterowcolor"));
 		
-	m_dirModel = new QDirModel;
-	m_dirModel->setFilter(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+	// QFileSystemModel reads the directories in a separate thread, and
+	// watches the ones it has read, so the view never blocks on large
+	// (or network) directories and needs no manual refresh.
+	m_dirModel = new QFileSystemModel(this);
+	m_dirModel->setFilter(QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot);
 	m_dirView = new QListView;
 	m_dirView->setModel(m_dirModel);
 	m_dirView->setDragEnabled(true);
@@ -61,7 +64,6 @@ void FileWidget::showEvent( QShowEvent * event ) {
 	m_dirView->setSelectionMode(QAbstractItemView::ExtendedSelection);
 	m_dirView->setAlternatingRowColors(true);
 	m_dirView->setPalette(palette);
-	m_dirModel->setSorting(QDir::DirsFirst | QDir::Name | QDir::IgnoreCase);
 		
 	m_box = new QComboBox(this);
 	m_box->addItem("", "");
@@ -79,16 +81,8 @@ void FileWidget::showEvent( QShowEvent * event ) {
 	upButton->setMaximumHeight(25);
 	upButton->setMaximumWidth(30);
 		
-	QPushButton* refreshButton = new QPushButton(this);
-	QIcon refreshIcon = QIcon(find_pixmap(":/refresh-16"));
-	refreshButton->setToolTip(tr("Refresh File View"));
-	refreshButton->setIcon(refreshIcon);
-	refreshButton->setMaximumHeight(25);
-	refreshButton->setMaximumWidth(30);
-		
 	QHBoxLayout* hlay = new QHBoxLayout;
 	hlay->addWidget(upButton);
-	hlay->addWidget(refreshButton);
 	hlay->addWidget(m_box, 10);
 		
 	QVBoxLayout* lay = new QVBoxLayout(this);
@@ -101,13 +95,13 @@ void FileWidget::showEvent( QShowEvent * event ) {
 		
 	connect(m_dirView, SIGNAL(clicked(const QModelIndex& )), this, SLOT(dirview_item_clicked(const QModelIndex&)));
 	connect(upButton, SIGNAL(clicked()), this, SLOT(dir_up_button_clicked()));
-	connect(refreshButton, SIGNAL(clicked()), this, SLOT(refresh_button_clicked()));
 	connect(m_box, SIGNAL(activated(int)), this, SLOT(box_actived(int)));
 }
 		
 void FileWidget::dirview_item_clicked(const QModelIndex & index)
 {
 	if (m_dirModel->isDir(index)) {
+		m_dirModel->setRootPath(m_dirModel->filePath(index));
 		m_dirView->setRootIndex(index);
 		pm().get_project()->set_import_dir(m_dirModel->filePath(index));
 		m_box->setItemText(0, m_dirModel->filePath(index));
@@ -137,25 +131,20 @@ void FileWidget::dir_up_button_clicked()
 	}
 #endif
 	
-	m_dirView->setRootIndex(m_dirModel->index(dir.canonicalPath()));
+	m_dirView->setRootIndex(m_dirModel->setRootPath(dir.canonicalPath()));
 	m_box->setItemText(0, text);
 	m_box->setItemData(0, dir.canonicalPath());
 	m_box->setCurrentIndex(0);
 }
 
-void FileWidget::refresh_button_clicked()
-{
-	m_dirModel->refresh(m_dirView->rootIndex());
-}
-
 void FileWidget::box_actived(int i)
 {
-	m_dirView->setRootIndex(m_dirModel->index(m_box->itemData(i).toString()));
+	m_dirView->setRootIndex(m_dirModel->setRootPath(m_box->itemData(i).toString()));
 }
 
 void FileWidget::set_current_path(const QString& path) const
 {
-	m_dirView->setRootIndex(m_dirModel->index(path));
+	m_dirView->setRootIndex(m_dirModel->setRootPath(path));
 	m_box->setItemText(0, path);
 	m_box->setItemData(0, path);
 }
@@ -164,7 +153,7 @@ void FileWidget::set_current_path(const QString& path) const
 ResourcesWidget::ResourcesWidget(QWidget * parent)
 	: QWidget(parent)
 {
-	sourcesTreeWidget = 0;
+	sourcesTreeView = 0;
 }
 
 ResourcesWidget::~ ResourcesWidget()
@@ -175,29 +164,32 @@ void ResourcesWidget::showEvent( QShowEvent * event )
 {
 	Q_UNUSED(event);
 	
-	if (sourcesTreeWidget) {
+	if (sourcesTreeView) {
 		return;
 	}
 	
 	setupUi(this);
 	
+	m_model = new ResourcesModel(this);
+	sourcesTreeView->setModel(m_model);
+	
 	QPalette palette;
 	palette.setColor(QPalette::AlternateBase, themer()->get_color("ResourcesBin:alternaterowcolor"));
-	sourcesTreeWidget->setPalette(palette);
-	sourcesTreeWidget->setSelectionMode(QAbstractItemView::ExtendedSelection);
-	sourcesTreeWidget->setAlternatingRowColors(true);
-	sourcesTreeWidget->setDragEnabled(true);
-	sourcesTreeWidget->setDropIndicatorShown(true);
-	sourcesTreeWidget->setIndentation(COLUMN_INDENTION);
-	sourcesTreeWidget->header()->setResizeMode(0, QHeaderView::Fixed);
-	sourcesTreeWidget->header()->setResizeMode(1, QHeaderView::Fixed);
-	sourcesTreeWidget->header()->setResizeMode(2, QHeaderView::Fixed);
-	sourcesTreeWidget->header()->setResizeMode(3, QHeaderView::Fixed);
-	sourcesTreeWidget->header()->resizeSection(1, LENGTH_SECTION_WIDTH);
-	sourcesTreeWidget->header()->resizeSection(2, LENGTH_SECTION_WIDTH);
-	sourcesTreeWidget->header()->resizeSection(3, LENGTH_SECTION_WIDTH);
-	sourcesTreeWidget->header()->setStretchLastSection(false);
-	sourcesTreeWidget->setUniformRowHeights(true);
+	sourcesTreeView->setPalette(palette);
+	sourcesTreeView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+	sourcesTreeView->setAlternatingRowColors(true);
+	sourcesTreeView->setDragEnabled(true);
+	sourcesTreeView->setDropIndicatorShown(true);
+	sourcesTreeView->setIndentation(COLUMN_INDENTION);
+	sourcesTreeView->header()->setResizeMode(0, QHeaderView::Fixed);
+	sourcesTreeView->header()->setResizeMode(1, QHeaderView::Fixed);
+	sourcesTreeView->header()->setResizeMode(2, QHeaderView::Fixed);
+	sourcesTreeView->header()->setResizeMode(3, QHeaderView::Fixed);
+	sourcesTreeView->header()->resizeSection(1, LENGTH_SECTION_WIDTH);
+	sourcesTreeView->header()->resizeSection(2, LENGTH_SECTION_WIDTH);
+	sourcesTreeView->header()->resizeSection(3, LENGTH_SECTION_WIDTH);
+	sourcesTreeView->header()->setStretchLastSection(false);
+	sourcesTreeView->setUniformRowHeights(true);
 	
 	
 	m_filewidget = new FileWidget(this);
@@ -223,14 +215,12 @@ void ResourcesWidget::set_project(Project * project)
 {
         m_project = project;
 
-        sourcesTreeWidget->clear();
-	m_sourceindices.clear();
-	m_clipindices.clear();
+	m_model->clear();
 	sheetComboBox->clear();
+	m_currentSheet = 0;
 	
 	if (!m_project) {
 		sheetComboBox->setEnabled(false);
-		m_currentSheet = 0;
 		return;
 	}
 	
@@ -245,42 +235,27 @@ void ResourcesWidget::project_load_finished()
 		return;
 	}
 	
-	ResourcesManager* rsmanager = m_project->get_audiosource_manager();
-	
 	connect(m_project, SIGNAL(sheetAdded(Sheet*)), this, SLOT(sheet_added(Sheet*)));
 	connect(m_project, SIGNAL(sheetRemoved(Sheet*)), this, SLOT(sheet_removed(Sheet*)));
         connect(m_project, SIGNAL(currentSessionChanged(TSession*)), this, SLOT(set_current_session(TSession*)));
 	
-	connect(rsmanager, SIGNAL(clipAdded(AudioClip*)), this, SLOT(add_clip(AudioClip*)));
-	connect(rsmanager, SIGNAL(clipRemoved(AudioClip*)), this, SLOT(remove_clip(AudioClip*)));
-	connect(rsmanager, SIGNAL(sourceAdded(ReadSource*)), this, SLOT(add_source(ReadSource*)));
-	connect(rsmanager, SIGNAL(sourceRemoved(ReadSource*)), this, SLOT(remove_source(ReadSource*)));
-	
-	foreach(ReadSource* rs, resources_manager()->get_all_audio_sources()) {
-		add_source(rs);
-	}
-	
-	foreach(AudioClip* clip, resources_manager()->get_all_clips()) {
-		add_clip(clip);
-	}
+	m_model->set_resources_manager(m_project->get_audiosource_manager());
 	
 	foreach(Sheet* sheet, m_project->get_sheets()) {
 		sheet_added(sheet);
 	}
 	
         set_current_sheet(qobject_cast<Sheet*>(m_project->get_current_session()));
-
-	sourcesTreeWidget->sortItems(0, Qt::AscendingOrder);
 }
 
 void ResourcesWidget::view_combo_box_index_changed(int index)
 {
 	if (index == 0) {
-		sourcesTreeWidget->show();
+		sourcesTreeView->show();
 		sheetComboBox->show();
 		m_filewidget->hide();
 	} else if (index == 1) {
-		sourcesTreeWidget->hide();
+		sourcesTreeView->hide();
 		sheetComboBox->hide();
 		m_filewidget->show();
                 if (m_project) {
@@ -327,215 +302,644 @@ void ResourcesWidget::set_current_sheet(Sheet * sheet)
 	
 	m_currentSheet = sheet;
 	
-	filter_on_current_sheet();
+	if (m_currentSheet) {
+		m_model->set_filter_sheet(m_currentSheet);
+	}
+}
+
+
+/**
+ * \class ResourcesModel
+ * \brief Model of the ReadSources and their AudioClips of a Project, filtered on a Sheet
+ *
+ * The model is fed directly from the ResourcesManager signals. Top level rows are the
+ * ReadSources created by, or used by a clip on the filter Sheet, sorted by name. The
+ * clips of a source are only collected when it's row is expanded (fetchMore()).
+ *
+ * For each sheet the model keeps the number of references to each source, updated when
+ * a source or clip is added or removed. Switching the filter sheet takes the visible
+ * sources from that index, without walking all sources and clips.
+ *
+ * Without a filter sheet, all sources and clips are shown.
+ */
+
+enum {
+	NAME_COLUMN,
+	LENGTH_COLUMN,
+	START_COLUMN,
+	END_COLUMN,
+	COLUMN_COUNT
+};
+
+ResourcesModel::ResourcesModel(QObject * parent)
+	: QAbstractItemModel(parent)
+	, m_manager(0)
+	, m_sheetId(0)
+{
+}
+
+ResourcesModel::~ResourcesModel()
+{
+	qDeleteAll(m_nodes);
+}
+
+void ResourcesModel::clear()
+{
+	foreach(SourceNode* node, m_nodes) {
+		disconnect(node->source, 0, this, 0);
+		foreach(AudioClip* clip, node->clips) {
+			disconnect(clip, 0, this, 0);
+		}
+	}
+	
+	if (m_manager) {
+		disconnect(m_manager, 0, this, 0);
+		m_manager = 0;
+	}
+	
+	qDeleteAll(m_nodes);
+	m_nodes.clear();
+	m_clips.clear();
+	m_sheetRefs.clear();
+	m_rows.clear();
+	m_sheetId = 0;
+	
+	reset();
 }
 
+void ResourcesModel::set_resources_manager(ResourcesManager * manager)
+{
+	clear();
+	
+	m_manager = manager;
+	connect(manager, SIGNAL(clipAdded(AudioClip*)), this, SLOT(add_clip(AudioClip*)));
+	connect(manager, SIGNAL(clipRemoved(AudioClip*)), this, SLOT(update_clip(AudioClip*)));
+	connect(manager, SIGNAL(sourceAdded(ReadSource*)), this, SLOT(add_source(ReadSource*)));
+	connect(manager, SIGNAL(sourceRemoved(ReadSource*)), this, SLOT(remove_source(ReadSource*)));
+	
+	// Fill the indices without notifying the views for each item,
+	// and sort the rows once.
+	foreach(ReadSource* source, manager->get_all_audio_sources()) {
+		SourceNode* node = new SourceNode;
+		node->source = source;
+		node->row = -1;
+		node->populated = false;
+		m_nodes.insert(source->get_id(), node);
+		m_sheetRefs[source->get_orig_sheet_id()][source->get_id()]++;
+		connect(source, SIGNAL(stateChanged()), this, SLOT(source_state_changed()));
+	}
+	
+	foreach(AudioClip* clip, manager->get_all_clips()) {
+		SourceNode* node = m_nodes.value(clip->get_readsource_id());
+		if (!node) {
+			continue;
+		}
+		node->clips.append(clip);
+		m_clips.insert(clip, ClipRef(node, clip->get_sheet_id()));
+		m_sheetRefs[clip->get_sheet_id()][clip->get_readsource_id()]++;
+		connect(clip, SIGNAL(recordingFinished(AudioClip*)), this, SLOT(clip_state_changed()));
+		connect(clip, SIGNAL(stateChanged()), this, SLOT(clip_state_changed()));
+		connect(clip, SIGNAL(positionChanged()), this, SLOT(clip_state_changed()));
+		connect(clip, SIGNAL(destroyed(QObject*)), this, SLOT(clip_destroyed(QObject*)));
+	}
+	
+	m_rows = m_nodes.values();
+	qSort(m_rows.begin(), m_rows.end(), name_smaller);
+	number_rows(0);
+	
+	reset();
+}
 
-void ResourcesWidget::filter_on_current_sheet()
+/**
+ * Shows only the sources and clips of \a sheet.
+ */
+void ResourcesModel::set_filter_sheet(Sheet * sheet)
 {
-	if (!m_currentSheet) {
+	qint64 sheetId = sheet ? sheet->get_id() : 0;
+	
+	if (sheetId == m_sheetId) {
 		return;
 	}
 	
-	foreach(ClipTreeItem* item, m_clipindices.values()) {
-		item->apply_filter(m_currentSheet);
+	foreach(SourceNode* node, m_rows) {
+		node->row = -1;
+		node->populated = false;
+		node->children.clear();
+	}
+	m_rows.clear();
+	
+	m_sheetId = sheetId;
+	
+	if (m_sheetId) {
+		QHash<qint64, int> refs = m_sheetRefs.value(m_sheetId);
+		QHash<qint64, int>::const_iterator it = refs.constBegin();
+		while (it != refs.constEnd()) {
+			SourceNode* node = m_nodes.value(it.key());
+			if (node) {
+				m_rows.append(node);
+			}
+			++it;
+		}
+	} else {
+		m_rows = m_nodes.values();
+	}
+	
+	qSort(m_rows.begin(), m_rows.end(), name_smaller);
+	number_rows(0);
+	
+	reset();
+}
+
+bool ResourcesModel::name_smaller(const SourceNode * left, const SourceNode * right)
+{
+	return left->source->get_short_name() < right->source->get_short_name();
+}
+
+bool ResourcesModel::is_clip_visible(AudioClip * clip) const
+{
+	return !m_sheetId || clip->get_sheet_id() == m_sheetId;
+}
+
+void ResourcesModel::add_reference(qint64 sheetId, SourceNode * node)
+{
+	int& refs = m_sheetRefs[sheetId][node->source->get_id()];
+	refs++;
+	
+	if (refs == 1 && sheetId == m_sheetId) {
+		insert_row(node);
 	}
+}
 
+void ResourcesModel::remove_reference(qint64 sheetId, SourceNode * node)
+{
+	QHash<qint64, int>& refs = m_sheetRefs[sheetId];
+	qint64 id = node->source->get_id();
 	
-	foreach(SourceTreeItem* item, m_sourceindices.values()) {
-		item->apply_filter(m_currentSheet);
+	if (--refs[id] > 0) {
+		return;
+	}
+	
+	refs.remove(id);
+	
+	if (sheetId == m_sheetId) {
+		remove_row(node);
 	}
 }
 
+void ResourcesModel::number_rows(int from)
+{
+	for (int i=from; i<m_rows.size(); ++i) {
+		m_rows.at(i)->row = i;
+	}
+}
 
-void ResourcesWidget::add_clip(AudioClip * clip)
+void ResourcesModel::insert_row(SourceNode * node)
 {
-	ClipTreeItem* item = m_clipindices.value(clip->get_id());
+	if (node->row != -1) {
+		return;
+	}
+	
+	int row = qLowerBound(m_rows.begin(), m_rows.end(), node, name_smaller) - m_rows.begin();
 	
-	if (!item) {
-		SourceTreeItem* sourceitem = m_sourceindices.value(clip->get_readsource_id());
+	beginInsertRows(QModelIndex(), row, row);
+	m_rows.insert(row, node);
+	number_rows(row);
+	endInsertRows();
+}
+
+void ResourcesModel::remove_row(SourceNode * node)
+{
+	if (node->row == -1) {
+		return;
+	}
 	
-		if (! sourceitem ) return;
+	int row = node->row;
 	
-		ClipTreeItem* clipitem = new ClipTreeItem(sourceitem, clip);
-		m_clipindices.insert(clip->get_id(), clipitem);
-		
-		clipitem->setTextAlignment(1, Qt::AlignHCenter);
-		clipitem->setTextAlignment(2, Qt::AlignHCenter);
-		clipitem->setTextAlignment(3, Qt::AlignLeft);
-		
-		connect(clip, SIGNAL(positionChanged()), clipitem, SLOT(clip_state_changed()));
+	beginRemoveRows(QModelIndex(), row, row);
+	m_rows.removeAt(row);
+	node->row = -1;
+	node->populated = false;
+	node->children.clear();
+	number_rows(row);
+	endRemoveRows();
+}
+
+void ResourcesModel::populate(SourceNode * node, bool notify)
+{
+	QList<AudioClip*> children;
+	foreach(AudioClip* clip, node->clips) {
+		if (is_clip_visible(clip)) {
+			children.append(clip);
+		}
 	}
 	
-	update_clip_state(clip);
+	node->populated = true;
+	
+	if (children.isEmpty()) {
+		return;
+	}
+	
+	if (notify) {
+		beginInsertRows(source_index(node), 0, children.size() - 1);
+	}
+	node->children = children;
+	if (notify) {
+		endInsertRows();
+	}
 }
 
-void ResourcesWidget::remove_clip(AudioClip * clip)
+void ResourcesModel::add_source(ReadSource * source)
 {
-	ClipTreeItem* item = m_clipindices.value(clip->get_id());
+	SourceNode* node = m_nodes.value(source->get_id());
 	
-	if (!item) {
-		 return;
+	if (node) {
+		source_row_changed(node);
+		return;
 	}
 	
-	update_clip_state(clip);
+	node = new SourceNode;
+	node->source = source;
+	node->row = -1;
+	node->populated = false;
+	m_nodes.insert(source->get_id(), node);
+	connect(source, SIGNAL(stateChanged()), this, SLOT(source_state_changed()));
+	
+	if (!m_sheetId) {
+		insert_row(node);
+	}
+	add_reference(source->get_orig_sheet_id(), node);
 }
 
-void ResourcesWidget::add_source(ReadSource * source)
+void ResourcesModel::remove_source(ReadSource * source)
 {
-	SourceTreeItem* item = m_sourceindices.value(source->get_id());
+	SourceNode* node = m_nodes.value(source->get_id());
 	
-	if (! item) {
-		item = new SourceTreeItem(sourcesTreeWidget, source);
-		m_sourceindices.insert(source->get_id(), item);
-		item->setTextAlignment(1, Qt::AlignHCenter);
-		item->setTextAlignment(2, Qt::AlignHCenter);
-		item->setTextAlignment(3, Qt::AlignLeft);
+	if (!node) {
+		return;
 	}
 	
-	item->source_state_changed();
+	remove_row(node);
+	
+	QMutableHashIterator<qint64, QHash<qint64, int> > it(m_sheetRefs);
+	while (it.hasNext()) {
+		it.next();
+		it.value().remove(source->get_id());
+	}
+	
+	disconnect(source, 0, this, 0);
+	foreach(AudioClip* clip, node->clips) {
+		disconnect(clip, 0, this, 0);
+		m_clips.remove(clip);
+	}
+	
+	m_nodes.remove(source->get_id());
+	delete node;
 }
 
-void ResourcesWidget::remove_source(ReadSource * source)
+void ResourcesModel::add_clip(AudioClip * clip)
 {
-	SourceTreeItem* item = m_sourceindices.value(source->get_id());
+	if (m_clips.contains(clip)) {
+		update_clip(clip);
+		return;
+	}
+	
+	SourceNode* node = m_nodes.value(clip->get_readsource_id());
+	
+	if (!node) {
+		return;
+	}
+	
+	node->clips.append(clip);
+	m_clips.insert(clip, ClipRef(node, clip->get_sheet_id()));
+	connect(clip, SIGNAL(recordingFinished(AudioClip*)), this, SLOT(clip_state_changed()));
+	connect(clip, SIGNAL(stateChanged()), this, SLOT(clip_state_changed()));
+	connect(clip, SIGNAL(positionChanged()), this, SLOT(clip_state_changed()));
+	connect(clip, SIGNAL(destroyed(QObject*)), this, SLOT(clip_destroyed(QObject*)));
+	
+	bool wasVisible = (node->row != -1);
+	
+	add_reference(clip->get_sheet_id(), node);
+	
+	if (wasVisible && is_clip_visible(clip)) {
+		if (node->populated) {
+			int row = node->children.size();
+			beginInsertRows(source_index(node), row, row);
+			node->children.append(clip);
+			endInsertRows();
+		} else {
+			// The view doesn't notice a row that gets it's first child,
+			// populating it now informs the view in either case.
+			populate(node, true);
+		}
+	}
+	
+	source_row_changed(node);
+}
 
-	if (!item) {
+/**
+ * Removed clips stay listed (in light gray), they can be dragged onto a track again.
+ */
+void ResourcesModel::update_clip(AudioClip * clip)
+{
+	SourceNode* node = m_clips.value(clip).node;
+	
+	if (!node) {
 		return;
 	}
+	
+	int row = node->children.indexOf(clip);
+	if (row != -1) {
+		QModelIndex parent = source_index(node);
+		emit dataChanged(index(row, 0, parent), index(row, COLUMN_COUNT - 1, parent));
+	}
+	
+	source_row_changed(node);
+}
 
-	m_sourceindices.remove(source->get_id());
-	sourcesTreeWidget->takeTopLevelItem(sourcesTreeWidget->indexOfTopLevelItem(item));
-	delete item;
+void ResourcesModel::clip_state_changed()
+{
+	AudioClip* clip = qobject_cast<AudioClip*>(sender());
+	if (clip) {
+		update_clip(clip);
+	}
 }
 
-void ResourcesWidget::update_clip_state(AudioClip* clip)
+void ResourcesModel::clip_destroyed(QObject * obj)
 {
-	ClipTreeItem* item = m_clipindices.value(clip->get_id());
-	Q_ASSERT(item);
+	// The AudioClip part is already destroyed, only use it as a key.
+	AudioClip* clip = static_cast<AudioClip*>(obj);
+	ClipRef ref = m_clips.take(clip);
+	SourceNode* node = ref.node;
 	
-	item->clip_state_changed();
+	if (!node) {
+		return;
+	}
+	
+	node->clips.removeAll(clip);
 	
-	update_source_state(clip->get_readsource_id());
+	int row = node->children.indexOf(clip);
+	if (row != -1) {
+		beginRemoveRows(source_index(node), row, row);
+		node->children.removeAt(row);
+		endRemoveRows();
+	}
+	
+	remove_reference(ref.sheetId, node);
 }
 
-void ResourcesWidget::update_source_state(qint64 id)
+void ResourcesModel::source_state_changed()
 {
-	SourceTreeItem* item = m_sourceindices.value(id);
-	Q_ASSERT(item);
-	item->source_state_changed();
+	ReadSource* source = qobject_cast<ReadSource*>(sender());
+	if (!source) {
+		return;
+	}
+	
+	SourceNode* node = m_nodes.value(source->get_id());
+	if (node) {
+		source_row_changed(node);
+	}
 }
 
-ClipTreeItem::ClipTreeItem(SourceTreeItem * parent, AudioClip * clip)
-	: QTreeWidgetItem(parent)
-	, m_clip(clip)
+void ResourcesModel::source_row_changed(SourceNode * node)
 {
-	setData(0, Qt::UserRole, clip->get_id());
-	connect(clip, SIGNAL(recordingFinished(AudioClip*)), this, SLOT(clip_state_changed()));
-	connect(clip, SIGNAL(stateChanged()), this, SLOT(clip_state_changed()));
+	if (node->row == -1) {
+		return;
+	}
+	
+	emit dataChanged(index(node->row, 0), index(node->row, COLUMN_COUNT - 1));
 }
 
-void ClipTreeItem::clip_state_changed()
+QModelIndex ResourcesModel::source_index(SourceNode * node, int column) const
 {
-	if (resources_manager()->is_clip_in_use(m_clip->get_id())) {
-		for (int i=0; i<5; ++i) {
-			setForeground(i, QColor(Qt::black));
-		}
-	} else {
-		for (int i=0; i<5; ++i) {
-			setForeground(i, QColor(Qt::lightGray));
-		}
+	if (node->row == -1) {
+		return QModelIndex();
 	}
 	
-	QString start = timeref_to_ms(m_clip->get_source_start_location());
-	QString end = timeref_to_ms(m_clip->get_source_end_location());
-		
-	setText(0, m_clip->get_name());
-	setText(1, timeref_to_ms(m_clip->get_length()));
-	setText(2, start);
-	setText(3, end);
-	setToolTip(0, m_clip->get_name() + "   " + start + " - " + end);
+	return createIndex(node->row, column);
 }
 
-void ClipTreeItem::apply_filter(Sheet * sheet)
+QModelIndex ResourcesModel::index(int row, int column, const QModelIndex & parent) const
 {
-	if (m_clip->get_sheet_id() == sheet->get_id()) {
-		if (isHidden()) {
-			setHidden(false);
-		}
-	} else {
-		if (!isHidden()) {
-			setHidden(true);
+	if (row < 0 || column < 0 || column >= COLUMN_COUNT) {
+		return QModelIndex();
+	}
+	
+	// Top level indices have no internal pointer, clip indices point to their SourceNode
+	if (!parent.isValid()) {
+		if (row >= m_rows.size()) {
+			return QModelIndex();
 		}
-	} 
+		return createIndex(row, column);
+	}
+	
+	if (parent.internalPointer() || parent.row() >= m_rows.size()) {
+		return QModelIndex();
+	}
+	
+	SourceNode* node = m_rows.at(parent.row());
+	if (row >= node->children.size()) {
+		return QModelIndex();
+	}
+	
+	return createIndex(row, column, node);
+}
+
+QModelIndex ResourcesModel::parent(const QModelIndex & child) const
+{
+	if (!child.isValid() || !child.internalPointer()) {
+		return QModelIndex();
+	}
+	
+	return source_index(static_cast<SourceNode*>(child.internalPointer()));
+}
+
+int ResourcesModel::rowCount(const QModelIndex & parent) const
+{
+	if (!parent.isValid()) {
+		return m_rows.size();
+	}
+	
+	if (parent.internalPointer() || parent.column() != 0) {
+		return 0;
+	}
+	
+	return m_rows.at(parent.row())->children.size();
 }
 
+int ResourcesModel::columnCount(const QModelIndex & parent) const
+{
+	Q_UNUSED(parent);
+	return COLUMN_COUNT;
+}
 
+bool ResourcesModel::hasChildren(const QModelIndex & parent) const
+{
+	if (!parent.isValid()) {
+		return m_rows.size() > 0;
+	}
+	
+	if (parent.internalPointer() || parent.column() != 0) {
+		return false;
+	}
+	
+	SourceNode* node = m_rows.at(parent.row());
+	if (node->populated) {
+		return node->children.size() > 0;
+	}
+	
+	// A source is shown for the filter sheet when created by it, or for it's clips
+	if (!m_sheetId) {
+		return node->clips.size() > 0;
+	}
+	int refs = m_sheetRefs.value(m_sheetId).value(node->source->get_id());
+	return refs > (node->source->get_orig_sheet_id() == m_sheetId ? 1 : 0);
+}
 
-SourceTreeItem::SourceTreeItem(QTreeWidget* parent, ReadSource * source)
-	: QTreeWidgetItem(parent)
-	, m_source(source)
+bool ResourcesModel::canFetchMore(const QModelIndex & parent) const
 {
-	connect(m_source, SIGNAL(stateChanged()), this, SLOT(source_state_changed()));
+	if (!parent.isValid() || parent.internalPointer() || parent.column() != 0) {
+		return false;
+	}
+	
+	return !m_rows.at(parent.row())->populated;
 }
 
-void SourceTreeItem::apply_filter(Sheet * sheet)
+void ResourcesModel::fetchMore(const QModelIndex & parent)
 {
-	if (m_source->get_orig_sheet_id() == sheet->get_id()) {
-		setHidden(false);
+	if (!canFetchMore(parent)) {
 		return;
 	}
 	
-	bool show = false;
+	populate(m_rows.at(parent.row()), true);
+}
+
+QVariant ResourcesModel::data(const QModelIndex & index, int role) const
+{
+	if (!index.isValid()) {
+		return QVariant();
+	}
+	
+	SourceNode* parentNode = static_cast<SourceNode*>(index.internalPointer());
+	
+	if (!parentNode) {
+		ReadSource* source = m_rows.at(index.row())->source;
 		
-	for (int i=0; i < childCount(); ++i) {
-		if (!child(i)->isHidden()) {
-			show = true;
+		switch (role) {
+		case Qt::DisplayRole:
+			switch (index.column()) {
+				case NAME_COLUMN: return source->get_short_name();
+				case LENGTH_COLUMN: return timeref_to_ms(source->get_length());
+				default: return QString();
+			}
+		case Qt::ToolTipRole:
+			if (index.column() == NAME_COLUMN) {
+				return source->get_short_name() + "   " + timeref_to_ms(source->get_length());
+			}
+			break;
+		case Qt::ForegroundRole:
+			if (resources_manager()->is_source_in_use(source->get_id())) {
+				return QColor(Qt::black);
+			}
+			return QColor(Qt::lightGray);
+		case Qt::UserRole:
+			if (index.column() == NAME_COLUMN) {
+				return source->get_id();
+			}
 			break;
 		}
-	}
-		
-	if (show) {
-		setHidden(false);
 	} else {
-		setHidden(true);
+		AudioClip* clip = parentNode->children.at(index.row());
+		
+		switch (role) {
+		case Qt::DisplayRole:
+			switch (index.column()) {
+				case NAME_COLUMN: return clip->get_name();
+				case LENGTH_COLUMN: return timeref_to_ms(clip->get_length());
+				case START_COLUMN: return timeref_to_ms(clip->get_source_start_location());
+				case END_COLUMN: return timeref_to_ms(clip->get_source_end_location());
+			}
+			break;
+		case Qt::ToolTipRole:
+			if (index.column() == NAME_COLUMN) {
+				return clip->get_name() + "   " + timeref_to_ms(clip->get_source_start_location())
+						+ " - " + timeref_to_ms(clip->get_source_end_location());
+			}
+			break;
+		case Qt::ForegroundRole:
+			if (resources_manager()->is_clip_in_use(clip->get_id())) {
+				return QColor(Qt::black);
+			}
+			return QColor(Qt::lightGray);
+		case Qt::UserRole:
+			if (index.column() == NAME_COLUMN) {
+				return clip->get_id();
+			}
+			break;
+		}
 	}
+	
+	if (role == Qt::TextAlignmentRole) {
+		if (index.column() == LENGTH_COLUMN || index.column() == START_COLUMN) {
+			return int(Qt::AlignHCenter);
+		}
+		if (index.column() == END_COLUMN) {
+			return int(Qt::AlignLeft);
+		}
+	}
+	
+	return QVariant();
 }
 
-void SourceTreeItem::source_state_changed()
+/**
+ * The ids (Qt::UserRole) are part of the drag data, the ClipsViewPort uses them on drop.
+ */
+QMap<int, QVariant> ResourcesModel::itemData(const QModelIndex & index) const
 {
-	if (resources_manager()->is_source_in_use(m_source->get_id())) {
-		for (int i=0; i<5; ++i) {
-			setForeground(i, QColor(Qt::black));
-		}
-	} else {
-		for (int i=0; i<5; ++i) {
-			setForeground(i, QColor(Qt::lightGray));
-		}
+	QMap<int, QVariant> roles = QAbstractItemModel::itemData(index);
+	
+	QVariant id = data(index, Qt::UserRole);
+	if (id.isValid()) {
+		roles.insert(Qt::UserRole, id);
+	}
+	
+	return roles;
+}
+
+QVariant ResourcesModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+		return QVariant();
 	}
 	
-	int rate = m_source->get_rate();
-	if (rate == 0) rate = pm().get_project()->get_rate();
-	QString duration = timeref_to_ms(m_source->get_length());
-	setText(0, m_source->get_short_name());
-	setText(1, duration);
-	setText(2, "");
-	setText(3, "");
-	setData(0, Qt::UserRole, m_source->get_id());
-	setToolTip(0, m_source->get_short_name() + "   " + duration);
+	switch (section) {
+		case NAME_COLUMN: return tr("Name");
+		case LENGTH_COLUMN: return tr("Length");
+		case START_COLUMN: return tr("Start");
+		case END_COLUMN: return tr("End");
+	}
+	
+	return QVariant();
+}
 
+Qt::ItemFlags ResourcesModel::flags(const QModelIndex & index) const
+{
+	if (!index.isValid()) {
+		return 0;
+	}
+	
+	return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsDragEnabled;
 }
 
 void ResourcesWidget::resizeEvent(QResizeEvent * e)
 {
-	if (sourcesTreeWidget) {
+	if (sourcesTreeView) {
 		int w = width() - COLUMN_INDENTION;
 		int nameSectionWidth = w - (3 * LENGTH_SECTION_WIDTH);
 		if (nameSectionWidth < 130) {
 			nameSectionWidth = 130;
 		}
 		
-		sourcesTreeWidget->header()->resizeSection(0, nameSectionWidth);
+		sourcesTreeView->header()->resizeSection(0, nameSectionWidth);
 	}
 }
 
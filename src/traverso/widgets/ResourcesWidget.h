@@ -23,17 +23,17 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA.
 #define RESOURCESWIDGET_H
 
 #include <QWidget>
-#include <QTreeWidgetItem>
+#include <QAbstractItemModel>
 #include "ui_ResourcesWidget.h"
 
 class Project;
 class Sheet;
 class AudioClip;
 class ReadSource;
-class SourceTreeItem;
+class ResourcesManager;
 class QShowEvent;
 class QListView;
-class QDirModel;
+class QFileSystemModel;
 class QComboBox;
 
 class FileWidget : public QWidget
@@ -51,47 +51,88 @@ public:
 private slots:
 	void dirview_item_clicked(const QModelIndex & index);
 	void dir_up_button_clicked();
-	void refresh_button_clicked();
 	void box_actived(int i);
 
 private:
 	QListView* m_dirView;
-	QDirModel* m_dirModel;
+	QFileSystemModel* m_dirModel;
 	QComboBox* m_box;
 };
 
 
-class ClipTreeItem : public QObject, public QTreeWidgetItem
+/**
+ * Model of the ReadSources and their AudioClips of a Project, filtered on a Sheet.
+ * See ResourcesWidget.cpp for details.
+ */
+class ResourcesModel : public QAbstractItemModel
 {
 	Q_OBJECT
-	
-public:
-	ClipTreeItem(SourceTreeItem* parent, AudioClip* clip);
-	
-	void apply_filter(Sheet* sheet);
-
 
-public slots:
-	void clip_state_changed();	
-
-private:
-	AudioClip* m_clip;
-};
-
-class SourceTreeItem : public QObject, public QTreeWidgetItem
-{
-	Q_OBJECT
-	
 public:
-	SourceTreeItem(QTreeWidget* parent, ReadSource* source);
-
-	void apply_filter(Sheet* sheet);
+	ResourcesModel(QObject* parent=0);
+	~ResourcesModel();
+
+	void set_resources_manager(ResourcesManager* manager);
+	void set_filter_sheet(Sheet* sheet);
+	void clear();
+
+	QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const;
+	QModelIndex parent(const QModelIndex& child) const;
+	int rowCount(const QModelIndex& parent = QModelIndex()) const;
+	int columnCount(const QModelIndex& parent = QModelIndex()) const;
+	bool hasChildren(const QModelIndex& parent = QModelIndex()) const;
+	bool canFetchMore(const QModelIndex& parent) const;
+	void fetchMore(const QModelIndex& parent);
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+	QMap<int, QVariant> itemData(const QModelIndex& index) const;
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+	Qt::ItemFlags flags(const QModelIndex& index) const;
 
 private:
-	ReadSource* m_source;
-	
+	struct SourceNode {
+		ReadSource*		source;
+		QList<AudioClip*>	clips;		// all clips using the source
+		QList<AudioClip*>	children;	// clips on the filter sheet, once populated
+		int			row;		// -1 when filtered out
+		bool			populated;
+	};
+
+	struct ClipRef {
+		ClipRef(SourceNode* n=0, qint64 id=0) : node(n), sheetId(id) {}
+		SourceNode*	node;
+		qint64		sheetId;	// the clip's sheet id when added, it's gone on destruction
+	};
+
+	ResourcesManager*		m_manager;
+	QHash<qint64, SourceNode*>	m_nodes;
+	QHash<AudioClip*, ClipRef>	m_clips;
+	// per sheet id, the number of references (clips, or created by) of each source id
+	QHash<qint64, QHash<qint64, int> > m_sheetRefs;
+	QList<SourceNode*>		m_rows;
+	qint64				m_sheetId;
+
+	bool is_clip_visible(AudioClip* clip) const;
+	void add_reference(qint64 sheetId, SourceNode* node);
+	void remove_reference(qint64 sheetId, SourceNode* node);
+	void insert_row(SourceNode* node);
+	void remove_row(SourceNode* node);
+	void number_rows(int from);
+	void populate(SourceNode* node, bool notify);
+	void source_row_changed(SourceNode* node);
+	QModelIndex source_index(SourceNode* node, int column=0) const;
+
+	static bool name_smaller(const SourceNode* left, const SourceNode* right);
+
 public slots:
+	void add_source(ReadSource* source);
+	void remove_source(ReadSource* source);
+	void add_clip(AudioClip* clip);
+	void update_clip(AudioClip* clip);
+
+private slots:
 	void source_state_changed();
+	void clip_state_changed();
+	void clip_destroyed(QObject* obj);
 };
 
 class ResourcesWidget : public QWidget, protected Ui::ResourcesWidget
@@ -110,13 +151,7 @@ private:
 	Project* m_project;
 	Sheet* m_currentSheet;
 	FileWidget* m_filewidget;
-	QHash<qint64, ClipTreeItem*> m_clipindices;
-	QHash<qint64, SourceTreeItem*> m_sourceindices;
-	
-	void update_clip_state(AudioClip* clip);
-	void update_source_state(qint64 id);
-	
-	void filter_on_current_sheet();
+	ResourcesModel* m_model;
 	
 private slots:
 	void set_project(Project* project);
@@ -128,11 +163,6 @@ private slots:
 	void sheet_added(Sheet* sheet);
 	void sheet_removed(Sheet* sheet);
 	void set_current_sheet(Sheet* sheet);
-	
-	void add_clip(AudioClip* clip);
-	void remove_clip(AudioClip* clip);
-	void add_source(ReadSource* source);
-	void remove_source(ReadSource* source);
 };
 
 
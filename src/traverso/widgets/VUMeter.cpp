@@ -36,6 +36,7 @@
 #include <AudioDevice.h>
 #include <AudioChannel.h>
 #include <AudioBus.h>
+#include <TMeterBus.h>
 
 // Always put me below _all_ includes, this is needed
 // in case we run with memory leak detection enabled!
@@ -460,14 +461,13 @@ void VUMeterOverLed::load_theme_data()
  * 60268-18. It ranges from +6.0 dB to -70.0 dB.
  *
  * A VUMeterLevel is usually constructed within a VUMeter object. The audio level is
- * read from an AudioChannel object, which must be given in the constructor. The
- * VUMeterLevel is optimized for efficient space usage and switches from 3D look
- * to 2D look for narrow sizes.
+ * read from the VUMonitor of an AudioChannel object, which must be given in the constructor,
+ * each time the TMeterBus signals a new snapshot. The VUMeterLevel is optimized for
+ * efficient space usage and switches from 3D look to 2D look for narrow sizes.
  */
 
 static const int OVER_SAMPLES_COUNT = 2;	// sensitivity of the 'over' indicator
-static const int RMS_SAMPLES = 50;		// number of updates to be stored for RMS calculation
-static const int UPDATE_FREQ = 40;		// frame rate of the level meter (update interval in ms)
+static const int UPDATE_FREQ = 40;		// frame rate of the level meter, driven by TMainWindow (update interval in ms)
 static const int PEAK_HOLD_TIME = 1000;		// peak hold time (ms)
 static const int PEAK_HOLD_MODE = 1;		// 0 = no peak hold, 1 = dynamic, 2 = constant
 static const bool SHOW_RMS = false;		// toggle RMS lines on / off
@@ -477,41 +477,35 @@ VUMeterLevel::VUMeterLevel(QWidget* parent, AudioChannel* chan)
 	: QWidget(parent)
 	, m_channel(chan)
 {
-        m_monitor = new VUMonitor();
-        m_channel->add_monitor(m_monitor);
+        m_monitor = m_channel->get_vumonitor();
 
 	tailDeltaY = peakHoldValue = rms = -120.0;
-	overCount = rmsIndex = 0;
+	overCount = 0;
+	peakHoldUpdates = 0;
 	peakHoldFalling = false;
 	peak = 0.0;
 	
 	// falloff speed, according to IEC 60268-18: 20 dB in 1.7 sec.
 	maxFalloff = 20.0 / (1700.0 / (float)UPDATE_FREQ);
 	
-	for (int i = 0; i < RMS_SAMPLES; i++) {
-		peakHistory[i] = 0.0;
-	}
-
 	setAttribute(Qt::WA_OpaquePaintEvent);
 	setAutoFillBackground(false);
 
 	connect(&audiodevice(), SIGNAL(stopped()), this, SLOT(stop()));
-	connect(&timer, SIGNAL(timeout()), this, SLOT(update_peak()));
-	connect(&phTimer, SIGNAL(timeout()), this, SLOT(reset_peak_hold_value()));
+	connect(&meterbus(), SIGNAL(snapshotUpdated()), this, SLOT(update_peak()));
 	connect(themer(), SIGNAL(themeLoaded()), this, SLOT(load_theme_data()), Qt::QueuedConnection);
 	load_theme_data();
 
-	timer.start(UPDATE_FREQ);
-	
-	if (PEAK_HOLD_MODE == 1) {
-		phTimer.start(PEAK_HOLD_TIME);
+	if (SHOW_RMS) {
+		meterbus().add_rms_user();
 	}
 }
 
 VUMeterLevel::~VUMeterLevel()
 {
-        // FIXME crashes when loading a project!
-//        delete m_monitor;
+	if (SHOW_RMS) {
+		meterbus().remove_rms_user();
+	}
 }
 
 void VUMeterLevel::paintEvent( QPaintEvent*  )
@@ -545,13 +539,10 @@ void VUMeterLevel::paintEvent( QPaintEvent*  )
 		peakHoldFalling = false;
 		peakHoldValue = dBVal;
 		
-		// Comment by Remon: EHH?? The phTimer is still running since it _is_ allready started from the 
-		// constructor, right? We don't stop the timer anywhere...
-		// Reply by Nic: The timer is REstarted here, which is done by QTimer::start(int) as well.
-		//	We want the new peak hold value to be held for 1 sec., so we restart the timer
-		//	as soon as a new phvalue was detected.
+		// We want the new peak hold value to be held for 1 sec., so we restart
+		// counting the updates as soon as a new phvalue was detected.
 		if (PEAK_HOLD_MODE == 1) {
-			phTimer.start(PEAK_HOLD_TIME);
+			peakHoldUpdates = 0;
 		}
 	}
 
@@ -622,7 +613,11 @@ void VUMeterLevel::resize_level_pixmap( )
 void VUMeterLevel::update_peak( )
 {
         peak = m_monitor->get_peak_value();
-        m_monitor->set_read();
+
+	// the peak hold value starts falling after PEAK_HOLD_TIME
+	if (PEAK_HOLD_MODE == 1 && ++peakHoldUpdates * UPDATE_FREQ >= PEAK_HOLD_TIME) {
+		peakHoldFalling = true;
+	}
 
 	// if the meter drops to -inf, reset the 'over LED' and peak hold values
 	if ((peak == 0.0) && (tailDeltaY <= -70.0)) {
@@ -633,22 +628,7 @@ void VUMeterLevel::update_peak( )
 
 	// RMS lines
 	if (SHOW_RMS) {
-		// use some kind of 'ring buffer' to store the last couple of peak values
-		if (rmsIndex >= RMS_SAMPLES) {
-			rmsIndex = 0;
-		}
-
-		peakHistory[rmsIndex] = peak;
-
-		// calculate the RMS
-		float squares = 0.0;
-
-		for (int i = 0; i < RMS_SAMPLES; i++) {
-			squares += peakHistory[i] * peakHistory[i];
-		}
-
-		rms = sqrt(squares / float(RMS_SAMPLES));
-		rmsIndex++;
+		rms = m_monitor->get_rms_value();
 	}
 
 	// 'over' detection
@@ -665,7 +645,8 @@ void VUMeterLevel::update_peak( )
 
 void VUMeterLevel::stop( )
 {
-	timer.stop();
+	// the AudioChannel (and it's VUMonitor) will be deleted
+	disconnect(&meterbus(), SIGNAL(snapshotUpdated()), this, SLOT(update_peak()));
 	emit activate_over_led(false);
 }
 
@@ -689,11 +670,6 @@ QSize VUMeterLevel::minimumSizeHint() const
 	return QSize(10, 40);
 }
 
-void VUMeterLevel::reset_peak_hold_value()
-{
-	peakHoldFalling = true;
-}
-
 void VUMeterLevel::load_theme_data()
 {
 	float zeroDB = 1.0 - 100.0/115.0;  // 0 dB position
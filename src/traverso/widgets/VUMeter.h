@@ -26,7 +26,6 @@
 #include <QWidget>
 #include <QString>
 #include <QVector>
-#include <QTimer>
 
 class AudioBus;
 class AudioChannel;
@@ -186,8 +185,6 @@ private:
 			m_colBg;
         QPixmap		levelPixmap;
         QPixmap		clearPixmap;
-        QTimer 		timer,
-			phTimer;
 	QLinearGradient	gradient2D;
 	QColor		m_colOverLed;
 
@@ -198,8 +195,7 @@ private:
 	float			rms;
 	float			maxFalloff;
 	float			peakHoldValue;
-	float			peakHistory[50];
-	short unsigned int	rmsIndex;
+	int			peakHoldUpdates;
 	short unsigned int	overCount;
 
         void resize_level_pixmap();
@@ -209,7 +205,6 @@ private slots:
 	void stop();
 	void start();
         void update_peak();
-	void reset_peak_hold_value();
 	void load_theme_data();
 
 signals: